@@ -29,7 +29,20 @@
  * operations over time so as not to interrupt animations or interactivity.
  *
  * Operations added to the #MxActorManager will strictly be performed in the
- * order in which they were added.
+ * order in which they were added, unless their priority is changed with
+ * mx_actor_manager_set_operation_priority().
+ *
+ * By default, operations are performed for #MxActorManager:time-slice
+ * milliseconds per frame. In adaptive mode, the time is instead what remains
+ * of #MxActorManager:frame-interval after the measured cost of laying out
+ * and painting recent frames, and consecutive additions to or removals from
+ * the same container are performed together, so that they cost a single
+ * relayout. #MxActorManager::frame-processed reports how much was done in
+ * each frame.
+ *
+ * Work that does not need the main thread, such as formatting text or
+ * decoding images, can be done on worker threads before the actor is
+ * created, with mx_actor_manager_prepare_actor().
  *
  * Since: 1.2
  */
@@ -53,7 +66,10 @@ enum
 
   PROP_STAGE,
   PROP_TIME_SLICE,
-  PROP_N_OPERATIONS
+  PROP_N_OPERATIONS,
+  PROP_ADAPTIVE,
+  PROP_PREPARE_LIMIT,
+  PROP_FRAME_INTERVAL
 };
 
 enum
@@ -65,6 +81,8 @@ enum
   OP_COMPLETED,
   OP_CANCELLED,
   OP_FAILED,
+  BATCH_PROGRESS,
+  FRAME_PROCESSED,
 
   LAST_SIGNAL
 };
@@ -74,20 +92,57 @@ typedef enum
   MX_ACTOR_MANAGER_CREATE,
   MX_ACTOR_MANAGER_ADD,
   MX_ACTOR_MANAGER_REMOVE,
-  MX_ACTOR_MANAGER_UNREF
+  MX_ACTOR_MANAGER_UNREF,
+  MX_ACTOR_MANAGER_CREATE_BATCH,
+  MX_ACTOR_MANAGER_REALIZE
 } MxActorManagerOperationType;
 
+typedef struct _MxActorManagerJob MxActorManagerJob;
+
+/* The part of an operation that is prepared on a worker thread. The worker
+ * only reads the functions and user data, and writes the payload before
+ * marking the job as done. The last reference is always dropped on the main
+ * thread. */
+struct _MxActorManagerJob
+{
+  volatile gint              ref_count;
+  volatile gint              cancelled;
+  volatile gint              done;
+
+  MxActorManagerPrepareFunc  prepare_func;
+  MxActorManagerRealizeFunc  realize_func;
+  gpointer                   payload;
+  GDestroyNotify             payload_free;
+  gpointer                   userdata;
+  GDestroyNotify             destroy_func;
+
+  /* main thread only; NULL once the operation is gone */
+  MxActorManager            *manager;
+  guint                      dispatched : 1;
+};
+
 typedef struct
 {
   MxActorManager              *manager;
   gulong                       id;
   MxActorManagerOperationType  type;
+  gint                         priority;
 
   MxActorManagerCreateFunc     create_func;
   gpointer                     userdata;
 
   ClutterActor                *actor;
   ClutterActor                *container;
+
+  /* creating a batch of actors */
+  MxActorManagerBatchFunc      batch_func;
+  GDestroyNotify               destroy_func;
+  guint                        n_actors;
+  guint                        n_done;
+  guint                        n_reported;
+
+  /* creating an actor from a payload prepared on a worker thread */
+  MxActorManagerJob           *job;
 } MxActorManagerOperation;
 
 struct _MxActorManagerPrivate
@@ -104,9 +159,36 @@ struct _MxActorManagerPrivate
 
   ClutterStage *stage;
 
+  gulong        next_id;
+
   guint         quark_set   : 1;
+  guint         adaptive    : 1;
+
+  /* measuring the cost of frames, for adaptive scheduling */
+  guint         frame_interval;
+  guint         pre_paint_func;
+  guint         post_paint_func;
+  gint64        frame_start;
+  gdouble       frame_cost;
+
+  /* statistics */
+  guint         n_processed;
+  guint         n_overruns;
+
+  /* preparing operations on worker threads */
+  GThreadPool  *pool;
+  GQueue       *pending_jobs;
+  guint         n_jobs;
+  guint         prepare_limit;
 };
 
+/* the least time spent performing operations per frame in adaptive mode,
+ * in ms, so that operations still complete when frames are expensive */
+#define MIN_ADAPTIVE_SLICE 1.0
+
+/* the weight of the last frame in the running average of frame costs */
+#define FRAME_COST_WEIGHT 0.25
+
 static guint signals[LAST_SIGNAL] = { 0, };
 
 static void mx_actor_manager_handle_op (MxActorManager *manager);
@@ -142,6 +224,18 @@ mx_actor_manager_get_property (GObject    *object,
       g_value_set_uint (value, g_queue_get_length (priv->ops));
       break;
 
+    case PROP_ADAPTIVE:
+      g_value_set_boolean (value, priv->adaptive);
+      break;
+
+    case PROP_PREPARE_LIMIT:
+      g_value_set_uint (value, priv->prepare_limit);
+      break;
+
+    case PROP_FRAME_INTERVAL:
+      g_value_set_uint (value, priv->frame_interval);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
     }
@@ -178,6 +272,18 @@ mx_actor_manager_set_property (GObject      *object,
       mx_actor_manager_set_time_slice (self, g_value_get_uint (value));
       break;
 
+    case PROP_ADAPTIVE:
+      mx_actor_manager_set_adaptive (self, g_value_get_boolean (value));
+      break;
+
+    case PROP_PREPARE_LIMIT:
+      mx_actor_manager_set_prepare_limit (self, g_value_get_uint (value));
+      break;
+
+    case PROP_FRAME_INTERVAL:
+      mx_actor_manager_set_frame_interval (self, g_value_get_uint (value));
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
     }
@@ -202,12 +308,28 @@ mx_actor_manager_dispose (GObject *object)
       priv->post_paint_handler = 0;
     }
 
+  if (priv->pre_paint_func)
+    {
+      clutter_threads_remove_repaint_func (priv->pre_paint_func);
+      clutter_threads_remove_repaint_func (priv->post_paint_func);
+      priv->pre_paint_func = 0;
+      priv->post_paint_func = 0;
+    }
+
   while (g_queue_get_length (priv->ops))
     {
       MxActorManagerOperation *op = g_queue_peek_head (priv->ops);
       mx_actor_manager_cancel_operation (self, op->id);
     }
 
+  if (priv->pool)
+    {
+      /* wait for the workers; the jobs left are cancelled, so they will
+       * not be prepared */
+      g_thread_pool_free (priv->pool, FALSE, TRUE);
+      priv->pool = NULL;
+    }
+
   if (priv->stage)
     {
       if (priv->quark_set)
@@ -241,6 +363,7 @@ mx_actor_manager_finalize (GObject *object)
                         NULL);
   g_hash_table_unref (priv->actor_op_links);
   g_timer_destroy (priv->timer);
+  g_queue_free (priv->pending_jobs);
 
   G_OBJECT_CLASS (mx_actor_manager_parent_class)->finalize (object);
 }
@@ -280,6 +403,56 @@ mx_actor_manager_class_init (MxActorManagerClass *klass)
                              MX_PARAM_READABLE);
   g_object_class_install_property (object_class, PROP_N_OPERATIONS, pspec);
 
+  /**
+   * MxActorManager:adaptive:
+   *
+   * Whether to derive the time spent performing operations from the cost of
+   * recent frames, rather than using #MxActorManager:time-slice.
+   *
+   * Since: 2.0
+   */
+  pspec = g_param_spec_boolean ("adaptive",
+                                "Adaptive",
+                                "Whether to fit operations into the time "
+                                "left over by recent frames",
+                                FALSE,
+                                MX_PARAM_READWRITE);
+  g_object_class_install_property (object_class, PROP_ADAPTIVE, pspec);
+
+  /**
+   * MxActorManager:prepare-limit:
+   *
+   * The most operations added with mx_actor_manager_prepare_actor() that
+   * may be prepared, or waiting to be realized, at once. Further operations
+   * wait to be prepared until earlier ones have been realized.
+   *
+   * Since: 2.0
+   */
+  pspec = g_param_spec_uint ("prepare-limit",
+                             "Prepare limit",
+                             "The most operations prepared ahead of being "
+                             "realized",
+                             1, G_MAXUINT, 32,
+                             MX_PARAM_READWRITE);
+  g_object_class_install_property (object_class, PROP_PREPARE_LIMIT, pspec);
+
+  /**
+   * MxActorManager:frame-interval:
+   *
+   * The time between frames, in ms, that laying out and painting a frame
+   * and performing operations should fit into in adaptive mode. When 0, the
+   * interval follows from the default frame rate.
+   *
+   * Since: 2.0
+   */
+  pspec = g_param_spec_uint ("frame-interval",
+                             "Frame interval",
+                             "The time between frames in adaptive mode, "
+                             "in ms, or 0 for the default frame rate",
+                             0, G_MAXUINT, 0,
+                             MX_PARAM_READWRITE);
+  g_object_class_install_property (object_class, PROP_FRAME_INTERVAL, pspec);
+
   /**
    * MxActorManager::actor-created:
    * @manager: the object that received the signal
@@ -419,6 +592,51 @@ mx_actor_manager_class_init (MxActorManagerClass *klass)
                   G_TYPE_NONE, 2,
                   G_TYPE_ULONG, G_TYPE_ERROR);
 
+  /**
+   * MxActorManager::batch-progress:
+   * @manager: the object that received the signal
+   * @id: The operation id
+   * @n_done: The number of actors created so far
+   * @n_actors: The number of actors in the batch
+   *
+   * Emitted at most once per frame while actors are created by an operation
+   * added with mx_actor_manager_create_actors(), and before the operation
+   * completes.
+   *
+   * Since: 2.0
+   */
+  signals[BATCH_PROGRESS] =
+    g_signal_new ("batch-progress",
+                  G_TYPE_FROM_CLASS (klass),
+                  G_SIGNAL_RUN_LAST,
+                  G_STRUCT_OFFSET (MxActorManagerClass, batch_progress),
+                  NULL, NULL,
+                  _mx_marshal_VOID__ULONG_UINT_UINT,
+                  G_TYPE_NONE, 3,
+                  G_TYPE_ULONG, G_TYPE_UINT, G_TYPE_UINT);
+
+  /**
+   * MxActorManager::frame-processed:
+   * @manager: the object that received the signal
+   * @n_processed: The number of operations performed in the frame
+   * @n_overruns: The number of frames that overran so far, see
+   *   mx_actor_manager_get_n_overruns()
+   *
+   * Emitted once for each frame in which operations were performed, after
+   * performing them.
+   *
+   * Since: 2.0
+   */
+  signals[FRAME_PROCESSED] =
+    g_signal_new ("frame-processed",
+                  G_TYPE_FROM_CLASS (klass),
+                  G_SIGNAL_RUN_LAST,
+                  G_STRUCT_OFFSET (MxActorManagerClass, frame_processed),
+                  NULL, NULL,
+                  _mx_marshal_VOID__UINT_UINT,
+                  G_TYPE_NONE, 2,
+                  G_TYPE_UINT, G_TYPE_UINT);
+
   actor_manager_quark = g_quark_from_static_string ("mx-actor-manager");
   actor_manager_error_quark =
     g_quark_from_static_string ("mx-actor-manager-error");
@@ -433,6 +651,9 @@ mx_actor_manager_init (MxActorManager *self)
   priv->actor_op_links = g_hash_table_new (NULL, NULL);
   priv->timer = g_timer_new ();
   priv->time_slice = 5;
+  priv->next_id = 1;
+  priv->pending_jobs = g_queue_new ();
+  priv->prepare_limit = 32;
 }
 
 /**
@@ -570,6 +791,105 @@ mx_actor_manager_container_destroyed (gpointer  data,
   op->container = NULL;
 }
 
+static void
+mx_actor_manager_job_unref (MxActorManagerJob *job)
+{
+  if (!g_atomic_int_dec_and_test (&job->ref_count))
+    return;
+
+  if (job->payload && job->payload_free)
+    job->payload_free (job->payload);
+
+  if (job->destroy_func)
+    job->destroy_func (job->userdata);
+
+  g_slice_free (MxActorManagerJob, job);
+}
+
+static gboolean
+mx_actor_manager_job_prepared_cb (MxActorManagerJob *job)
+{
+  if (job->manager)
+    mx_actor_manager_ensure_processing (job->manager);
+
+  return FALSE;
+}
+
+/* runs on a worker thread */
+static void
+mx_actor_manager_prepare_job (MxActorManagerJob *job,
+                              gpointer           userdata)
+{
+  if (!g_atomic_int_get (&job->cancelled))
+    job->payload = job->prepare_func (job->userdata);
+
+  g_atomic_int_set (&job->done, TRUE);
+
+  /* wake up the main thread, handing over the worker's reference */
+  g_idle_add_full (G_PRIORITY_HIGH,
+                   (GSourceFunc) mx_actor_manager_job_prepared_cb,
+                   job,
+                   (GDestroyNotify) mx_actor_manager_job_unref);
+}
+
+static void
+mx_actor_manager_dispatch_job (MxActorManager    *manager,
+                               MxActorManagerJob *job)
+{
+  MxActorManagerPrivate *priv = manager->priv;
+
+  g_queue_remove (priv->pending_jobs, job);
+
+  if (!priv->pool)
+    priv->pool = g_thread_pool_new ((GFunc) mx_actor_manager_prepare_job,
+                                    NULL,
+                                    MAX (1, g_get_num_processors ()),
+                                    FALSE,
+                                    NULL);
+
+  job->dispatched = TRUE;
+  priv->n_jobs++;
+
+  g_atomic_int_inc (&job->ref_count);
+  g_thread_pool_push (priv->pool, job, NULL);
+}
+
+/* Hands the pending jobs to the worker threads, in order, until as many
+ * jobs as allowed are being prepared or waiting to be realized */
+static void
+mx_actor_manager_dispatch_jobs (MxActorManager *manager)
+{
+  MxActorManagerPrivate *priv = manager->priv;
+
+  while (priv->n_jobs < priv->prepare_limit &&
+         !g_queue_is_empty (priv->pending_jobs))
+    mx_actor_manager_dispatch_job (manager,
+                                   g_queue_peek_head (priv->pending_jobs));
+}
+
+/* Queues @op_link after the operations with the same or a higher priority */
+static void
+mx_actor_manager_queue_op_link (MxActorManager *manager,
+                                GList          *op_link)
+{
+  MxActorManagerPrivate *priv = manager->priv;
+  MxActorManagerOperation *op = op_link->data;
+  guint position;
+  GList *l;
+
+  /* operations usually share a priority, so start from the tail */
+  position = g_queue_get_length (priv->ops);
+  for (l = g_queue_peek_tail_link (priv->ops); l; l = l->prev)
+    {
+      if (((MxActorManagerOperation *) l->data)->priority <= op->priority)
+        break;
+
+      position--;
+    }
+
+  g_queue_push_nth_link (priv->ops, position, op_link);
+}
+
 static MxActorManagerOperation *
 mx_actor_manager_op_new (MxActorManager              *manager,
                          MxActorManagerOperationType  type,
@@ -583,20 +903,16 @@ mx_actor_manager_op_new (MxActorManager              *manager,
   MxActorManagerOperation *op = g_slice_new0 (MxActorManagerOperation);
 
   op->manager = manager;
-
-  if (g_queue_peek_tail (priv->ops))
-    op->id = ((MxActorManagerOperation *)g_queue_peek_tail (priv->ops))->id + 1;
-  else
-    op->id = 1;
-
+  op->id = priv->next_id++;
   op->type = type;
   op->create_func = create_func;
   op->userdata = userdata;
   op->actor = actor;
   op->container = container;
 
-  g_queue_push_tail (priv->ops, op);
-  op_link = g_queue_peek_tail_link (priv->ops);
+  op_link = g_list_alloc ();
+  op_link->data = op;
+  mx_actor_manager_queue_op_link (manager, op_link);
 
   if (actor)
     {
@@ -647,12 +963,43 @@ mx_actor_manager_op_free (MxActorManager *manager,
                            op);
     }
 
+  if (op->destroy_func)
+    op->destroy_func (op->userdata);
+
+  if (op->job)
+    {
+      MxActorManagerJob *job = op->job;
+
+      if (job->dispatched)
+        priv->n_jobs--;
+      else
+        g_queue_remove (priv->pending_jobs, job);
+
+      g_atomic_int_set (&job->cancelled, TRUE);
+      job->manager = NULL;
+      mx_actor_manager_job_unref (job);
+
+      mx_actor_manager_dispatch_jobs (manager);
+    }
+
   if (_remove)
     g_queue_delete_link (priv->ops, op_link);
 
   g_slice_free (MxActorManagerOperation, op);
 }
 
+static void
+mx_actor_manager_report_progress (MxActorManager          *manager,
+                                  MxActorManagerOperation *op)
+{
+  if (op->n_done == op->n_reported)
+    return;
+
+  op->n_reported = op->n_done;
+  g_signal_emit (manager, signals[BATCH_PROGRESS], 0,
+                 op->id, op->n_done, op->n_actors);
+}
+
 static void
 mx_actor_manager_handle_op (MxActorManager *manager)
 {
@@ -741,6 +1088,65 @@ mx_actor_manager_handle_op (MxActorManager *manager)
                              "Actor destroyed before unref");
       break;
 
+    case MX_ACTOR_MANAGER_REALIZE:
+      if (!op->container)
+        {
+          error = g_error_new (actor_manager_error_quark,
+                               MX_ACTOR_MANAGER_CONTAINER_DESTROYED,
+                               "Container destroyed before addition");
+          break;
+        }
+
+      actor = op->job->realize_func (manager, op->job->payload,
+                                     op->job->userdata);
+
+      if (CLUTTER_IS_ACTOR (actor))
+        {
+          clutter_actor_add_child (op->container, actor);
+          g_signal_emit (manager, signals[ACTOR_ADDED], 0,
+                         op->id, op->container, actor);
+        }
+      else
+        error = g_error_new (actor_manager_error_quark,
+                             MX_ACTOR_MANAGER_CREATION_FAILED,
+                             "Actor realize function did not "
+                             "return a ClutterActor");
+      break;
+
+    case MX_ACTOR_MANAGER_CREATE_BATCH:
+      if (!op->container)
+        {
+          error = g_error_new (actor_manager_error_quark,
+                               MX_ACTOR_MANAGER_CONTAINER_DESTROYED,
+                               "Container destroyed before addition");
+          break;
+        }
+
+      actor = op->batch_func (manager, op->n_done, op->userdata);
+
+      if (!CLUTTER_IS_ACTOR (actor))
+        {
+          error = g_error_new (actor_manager_error_quark,
+                               MX_ACTOR_MANAGER_CREATION_FAILED,
+                               "Actor creation function did not "
+                               "return a ClutterActor");
+          break;
+        }
+
+      clutter_actor_add_child (op->container, actor);
+      op->n_done++;
+
+      /* the operation stays at the head of the queue until the whole
+       * batch is created */
+      if (op->n_done < op->n_actors)
+        {
+          g_object_unref (op->container);
+          return;
+        }
+
+      mx_actor_manager_report_progress (manager, op);
+      break;
+
     default:
       g_warning (G_STRLOC ": Unrecognised operation type (%d) "
                  "- Memory corruption?)", op->type);
@@ -780,28 +1186,135 @@ mx_actor_manager_post_paint_cb (ClutterActor   *stage,
   mx_actor_manager_ensure_processing (manager);
 }
 
+/* the time between frames, in ms */
+static gdouble
+mx_actor_manager_get_interval (MxActorManager *manager)
+{
+  guint frame_rate;
+
+  if (manager->priv->frame_interval)
+    return manager->priv->frame_interval;
+
+  frame_rate = clutter_get_default_frame_rate ();
+
+  return 1000.0 / MAX (frame_rate, 1);
+}
+
+/* the time to spend performing operations this frame, in ms */
+static gdouble
+mx_actor_manager_get_budget (MxActorManager *manager)
+{
+  MxActorManagerPrivate *priv = manager->priv;
+
+  if (!priv->adaptive)
+    return priv->time_slice;
+
+  return MAX (MIN_ADAPTIVE_SLICE,
+              mx_actor_manager_get_interval (manager) - priv->frame_cost);
+}
+
+/* whether the operation at the head of the queue belongs with the one of
+ * @type on @container just performed, so that they are performed in the
+ * same frame */
+static gboolean
+mx_actor_manager_continues_batch (MxActorManager              *manager,
+                                  MxActorManagerOperationType  type,
+                                  ClutterActor                *container)
+{
+  MxActorManagerOperation *next = g_queue_peek_head (manager->priv->ops);
+
+  if (!next || !container)
+    return FALSE;
+
+  return ((type == MX_ACTOR_MANAGER_ADD ||
+           type == MX_ACTOR_MANAGER_REMOVE) &&
+          next->type == type &&
+          next->container == container);
+}
+
 static gboolean
 mx_actor_manager_process_operations (MxActorManager *manager)
 {
   MxActorManagerPrivate *priv = manager->priv;
+  gdouble budget, elapsed;
 
   priv->source = 0;
+  priv->n_processed = 0;
+
+  budget = mx_actor_manager_get_budget (manager);
 
   g_timer_start (priv->timer);
 
   while (!g_queue_is_empty (priv->ops))
     {
+      MxActorManagerOperation *op = g_queue_peek_head (priv->ops);
+      MxActorManagerOperationType type;
+      ClutterActor *container;
+
+      /* operations are performed in order, so wait for the worker thread
+       * to finish preparing this one; it will restart processing. An
+       * operation moved ahead by its priority may not have been handed to
+       * a worker yet, and the ones that were may be waiting behind it. */
+      if (op->job && !g_atomic_int_get (&op->job->done))
+        {
+          if (!op->job->dispatched)
+            mx_actor_manager_dispatch_job (manager, op->job);
+          break;
+        }
+
+      /* keep what's needed to compare against the next operation, as
+       * handling the operation frees it; the container is only compared */
+      type = op->type;
+      container = op->container;
+
       mx_actor_manager_handle_op (manager);
+      priv->n_processed++;
 
-      if (priv->stage &&
-          g_timer_elapsed (priv->timer, NULL) * 1000 >= priv->time_slice)
+      if (!priv->stage)
+        continue;
+
+      elapsed = g_timer_elapsed (priv->timer, NULL) * 1000;
+
+      /* in adaptive mode, finish adding to or removing from a container
+       * within the frame, unless that takes the whole frame */
+      if (priv->adaptive &&
+          mx_actor_manager_continues_batch (manager, type, container) &&
+          elapsed < mx_actor_manager_get_interval (manager))
+        continue;
+
+      if (elapsed >= budget)
         break;
     }
 
   g_timer_stop (priv->timer);
 
+  /* report the progress of a batch once per frame */
   if (!g_queue_is_empty (priv->ops))
     {
+      MxActorManagerOperation *op = g_queue_peek_head (priv->ops);
+
+      if (op->type == MX_ACTOR_MANAGER_CREATE_BATCH)
+        mx_actor_manager_report_progress (manager, op);
+    }
+
+  /* the frame is late if operations took more than what was left of it,
+   * which is only known when the cost of frames is measured */
+  if (priv->adaptive && priv->stage &&
+      g_timer_elapsed (priv->timer, NULL) * 1000 >
+      mx_actor_manager_get_interval (manager) - priv->frame_cost)
+    priv->n_overruns++;
+
+  if (priv->n_processed)
+    g_signal_emit (manager, signals[FRAME_PROCESSED], 0,
+                   priv->n_processed, priv->n_overruns);
+
+  if (!g_queue_is_empty (priv->ops))
+    {
+      MxActorManagerOperation *op = g_queue_peek_head (priv->ops);
+
+      if (op->job && !g_atomic_int_get (&op->job->done))
+        return FALSE;
+
       if (!priv->post_paint_handler)
         priv->post_paint_handler =
           g_signal_connect (priv->stage, "paint",
@@ -906,6 +1419,138 @@ mx_actor_manager_add_actor (MxActorManager   *manager,
   return op->id;
 }
 
+/**
+ * mx_actor_manager_create_actors:
+ * @manager: A #MxActorManager
+ * @container: A #ClutterActor
+ * @n_actors: The number of actors to create
+ * @create_func: A function creating the actor at a given index
+ * @userdata: data to be passed to the function, or %NULL
+ * @destroy_func: callback to invoke on @userdata when the operation is
+ *   removed, or %NULL
+ *
+ * Creates @n_actors actors with @create_func and adds them to @container, in
+ * order of their index. The actors are created as a single operation, which
+ * is spread over as many frames as necessary, and may be cancelled as a whole
+ * with mx_actor_manager_cancel_operation(). Actors created before the
+ * operation was cancelled stay in @container.
+ *
+ * Rather than a signal for each actor, #MxActorManager::batch-progress is
+ * fired at most once per frame, and #MxActorManager::operation-completed
+ * is fired once all the actors were added. If @create_func does not return
+ * an actor, the remaining actors are not created and
+ * #MxActorManager::operation-failed is fired.
+ *
+ * Returns: The ID for this operation.
+ *
+ * Since: 2.0
+ */
+gulong
+mx_actor_manager_create_actors (MxActorManager          *manager,
+                                ClutterActor            *container,
+                                guint                    n_actors,
+                                MxActorManagerBatchFunc  create_func,
+                                gpointer                 userdata,
+                                GDestroyNotify           destroy_func)
+{
+  MxActorManagerOperation *op;
+
+  g_return_val_if_fail (MX_IS_ACTOR_MANAGER (manager), 0);
+  g_return_val_if_fail (CLUTTER_IS_ACTOR (container), 0);
+  g_return_val_if_fail (n_actors > 0, 0);
+  g_return_val_if_fail (create_func != NULL, 0);
+
+  op = mx_actor_manager_op_new (manager,
+                                MX_ACTOR_MANAGER_CREATE_BATCH,
+                                NULL,
+                                userdata,
+                                NULL,
+                                container);
+  op->batch_func = create_func;
+  op->destroy_func = destroy_func;
+  op->n_actors = n_actors;
+
+  mx_actor_manager_ensure_processing (manager);
+
+  return op->id;
+}
+
+/**
+ * mx_actor_manager_prepare_actor:
+ * @manager: A #MxActorManager
+ * @container: A #ClutterActor
+ * @prepare_func: A function preparing the payload for the actor
+ * @realize_func: A function creating the actor from the payload
+ * @payload_free: callback to free the payload, or %NULL
+ * @userdata: data to be passed to the functions, or %NULL
+ * @destroy_func: callback to invoke on @userdata when the operation is
+ *   removed, or %NULL
+ *
+ * Creates an actor in two stages and adds it to @container. @prepare_func is
+ * called on a worker thread, and should return a payload holding anything
+ * that is expensive to compute but does not need the main thread, like
+ * formatted text or decoded images. @prepare_func must not use Clutter, nor
+ * modify @userdata. @realize_func is then called on the main thread, like
+ * other operations, to create the actor from the payload. The payload is
+ * freed with @payload_free once the actor is realized, or the operation is
+ * cancelled.
+ *
+ * Operations are still performed in the order in which they were added, so
+ * an operation waits until its payload is prepared before it and the
+ * operations after it are performed. At most #MxActorManager:prepare-limit
+ * payloads are prepared ahead of being realized. The operation is cancelled
+ * along with the other operations on @container by
+ * mx_actor_manager_cancel_operations().
+ *
+ * On successful completion, the #MxActorManager::actor_added signal will
+ * be fired.
+ *
+ * Returns: The ID for this operation.
+ *
+ * Since: 2.0
+ */
+gulong
+mx_actor_manager_prepare_actor (MxActorManager            *manager,
+                                ClutterActor              *container,
+                                MxActorManagerPrepareFunc  prepare_func,
+                                MxActorManagerRealizeFunc  realize_func,
+                                GDestroyNotify             payload_free,
+                                gpointer                   userdata,
+                                GDestroyNotify             destroy_func)
+{
+  MxActorManagerOperation *op;
+  MxActorManagerJob *job;
+
+  g_return_val_if_fail (MX_IS_ACTOR_MANAGER (manager), 0);
+  g_return_val_if_fail (CLUTTER_IS_ACTOR (container), 0);
+  g_return_val_if_fail (prepare_func != NULL, 0);
+  g_return_val_if_fail (realize_func != NULL, 0);
+
+  job = g_slice_new0 (MxActorManagerJob);
+  job->ref_count = 1;
+  job->prepare_func = prepare_func;
+  job->realize_func = realize_func;
+  job->payload_free = payload_free;
+  job->userdata = userdata;
+  job->destroy_func = destroy_func;
+  job->manager = manager;
+
+  op = mx_actor_manager_op_new (manager,
+                                MX_ACTOR_MANAGER_REALIZE,
+                                NULL,
+                                NULL,
+                                NULL,
+                                container);
+  op->job = job;
+
+  g_queue_push_tail (manager->priv->pending_jobs, job);
+  mx_actor_manager_dispatch_jobs (manager);
+
+  mx_actor_manager_ensure_processing (manager);
+
+  return op->id;
+}
+
 /**
  * mx_actor_manager_remove_actor:
  * @manager: A #MxActorManager
@@ -1160,3 +1805,282 @@ mx_actor_manager_get_n_operations (MxActorManager *manager)
   g_return_val_if_fail (MX_IS_ACTOR_MANAGER (manager), 0);
   return g_queue_get_length (manager->priv->ops);
 }
+
+static gboolean
+mx_actor_manager_frame_start_cb (MxActorManager *manager)
+{
+  manager->priv->frame_start = g_get_monotonic_time ();
+
+  return TRUE;
+}
+
+static gboolean
+mx_actor_manager_frame_end_cb (MxActorManager *manager)
+{
+  MxActorManagerPrivate *priv = manager->priv;
+  gdouble cost;
+
+  if (!priv->frame_start)
+    return TRUE;
+
+  cost = (g_get_monotonic_time () - priv->frame_start) / 1000.0;
+  priv->frame_start = 0;
+
+  priv->frame_cost = (priv->frame_cost * (1.0 - FRAME_COST_WEIGHT)) +
+                     (cost * FRAME_COST_WEIGHT);
+
+  return TRUE;
+}
+
+/**
+ * mx_actor_manager_set_adaptive:
+ * @manager: A #MxActorManager
+ * @adaptive: %TRUE to fit operations into the time left over by frames
+ *
+ * Sets whether the time spent performing operations each frame is derived
+ * from the time it took to lay out and paint recent frames, and
+ * #MxActorManager:frame-interval. When adaptive, #MxActorManager:time-slice is not used, and
+ * consecutive additions to or removals from the same container are
+ * performed in the same frame where possible.
+ *
+ * Since: 2.0
+ */
+void
+mx_actor_manager_set_adaptive (MxActorManager *manager,
+                               gboolean        adaptive)
+{
+  MxActorManagerPrivate *priv;
+
+  g_return_if_fail (MX_IS_ACTOR_MANAGER (manager));
+
+  priv = manager->priv;
+
+  if (priv->adaptive == adaptive)
+    return;
+
+  priv->adaptive = adaptive;
+
+  if (adaptive)
+    {
+      priv->frame_start = 0;
+      priv->frame_cost = 0;
+
+      priv->pre_paint_func =
+        clutter_threads_add_repaint_func_full (CLUTTER_REPAINT_FLAGS_PRE_PAINT,
+                                               (GSourceFunc)
+                                               mx_actor_manager_frame_start_cb,
+                                               manager, NULL);
+      priv->post_paint_func =
+        clutter_threads_add_repaint_func_full (CLUTTER_REPAINT_FLAGS_POST_PAINT,
+                                               (GSourceFunc)
+                                               mx_actor_manager_frame_end_cb,
+                                               manager, NULL);
+    }
+  else
+    {
+      if (priv->pre_paint_func)
+        {
+          clutter_threads_remove_repaint_func (priv->pre_paint_func);
+          clutter_threads_remove_repaint_func (priv->post_paint_func);
+          priv->pre_paint_func = 0;
+          priv->post_paint_func = 0;
+        }
+    }
+
+  g_object_notify (G_OBJECT (manager), "adaptive");
+}
+
+/**
+ * mx_actor_manager_get_adaptive:
+ * @manager: A #MxActorManager
+ *
+ * Gets the value of the #MxActorManager:adaptive property.
+ *
+ * Returns: %TRUE if the time spent performing operations adapts to the cost
+ *   of recent frames
+ *
+ * Since: 2.0
+ */
+gboolean
+mx_actor_manager_get_adaptive (MxActorManager *manager)
+{
+  g_return_val_if_fail (MX_IS_ACTOR_MANAGER (manager), FALSE);
+  return manager->priv->adaptive;
+}
+
+/**
+ * mx_actor_manager_set_operation_priority:
+ * @manager: A #MxActorManager
+ * @id: An operation ID
+ * @priority: the priority of the operation
+ *
+ * Sets the priority of the given operation. Operations with a lower
+ * priority value are performed first, and operations with the same priority
+ * are performed in the order in which they were added. Operations have a
+ * priority of %G_PRIORITY_DEFAULT when they are added.
+ *
+ * <note><para>
+ * Operations on the same actor should share a priority, otherwise they may
+ * be performed out of order, for example removing an actor before it was
+ * added.
+ * </para></note>
+ *
+ * Since: 2.0
+ */
+void
+mx_actor_manager_set_operation_priority (MxActorManager *manager,
+                                         gulong          id,
+                                         gint            priority)
+{
+  MxActorManagerOperation *op;
+  MxActorManagerPrivate *priv;
+  GList *op_link;
+
+  g_return_if_fail (MX_IS_ACTOR_MANAGER (manager));
+  g_return_if_fail (id > 0);
+
+  priv = manager->priv;
+
+  op_link = g_queue_find_custom (priv->ops, &id, mx_actor_manager_find_by_id);
+
+  if (!op_link)
+    {
+      g_warning (G_STRLOC ": Unknown operation (%lu)", id);
+      return;
+    }
+
+  op = op_link->data;
+  if (op->priority == priority)
+    return;
+
+  g_queue_unlink (priv->ops, op_link);
+  op->priority = priority;
+  mx_actor_manager_queue_op_link (manager, op_link);
+}
+
+/**
+ * mx_actor_manager_get_n_processed:
+ * @manager: A #MxActorManager
+ *
+ * Retrieves the amount of operations performed during the last frame in
+ * which operations were performed.
+ *
+ * Returns: Number of operations performed in the last frame
+ *
+ * Since: 2.0
+ */
+guint
+mx_actor_manager_get_n_processed (MxActorManager *manager)
+{
+  g_return_val_if_fail (MX_IS_ACTOR_MANAGER (manager), 0);
+  return manager->priv->n_processed;
+}
+
+/**
+ * mx_actor_manager_get_n_overruns:
+ * @manager: A #MxActorManager
+ *
+ * Retrieves the amount of frames in which performing operations took longer
+ * than the time left in the frame, since the manager was created. The time
+ * it takes to lay out and paint frames is only measured in adaptive mode,
+ * so only frames processed in adaptive mode are counted.
+ *
+ * Returns: Number of frames that overran their time for operations
+ *
+ * Since: 2.0
+ */
+guint
+mx_actor_manager_get_n_overruns (MxActorManager *manager)
+{
+  g_return_val_if_fail (MX_IS_ACTOR_MANAGER (manager), 0);
+  return manager->priv->n_overruns;
+}
+
+/**
+ * mx_actor_manager_set_prepare_limit:
+ * @manager: A #MxActorManager
+ * @limit: the most operations to prepare ahead of realizing them
+ *
+ * Sets the value of the #MxActorManager:prepare-limit property.
+ *
+ * Since: 2.0
+ */
+void
+mx_actor_manager_set_prepare_limit (MxActorManager *manager,
+                                    guint           limit)
+{
+  MxActorManagerPrivate *priv;
+
+  g_return_if_fail (MX_IS_ACTOR_MANAGER (manager));
+  g_return_if_fail (limit > 0);
+
+  priv = manager->priv;
+
+  if (priv->prepare_limit != limit)
+    {
+      priv->prepare_limit = limit;
+      mx_actor_manager_dispatch_jobs (manager);
+
+      g_object_notify (G_OBJECT (manager), "prepare-limit");
+    }
+}
+
+/**
+ * mx_actor_manager_get_prepare_limit:
+ * @manager: A #MxActorManager
+ *
+ * Gets the value of the #MxActorManager:prepare-limit property.
+ *
+ * Returns: the most operations prepared ahead of being realized
+ *
+ * Since: 2.0
+ */
+guint
+mx_actor_manager_get_prepare_limit (MxActorManager *manager)
+{
+  g_return_val_if_fail (MX_IS_ACTOR_MANAGER (manager), 0);
+  return manager->priv->prepare_limit;
+}
+
+/**
+ * mx_actor_manager_set_frame_interval:
+ * @manager: A #MxActorManager
+ * @msecs: the time between frames, in ms, or 0 for the default frame rate
+ *
+ * Sets the value of the #MxActorManager:frame-interval property.
+ *
+ * Since: 2.0
+ */
+void
+mx_actor_manager_set_frame_interval (MxActorManager *manager,
+                                     guint           msecs)
+{
+  MxActorManagerPrivate *priv;
+
+  g_return_if_fail (MX_IS_ACTOR_MANAGER (manager));
+
+  priv = manager->priv;
+
+  if (priv->frame_interval != msecs)
+    {
+      priv->frame_interval = msecs;
+      g_object_notify (G_OBJECT (manager), "frame-interval");
+    }
+}
+
+/**
+ * mx_actor_manager_get_frame_interval:
+ * @manager: A #MxActorManager
+ *
+ * Gets the value of the #MxActorManager:frame-interval property.
+ *
+ * Returns: the time between frames in ms, or 0 for the default frame rate
+ *
+ * Since: 2.0
+ */
+guint
+mx_actor_manager_get_frame_interval (MxActorManager *manager)
+{
+  g_return_val_if_fail (MX_IS_ACTOR_MANAGER (manager), 0);
+  return manager->priv->frame_interval;
+}
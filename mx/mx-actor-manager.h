@@ -57,6 +57,52 @@ typedef struct _MxActorManagerPrivate MxActorManagerPrivate;
 typedef ClutterActor * (*MxActorManagerCreateFunc) (MxActorManager *manager,
                                                     gpointer        userdata);
 
+/**
+ * MxActorManagerBatchFunc:
+ * @manager: A #MxActorManager
+ * @index: The index of the actor to create in the batch
+ * @userdata: data passed to mx_actor_manager_create_actors()
+ *
+ * Creates the actor at @index in a batch of actors.
+ *
+ * Returns: a new #ClutterActor
+ *
+ * Since: 2.0
+ */
+typedef ClutterActor * (*MxActorManagerBatchFunc) (MxActorManager *manager,
+                                                   guint           index,
+                                                   gpointer        userdata);
+
+/**
+ * MxActorManagerPrepareFunc:
+ * @userdata: data passed to mx_actor_manager_prepare_actor()
+ *
+ * Prepares the payload an actor will be created from. This is called on a
+ * worker thread.
+ *
+ * Returns: the payload
+ *
+ * Since: 2.0
+ */
+typedef gpointer (*MxActorManagerPrepareFunc) (gpointer userdata);
+
+/**
+ * MxActorManagerRealizeFunc:
+ * @manager: A #MxActorManager
+ * @payload: the payload returned by the #MxActorManagerPrepareFunc
+ * @userdata: data passed to mx_actor_manager_prepare_actor()
+ *
+ * Creates an actor from a prepared payload. This is called on the main
+ * thread.
+ *
+ * Returns: a new #ClutterActor
+ *
+ * Since: 2.0
+ */
+typedef ClutterActor * (*MxActorManagerRealizeFunc) (MxActorManager *manager,
+                                                     gpointer        payload,
+                                                     gpointer        userdata);
+
 typedef enum
 {
   MX_ACTOR_MANAGER_CONTAINER_DESTROYED,
@@ -100,9 +146,16 @@ struct _MxActorManagerClass
                             gulong          id,
                             GError         *error);
 
+  void (*batch_progress) (MxActorManager *manager,
+                          gulong          id,
+                          guint           n_done,
+                          guint           n_actors);
+
+  void (*frame_processed) (MxActorManager *manager,
+                           guint           n_processed,
+                           guint           n_overruns);
+
   /* padding for future expansion */
-  void (*_padding_0) (void);
-  void (*_padding_1) (void);
   void (*_padding_2) (void);
   void (*_padding_3) (void);
   void (*_padding_4) (void);
@@ -125,6 +178,21 @@ gulong mx_actor_manager_add_actor (MxActorManager *manager,
                                    ClutterActor   *container,
                                    ClutterActor   *actor);
 
+gulong mx_actor_manager_create_actors (MxActorManager          *manager,
+                                       ClutterActor            *container,
+                                       guint                    n_actors,
+                                       MxActorManagerBatchFunc  create_func,
+                                       gpointer                 userdata,
+                                       GDestroyNotify           destroy_func);
+
+gulong mx_actor_manager_prepare_actor (MxActorManager            *manager,
+                                       ClutterActor              *container,
+                                       MxActorManagerPrepareFunc  prepare_func,
+                                       MxActorManagerRealizeFunc  realize_func,
+                                       GDestroyNotify             payload_free,
+                                       gpointer                   userdata,
+                                       GDestroyNotify             destroy_func);
+
 gulong mx_actor_manager_remove_actor (MxActorManager *manager,
                                       ClutterActor   *container,
                                       ClutterActor   *actor);
@@ -144,6 +212,25 @@ guint mx_actor_manager_get_time_slice (MxActorManager *manager);
 
 guint mx_actor_manager_get_n_operations (MxActorManager *manager);
 
+void     mx_actor_manager_set_adaptive (MxActorManager *manager,
+                                        gboolean        adaptive);
+gboolean mx_actor_manager_get_adaptive (MxActorManager *manager);
+
+void mx_actor_manager_set_operation_priority (MxActorManager *manager,
+                                              gulong          id,
+                                              gint            priority);
+
+void  mx_actor_manager_set_prepare_limit (MxActorManager *manager,
+                                         guint           limit);
+guint mx_actor_manager_get_prepare_limit (MxActorManager *manager);
+
+void  mx_actor_manager_set_frame_interval (MxActorManager *manager,
+                                           guint           msecs);
+guint mx_actor_manager_get_frame_interval (MxActorManager *manager);
+
+guint mx_actor_manager_get_n_processed (MxActorManager *manager);
+guint mx_actor_manager_get_n_overruns  (MxActorManager *manager);
+
 G_END_DECLS
 
 #endif /* _MX_ACTOR_MANAGER_H */
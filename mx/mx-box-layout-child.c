@@ -113,7 +113,7 @@ mx_box_layout_child_set_property (GObject      *object,
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
     }
 
-  clutter_actor_queue_relayout ((ClutterActor*) box);
+  _mx_box_layout_child_changed (box, CLUTTER_CHILD_META (object)->actor);
 }
 
 static void
@@ -249,7 +249,7 @@ mx_box_layout_child_set_expand (MxBoxLayout  *box_layout,
 
   meta->expand = expand;
 
-  clutter_actor_queue_relayout (child);
+  _mx_box_layout_child_changed (box_layout, child);
 }
 
 /**
@@ -298,7 +298,7 @@ mx_box_layout_child_set_x_fill (MxBoxLayout  *box_layout,
 
   meta->x_fill = x_fill;
 
-  clutter_actor_queue_relayout (child);
+  _mx_box_layout_child_changed (box_layout, child);
 }
 
 /**
@@ -347,7 +347,7 @@ mx_box_layout_child_set_y_fill (MxBoxLayout  *box_layout,
 
   meta->y_fill = y_fill;
 
-  clutter_actor_queue_relayout (child);
+  _mx_box_layout_child_changed (box_layout, child);
 }
 
 /**
@@ -396,7 +396,7 @@ mx_box_layout_child_set_x_align (MxBoxLayout  *box_layout,
 
   meta->x_align = x_align;
 
-  clutter_actor_queue_relayout (child);
+  _mx_box_layout_child_changed (box_layout, child);
 }
 
 /**
@@ -445,6 +445,6 @@ mx_box_layout_child_set_y_align (MxBoxLayout  *box_layout,
 
   meta->y_align = y_align;
 
-  clutter_actor_queue_relayout (child);
+  _mx_box_layout_child_changed (box_layout, child);
 }
 
@@ -56,6 +56,7 @@
 #include "mx-box-layout.h"
 
 #include "mx-private.h"
+#include "mx-widget-private.h"
 #include "mx-scrollable.h"
 #include "mx-box-layout-child.h"
 #include "mx-focusable.h"
@@ -102,7 +103,6 @@ struct _MxBoxLayoutPrivate
   MxAdjustment *hadjustment;
   MxAdjustment *vadjustment;
 
-  GHashTable      *start_allocations;
   ClutterTimeline *timeline;
   guint            is_animating : 1;
   guint            enable_animations : 1;
@@ -111,8 +111,64 @@ struct _MxBoxLayoutPrivate
   MxOrientation orientation;
 
   MxFocusable *last_focus;
+
+  /* visible children in layout order, with their cached size requests
+   * and allocations */
+  GArray       *children;
+  guint         children_valid : 1;
+  guint         in_order : 1;  /* allocated in order along the layout axis */
+  guint         allocated : 1; /* last_* hold the last allocation inputs */
+  guint         first_changed; /* G_MAXUINT when no child has changed */
+
+  gfloat        last_width;
+  gfloat        last_height;
+  MxPadding     last_padding;
+  guint         last_spacing;
+  gfloat        last_content_start;
+
+  /* see _mx_box_layout_set_content_range() */
+  gfloat        content_start;
+  gfloat        content_size;
 };
 
+typedef struct
+{
+  ClutterActor     *child;
+  MxBoxLayoutChild *meta;
+
+  /* size request along the layout axis, for the size across it */
+  gfloat            for_size;
+  gfloat            min_size;
+  gfloat            pref_size;
+
+  /* size request across the layout axis */
+  gfloat            cross_min_size;
+  gfloat            cross_pref_size;
+
+  /* space given to the child along the layout axis */
+  gfloat            slot_start;
+  gfloat            slot_size;
+
+  /* where the child was allocated along the layout axis */
+  gfloat            start;
+  gfloat            end;
+
+  ClutterActorBox   box;
+  ClutterActorBox   start_box;
+
+  guint             size_valid : 1;
+  guint             cross_size_valid : 1;
+  guint             changed : 1;
+  guint             has_start_box : 1;
+  guint             allocate : 1;
+  guint             skip : 1;
+} MxBoxLayoutChildInfo;
+
+static GQuark child_index_quark = 0;
+
+static void mx_box_layout_child_queue_relayout_cb (ClutterActor *child,
+                                                   MxBoxLayout  *box);
+
 void _mx_box_layout_finish_animation (MxBoxLayout *box);
 
 void
@@ -214,6 +270,43 @@ scrollable_set_adjustments (MxScrollable *scrollable,
       priv->vadjustment = vadjustment;
       g_object_notify (G_OBJECT (scrollable), "vertical-adjustment");
     }
+
+  _mx_widget_set_scroll_adjustments (MX_WIDGET (scrollable),
+                                     priv->hadjustment, priv->vadjustment);
+}
+
+/* unlike mx_scrollable_get_adjustments(), doesn't create an adjustment if
+ * there is none */
+MxAdjustment *
+_mx_box_layout_get_vadjustment (MxBoxLayout *box)
+{
+  return box->priv->vadjustment;
+}
+
+/*
+ * _mx_box_layout_set_content_range:
+ * @box: An #MxBoxLayout
+ * @start: where the first child starts along the orientation of @box
+ * @size: the size of the whole content along the orientation of @box, or
+ *   a negative value to use the size of the children
+ *
+ * For subclasses that only have children for the part of their content in
+ * view, such as a virtualized #MxListView. The children are laid out one
+ * after the other from @start, and the adjustments cover @size. Call it
+ * before chaining up to the allocation.
+ */
+void
+_mx_box_layout_set_content_range (MxBoxLayout *box,
+                                  gfloat       start,
+                                  gfloat       size)
+{
+  MxBoxLayoutPrivate *priv = box->priv;
+
+  if (size < 0)
+    start = 0;
+
+  priv->content_start = start;
+  priv->content_size = size;
 }
 
 static void
@@ -301,6 +394,12 @@ mx_box_container_actor_added (ClutterContainer *container,
 {
   MxBoxLayoutPrivate *priv = MX_BOX_LAYOUT (container)->priv;
 
+  priv->children_valid = FALSE;
+
+  g_signal_connect (actor, "queue-relayout",
+                    G_CALLBACK (mx_box_layout_child_queue_relayout_cb),
+                    container);
+
   if (priv->enable_animations)
     {
       _mx_box_layout_start_animation (MX_BOX_LAYOUT (container));
@@ -323,6 +422,13 @@ mx_box_container_actor_removed (ClutterContainer *container,
 
   g_object_ref (actor);
 
+  priv->children_valid = FALSE;
+
+  g_signal_handlers_disconnect_by_func (actor,
+                                        mx_box_layout_child_queue_relayout_cb,
+                                        container);
+  g_object_set_qdata (G_OBJECT (actor), child_index_quark, NULL);
+
   if ((ClutterActor *)priv->last_focus == actor)
     priv->last_focus = NULL;
 
@@ -392,23 +498,88 @@ update_adjustments (MxBoxLayout *self,
     }
 }
 
+/* Finds the index of @child in the laid out children, or -1 */
+static gint
+mx_box_layout_find_child (MxBoxLayout  *box,
+                          ClutterActor *child)
+{
+  MxBoxLayoutPrivate *priv = box->priv;
+  guint index;
+
+  if (!priv->children_valid || !CLUTTER_ACTOR_IS_VISIBLE (child))
+    return -1;
+
+  /* the index is stored off by one, so that 0 means unset */
+  index = GPOINTER_TO_UINT (g_object_get_qdata (G_OBJECT (child),
+                                                child_index_quark));
+  if (index-- == 0 || index >= priv->children->len ||
+      g_array_index (priv->children, MxBoxLayoutChildInfo, index).child != child)
+    return -1;
+
+  return index;
+}
+
+static MxFocusable*
+mx_box_layout_move_focus_in_children (MxBoxLayout      *box,
+                                      MxFocusDirection  direction,
+                                      MxFocusHint       hint,
+                                      gint              index)
+{
+  MxBoxLayoutPrivate *priv = box->priv;
+  gint step, i;
+
+  if (direction == MX_FOCUS_DIRECTION_NEXT)
+    step = 1;
+  else if (direction == MX_FOCUS_DIRECTION_PREVIOUS)
+    step = -1;
+  else
+    return NULL;
+
+  for (i = index + step; i >= 0 && i < (gint) priv->children->len; i += step)
+    {
+      ClutterActor *child =
+        g_array_index (priv->children, MxBoxLayoutChildInfo, i).child;
+
+      if (MX_IS_FOCUSABLE (child))
+        {
+          MxFocusable *focused =
+            mx_focusable_accept_focus (MX_FOCUSABLE (child), hint);
+
+          if (focused)
+            {
+              update_adjustments (box, MX_FOCUSABLE (child));
+              return focused;
+            }
+        }
+    }
+
+  return NULL;
+}
+
 static MxFocusable*
 mx_box_layout_move_focus (MxFocusable      *focusable,
                           MxFocusDirection  direction,
                           MxFocusable      *from)
 {
   MxBoxLayoutPrivate *priv = MX_BOX_LAYOUT (focusable)->priv;
-  GList *l, *childlink, *children;
+  GList *l, *childlink, *children = NULL;
   MxFocusHint hint;
   MxFocusable *focused = NULL;
+  gint index;
 
+  /* the index of laid out children saves walking the list of children */
+  index = mx_box_layout_find_child (MX_BOX_LAYOUT (focusable),
+                                    CLUTTER_ACTOR (from));
 
   /* find the current focus */
-  children = clutter_actor_get_children (CLUTTER_ACTOR (focusable));
-  childlink = g_list_find (children, from);
+  if (index < 0)
+    {
+      children = clutter_actor_get_children (CLUTTER_ACTOR (focusable));
+      childlink = g_list_find (children, from);
 
-  if (!childlink)
-    goto out;
+      if (!childlink)
+        goto out;
+    }
 
   priv->last_focus = from;
 
@@ -430,6 +601,10 @@ mx_box_layout_move_focus (MxFocusable      *focusable,
         direction = MX_FOCUS_DIRECTION_NEXT;
     }
 
+  if (index >= 0)
+    return mx_box_layout_move_focus_in_children (MX_BOX_LAYOUT (focusable),
+                                                 direction, hint, index);
+
   /* find the next widget to focus */
   if (direction == MX_FOCUS_DIRECTION_NEXT)
     {
@@ -687,13 +862,207 @@ mx_box_layout_finalize (GObject *object)
 {
   MxBoxLayoutPrivate *priv = MX_BOX_LAYOUT (object)->priv;
 
-  if (priv->start_allocations)
+  g_array_free (priv->children, TRUE);
+
+  G_OBJECT_CLASS (mx_box_layout_parent_class)->finalize (object);
+}
+
+static void
+mx_box_layout_child_queue_relayout_cb (ClutterActor *child,
+                                       MxBoxLayout  *box)
+{
+  MxBoxLayoutPrivate *priv = box->priv;
+  MxBoxLayoutChildInfo *info;
+  guint index;
+
+  /* the index is stored off by one, so that 0 means unset */
+  index = GPOINTER_TO_UINT (g_object_get_qdata (G_OBJECT (child),
+                                                child_index_quark));
+  if (index-- == 0 || index >= priv->children->len)
+    return;
+
+  info = &g_array_index (priv->children, MxBoxLayoutChildInfo, index);
+  if (info->child != child)
+    return;
+
+  info->size_valid = FALSE;
+  info->cross_size_valid = FALSE;
+  info->changed = TRUE;
+
+  priv->first_changed = MIN (priv->first_changed, index);
+}
+
+/*
+ * Called when the packing properties of @child change. They don't affect
+ * the size it requests, so its cached sizes are kept, and the relayout is
+ * queued on the box, as the child itself doesn't need one.
+ */
+void
+_mx_box_layout_child_changed (MxBoxLayout  *box,
+                              ClutterActor *child)
+{
+  MxBoxLayoutPrivate *priv = box->priv;
+  guint index;
+
+  index = GPOINTER_TO_UINT (g_object_get_qdata (G_OBJECT (child),
+                                                child_index_quark));
+  if (index-- > 0 && index < priv->children->len &&
+      g_array_index (priv->children, MxBoxLayoutChildInfo,
+                     index).child == child)
     {
-      g_hash_table_destroy (priv->start_allocations);
-      priv->start_allocations = NULL;
+      g_array_index (priv->children, MxBoxLayoutChildInfo,
+                     index).changed = TRUE;
+      priv->first_changed = MIN (priv->first_changed, index);
     }
 
-  G_OBJECT_CLASS (mx_box_layout_parent_class)->finalize (object);
+  clutter_actor_queue_relayout (CLUTTER_ACTOR (box));
+}
+
+/*
+ * Makes sure the array of child information matches the visible children,
+ * in order. Cached size requests and allocations are kept for the children
+ * that were there before.
+ */
+static void
+mx_box_layout_update_children (MxBoxLayout *box)
+{
+  MxBoxLayoutPrivate *priv = box->priv;
+  ClutterActor *actor = CLUTTER_ACTOR (box);
+  GArray *old_children;
+  ClutterActorIter iter;
+  ClutterActor *child;
+  guint i;
+
+  if (priv->children_valid)
+    {
+      gboolean matches = TRUE;
+
+      i = 0;
+      clutter_actor_iter_init (&iter, actor);
+      while (clutter_actor_iter_next (&iter, &child))
+        {
+          if (!CLUTTER_ACTOR_IS_VISIBLE (child))
+            continue;
+
+          if (i >= priv->children->len ||
+              g_array_index (priv->children, MxBoxLayoutChildInfo,
+                             i).child != child)
+            {
+              matches = FALSE;
+              break;
+            }
+
+          i++;
+        }
+
+      if (matches && i == priv->children->len)
+        return;
+    }
+
+  old_children = priv->children;
+  priv->children = g_array_sized_new (FALSE, FALSE,
+                                      sizeof (MxBoxLayoutChildInfo),
+                                      clutter_actor_get_n_children (actor));
+
+  clutter_actor_iter_init (&iter, actor);
+  while (clutter_actor_iter_next (&iter, &child))
+    {
+      MxBoxLayoutChildInfo info;
+      guint old_index;
+
+      if (!CLUTTER_ACTOR_IS_VISIBLE (child))
+        {
+          g_object_set_qdata (G_OBJECT (child), child_index_quark, NULL);
+          continue;
+        }
+
+      old_index = GPOINTER_TO_UINT (g_object_get_qdata (G_OBJECT (child),
+                                                        child_index_quark));
+
+      if (old_index > 0 && old_index <= old_children->len &&
+          g_array_index (old_children, MxBoxLayoutChildInfo,
+                         old_index - 1).child == child)
+        {
+          info = g_array_index (old_children, MxBoxLayoutChildInfo,
+                                old_index - 1);
+        }
+      else
+        {
+          memset (&info, 0, sizeof (info));
+          info.child = child;
+          info.meta = (MxBoxLayoutChild *)
+            clutter_container_get_child_meta ((ClutterContainer *) box,
+                                              child);
+          info.changed = TRUE;
+        }
+
+      g_array_append_val (priv->children, info);
+      g_object_set_qdata (G_OBJECT (child), child_index_quark,
+                          GUINT_TO_POINTER (priv->children->len));
+    }
+
+  g_array_free (old_children, TRUE);
+
+  priv->children_valid = TRUE;
+  priv->first_changed = 0;
+}
+
+/* size request along the layout axis, for the given size across it */
+static void
+mx_box_layout_child_info_measure (MxBoxLayout          *box,
+                                  MxBoxLayoutChildInfo *info,
+                                  gfloat                for_size)
+{
+  if (info->size_valid && info->for_size == for_size)
+    return;
+
+  if (box->priv->orientation == MX_ORIENTATION_VERTICAL)
+    clutter_actor_get_preferred_height (info->child, for_size,
+                                        &info->min_size, &info->pref_size);
+  else
+    clutter_actor_get_preferred_width (info->child, for_size,
+                                       &info->min_size, &info->pref_size);
+
+  info->for_size = for_size;
+  info->size_valid = TRUE;
+}
+
+/* size request across the layout axis */
+static void
+mx_box_layout_child_info_measure_cross (MxBoxLayout          *box,
+                                        MxBoxLayoutChildInfo *info)
+{
+  if (info->cross_size_valid)
+    return;
+
+  if (box->priv->orientation == MX_ORIENTATION_VERTICAL)
+    clutter_actor_get_preferred_width (info->child, -1,
+                                       &info->cross_min_size,
+                                       &info->cross_pref_size);
+  else
+    clutter_actor_get_preferred_height (info->child, -1,
+                                        &info->cross_min_size,
+                                        &info->cross_pref_size);
+
+  info->cross_size_valid = TRUE;
+}
+
+static void
+mx_box_layout_invalidate_sizes (MxBoxLayout *box)
+{
+  MxBoxLayoutPrivate *priv = box->priv;
+  guint i;
+
+  for (i = 0; i < priv->children->len; i++)
+    {
+      MxBoxLayoutChildInfo *info =
+        &g_array_index (priv->children, MxBoxLayoutChildInfo, i);
+
+      info->size_valid = FALSE;
+      info->cross_size_valid = FALSE;
+    }
+
+  priv->first_changed = 0;
 }
 
 static void
@@ -702,11 +1071,13 @@ mx_box_layout_get_preferred_width (ClutterActor *actor,
                                    gfloat       *min_width_p,
                                    gfloat       *natural_width_p)
 {
-  MxBoxLayoutPrivate *priv = MX_BOX_LAYOUT (actor)->priv;
+  MxBoxLayout *box = MX_BOX_LAYOUT (actor);
+  MxBoxLayoutPrivate *priv = box->priv;
   MxPadding padding = { 0, };
-  gint n_children = 0;
-  ClutterActorIter iter;
-  ClutterActor *child;
+  gint n_children;
+  guint i;
+
+  MX_PROFILE_BEGIN (actor, PREFERRED_SIZE);
 
   mx_widget_get_padding (MX_WIDGET (actor), &padding);
 
@@ -719,42 +1090,33 @@ mx_box_layout_get_preferred_width (ClutterActor *actor,
   if (for_height > 0)
     for_height = MAX (0, for_height - padding.top - padding.bottom);
 
-  clutter_actor_iter_init (&iter, actor);
-  while (clutter_actor_iter_next (&iter, &child))
-    {
-      gfloat child_min = 0, child_nat = 0;
-      gfloat child_for_height;
+  mx_box_layout_update_children (box);
+  n_children = priv->children->len;
 
-      if (!CLUTTER_ACTOR_IS_VISIBLE (child))
-        continue;
-
-      n_children++;
-
-      if (priv->orientation == MX_ORIENTATION_HORIZONTAL)
-        child_for_height = for_height;
-      else
-        child_for_height = -1;
-
-      clutter_actor_get_preferred_width (child,
-                                         child_for_height,
-                                         &child_min,
-                                         &child_nat);
+  for (i = 0; i < priv->children->len; i++)
+    {
+      MxBoxLayoutChildInfo *info =
+        &g_array_index (priv->children, MxBoxLayoutChildInfo, i);
 
       if (priv->orientation == MX_ORIENTATION_VERTICAL)
         {
+          mx_box_layout_child_info_measure_cross (box, info);
+
           if (min_width_p)
-            *min_width_p = MAX (child_min, *min_width_p);
+            *min_width_p = MAX (info->cross_min_size, *min_width_p);
 
           if (natural_width_p)
-            *natural_width_p = MAX (child_nat, *natural_width_p);
+            *natural_width_p = MAX (info->cross_pref_size, *natural_width_p);
         }
       else
         {
+          mx_box_layout_child_info_measure (box, info, for_height);
+
           if (min_width_p)
-            *min_width_p += child_min;
+            *min_width_p += info->min_size;
 
           if (natural_width_p)
-            *natural_width_p += child_nat;
+            *natural_width_p += info->pref_size;
 
         }
     }
@@ -774,6 +1136,8 @@ mx_box_layout_get_preferred_width (ClutterActor *actor,
 
   if (natural_width_p)
     *natural_width_p += padding.left + padding.right;
+
+  MX_PROFILE_END (actor, PREFERRED_SIZE);
 }
 
 static void
@@ -782,14 +1146,15 @@ mx_box_layout_get_preferred_height (ClutterActor *actor,
                                     gfloat       *min_height_p,
                                     gfloat       *natural_height_p)
 {
-  MxBoxLayoutPrivate *priv = MX_BOX_LAYOUT (actor)->priv;
+  MxBoxLayout *box = MX_BOX_LAYOUT (actor);
+  MxBoxLayoutPrivate *priv = box->priv;
   MxPadding padding = { 0, };
-  gint n_children = 0;
-  ClutterActor *child;
-  ClutterActorIter iter;
+  gint n_children;
+  guint i;
 
-  mx_widget_get_padding (MX_WIDGET (actor), &padding);
+  MX_PROFILE_BEGIN (actor, PREFERRED_SIZE);
 
+  mx_widget_get_padding (MX_WIDGET (actor), &padding);
 
   if (min_height_p)
     *min_height_p = 0;
@@ -800,43 +1165,34 @@ mx_box_layout_get_preferred_height (ClutterActor *actor,
   if (for_width > 0)
     for_width = MAX (0, for_width - padding.left - padding.right);
 
+  mx_box_layout_update_children (box);
+  n_children = priv->children->len;
 
-  clutter_actor_iter_init (&iter, actor);
-  while (clutter_actor_iter_next (&iter, &child))
+  for (i = 0; i < priv->children->len; i++)
     {
-      gfloat child_min = 0, child_nat = 0;
-      gfloat child_for_width;
-
-      if (!CLUTTER_ACTOR_IS_VISIBLE (child))
-        continue;
-
-      n_children++;
-
-      if (priv->orientation == MX_ORIENTATION_VERTICAL)
-        child_for_width = for_width;
-      else
-        child_for_width = -1;
-
-      clutter_actor_get_preferred_height (child,
-                                          child_for_width,
-                                          &child_min,
-                                          &child_nat);
+      MxBoxLayoutChildInfo *info =
+        &g_array_index (priv->children, MxBoxLayoutChildInfo, i);
 
       if (priv->orientation == MX_ORIENTATION_HORIZONTAL)
         {
+          mx_box_layout_child_info_measure_cross (box, info);
+
           if (min_height_p)
-            *min_height_p = MAX (child_min, *min_height_p);
+            *min_height_p = MAX (info->cross_min_size, *min_height_p);
 
           if (natural_height_p)
-            *natural_height_p = MAX (child_nat, *natural_height_p);
+            *natural_height_p = MAX (info->cross_pref_size,
+                                     *natural_height_p);
         }
       else
         {
+          mx_box_layout_child_info_measure (box, info, for_width);
+
           if (min_height_p)
-            *min_height_p += child_min;
+            *min_height_p += info->min_size;
 
           if (natural_height_p)
-            *natural_height_p += child_nat;
+            *natural_height_p += info->pref_size;
         }
     }
 
@@ -854,6 +1210,8 @@ mx_box_layout_get_preferred_height (ClutterActor *actor,
 
   if (natural_height_p)
     *natural_height_p += padding.top + padding.bottom;
+
+  MX_PROFILE_END (actor, PREFERRED_SIZE);
 }
 
 static void
@@ -935,89 +1293,49 @@ mx_box_layout_update_adjustments (ClutterActor *actor,
 }
 
 
-typedef struct
-{
-  ClutterActor *child;
-  gfloat pref_size;
-  gfloat min_size;
-  ClutterActorBox *box;
-  gboolean skip;
-} MxBoxLayoutChildInfo;
-
-
-static void
-mx_box_layout_child_info_free (MxBoxLayoutChildInfo *info)
-{
-  clutter_actor_box_free (info->box);
-  g_slice_free (MxBoxLayoutChildInfo, info);
-}
-
-static MxBoxLayoutChildInfo*
-mx_box_layout_child_info_new (ClutterActor          *child,
-                              gfloat                 pref_size,
-                              gfloat                 min_size,
-                              const ClutterActorBox *box)
-{
-  MxBoxLayoutChildInfo *info;
-
-  info = g_slice_new (MxBoxLayoutChildInfo);
-
-  info->child = child;
-  info->pref_size = pref_size;
-  info->min_size = min_size;
-  info->box = clutter_actor_box_copy (box);
-  info->skip = FALSE;
-
-  return info;
-}
-
 static void
 mx_box_layout_allocate (ClutterActor          *actor,
                         const ClutterActorBox *box,
                         ClutterAllocationFlags flags)
 {
-  MxBoxLayoutPrivate *priv = MX_BOX_LAYOUT (actor)->priv;
+  MxBoxLayout *layout = MX_BOX_LAYOUT (actor);
+  MxBoxLayoutPrivate *priv = layout->priv;
   gfloat avail_width, avail_height, pref_width, pref_height;
   MxPadding padding = { 0, };
-  gboolean allocate_pref;
+  gboolean allocate_pref, incremental;
   gfloat extra_space = 0;
   gfloat position = 0;
   gfloat actual_size = 0;
-  ClutterActor *child;
-  ClutterActorIter iter;
+  gfloat for_size;
   gint n_expand_children, n_children;
-  GList *boxes = NULL, *l;
+  guint i, start;
+
+  MX_PROFILE_BEGIN (actor, ALLOCATE);
 
   CLUTTER_ACTOR_CLASS (mx_box_layout_parent_class)->allocate (actor, box,
                                                               flags);
 
-  if (clutter_actor_get_n_children (actor) == 0)
-    return;
+  priv->in_order = FALSE;
+
+  mx_box_layout_update_children (layout);
 
   /* count the number of children with expand set to TRUE and the
    * amount of visible children.
    */
-  n_children = n_expand_children = 0;
-  clutter_actor_iter_init (&iter, actor);
-  while (clutter_actor_iter_next (&iter, &child))
+  n_children = priv->children->len;
+  n_expand_children = 0;
+  for (i = 0; i < priv->children->len; i++)
     {
-      if (CLUTTER_ACTOR_IS_VISIBLE (child))
-        {
-          MxBoxLayoutChild *meta;
-
-          meta = (MxBoxLayoutChild*)
-            clutter_container_get_child_meta ((ClutterContainer *) actor,
-                                              child);
-          n_children++;
-
-          if (meta->expand)
-            n_expand_children++;
-        }
+      if (g_array_index (priv->children, MxBoxLayoutChildInfo, i).meta->expand)
+        n_expand_children++;
     }
 
   /* We have no visible children, so bail out */
   if (n_children == 0)
-    return;
+    {
+      MX_PROFILE_END (actor, ALLOCATE);
+      return;
+    }
 
   mx_widget_get_padding (MX_WIDGET (actor), &padding);
 
@@ -1033,7 +1351,14 @@ mx_box_layout_allocate (ClutterActor          *actor,
                                           &min_height, &pref_height);
       pref_width = avail_width;
 
-      if (!priv->vadjustment && (pref_height > box->y2 - box->y1))
+      if (priv->content_size >= 0)
+        {
+          /* the children are only part of the content, which is never
+           * shrunk */
+          pref_height = priv->content_size + padding.top + padding.bottom;
+          allocate_pref = TRUE;
+        }
+      else if (!priv->vadjustment && (pref_height > box->y2 - box->y1))
         {
           /* allocated less than the preferred height and not scrolling */
           allocate_pref = FALSE;
@@ -1049,7 +1374,12 @@ mx_box_layout_allocate (ClutterActor          *actor,
                                          &min_width, &pref_width);
       pref_height = avail_height;
 
-      if (!priv->hadjustment && (pref_width > box->x2 - box->x1))
+      if (priv->content_size >= 0)
+        {
+          pref_width = priv->content_size + padding.left + padding.right;
+          allocate_pref = TRUE;
+        }
+      else if (!priv->hadjustment && (pref_width > box->x2 - box->x1))
         {
           /* allocated less than the preferred width and not scrolling */
           allocate_pref = FALSE;
@@ -1087,29 +1417,74 @@ mx_box_layout_allocate (ClutterActor          *actor,
         extra_space = 0;
     }
 
+  /* If only some children changed since the last allocation, and nothing
+   * else that affects their positions did, the children before the first
+   * one that changed stay where they are, as do the following ones that
+   * haven't changed or moved. Expanded children and shrinking depend on the
+   * size of every child, so they always need a full layout.
+   */
+  incremental = (priv->allocated &&
+                 !priv->is_animating &&
+                 allocate_pref &&
+                 n_expand_children == 0 &&
+                 !(flags & CLUTTER_ABSOLUTE_ORIGIN_CHANGED) &&
+                 priv->last_width == avail_width &&
+                 priv->last_height == avail_height &&
+                 priv->last_padding.left == padding.left &&
+                 priv->last_padding.top == padding.top &&
+                 priv->last_spacing == priv->spacing &&
+                 priv->last_content_start == priv->content_start);
+
+  start = incremental ? MIN (priv->first_changed, priv->children->len) : 0;
+
+  /* children that queue a relayout while being allocated mark themselves
+   * again for the next allocation */
+  priv->first_changed = G_MAXUINT;
+
   if (priv->orientation == MX_ORIENTATION_VERTICAL)
-    position = padding.top;
+    {
+      position = padding.top + priv->content_start;
+      for_size = avail_width;
+    }
   else
-    position = padding.left;
+    {
+      position = padding.left + priv->content_start;
+      for_size = avail_height;
+    }
 
-  clutter_actor_iter_init (&iter, actor);
-  while (clutter_actor_iter_next (&iter, &child))
+  if (start > 0)
+    {
+      MxBoxLayoutChildInfo *prev =
+        &g_array_index (priv->children, MxBoxLayoutChildInfo, start - 1);
+
+      position = prev->slot_start + prev->slot_size + priv->spacing;
+    }
+
+  for (i = start; i < priv->children->len; i++)
     {
+      MxBoxLayoutChildInfo *info =
+        &g_array_index (priv->children, MxBoxLayoutChildInfo, i);
       ClutterActorBox child_box, old_child_box;
-      gfloat child_nat, child_min;
-      MxBoxLayoutChild *meta;
+      MxBoxLayoutChild *meta = info->meta;
+      gfloat child_nat;
 
-      if (!CLUTTER_ACTOR_IS_VISIBLE (child))
-        continue;
+      info->skip = FALSE;
 
-      meta = (MxBoxLayoutChild*)
-        clutter_container_get_child_meta ((ClutterContainer *) actor, child);
+      if (incremental && !info->changed && info->slot_start == position)
+        {
+          info->allocate = FALSE;
+          position += info->slot_size + priv->spacing;
+          continue;
+        }
+
+      info->changed = FALSE;
+      info->allocate = TRUE;
+
+      mx_box_layout_child_info_measure (layout, info, for_size);
+      child_nat = info->pref_size;
 
       if (priv->orientation == MX_ORIENTATION_VERTICAL)
         {
-          clutter_actor_get_preferred_height (child, avail_width,
-                                              &child_min, &child_nat);
-
           child_box.y1 = position;
 
           if (allocate_pref && meta->expand)
@@ -1122,9 +1497,6 @@ mx_box_layout_allocate (ClutterActor          *actor,
         }
       else
         {
-          clutter_actor_get_preferred_width (child, avail_height,
-                                             &child_min, &child_nat);
-
           child_box.x1 = position;
 
           if (allocate_pref && meta->expand)
@@ -1141,68 +1513,52 @@ mx_box_layout_allocate (ClutterActor          *actor,
 
       /* Adjust the box for alignment/fill */
       old_child_box = child_box;
-      mx_allocate_align_fill (child, &child_box, meta->x_align, meta->y_align,
+      mx_allocate_align_fill (info->child, &child_box,
+                              meta->x_align, meta->y_align,
                               meta->x_fill, meta->y_fill);
 
       if (priv->is_animating)
         {
-          ClutterActorBox *start, *end, now;
+          ClutterActorBox *start_box, *end;
           gdouble alpha;
 
-          start = g_hash_table_lookup (priv->start_allocations, child);
+          start_box = &info->start_box;
           end = &child_box;
           alpha = clutter_timeline_get_progress (priv->timeline);
 
-          if (!start)
+          if (!info->has_start_box)
             {
               /* don't know where this actor was from (possibly recently
                * added), so just allocate the end co-ordinates */
-              boxes = g_list_prepend (boxes,
-                                      mx_box_layout_child_info_new (child,
-                                                                    child_nat,
-                                                                    child_min,
-                                                                    end));
-              goto next;
-            }
-
-          now.x1 = (int) (start->x1 + (end->x1 - start->x1) * alpha);
-          now.x2 = (int) (start->x2 + (end->x2 - start->x2) * alpha);
-          now.y1 = (int) (start->y1 + (end->y1 - start->y1) * alpha);
-          now.y2 = (int) (start->y2 + (end->y2 - start->y2) * alpha);
-
-          boxes = g_list_prepend (boxes,
-                                  mx_box_layout_child_info_new (child,
-                                                                child_nat,
-                                                                child_min,
-                                                                &now));
-        }
-      else
-        {
-          /* store the allocations in case an animation is needed soon */
-          ClutterActorBox *copy;
-
-          /* update the value in the hash table */
-          if (priv->enable_animations)
-            {
-              copy = g_boxed_copy (CLUTTER_TYPE_ACTOR_BOX, &child_box);
-              g_hash_table_insert (priv->start_allocations, child, copy);
+              info->box = *end;
             }
           else
             {
-              copy = &child_box;
+              info->box.x1 = (int) (start_box->x1 +
+                                    (end->x1 - start_box->x1) * alpha);
+              info->box.x2 = (int) (start_box->x2 +
+                                    (end->x2 - start_box->x2) * alpha);
+              info->box.y1 = (int) (start_box->y1 +
+                                    (end->y1 - start_box->y1) * alpha);
+              info->box.y2 = (int) (start_box->y2 +
+                                    (end->y2 - start_box->y2) * alpha);
             }
-
-          boxes = g_list_prepend (boxes,
-                                  mx_box_layout_child_info_new (child,
-                                                                child_nat,
-                                                                child_min,
-                                                                copy));
         }
-next:
+      else
+        {
+          /* store the allocation in case an animation is needed soon */
+          info->box = child_box;
+          info->start_box = child_box;
+          info->has_start_box = TRUE;
+        }
+
+      info->slot_start = position;
       if (priv->orientation == MX_ORIENTATION_VERTICAL)
-        position += (old_child_box.y2 - old_child_box.y1) + priv->spacing;
+        info->slot_size = old_child_box.y2 - old_child_box.y1;
       else
-        position += (old_child_box.x2 - old_child_box.x1) + priv->spacing;
+        info->slot_size = old_child_box.x2 - old_child_box.x1;
+
+      position += info->slot_size + priv->spacing;
     }
 
   actual_size += priv->spacing * (n_children - 1);
@@ -1212,10 +1568,6 @@ next:
     {
       gint n_children_remaining;
 
-      /* elements in the boxes list are prepended when added, so the last item
-       * is the first child */
-      GList *start_at = g_list_last (boxes);
-
       /* target is avail_size, current size is actual_size */
       gfloat avail_size;
 
@@ -1226,7 +1578,7 @@ next:
 
 
       /* the number of children that are still able to be reduced in size */
-      n_children_remaining = g_list_length (boxes);
+      n_children_remaining = priv->children->len;
 
 
       while (actual_size > avail_size && n_children_remaining > 0)
@@ -1235,14 +1587,15 @@ next:
 
           /* iterate over the children, reducing the size of those that can be
            * reduced and repositions the next actor to accommodate */
-          for (l = start_at; l; l = g_list_previous (l))
+          for (i = 0; i < priv->children->len; i++)
             {
-              MxBoxLayoutChildInfo *info = l->data;
+              MxBoxLayoutChildInfo *info =
+                &g_array_index (priv->children, MxBoxLayoutChildInfo, i);
 
               if (priv->orientation == MX_ORIENTATION_HORIZONTAL)
                 {
-                  info->box->x2 += new_pos;
-                  info->box->x1 += new_pos;
+                  info->box.x2 += new_pos;
+                  info->box.x1 += new_pos;
 
                   if (info->skip)
                     continue;
@@ -1253,10 +1606,10 @@ next:
                   if (actual_size <= avail_size)
                     continue;
 
-                  if (info->box->x2 - info->box->x1 > info->min_size)
+                  if (info->box.x2 - info->box.x1 > info->min_size)
                     {
                       actual_size--;
-                      info->box->x2--;
+                      info->box.x2--;
                       new_pos--;
                     }
                   else
@@ -1267,8 +1620,8 @@ next:
                 }
               else /* orientation == MX_ORIENTATION_VERTICAL */
                 {
-                  info->box->y2 += new_pos;
-                  info->box->y1 += new_pos;
+                  info->box.y2 += new_pos;
+                  info->box.y1 += new_pos;
 
                   if (info->skip)
                     continue;
@@ -1279,10 +1632,10 @@ next:
                   if (actual_size <= avail_size)
                     continue;
 
-                  if (info->box->y2 - info->box->y1 > info->min_size)
+                  if (info->box.y2 - info->box.y1 > info->min_size)
                     {
                       actual_size--;
-                      info->box->y2--;
+                      info->box.y2--;
                       new_pos--;
                     }
                   else
@@ -1296,14 +1649,41 @@ next:
     }
 
   /* finally, allocate the children */
-  for (l = boxes; l; l = g_list_next (l))
+  for (i = start; i < priv->children->len; i++)
     {
-      MxBoxLayoutChildInfo *info = l->data;
+      MxBoxLayoutChildInfo *info =
+        &g_array_index (priv->children, MxBoxLayoutChildInfo, i);
+
+      if (!info->allocate)
+        continue;
+
+      clutter_actor_allocate (info->child, &info->box, flags);
 
-      clutter_actor_allocate (info->child, info->box, flags);
+      if (priv->orientation == MX_ORIENTATION_VERTICAL)
+        {
+          info->start = info->box.y1;
+          info->end = info->box.y2;
+        }
+      else
+        {
+          info->start = info->box.x1;
+          info->end = info->box.x2;
+        }
     }
 
-  g_list_free_full (boxes, (GDestroyNotify) mx_box_layout_child_info_free);
+  /* Children are in order along the layout axis except while animating, so
+   * the ones in view can be found quickly when painting.
+   */
+  priv->in_order = !priv->is_animating;
+
+  priv->allocated = !priv->is_animating;
+  priv->last_width = avail_width;
+  priv->last_height = avail_height;
+  priv->last_padding = padding;
+  priv->last_spacing = priv->spacing;
+  priv->last_content_start = priv->content_start;
+
+  MX_PROFILE_END (actor, ALLOCATE);
 }
 
 static void
@@ -1328,126 +1708,137 @@ mx_box_layout_apply_transform (ClutterActor *a,
   cogl_matrix_translate (m, (int) -x, (int) -y, 0);
 }
 
+/* Finds the range of allocated children that overlap @view along the layout
+ * axis, by binary search. */
 static gboolean
-mx_box_layout_get_paint_volume (ClutterActor       *actor,
-                                ClutterPaintVolume *volume)
+mx_box_layout_get_children_in_view (MxBoxLayout           *box,
+                                    const ClutterActorBox *view,
+                                    guint                 *first,
+                                    guint                 *last)
 {
-  MxBoxLayoutPrivate *priv = MX_BOX_LAYOUT (actor)->priv;
-  ClutterVertex vertex;
+  MxBoxLayoutPrivate *priv = box->priv;
+  gfloat view_start, view_end;
+  guint low, high;
 
-  if (!clutter_paint_volume_set_from_allocation (volume, actor))
+  if (!priv->children_valid || !priv->in_order)
     return FALSE;
 
-  clutter_paint_volume_get_origin (volume, &vertex);
+  if (priv->orientation == MX_ORIENTATION_VERTICAL)
+    {
+      view_start = view->y1;
+      view_end = view->y2;
+    }
+  else
+    {
+      view_start = view->x1;
+      view_end = view->x2;
+    }
 
-  if (priv->hadjustment)
-    vertex.x += mx_adjustment_get_value (priv->hadjustment);
+  /* the first child ending after the start of the view */
+  low = 0;
+  high = priv->children->len;
+  while (low < high)
+    {
+      guint mid = (low + high) / 2;
 
-  if (priv->vadjustment)
-    vertex.y += mx_adjustment_get_value (priv->vadjustment);
+      if (g_array_index (priv->children, MxBoxLayoutChildInfo,
+                         mid).end <= view_start)
+        low = mid + 1;
+      else
+        high = mid;
+    }
+  *first = low;
 
-  clutter_paint_volume_set_origin (volume, &vertex);
+  /* the first child starting after the end of the view */
+  high = priv->children->len;
+  while (low < high)
+    {
+      guint mid = (low + high) / 2;
+
+      if (g_array_index (priv->children, MxBoxLayoutChildInfo,
+                         mid).start < view_end)
+        low = mid + 1;
+      else
+        high = mid;
+    }
+  *last = low;
 
   return TRUE;
 }
 
 static void
-mx_box_layout_paint (ClutterActor *actor)
+mx_box_layout_paint_child_in_view (ClutterActor          *actor,
+                                   ClutterActor          *child,
+                                   const ClutterActorBox *box_b)
+{
+  if (!CLUTTER_ACTOR_IS_VISIBLE (child))
+    return;
+
+  if (!box_b || mx_widget_is_child_in_area (MX_WIDGET (actor), child, box_b))
+    clutter_actor_paint (child);
+}
+
+/* paints (or picks) the children within the scrolled view */
+static void
+mx_box_layout_paint_children (ClutterActor *actor)
 {
   MxBoxLayoutPrivate *priv = MX_BOX_LAYOUT (actor)->priv;
-  gdouble x, y;
-  ClutterActorBox child_b;
   ClutterActorBox box_b;
   ClutterActor *child;
   ClutterActorIter iter;
-
-  CLUTTER_ACTOR_CLASS (mx_box_layout_parent_class)->paint (actor);
+  guint first, last, i;
 
   if (clutter_actor_get_n_children (actor) == 0)
     return;
 
-  if (priv->hadjustment)
-    x = mx_adjustment_get_value (priv->hadjustment);
-  else
-    x = 0;
-
-  if (priv->vadjustment)
-    y = mx_adjustment_get_value (priv->vadjustment);
-  else
-    y = 0;
+  if (!mx_widget_get_view_area (MX_WIDGET (actor), &box_b))
+    {
+      clutter_actor_iter_init (&iter, actor);
+      while (clutter_actor_iter_next (&iter, &child))
+        mx_box_layout_paint_child_in_view (actor, child, NULL);
+      return;
+    }
 
-  clutter_actor_get_allocation_box (actor, &box_b);
-  box_b.x2 = (box_b.x2 - box_b.x1) + x;
-  box_b.x1 = x;
-  box_b.y2 = (box_b.y2 - box_b.y1) + y;
-  box_b.y1 = y;
+  if (mx_box_layout_get_children_in_view (MX_BOX_LAYOUT (actor), &box_b,
+                                          &first, &last))
+    {
+      for (i = first; i < last; i++)
+        mx_box_layout_paint_child_in_view (actor,
+                                           g_array_index (priv->children,
+                                                          MxBoxLayoutChildInfo,
+                                                          i).child,
+                                           &box_b);
+      return;
+    }
 
   clutter_actor_iter_init (&iter, actor);
   while (clutter_actor_iter_next (&iter, &child))
-    {
-      if (!CLUTTER_ACTOR_IS_VISIBLE (child))
-        continue;
+    mx_box_layout_paint_child_in_view (actor, child, &box_b);
+}
+
+static void
+mx_box_layout_paint (ClutterActor *actor)
+{
+  MX_PROFILE_BEGIN (actor, PAINT);
 
-      clutter_actor_get_allocation_box (child, &child_b);
+  CLUTTER_ACTOR_CLASS (mx_box_layout_parent_class)->paint (actor);
 
-      if ((child_b.x1 < box_b.x2) &&
-          (child_b.x2 > box_b.x1) &&
-          (child_b.y1 < box_b.y2) &&
-          (child_b.y2 > box_b.y1))
-        {
-          clutter_actor_paint (child);
-        }
-    }
+  mx_box_layout_paint_children (actor);
+
+  MX_PROFILE_END (actor, PAINT);
 }
 
 static void
 mx_box_layout_pick (ClutterActor       *actor,
                     const ClutterColor *color)
 {
-  MxBoxLayoutPrivate *priv = MX_BOX_LAYOUT (actor)->priv;
-  ClutterActor *child;
-  ClutterActorIter iter;
-  gdouble x, y;
-  ClutterActorBox child_b;
-  ClutterActorBox box_b;
+  MX_PROFILE_BEGIN (actor, PICK);
 
   CLUTTER_ACTOR_CLASS (mx_box_layout_parent_class)->pick (actor, color);
 
-  if (clutter_actor_get_n_children (actor) == 0)
-    return;
+  mx_box_layout_paint_children (actor);
 
-  if (priv->hadjustment)
-    x = mx_adjustment_get_value (priv->hadjustment);
-  else
-    x = 0;
-
-  if (priv->vadjustment)
-    y = mx_adjustment_get_value (priv->vadjustment);
-  else
-    y = 0;
-
-  clutter_actor_get_allocation_box (actor, &box_b);
-  box_b.x2 = (box_b.x2 - box_b.x1) + x;
-  box_b.x1 = x;
-  box_b.y2 = (box_b.y2 - box_b.y1) + y;
-  box_b.y1 = y;
-
-  clutter_actor_iter_init (&iter, actor);
-  while (clutter_actor_iter_next (&iter, &child))
-    {
-      if (!CLUTTER_ACTOR_IS_VISIBLE (child))
-        continue;
-
-      clutter_actor_get_allocation_box (child, &child_b);
-
-      if ((child_b.x1 < box_b.x2)
-          && (child_b.x2 > box_b.x1)
-          && (child_b.y1 < box_b.y2)
-          && (child_b.y2 > box_b.y1))
-        {
-          clutter_actor_paint (child);
-        }
-    }
+  MX_PROFILE_END (actor, PICK);
 }
 
 static void
@@ -1459,6 +1850,8 @@ mx_box_layout_class_init (MxBoxLayoutClass *klass)
 
   g_type_class_add_private (klass, sizeof (MxBoxLayoutPrivate));
 
+  child_index_quark = g_quark_from_static_string ("mx-box-layout-child-index");
+
   object_class->get_property = mx_box_layout_get_property;
   object_class->set_property = mx_box_layout_set_property;
   object_class->dispose = mx_box_layout_dispose;
@@ -1468,7 +1861,6 @@ mx_box_layout_class_init (MxBoxLayoutClass *klass)
   actor_class->get_preferred_width = mx_box_layout_get_preferred_width;
   actor_class->get_preferred_height = mx_box_layout_get_preferred_height;
   actor_class->apply_transform = mx_box_layout_apply_transform;
-  actor_class->get_paint_volume = mx_box_layout_get_paint_volume;
 
   actor_class->paint = mx_box_layout_paint;
   actor_class->pick = mx_box_layout_pick;
@@ -1514,12 +1906,6 @@ mx_box_layout_class_init (MxBoxLayoutClass *klass)
 
 }
 
-static void
-mx_box_layout_free_allocation (ClutterActorBox *box)
-{
-  g_boxed_free (CLUTTER_TYPE_ACTOR_BOX, box);
-}
-
 static void
 mx_box_layout_style_changed (MxWidget *widget,
                              gpointer  userdata)
@@ -1546,17 +1932,18 @@ mx_box_layout_init (MxBoxLayout *self)
 {
   self->priv = BOX_LAYOUT_PRIVATE (self);
 
-
-  self->priv->start_allocations = g_hash_table_new_full (g_direct_hash,
-                                                         g_direct_equal,
-                                                         NULL,
-                                                         (GDestroyNotify)
-                                                         mx_box_layout_free_allocation);
-
   g_signal_connect (self, "style-changed",
                     G_CALLBACK (mx_box_layout_style_changed), NULL);
 
   self->priv->scroll_to_focused = TRUE;
+
+  self->priv->children = g_array_new (FALSE, FALSE,
+                                      sizeof (MxBoxLayoutChildInfo));
+  self->priv->first_changed = G_MAXUINT;
+  self->priv->content_size = -1;
+
+  /* cull the children against the scrolled view */
+  _mx_widget_set_scroll_adjustments (MX_WIDGET (self), NULL, NULL);
 }
 
 /**
@@ -1595,6 +1982,8 @@ mx_box_layout_set_orientation (MxBoxLayout *box,
   if (box->priv->orientation != orientation)
     {
       box->priv->orientation = orientation;
+      box->priv->in_order = FALSE;
+      mx_box_layout_invalidate_sizes (box);
       _mx_box_layout_start_animation (box);
       clutter_actor_queue_relayout (CLUTTER_ACTOR (box));
 
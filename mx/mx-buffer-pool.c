@@ -0,0 +1,185 @@
+/* -*- mode: C; c-file-style: "gnu"; indent-tabs-mode: nil; -*- */
+/*
+ * mx-buffer-pool.c: Size-bucketed pool of pixel buffers
+ *
+ * Copyright 2012 Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/*
+ * A process-wide pool of pixel buffers, shared between the image decoding
+ * threads and the main thread that uploads the pixels to textures.
+ *
+ * Requests are rounded up to the next power of two and served from a free
+ * list for that size, so that images of similar dimensions (thumbnails,
+ * animation frames) keep re-using the same few blocks of memory instead of
+ * churning the allocator. Free buffers are kept around up to a fixed budget;
+ * anything beyond that, and any request larger than the biggest bucket, goes
+ * straight back to the system allocator.
+ *
+ * Each buffer is preceded by a small header recording its bucket, so that
+ * _mx_buffer_pool_free() doesn't need to be told the size.
+ */
+
+#include "mx-buffer-pool.h"
+
+#include <string.h>
+
+/* Buckets hold 4KiB (1 << 12) to 32MiB (1 << 25) buffers */
+#define MIN_BUCKET_SHIFT 12
+#define MAX_BUCKET_SHIFT 25
+#define N_BUCKETS        (MAX_BUCKET_SHIFT - MIN_BUCKET_SHIFT + 1)
+
+/* Maximum amount of memory held in free lists */
+#define MAX_CACHED_BYTES (32 * 1024 * 1024)
+
+/* Keep the pixel data 16-byte aligned */
+#define HEADER_SIZE      16
+
+#define UNPOOLED         N_BUCKETS
+
+typedef struct
+{
+  gsize size;
+  guint bucket;
+} MxBufferHeader;
+
+G_STATIC_ASSERT (sizeof (MxBufferHeader) <= HEADER_SIZE);
+
+static GMutex             pool_mutex;
+static GSList            *pool_buckets[N_BUCKETS] = { NULL, };
+static MxBufferPoolStats  pool_stats = { 0, };
+
+static guint
+mx_buffer_pool_get_bucket (gsize size)
+{
+  guint shift = MIN_BUCKET_SHIFT;
+
+  while (((gsize) 1 << shift) < size)
+    {
+      if (++shift > MAX_BUCKET_SHIFT)
+        return UNPOOLED;
+    }
+
+  return shift - MIN_BUCKET_SHIFT;
+}
+
+/*
+ * _mx_buffer_pool_alloc:
+ * @size: the required size in bytes
+ *
+ * Retrieves a buffer of at least @size bytes from the pool, allocating a new
+ * one if necessary. The contents of the buffer are undefined. This function
+ * may be called from any thread.
+ *
+ * Returns: a buffer, to be released with _mx_buffer_pool_free()
+ */
+gpointer
+_mx_buffer_pool_alloc (gsize size)
+{
+  MxBufferHeader *header = NULL;
+  guint bucket;
+
+  bucket = mx_buffer_pool_get_bucket (size);
+
+  g_mutex_lock (&pool_mutex);
+
+  if (bucket != UNPOOLED && pool_buckets[bucket])
+    {
+      header = pool_buckets[bucket]->data;
+      pool_buckets[bucket] = g_slist_delete_link (pool_buckets[bucket],
+                                                  pool_buckets[bucket]);
+      pool_stats.bytes_cached -= header->size;
+      pool_stats.hits++;
+    }
+  else
+    pool_stats.misses++;
+
+  if (!header)
+    {
+      gsize alloc_size;
+
+      g_mutex_unlock (&pool_mutex);
+
+      alloc_size = (bucket == UNPOOLED) ?
+        size : ((gsize) 1 << (bucket + MIN_BUCKET_SHIFT));
+      header = g_malloc (HEADER_SIZE + alloc_size);
+      header->size = alloc_size;
+      header->bucket = bucket;
+
+      g_mutex_lock (&pool_mutex);
+    }
+
+  pool_stats.bytes_in_use += header->size;
+  pool_stats.bytes_in_use_high_water_mark =
+    MAX (pool_stats.bytes_in_use_high_water_mark, pool_stats.bytes_in_use);
+
+  g_mutex_unlock (&pool_mutex);
+
+  return ((guint8 *) header) + HEADER_SIZE;
+}
+
+/*
+ * _mx_buffer_pool_free:
+ * @buffer: a buffer returned by _mx_buffer_pool_alloc(), or %NULL
+ *
+ * Returns @buffer to the pool. This function may be called from any thread,
+ * and has a signature compatible with #GDestroyNotify.
+ */
+void
+_mx_buffer_pool_free (gpointer buffer)
+{
+  MxBufferHeader *header;
+
+  if (!buffer)
+    return;
+
+  header = (MxBufferHeader *) (((guint8 *) buffer) - HEADER_SIZE);
+
+  g_mutex_lock (&pool_mutex);
+
+  pool_stats.bytes_in_use -= header->size;
+
+  if (header->bucket != UNPOOLED &&
+      pool_stats.bytes_cached + header->size <= MAX_CACHED_BYTES)
+    {
+      pool_buckets[header->bucket] =
+        g_slist_prepend (pool_buckets[header->bucket], header);
+      pool_stats.bytes_cached += header->size;
+      pool_stats.bytes_cached_high_water_mark =
+        MAX (pool_stats.bytes_cached_high_water_mark,
+             pool_stats.bytes_cached);
+      header = NULL;
+    }
+
+  g_mutex_unlock (&pool_mutex);
+
+  g_free (header);
+}
+
+/*
+ * _mx_buffer_pool_get_stats:
+ * @stats: return location for the statistics
+ *
+ * Retrieves a snapshot of the pool usage statistics.
+ */
+void
+_mx_buffer_pool_get_stats (MxBufferPoolStats *stats)
+{
+  g_mutex_lock (&pool_mutex);
+  memcpy (stats, &pool_stats, sizeof (MxBufferPoolStats));
+  g_mutex_unlock (&pool_mutex);
+}
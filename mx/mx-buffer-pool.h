@@ -0,0 +1,49 @@
+/* -*- mode: C; c-file-style: "gnu"; indent-tabs-mode: nil; -*- */
+/*
+ * mx-buffer-pool.h: Size-bucketed pool of pixel buffers
+ *
+ * Copyright 2012 Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/*
+ * This is private to MX
+ */
+
+#ifndef __MX_BUFFER_POOL_H__
+#define __MX_BUFFER_POOL_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct
+{
+  gsize bytes_in_use;
+  gsize bytes_in_use_high_water_mark;
+  gsize bytes_cached;
+  gsize bytes_cached_high_water_mark;
+  guint hits;
+  guint misses;
+} MxBufferPoolStats;
+
+gpointer _mx_buffer_pool_alloc     (gsize              size);
+void     _mx_buffer_pool_free      (gpointer           buffer);
+void     _mx_buffer_pool_get_stats (MxBufferPoolStats *stats);
+
+G_END_DECLS
+
+#endif /* __MX_BUFFER_POOL_H__ */
@@ -652,10 +652,14 @@ mx_button_allocate (ClutterActor           *actor,
   MxButtonPrivate *priv = MX_BUTTON (actor)->priv;
   ClutterActorBox child_box;
 
+  MX_PROFILE_BEGIN (actor, ALLOCATE);
+
   CLUTTER_ACTOR_CLASS (mx_button_parent_class)->allocate (actor, box, flags);
 
   mx_widget_get_available_area (MX_WIDGET (actor), box, &child_box);
   clutter_actor_allocate (priv->child, &child_box, flags);
+
+  MX_PROFILE_END (actor, ALLOCATE);
 }
 
 static void
@@ -667,6 +671,8 @@ mx_button_get_preferred_width (ClutterActor *actor,
   MxButtonPrivate *priv = MX_BUTTON (actor)->priv;
   MxPadding padding;
 
+  MX_PROFILE_BEGIN (actor, PREFERRED_SIZE);
+
   if (priv->content_image)
     {
       gfloat width;
@@ -678,6 +684,7 @@ mx_button_get_preferred_width (ClutterActor *actor,
       if (pref_width)
         *pref_width = width;
 
+      MX_PROFILE_END (actor, PREFERRED_SIZE);
       return;
     }
 
@@ -696,6 +703,7 @@ mx_button_get_preferred_width (ClutterActor *actor,
   if (pref_width)
     *pref_width += padding.left + padding.right;
 
+  MX_PROFILE_END (actor, PREFERRED_SIZE);
 }
 
 static void
@@ -707,6 +715,8 @@ mx_button_get_preferred_height (ClutterActor *actor,
   MxButtonPrivate *priv = MX_BUTTON (actor)->priv;
   MxPadding padding;
 
+  MX_PROFILE_BEGIN (actor, PREFERRED_SIZE);
+
   if (priv->content_image)
     {
       gfloat height;
@@ -718,6 +728,7 @@ mx_button_get_preferred_height (ClutterActor *actor,
       if (pref_height)
         *pref_height = height;
 
+      MX_PROFILE_END (actor, PREFERRED_SIZE);
       return;
     }
 
@@ -735,6 +746,8 @@ mx_button_get_preferred_height (ClutterActor *actor,
 
   if (pref_height)
     *pref_height += padding.top + padding.bottom;
+
+  MX_PROFILE_END (actor, PREFERRED_SIZE);
 }
 
 static void
@@ -742,6 +755,8 @@ mx_button_paint (ClutterActor *actor)
 {
   MxButtonPrivate *priv = MX_BUTTON (actor)->priv;
 
+  MX_PROFILE_BEGIN (actor, PAINT);
+
   if (priv->content_image)
     {
       ClutterActorBox box;
@@ -758,6 +773,8 @@ mx_button_paint (ClutterActor *actor)
       if (priv->child)
         clutter_actor_paint (priv->child);
     }
+
+  MX_PROFILE_END (actor, PAINT);
 }
 
 static void
@@ -765,6 +782,8 @@ mx_button_pick (ClutterActor *actor, const ClutterColor *color)
 {
   MxButtonPrivate *priv = MX_BUTTON (actor)->priv;
 
+  MX_PROFILE_BEGIN (actor, PICK);
+
   CLUTTER_ACTOR_CLASS (mx_button_parent_class)->pick (actor, color);
 
   if (!priv->content_image)
@@ -772,6 +791,8 @@ mx_button_pick (ClutterActor *actor, const ClutterColor *color)
       if (priv->child)
         clutter_actor_paint (priv->child);
     }
+
+  MX_PROFILE_END (actor, PICK);
 }
 
 static void
@@ -0,0 +1,335 @@
+/* -*- mode: C; c-file-style: "gnu"; indent-tabs-mode: nil; -*- */
+/*
+ * mx-cache-effect.c: An offscreen effect caching the painting of an actor
+ *
+ * Copyright 2012 Intel Corporation
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/**
+ * SECTION:mx-cache-effect
+ * @short_description: An effect caching the painting of an actor
+ *
+ * #MxCacheEffect is a #ClutterEffect that paints an actor and its children
+ * to a texture once, and paints that texture instead of the actor for as
+ * long as neither the actor nor any of its descendants queue a redraw or a
+ * relayout, and the actor isn't moved relative to the stage. It is useful
+ * for complex widgets, such as dialogs, menus and toolbars, that rarely
+ * change while something else on the stage animates.
+ *
+ * When the cached texture has to be painted again for most frames, the
+ * cache only adds the cost of the offscreen buffer, so the effect watches
+ * how often it is reused. If the cache misses on most of the recent frames,
+ * it is bypassed and the actor is painted directly, until the actor has
+ * stayed unchanged for a while.
+ *
+ * #MxWidget adds an #MxCacheEffect itself when the "-mx-cache" style
+ * property is set to "true".
+ *
+ * Since: 2.0
+ */
+
+#include "mx-cache-effect.h"
+#include "mx-private.h"
+
+G_DEFINE_TYPE (MxCacheEffect, mx_cache_effect, CLUTTER_TYPE_OFFSCREEN_EFFECT)
+
+#define CACHE_EFFECT_PRIVATE(o) \
+  (G_TYPE_INSTANCE_GET_PRIVATE ((o), MX_TYPE_CACHE_EFFECT, MxCacheEffectPrivate))
+
+/* the number of paints the hit ratio is judged over */
+#define CACHE_WINDOW 16
+
+/* the cache is bypassed when more paints than this miss in a window */
+#define CACHE_MAX_MISSES 12
+
+enum
+{
+  PROP_0,
+
+  PROP_BYPASSED
+};
+
+struct _MxCacheEffectPrivate
+{
+  guint n_hits;
+  guint n_misses;
+
+  guint window_paints;
+  guint window_misses;
+
+  /* the paints without a redraw of the actor while bypassed */
+  guint clean_paints;
+
+  guint rendering : 1;
+  guint bypassed  : 1;
+};
+
+static void
+mx_cache_effect_get_property (GObject    *object,
+                              guint       property_id,
+                              GValue     *value,
+                              GParamSpec *pspec)
+{
+  MxCacheEffectPrivate *priv = MX_CACHE_EFFECT (object)->priv;
+
+  switch (property_id)
+    {
+    case PROP_BYPASSED:
+      g_value_set_boolean (value, priv->bypassed);
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+    }
+}
+
+static void
+mx_cache_effect_set_bypassed (MxCacheEffect *self,
+                              gboolean       bypassed)
+{
+  MxCacheEffectPrivate *priv = self->priv;
+
+  MX_NOTE (PROFILE, "%s cache of %s, hit ratio %.2f",
+           bypassed ? "Bypassing" : "Resuming",
+           G_OBJECT_TYPE_NAME (clutter_actor_meta_get_actor (
+             CLUTTER_ACTOR_META (self))),
+           mx_cache_effect_get_hit_ratio (self));
+
+  priv->bypassed = bypassed;
+  priv->clean_paints = 0;
+  priv->window_paints = 0;
+  priv->window_misses = 0;
+
+  g_object_notify (G_OBJECT (self), "bypassed");
+}
+
+static gboolean
+mx_cache_effect_pre_paint (ClutterEffect *effect)
+{
+  MxCacheEffectPrivate *priv = MX_CACHE_EFFECT (effect)->priv;
+
+  /* ClutterOffscreenEffect only goes through pre_paint when the cached
+   * texture can't be reused */
+  priv->rendering = TRUE;
+
+  return CLUTTER_EFFECT_CLASS (mx_cache_effect_parent_class)->
+    pre_paint (effect);
+}
+
+static void
+mx_cache_effect_paint (ClutterEffect           *effect,
+                       ClutterEffectPaintFlags  flags)
+{
+  MxCacheEffect *self = MX_CACHE_EFFECT (effect);
+  MxCacheEffectPrivate *priv = self->priv;
+
+  if (priv->bypassed)
+    {
+      if (flags & CLUTTER_EFFECT_PAINT_ACTOR_DIRTY)
+        priv->clean_paints = 0;
+      else
+        priv->clean_paints++;
+
+      if (priv->clean_paints < CACHE_WINDOW)
+        {
+          ClutterActor *actor =
+            clutter_actor_meta_get_actor (CLUTTER_ACTOR_META (effect));
+
+          clutter_actor_continue_paint (actor);
+          return;
+        }
+
+      /* the actor has settled, try caching it again. The redraws of the
+       * actor while bypassed weren't seen by the offscreen effect, so make
+       * it paint the actor again rather than the texture from before */
+      mx_cache_effect_set_bypassed (self, FALSE);
+      flags |= CLUTTER_EFFECT_PAINT_ACTOR_DIRTY;
+    }
+
+  priv->rendering = FALSE;
+
+  CLUTTER_EFFECT_CLASS (mx_cache_effect_parent_class)->paint (effect, flags);
+
+  if (priv->rendering)
+    {
+      priv->n_misses++;
+      priv->window_misses++;
+    }
+  else
+    priv->n_hits++;
+
+  if (++priv->window_paints == CACHE_WINDOW)
+    {
+      if (priv->window_misses > CACHE_MAX_MISSES)
+        mx_cache_effect_set_bypassed (self, TRUE);
+      else
+        priv->window_paints = priv->window_misses = 0;
+    }
+}
+
+static void
+mx_cache_effect_class_init (MxCacheEffectClass *klass)
+{
+  GParamSpec *pspec;
+
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  ClutterEffectClass *effect_class = CLUTTER_EFFECT_CLASS (klass);
+
+  g_type_class_add_private (klass, sizeof (MxCacheEffectPrivate));
+
+  object_class->get_property = mx_cache_effect_get_property;
+
+  effect_class->pre_paint = mx_cache_effect_pre_paint;
+  effect_class->paint = mx_cache_effect_paint;
+
+  /**
+   * MxCacheEffect:bypassed:
+   *
+   * Whether the cache is being bypassed because it was missing on most
+   * frames.
+   *
+   * Since: 2.0
+   */
+  pspec = g_param_spec_boolean ("bypassed",
+                                "Bypassed",
+                                "Whether the cache is being bypassed",
+                                FALSE,
+                                MX_PARAM_READABLE);
+  g_object_class_install_property (object_class, PROP_BYPASSED, pspec);
+}
+
+static void
+mx_cache_effect_init (MxCacheEffect *self)
+{
+  self->priv = CACHE_EFFECT_PRIVATE (self);
+}
+
+/**
+ * mx_cache_effect_new:
+ *
+ * Creates a new #MxCacheEffect to be used with clutter_actor_add_effect().
+ *
+ * Returns: the newly created #MxCacheEffect
+ *
+ * Since: 2.0
+ */
+ClutterEffect *
+mx_cache_effect_new (void)
+{
+  return g_object_new (MX_TYPE_CACHE_EFFECT, NULL);
+}
+
+/**
+ * mx_cache_effect_get_n_hits:
+ * @effect: An #MxCacheEffect
+ *
+ * Gets the number of times the cached texture was painted instead of the
+ * actor since the effect was created or the counters were reset.
+ *
+ * Returns: the number of cache hits
+ *
+ * Since: 2.0
+ */
+guint
+mx_cache_effect_get_n_hits (MxCacheEffect *effect)
+{
+  g_return_val_if_fail (MX_IS_CACHE_EFFECT (effect), 0);
+
+  return effect->priv->n_hits;
+}
+
+/**
+ * mx_cache_effect_get_n_misses:
+ * @effect: An #MxCacheEffect
+ *
+ * Gets the number of times the actor had to be painted to the cached
+ * texture again since the effect was created or the counters were reset.
+ * Paints while the cache is bypassed are not counted.
+ *
+ * Returns: the number of cache misses
+ *
+ * Since: 2.0
+ */
+guint
+mx_cache_effect_get_n_misses (MxCacheEffect *effect)
+{
+  g_return_val_if_fail (MX_IS_CACHE_EFFECT (effect), 0);
+
+  return effect->priv->n_misses;
+}
+
+/**
+ * mx_cache_effect_get_hit_ratio:
+ * @effect: An #MxCacheEffect
+ *
+ * Gets the proportion of the paints through the cache that reused the
+ * cached texture.
+ *
+ * Returns: the hit ratio, between 0 and 1
+ *
+ * Since: 2.0
+ */
+gdouble
+mx_cache_effect_get_hit_ratio (MxCacheEffect *effect)
+{
+  MxCacheEffectPrivate *priv;
+
+  g_return_val_if_fail (MX_IS_CACHE_EFFECT (effect), 0);
+
+  priv = effect->priv;
+
+  if (priv->n_hits + priv->n_misses == 0)
+    return 0;
+
+  return priv->n_hits / (gdouble) (priv->n_hits + priv->n_misses);
+}
+
+/**
+ * mx_cache_effect_reset_counters:
+ * @effect: An #MxCacheEffect
+ *
+ * Resets the numbers of cache hits and misses to zero.
+ *
+ * Since: 2.0
+ */
+void
+mx_cache_effect_reset_counters (MxCacheEffect *effect)
+{
+  g_return_if_fail (MX_IS_CACHE_EFFECT (effect));
+
+  effect->priv->n_hits = 0;
+  effect->priv->n_misses = 0;
+}
+
+/**
+ * mx_cache_effect_get_bypassed:
+ * @effect: An #MxCacheEffect
+ *
+ * Gets whether the cache is being bypassed because it was missing on most
+ * frames. See #MxCacheEffect:bypassed.
+ *
+ * Returns: %TRUE if the actor is being painted directly
+ *
+ * Since: 2.0
+ */
+gboolean
+mx_cache_effect_get_bypassed (MxCacheEffect *effect)
+{
+  g_return_val_if_fail (MX_IS_CACHE_EFFECT (effect), FALSE);
+
+  return effect->priv->bypassed;
+}
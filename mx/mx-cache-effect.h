@@ -0,0 +1,92 @@
+/* -*- mode: C; c-file-style: "gnu"; indent-tabs-mode: nil; -*- */
+/*
+ * mx-cache-effect.h: An offscreen effect caching the painting of an actor
+ *
+ * Copyright 2012 Intel Corporation
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#if !defined(MX_H_INSIDE) && !defined(MX_COMPILATION)
+#error "Only <mx/mx.h> can be included directly.h"
+#endif
+
+#ifndef _MX_CACHE_EFFECT_H
+#define _MX_CACHE_EFFECT_H
+
+#include <glib-object.h>
+#include <clutter/clutter.h>
+
+G_BEGIN_DECLS
+
+#define MX_TYPE_CACHE_EFFECT mx_cache_effect_get_type()
+
+#define MX_CACHE_EFFECT(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST ((obj), \
+  MX_TYPE_CACHE_EFFECT, MxCacheEffect))
+
+#define MX_CACHE_EFFECT_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_CAST ((klass), \
+  MX_TYPE_CACHE_EFFECT, MxCacheEffectClass))
+
+#define MX_IS_CACHE_EFFECT(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE ((obj), \
+  MX_TYPE_CACHE_EFFECT))
+
+#define MX_IS_CACHE_EFFECT_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_TYPE ((klass), \
+  MX_TYPE_CACHE_EFFECT))
+
+#define MX_CACHE_EFFECT_GET_CLASS(obj) \
+  (G_TYPE_INSTANCE_GET_CLASS ((obj), \
+  MX_TYPE_CACHE_EFFECT, MxCacheEffectClass))
+
+typedef struct _MxCacheEffect MxCacheEffect;
+typedef struct _MxCacheEffectClass MxCacheEffectClass;
+typedef struct _MxCacheEffectPrivate MxCacheEffectPrivate;
+
+/**
+ * MxCacheEffect:
+ *
+ * The contents of this structure are private and should only be accessed
+ * through the public API.
+ */
+struct _MxCacheEffect
+{
+  /*< private >*/
+  ClutterOffscreenEffect parent;
+
+  MxCacheEffectPrivate *priv;
+};
+
+struct _MxCacheEffectClass
+{
+  ClutterOffscreenEffectClass parent_class;
+};
+
+GType mx_cache_effect_get_type (void) G_GNUC_CONST;
+
+ClutterEffect *mx_cache_effect_new (void);
+
+guint    mx_cache_effect_get_n_hits      (MxCacheEffect *effect);
+guint    mx_cache_effect_get_n_misses    (MxCacheEffect *effect);
+gdouble  mx_cache_effect_get_hit_ratio   (MxCacheEffect *effect);
+void     mx_cache_effect_reset_counters  (MxCacheEffect *effect);
+
+gboolean mx_cache_effect_get_bypassed    (MxCacheEffect *effect);
+
+G_END_DECLS
+
+#endif /* _MX_CACHE_EFFECT_H */
@@ -93,9 +93,21 @@
  *   new columns, before being added to rows.</para>
  *   <graphic fileref="MxGrid-2cols-column-major.png" format="PNG"/>
  * </figure>
+ *
+ * When a subclass provides its items through the @get_n_items,
+ * @create_item and @bind_item members of #MxGridClass, as #MxItemView
+ * does, setting #MxGrid:virtualized lets the grid create and bind children
+ * only for the items in view. If rows and columns are both homogenous and
+ * #MxGrid:max_stride is set, the position of each item follows from its
+ * index, so only the items visible through the scroll adjustments (plus a
+ * line either side) exist as children, and they are re-used for other
+ * items as the grid scrolls. Otherwise, a child is created for every item.
+ * While a kinetic scroll is under way, mx_scrollable_prefetch_hint() lets
+ * the grid also bind up to a page of the items it is heading towards.
  */
 
 #include <string.h>
+#include <math.h>
 
 #include "mx-scrollable.h"
 #include "mx-grid.h"
@@ -103,9 +115,11 @@
 #include "mx-focusable.h"
 #include "mx-enum-types.h"
 #include "mx-private.h"
+#include "mx-widget-private.h"
 
 typedef struct _MxGridActorData MxGridActorData;
 
+static void mx_grid_dispose             (GObject *object);
 static void mx_grid_finalize            (GObject *object);
 
 static void mx_grid_set_property        (GObject      *object,
@@ -203,8 +217,32 @@ struct _MxGridPrivate
 
   guint ignore_css_col_spacing : 1;
   guint ignore_css_row_spacing : 1;
+
+  /* virtualized mode */
+  guint virtualized            : 1;
+
+  GPtrArray    *items;          /* children showing items, in index order */
+  gint          first_item;     /* index of the first of those children */
+  GSList       *free_items;     /* hidden children available for re-use */
+  gfloat        cell_width;
+  gfloat        cell_height;
+  ClutterActor *template_item;  /* measures the cells when none is realized */
+  guint         items_dirty    : 1;
+  guint         in_allocation  : 1;
+  guint         pre_paint_func;
+
+  /* range of the items in view, without the overscan or prefetching */
+  gint          view_first;
+  gint          view_last;
+
+  /* where a kinetic scroll is heading, see mx_scrollable_prefetch_hint() */
+  guint         prefetching    : 1;
+  gdouble       prefetch_value;
 };
 
+/* Number of lines to keep realized beyond the visible area */
+#define VIRTUAL_OVERSCAN_LINES 1
+
 enum
 {
   PROP_0,
@@ -219,6 +257,7 @@ enum
   PROP_HADJUST,
   PROP_VADJUST,
   PROP_MAX_STRIDE,
+  PROP_VIRTUALIZED
 };
 
 struct _MxGridActorData
@@ -228,6 +267,382 @@ struct _MxGridActorData
   gfloat   pref_width, pref_height;
 };
 
+
+/* virtualized mode */
+static gboolean
+mx_grid_has_item_source (MxGrid *grid)
+{
+  MxGridClass *klass = MX_GRID_GET_CLASS (grid);
+
+  return (klass->get_n_items && klass->create_item && klass->bind_item);
+}
+
+/* whether the grid creates its own children, for the items in view only */
+static gboolean
+mx_grid_is_virtual (MxGrid *grid)
+{
+  MxGridPrivate *priv = grid->priv;
+
+  return (priv->virtualized &&
+          priv->homogenous_rows &&
+          priv->homogenous_columns &&
+          priv->max_stride > 0 &&
+          mx_grid_has_item_source (grid));
+}
+
+static void
+mx_grid_release_item (MxGrid       *grid,
+                      ClutterActor *item)
+{
+  MxGridPrivate *priv = grid->priv;
+
+  clutter_actor_hide (item);
+  priv->free_items = g_slist_prepend (priv->free_items, item);
+}
+
+static ClutterActor *
+mx_grid_acquire_item (MxGrid *grid,
+                      guint   index)
+{
+  MxGridPrivate *priv = grid->priv;
+  ClutterActor *item;
+
+  if (priv->free_items)
+    {
+      item = priv->free_items->data;
+      priv->free_items = g_slist_delete_link (priv->free_items,
+                                              priv->free_items);
+      clutter_actor_show (item);
+    }
+  else
+    {
+      item = MX_GRID_GET_CLASS (grid)->create_item (grid);
+      clutter_actor_add_child (CLUTTER_ACTOR (grid), item);
+    }
+
+  /* let images loaded for items that aren't in view yet wait for the ones
+   * that are */
+  _mx_image_set_prefetching (mx_grid_is_virtual (grid) &&
+                             ((gint) index < priv->view_first ||
+                              (gint) index >= priv->view_last));
+  MX_GRID_GET_CLASS (grid)->bind_item (grid, item, index);
+  _mx_image_set_prefetching (FALSE);
+
+  return item;
+}
+
+/*
+ * Makes the children showing items the ones for the items from @first up to
+ * (not including) @last, re-using the children of other items.
+ */
+static void
+mx_grid_realize_items (MxGrid *grid,
+                       gint    first,
+                       gint    last)
+{
+  MxGridPrivate *priv = grid->priv;
+  GPtrArray *old_items, *new_items;
+  ClutterActor *prev;
+  gint index, old_first, old_last;
+  guint i;
+
+  old_items = priv->items;
+  old_first = priv->first_item;
+  old_last = old_first + old_items->len;
+
+  /* release the children outside the new range first, so they can be
+   * re-used straight away */
+  for (i = 0; i < old_items->len; i++)
+    {
+      index = old_first + i;
+
+      if (index < first || index >= last)
+        {
+          mx_grid_release_item (grid, g_ptr_array_index (old_items, i));
+          g_ptr_array_index (old_items, i) = NULL;
+        }
+    }
+
+  new_items = g_ptr_array_sized_new (MAX (last - first, 0));
+  for (index = first; index < last; index++)
+    {
+      ClutterActor *item;
+
+      if (index >= old_first && index < old_last)
+        item = g_ptr_array_index (old_items, index - old_first);
+      else
+        item = mx_grid_acquire_item (grid, index);
+
+      g_ptr_array_add (new_items, item);
+    }
+
+  g_ptr_array_free (old_items, TRUE);
+  priv->items = new_items;
+  priv->first_item = first;
+
+  /* keep the children in item order, so that focus navigation works */
+  prev = NULL;
+  for (i = 0; i < new_items->len; i++)
+    {
+      ClutterActor *item = g_ptr_array_index (new_items, i);
+
+      if (prev && clutter_actor_get_previous_sibling (item) != prev)
+        clutter_actor_set_child_above_sibling (CLUTTER_ACTOR (grid),
+                                               item, prev);
+
+      prev = item;
+    }
+}
+
+/* makes sure the children match the items after they or the layout change */
+static void
+mx_grid_update_items (MxGrid *grid)
+{
+  MxGridPrivate *priv = grid->priv;
+
+  if (!priv->virtualized || !mx_grid_has_item_source (grid))
+    return;
+
+  if (mx_grid_is_virtual (grid))
+    {
+      /* the items in view are bound again before the next frame is laid
+       * out, see mx_grid_pre_paint_cb() */
+      priv->items_dirty = TRUE;
+      clutter_actor_queue_relayout (CLUTTER_ACTOR (grid));
+    }
+  else
+    {
+      /* positions depend on the size of every item, so realize them all */
+      mx_grid_realize_items (grid, 0,
+                             MX_GRID_GET_CLASS (grid)->get_n_items (grid));
+    }
+}
+
+static void
+mx_grid_clear_template (MxGrid *grid)
+{
+  MxGridPrivate *priv = grid->priv;
+
+  if (priv->template_item)
+    {
+      clutter_actor_destroy (priv->template_item);
+      g_object_unref (priv->template_item);
+      priv->template_item = NULL;
+    }
+}
+
+/* updates the cell size from the items in view, which must be homogenous,
+ * and returns whether it changed */
+static gboolean
+mx_grid_update_cell_size (MxGrid *grid)
+{
+  MxGridPrivate *priv = grid->priv;
+  gfloat old_width, old_height;
+  guint i;
+
+  old_width = priv->cell_width;
+  old_height = priv->cell_height;
+
+  priv->cell_width = priv->cell_height = 0;
+
+  /* without realized items, measure the first item on a child of our own
+   * so there's something to go on. It isn't added to the grid, so binding
+   * it is fine while laying out */
+  if (priv->items->len == 0 &&
+      MX_GRID_GET_CLASS (grid)->get_n_items (grid) > 0)
+    {
+      if (!priv->template_item)
+        {
+          priv->template_item = MX_GRID_GET_CLASS (grid)->create_item (grid);
+          g_object_ref_sink (priv->template_item);
+        }
+
+      MX_GRID_GET_CLASS (grid)->bind_item (grid, priv->template_item, 0);
+      clutter_actor_get_preferred_size (priv->template_item, NULL, NULL,
+                                        &priv->cell_width,
+                                        &priv->cell_height);
+    }
+
+  for (i = 0; i < priv->items->len; i++)
+    {
+      gfloat natural_width, natural_height;
+
+      clutter_actor_get_preferred_size (g_ptr_array_index (priv->items, i),
+                                        NULL, NULL,
+                                        &natural_width, &natural_height);
+
+      priv->cell_width = MAX (priv->cell_width, natural_width);
+      priv->cell_height = MAX (priv->cell_height, natural_height);
+    }
+
+  return (priv->cell_width != old_width || priv->cell_height != old_height);
+}
+
+/* gets the cell size and spacing, along (a) and across (b) the lines */
+static void
+mx_grid_get_cell_extents (MxGrid *grid,
+                          gfloat *cell_a,
+                          gfloat *cell_b,
+                          gfloat *agap,
+                          gfloat *bgap)
+{
+  MxGridPrivate *priv = grid->priv;
+
+  if (priv->orientation == MX_ORIENTATION_VERTICAL)
+    {
+      *cell_a = priv->cell_height;
+      *cell_b = priv->cell_width;
+      *agap = priv->row_spacing;
+      *bgap = priv->col_spacing;
+    }
+  else
+    {
+      *cell_a = priv->cell_width;
+      *cell_b = priv->cell_height;
+      *agap = priv->col_spacing;
+      *bgap = priv->row_spacing;
+    }
+}
+
+/* Computes the range of items in view from the scroll adjustment. With
+ * @extend, the range includes the overscan and up to a page towards the
+ * position a kinetic scroll is heading to. */
+static void
+mx_grid_get_visible_items (MxGrid   *grid,
+                           gboolean  extend,
+                           gint     *first,
+                           gint     *last)
+{
+  MxGridPrivate *priv = grid->priv;
+  gfloat cell_a, cell_b, agap, bgap, offset;
+  gint n_items, first_line, last_line;
+  gdouble value, page_size, start, end;
+  MxAdjustment *adjustment;
+  MxPadding padding;
+
+  n_items = MX_GRID_GET_CLASS (grid)->get_n_items (grid);
+
+  mx_grid_get_cell_extents (grid, &cell_a, &cell_b, &agap, &bgap);
+  mx_widget_get_padding (MX_WIDGET (grid), &padding);
+
+  if (priv->orientation == MX_ORIENTATION_VERTICAL)
+    {
+      adjustment = priv->hadjustment;
+      offset = padding.left;
+    }
+  else
+    {
+      adjustment = priv->vadjustment;
+      offset = padding.top;
+    }
+
+  if (!adjustment || cell_b + bgap <= 0)
+    {
+      *first = 0;
+      *last = n_items;
+      return;
+    }
+
+  mx_adjustment_get_values (adjustment, &value, NULL, NULL, NULL, NULL,
+                            &page_size);
+
+  /* before the first allocation, assume the view is as big as the stage */
+  if (page_size <= 0)
+    {
+      ClutterActor *stage = clutter_actor_get_stage (CLUTTER_ACTOR (grid));
+
+      if (stage)
+        page_size = (priv->orientation == MX_ORIENTATION_VERTICAL) ?
+          clutter_actor_get_width (stage) : clutter_actor_get_height (stage);
+    }
+
+  start = value;
+  end = value + page_size;
+
+  if (extend && priv->prefetching)
+    {
+      if (priv->prefetch_value > value)
+        end = MIN (priv->prefetch_value, value + page_size) + page_size;
+      else
+        start = MAX (priv->prefetch_value, value - page_size);
+    }
+
+  first_line = floor ((start - offset) / (cell_b + bgap));
+  last_line = ceil ((end - offset) / (cell_b + bgap));
+
+  if (extend)
+    {
+      first_line -= VIRTUAL_OVERSCAN_LINES;
+      last_line += VIRTUAL_OVERSCAN_LINES;
+    }
+
+  first_line = MAX (first_line, 0);
+
+  *first = MIN (first_line * priv->max_stride, n_items);
+  *last = CLAMP (last_line * priv->max_stride, *first, n_items);
+}
+
+/* whether items without a child have come into view */
+static gboolean
+mx_grid_needs_realize (MxGrid *grid)
+{
+  MxGridPrivate *priv = grid->priv;
+  gint first, last;
+
+  if (priv->items_dirty)
+    return TRUE;
+
+  mx_grid_get_visible_items (grid, TRUE, &first, &last);
+
+  return (first < priv->first_item ||
+          last > priv->first_item + (gint) priv->items->len);
+}
+
+/* Realizes the items in view, and lays them out again. This is never called
+ * from within a layout, as adding and binding children would queue another
+ * one. */
+static void
+mx_grid_update_visible_items (MxGrid *grid)
+{
+  MxGridPrivate *priv = grid->priv;
+  gint first, last, pass;
+
+  if (priv->items_dirty)
+    {
+      mx_grid_realize_items (grid, 0, 0);
+      mx_grid_clear_template (grid);
+      priv->items_dirty = FALSE;
+    }
+
+  /* the range in view depends on the cell size, which depends on the
+   * items; when that changes, realize the items for the new size once */
+  for (pass = 0; pass < 2; pass++)
+    {
+      mx_grid_get_visible_items (grid, FALSE, &priv->view_first,
+                                 &priv->view_last);
+      mx_grid_get_visible_items (grid, TRUE, &first, &last);
+      mx_grid_realize_items (grid, first, last);
+
+      if (!mx_grid_update_cell_size (grid))
+        break;
+    }
+
+  clutter_actor_queue_relayout (CLUTTER_ACTOR (grid));
+}
+
+/* Runs before the stage is laid out, to realize the items the changes to the
+ * items, the size of the view or the scrolling since the last frame need */
+static gboolean
+mx_grid_pre_paint_cb (gpointer data)
+{
+  MxGrid *grid = data;
+
+  if (mx_grid_is_virtual (grid) && mx_grid_needs_realize (grid))
+    mx_grid_update_visible_items (grid);
+
+  return TRUE;
+}
+
 static void
 mx_grid_style_changed (MxWidget *widget, gpointer userdata)
 {
@@ -265,6 +680,18 @@ adjustment_value_notify_cb (MxAdjustment *adjustment,
                             GParamSpec   *pspec,
                             MxGrid       *grid)
 {
+  MxGridPrivate *priv = grid->priv;
+
+  /* Items scrolling into view need binding and allocating. The value may
+   * be clamped while allocating, the items are then realized before the
+   * next layout, see mx_grid_pre_paint_cb() */
+  if (mx_grid_is_virtual (grid) && !priv->in_allocation &&
+      mx_grid_needs_realize (grid))
+    {
+      mx_grid_update_visible_items (grid);
+      return;
+    }
+
   clutter_actor_queue_redraw (CLUTTER_ACTOR (grid));
 }
 
@@ -318,6 +745,9 @@ scrollable_set_adjustments (MxScrollable *scrollable,
       priv->vadjustment = vadjustment;
       g_object_notify (G_OBJECT (scrollable), "vertical-adjustment");
     }
+
+  _mx_widget_set_scroll_adjustments (MX_WIDGET (scrollable),
+                                     priv->hadjustment, priv->vadjustment);
 }
 
 static void
@@ -378,11 +808,43 @@ scrollable_get_adjustments (MxScrollable  *scrollable,
     }
 }
 
+static void
+scrollable_prefetch_hint (MxScrollable *scrollable,
+                          gdouble       hvalue,
+                          gdouble       vvalue,
+                          gdouble       hvelocity,
+                          gdouble       vvelocity)
+{
+  MxGrid *grid = MX_GRID (scrollable);
+  MxGridPrivate *priv = grid->priv;
+  gdouble value, velocity;
+
+  /* only the direction the lines scroll in matters */
+  if (priv->orientation == MX_ORIENTATION_VERTICAL)
+    {
+      value = hvalue;
+      velocity = hvelocity;
+    }
+  else
+    {
+      value = vvalue;
+      velocity = vvelocity;
+    }
+
+  priv->prefetching = (velocity != 0);
+  priv->prefetch_value = value;
+
+  if (priv->prefetching && mx_grid_is_virtual (grid) &&
+      mx_grid_needs_realize (grid))
+    mx_grid_update_visible_items (grid);
+}
+
 static void
 scrollable_interface_init (MxScrollableIface *iface)
 {
   iface->set_adjustments = scrollable_set_adjustments;
   iface->get_adjustments = scrollable_get_adjustments;
+  iface->prefetch_hint = scrollable_prefetch_hint;
 }
 
 static void
@@ -434,27 +896,32 @@ mx_grid_apply_transform (ClutterActor *a,
   cogl_matrix_translate (m , (int) -x, (int) -y, 0);
 }
 
-static gboolean
-mx_grid_get_paint_volume (ClutterActor       *actor,
-                          ClutterPaintVolume *volume)
+static void
+mx_grid_map (ClutterActor *actor)
 {
   MxGridPrivate *priv = MX_GRID (actor)->priv;
-  ClutterVertex vertex;
 
-  if (!clutter_paint_volume_set_from_allocation (volume, actor))
-    return FALSE;
+  CLUTTER_ACTOR_CLASS (mx_grid_parent_class)->map (actor);
 
-  clutter_paint_volume_get_origin (volume, &vertex);
-
-  if (priv->hadjustment)
-    vertex.x += mx_adjustment_get_value (priv->hadjustment);
+  if (!priv->pre_paint_func)
+    priv->pre_paint_func =
+      clutter_threads_add_repaint_func_full (CLUTTER_REPAINT_FLAGS_PRE_PAINT,
+                                             mx_grid_pre_paint_cb,
+                                             actor, NULL);
+}
 
-  if (priv->vadjustment)
-    vertex.y += mx_adjustment_get_value (priv->vadjustment);
+static void
+mx_grid_unmap (ClutterActor *actor)
+{
+  MxGridPrivate *priv = MX_GRID (actor)->priv;
 
-  clutter_paint_volume_set_origin (volume, &vertex);
+  if (priv->pre_paint_func)
+    {
+      clutter_threads_remove_repaint_func (priv->pre_paint_func);
+      priv->pre_paint_func = 0;
+    }
 
-  return TRUE;
+  CLUTTER_ACTOR_CLASS (mx_grid_parent_class)->unmap (actor);
 }
 
 static void
@@ -465,6 +932,7 @@ mx_grid_class_init (MxGridClass *klass)
 
   GParamSpec *pspec;
 
+  gobject_class->dispose = mx_grid_dispose;
   gobject_class->finalize = mx_grid_finalize;
 
   gobject_class->set_property = mx_grid_set_property;
@@ -476,7 +944,8 @@ mx_grid_class_init (MxGridClass *klass)
   actor_class->get_preferred_height = mx_grid_get_preferred_height;
   actor_class->allocate             = mx_grid_allocate;
   actor_class->apply_transform      = mx_grid_apply_transform;
-  actor_class->get_paint_volume     = mx_grid_get_paint_volume;
+  actor_class->map                  = mx_grid_map;
+  actor_class->unmap                = mx_grid_unmap;
 
   g_type_class_add_private (klass, sizeof (MxGridPrivate));
 
@@ -558,6 +1027,21 @@ mx_grid_class_init (MxGridClass *klass)
                             G_PARAM_READWRITE|G_PARAM_CONSTRUCT);
   g_object_class_install_property (gobject_class, PROP_MAX_STRIDE, pspec);
 
+  /**
+   * MxGrid:virtualized:
+   *
+   * Whether to only create children for the items in view, when the items
+   * are provided by a subclass.
+   *
+   * Since: 2.0
+   */
+  pspec = g_param_spec_boolean ("virtualized",
+                                "Virtualized",
+                                "Only create children for the items in view",
+                                FALSE,
+                                MX_PARAM_READWRITE);
+  g_object_class_install_property (gobject_class, PROP_VIRTUALIZED, pspec);
+
   g_object_class_override_property (gobject_class,
                                     PROP_HADJUST,
                                     "horizontal-adjustment");
@@ -766,8 +1250,13 @@ mx_grid_init (MxGrid *self)
                              NULL,
                              mx_grid_free_actor_data);
 
+  priv->items = g_ptr_array_new ();
+
   g_signal_connect (self, "style-changed",
                     G_CALLBACK (mx_grid_style_changed), NULL);
+
+  /* cull the children against the scrolled view */
+  _mx_widget_set_scroll_adjustments (MX_WIDGET (self), NULL, NULL);
 }
 
 static void
@@ -778,9 +1267,29 @@ mx_grid_finalize (GObject *object)
 
   g_hash_table_destroy (priv->hash_table);
 
+  g_ptr_array_free (priv->items, TRUE);
+  g_slist_free (priv->free_items);
+
   G_OBJECT_CLASS (mx_grid_parent_class)->finalize (object);
 }
 
+static void
+mx_grid_dispose (GObject *object)
+{
+  MxGrid *self = (MxGrid *) object;
+  MxGridPrivate *priv = self->priv;
+
+  mx_grid_clear_template (self);
+
+  if (priv->pre_paint_func)
+    {
+      clutter_threads_remove_repaint_func (priv->pre_paint_func);
+      priv->pre_paint_func = 0;
+    }
+
+  G_OBJECT_CLASS (mx_grid_parent_class)->dispose (object);
+}
+
 void
 mx_grid_set_line_alignment (MxGrid  *self,
                             MxAlign  value)
@@ -817,6 +1326,7 @@ mx_grid_set_homogenous_rows (MxGrid  *self,
   if (value != priv->homogenous_rows)
     {
       priv->homogenous_rows = value;
+      mx_grid_update_items (self);
       clutter_actor_queue_relayout (CLUTTER_ACTOR (self));
     }
 }
@@ -843,6 +1353,7 @@ mx_grid_set_homogenous_columns (MxGrid  *self,
   if (value != priv->homogenous_columns)
     {
       priv->homogenous_columns = value;
+      mx_grid_update_items (self);
       clutter_actor_queue_relayout (CLUTTER_ACTOR (self));
     }
 }
@@ -1002,6 +1513,7 @@ mx_grid_set_max_stride (MxGrid *self,
   if (value != priv->max_stride)
     {
       priv->max_stride = value;
+      mx_grid_update_items (self);
       clutter_actor_queue_relayout (CLUTTER_ACTOR (self));
     }
 }
@@ -1014,6 +1526,68 @@ mx_grid_get_max_stride (MxGrid *self)
   return self->priv->max_stride;
 }
 
+/**
+ * mx_grid_set_virtualized:
+ * @self: A #MxGrid
+ * @value: %TRUE to only create children for the items in view
+ *
+ * Sets whether the grid creates its children itself, only for the items in
+ * view, using the items provided by a subclass through #MxGridClass. This
+ * has no effect if the subclass doesn't provide items.
+ *
+ * Children are only limited to the items in view when
+ * #MxGrid:homogenous-rows and #MxGrid:homogenous-columns are set and
+ * #MxGrid:max-stride is non-zero, as the position of each item can then
+ * be computed from its index. Every item has the size of the largest of
+ * the items in view.
+ *
+ * Since: 2.0
+ */
+void
+mx_grid_set_virtualized (MxGrid   *self,
+                         gboolean  value)
+{
+  MxGridPrivate *priv;
+
+  g_return_if_fail (MX_IS_GRID (self));
+
+  priv = self->priv;
+
+  if (priv->virtualized == value)
+    return;
+
+  /* The subclass repopulates the grid its own way when notified, so start
+   * from an empty grid either way.
+   */
+  if (mx_grid_has_item_source (self))
+    clutter_actor_remove_all_children (CLUTTER_ACTOR (self));
+
+  priv->virtualized = value;
+
+  mx_grid_update_items (self);
+  clutter_actor_queue_relayout (CLUTTER_ACTOR (self));
+
+  g_object_notify (G_OBJECT (self), "virtualized");
+}
+
+/**
+ * mx_grid_get_virtualized:
+ * @self: A #MxGrid
+ *
+ * Gets whether the grid only creates children for the items in view.
+ *
+ * Returns: %TRUE if the grid is virtualized
+ *
+ * Since: 2.0
+ */
+gboolean
+mx_grid_get_virtualized (MxGrid *self)
+{
+  g_return_val_if_fail (MX_IS_GRID (self), FALSE);
+
+  return self->priv->virtualized;
+}
+
 static void
 mx_grid_set_property (GObject      *object,
                       guint         prop_id,
@@ -1065,6 +1639,9 @@ mx_grid_set_property (GObject      *object,
     case PROP_MAX_STRIDE:
       mx_grid_set_max_stride (grid, g_value_get_int (value));
       break;
+    case PROP_VIRTUALIZED:
+      mx_grid_set_virtualized (grid, g_value_get_boolean (value));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1117,6 +1694,9 @@ mx_grid_get_property (GObject    *object,
     case PROP_MAX_STRIDE:
       g_value_set_int (value, mx_grid_get_max_stride (grid));
       break;
+    case PROP_VIRTUALIZED:
+      g_value_set_boolean (value, mx_grid_get_virtualized (grid));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1162,107 +1742,68 @@ mx_grid_actor_removed (ClutterContainer *container,
   MxGridPrivate *priv = layout->priv;
 
   g_hash_table_remove (priv->hash_table, actor);
+
+  /* forget about removed items; they're replaced before the next frame */
+  if (priv->items->len || priv->free_items)
+    {
+      priv->free_items = g_slist_remove (priv->free_items, actor);
+
+      if (g_ptr_array_remove (priv->items, actor))
+        {
+          mx_grid_realize_items (layout, 0, 0);
+          clutter_actor_queue_relayout (CLUTTER_ACTOR (layout));
+        }
+    }
 }
 
+/* paints (or picks) the children within the scrolled view */
 static void
-mx_grid_paint (ClutterActor *actor)
+mx_grid_paint_children (ClutterActor *actor)
 {
-  MxGrid *layout = (MxGrid *) actor;
-  MxGridPrivate *priv = layout->priv;
-  gfloat x, y;
   ClutterActorBox grid_b;
   ClutterActorIter iter;
   ClutterActor *child;
+  gboolean cull;
 
-  if (priv->hadjustment)
-    x = mx_adjustment_get_value (priv->hadjustment);
-  else
-    x = 0;
-
-  if (priv->vadjustment)
-    y = mx_adjustment_get_value (priv->vadjustment);
-  else
-    y = 0;
-
-  CLUTTER_ACTOR_CLASS (mx_grid_parent_class)->paint (actor);
-
-  clutter_actor_get_allocation_box (actor, &grid_b);
-  grid_b.x2 = (grid_b.x2 - grid_b.x1) + x;
-  grid_b.x1 = x;
-  grid_b.y2 = (grid_b.y2 - grid_b.y1) + y;
-  grid_b.y1 = y;
+  cull = mx_widget_get_view_area (MX_WIDGET (actor), &grid_b);
 
   clutter_actor_iter_init (&iter, actor);
   while (clutter_actor_iter_next (&iter, &child))
     {
-      ClutterActorBox child_b;
-
-      g_assert (child != NULL);
+      if (!CLUTTER_ACTOR_IS_VISIBLE (child))
+        continue;
 
       /* ensure the child is "on screen" */
-      clutter_actor_get_allocation_box (CLUTTER_ACTOR (child), &child_b);
-
-      if ((child_b.x1 < grid_b.x2)
-          && (child_b.x2 > grid_b.x1)
-          && (child_b.y1 < grid_b.y2)
-          && (child_b.y2 > grid_b.y1)
-          && CLUTTER_ACTOR_IS_VISIBLE (child))
-        {
-          clutter_actor_paint (child);
-        }
+      if (!cull || mx_widget_is_child_in_area (MX_WIDGET (actor), child,
+                                               &grid_b))
+        clutter_actor_paint (child);
     }
 }
 
 static void
-mx_grid_pick (ClutterActor       *actor,
-              const ClutterColor *color)
+mx_grid_paint (ClutterActor *actor)
 {
-  MxGrid *layout = (MxGrid *) actor;
-  MxGridPrivate *priv = layout->priv;
-  gfloat x, y;
-  ClutterActorBox grid_b;
-  ClutterActorIter iter;
-  ClutterActor *child;
-
-  if (priv->hadjustment)
-    x = mx_adjustment_get_value (priv->hadjustment);
-  else
-    x = 0;
-
-  if (priv->vadjustment)
-    y = mx_adjustment_get_value (priv->vadjustment);
-  else
-    y = 0;
+  MX_PROFILE_BEGIN (actor, PAINT);
 
-  /* Chain up so we get a bounding box pained (if we are reactive) */
-  CLUTTER_ACTOR_CLASS (mx_grid_parent_class)->pick (actor, color);
+  CLUTTER_ACTOR_CLASS (mx_grid_parent_class)->paint (actor);
 
+  mx_grid_paint_children (actor);
 
-  clutter_actor_get_allocation_box (actor, &grid_b);
-  grid_b.x2 = (grid_b.x2 - grid_b.x1) + x;
-  grid_b.x1 = x;
-  grid_b.y2 = (grid_b.y2 - grid_b.y1) + y;
-  grid_b.y1 = y;
+  MX_PROFILE_END (actor, PAINT);
+}
 
-  clutter_actor_iter_init (&iter, actor);
-  while (clutter_actor_iter_next (&iter, &child))
-    {
-      ClutterActorBox child_b;
+static void
+mx_grid_pick (ClutterActor       *actor,
+              const ClutterColor *color)
+{
+  MX_PROFILE_BEGIN (actor, PICK);
 
-      g_assert (child != NULL);
+  /* Chain up so we get a bounding box pained (if we are reactive) */
+  CLUTTER_ACTOR_CLASS (mx_grid_parent_class)->pick (actor, color);
 
-      /* ensure the child is "on screen" */
-      clutter_actor_get_allocation_box (CLUTTER_ACTOR (child), &child_b);
+  mx_grid_paint_children (actor);
 
-      if ((child_b.x1 < grid_b.x2)
-          && (child_b.x2 > grid_b.x1)
-          && (child_b.y1 < grid_b.y2)
-          && (child_b.y2 > grid_b.y1)
-          && CLUTTER_ACTOR_IS_VISIBLE (child))
-        {
-          clutter_actor_paint (child);
-        }
-    }
+  MX_PROFILE_END (actor, PICK);
 }
 
 static void
@@ -1274,6 +1815,8 @@ mx_grid_get_preferred_width (ClutterActor *self,
   gfloat actual_width, min_width;
   ClutterActorBox box;
 
+  MX_PROFILE_BEGIN (self, PREFERRED_SIZE);
+
   box.x1 = 0;
   box.y1 = 0;
   box.x2 = G_MAXFLOAT;
@@ -1286,6 +1829,8 @@ mx_grid_get_preferred_width (ClutterActor *self,
     *min_width_p = min_width;
   if (natural_width_p)
     *natural_width_p = actual_width;
+
+  MX_PROFILE_END (self, PREFERRED_SIZE);
 }
 
 static void
@@ -1297,6 +1842,8 @@ mx_grid_get_preferred_height (ClutterActor *self,
   gfloat actual_height, min_height;
   ClutterActorBox box;
 
+  MX_PROFILE_BEGIN (self, PREFERRED_SIZE);
+
   box.x1 = 0;
   box.y1 = 0;
   box.x2 = for_width;
@@ -1309,6 +1856,8 @@ mx_grid_get_preferred_height (ClutterActor *self,
     *min_height_p = min_height;
   if (natural_height_p)
     *natural_height_p = actual_height;
+
+  MX_PROFILE_END (self, PREFERRED_SIZE);
 }
 
 static gfloat
@@ -1430,6 +1979,120 @@ compute_row_start (ClutterActor     *container,
   return (priv->a_wrap - current_a);
 }
 
+/* allocation when the position of each item follows from its index */
+static void
+mx_grid_do_allocate_virtual (ClutterActor          *self,
+                             ClutterAllocationFlags flags,
+                             gboolean               calculate_extents_only,
+                             gfloat                *actual_width,
+                             gfloat                *actual_height,
+                             gfloat                *min_width,
+                             gfloat                *min_height)
+{
+  MxGrid *layout = (MxGrid *) self;
+  MxGridPrivate *priv = layout->priv;
+  gfloat cell_a, cell_b, agap, bgap;
+  gfloat extent_a, extent_b;
+  gint n_items, n_lines, stride;
+  gdouble aalign, balign;
+  MxPadding padding;
+  guint i;
+
+  /* items may have changed size since they were realized */
+  if (calculate_extents_only)
+    mx_grid_update_cell_size (layout);
+
+  mx_widget_get_padding (MX_WIDGET (self), &padding);
+
+  n_items = MX_GRID_GET_CLASS (layout)->get_n_items (layout);
+  stride = priv->max_stride;
+  n_lines = (n_items + stride - 1) / stride;
+
+  mx_grid_get_cell_extents (layout, &cell_a, &cell_b, &agap, &bgap);
+
+  extent_a = n_items ? MIN (n_items, stride) * (cell_a + agap) - agap : 0;
+  extent_b = n_lines ? n_lines * (cell_b + bgap) - bgap : 0;
+
+  if (priv->orientation == MX_ORIENTATION_VERTICAL)
+    {
+      if (actual_width)
+        *actual_width = padding.left + extent_b + padding.right;
+      if (actual_height)
+        *actual_height = padding.top + extent_a + padding.bottom;
+      if (min_width)
+        *min_width = padding.left + cell_b + padding.right;
+      if (min_height)
+        *min_height = padding.top + cell_a + padding.bottom;
+
+      aalign = MX_ALIGN_TO_FLOAT (priv->child_y_align);
+      balign = MX_ALIGN_TO_FLOAT (priv->child_x_align);
+    }
+  else
+    {
+      if (actual_width)
+        *actual_width = padding.left + extent_a + padding.right;
+      if (actual_height)
+        *actual_height = padding.top + extent_b + padding.bottom;
+      if (min_width)
+        *min_width = padding.left + cell_a + padding.right;
+      if (min_height)
+        *min_height = padding.top + cell_b + padding.bottom;
+
+      aalign = MX_ALIGN_TO_FLOAT (priv->child_x_align);
+      balign = MX_ALIGN_TO_FLOAT (priv->child_y_align);
+    }
+
+  if (calculate_extents_only)
+    return;
+
+  for (i = 0; i < priv->items->len; i++)
+    {
+      ClutterActor *child = g_ptr_array_index (priv->items, i);
+      gint index = priv->first_item + i;
+      gfloat natural_a, natural_b, a, b;
+      ClutterActorBox child_box;
+
+      clutter_actor_get_preferred_size (child, NULL, NULL,
+                                        &natural_a, &natural_b);
+
+      if (priv->orientation == MX_ORIENTATION_VERTICAL)
+        {
+          gfloat temp = natural_a;
+          natural_a = natural_b;
+          natural_b = temp;
+        }
+
+      natural_a = MIN (natural_a, cell_a);
+      natural_b = MIN (natural_b, cell_b);
+
+      a = (index % stride) * (cell_a + agap) + (cell_a - natural_a) * aalign;
+      b = (index / stride) * (cell_b + bgap) + (cell_b - natural_b) * balign;
+
+      if (priv->orientation == MX_ORIENTATION_VERTICAL)
+        {
+          child_box.x1 = b;
+          child_box.y1 = a;
+          child_box.x2 = b + natural_b;
+          child_box.y2 = a + natural_a;
+        }
+      else
+        {
+          child_box.x1 = a;
+          child_box.y1 = b;
+          child_box.x2 = a + natural_a;
+          child_box.y2 = b + natural_b;
+        }
+
+      /* account for padding and pixel-align */
+      child_box.x1 = (int)(child_box.x1 + padding.left);
+      child_box.y1 = (int)(child_box.y1 + padding.top);
+      child_box.x2 = (int)(child_box.x2 + padding.left);
+      child_box.y2 = (int)(child_box.y2 + padding.top);
+
+      clutter_actor_allocate (child, &child_box, flags);
+    }
+}
+
 static void
 mx_grid_do_allocate (ClutterActor          *self,
                      const ClutterActorBox *box,
@@ -1459,6 +2122,14 @@ mx_grid_do_allocate (ClutterActor          *self,
   ClutterActorIter iter;
   ClutterActor *child;
 
+  if (mx_grid_is_virtual (layout))
+    {
+      mx_grid_do_allocate_virtual (self, flags, calculate_extents_only,
+                                   actual_width, actual_height,
+                                   min_width, min_height);
+      return;
+    }
+
   mx_widget_get_padding (MX_WIDGET (self), &padding);
 
   if (actual_width)
@@ -1689,6 +2360,10 @@ mx_grid_allocate (ClutterActor          *self,
   MxGridPrivate *priv = MX_GRID (self)->priv;
   ClutterActorBox alloc_box = *box;
 
+  MX_PROFILE_BEGIN (self, ALLOCATE);
+
+  priv->in_allocation = TRUE;
+
   /* chain up here to preserve the allocated size
    *
    * (we ignore the height of the allocation if we have a vadjustment set,
@@ -1698,7 +2373,6 @@ mx_grid_allocate (ClutterActor          *self,
   CLUTTER_ACTOR_CLASS (mx_grid_parent_class)
   ->allocate (self, box, flags);
 
-
   /* only update vadjustment - we don't really want horizontal scrolling */
   if (priv->vadjustment && priv->orientation == MX_ORIENTATION_HORIZONTAL)
     {
@@ -1766,6 +2440,58 @@ mx_grid_allocate (ClutterActor          *self,
 
   mx_grid_do_allocate (self, &alloc_box, flags, FALSE, NULL, NULL,
       NULL, NULL);
+
+  priv->in_allocation = FALSE;
+
+  /* a new size may have brought more items into view; they are realized
+   * before the next layout, see mx_grid_pre_paint_cb() */
+  if (mx_grid_is_virtual (MX_GRID (self)) &&
+      mx_grid_needs_realize (MX_GRID (self)))
+    clutter_actor_queue_redraw (self);
+
+  MX_PROFILE_END (self, ALLOCATE);
+}
+
+/*
+ * _mx_grid_invalidate_items:
+ * @grid: A #MxGrid
+ *
+ * Called by subclasses providing items when the items change, so that the
+ * children are bound again.
+ */
+void
+_mx_grid_invalidate_items (MxGrid *grid)
+{
+  g_return_if_fail (MX_IS_GRID (grid));
+
+  mx_grid_update_items (grid);
+  clutter_actor_queue_relayout (CLUTTER_ACTOR (grid));
+}
+
+/*
+ * _mx_grid_get_item:
+ * @grid: A #MxGrid
+ * @index: An item index
+ *
+ * Gets the child currently showing the item at @index, when virtualized.
+ *
+ * Returns: the child, or %NULL if the item isn't realized
+ */
+ClutterActor *
+_mx_grid_get_item (MxGrid *grid,
+                   guint   index)
+{
+  MxGridPrivate *priv;
+
+  g_return_val_if_fail (MX_IS_GRID (grid), NULL);
+
+  priv = grid->priv;
+
+  if ((gint) index < priv->first_item ||
+      (gint) index >= priv->first_item + (gint) priv->items->len)
+    return NULL;
+
+  return g_ptr_array_index (priv->items, index - priv->first_item);
 }
 
 
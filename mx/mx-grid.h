@@ -59,16 +59,33 @@ typedef struct _MxGrid        MxGrid;
 typedef struct _MxGridClass   MxGridClass;
 typedef struct _MxGridPrivate MxGridPrivate;
 
+/**
+ * MxGridClass:
+ * @get_n_items: returns the number of items, when the items are provided by
+ *   the subclass
+ * @create_item: creates a new, unbound item
+ * @bind_item: sets up an item created by @create_item to show the item at
+ *   the given index
+ *
+ * When a subclass implements @get_n_items, @create_item and @bind_item,
+ * the grid creates its children itself when #MxGrid:virtualized is set.
+ */
 struct _MxGridClass
 {
+  /*< private >*/
   MxWidgetClass parent_class;
 
+  /*< public >*/
+  guint          (*get_n_items) (MxGrid       *grid);
+  ClutterActor * (*create_item) (MxGrid       *grid);
+  void           (*bind_item)   (MxGrid       *grid,
+                                 ClutterActor *item,
+                                 guint         index);
+
+  /*< private >*/
   /* padding for future expansion */
   void (*_padding_0) (void);
   void (*_padding_1) (void);
-  void (*_padding_2) (void);
-  void (*_padding_3) (void);
-  void (*_padding_4) (void);
 };
 
 /**
@@ -119,6 +136,10 @@ void mx_grid_set_max_stride (MxGrid *self,
                              gint    value);
 gint mx_grid_get_max_stride (MxGrid *self);
 
+void     mx_grid_set_virtualized (MxGrid   *self,
+                                  gboolean  value);
+gboolean mx_grid_get_virtualized (MxGrid   *self);
+
 G_END_DECLS
 
 #endif /* __MX_GRID_H__ */
@@ -24,10 +24,20 @@
  * or scaled to fit within the allocation. A transition effect occurs when a
  * new image is loaded.
  *
+ * Animated images (such as GIF or APNG files) can be played back using
+ * mx_image_set_from_animation_file(). Frames are decoded incrementally in a
+ * worker thread, and only a small number of decoded frames are kept ahead of
+ * the one being displayed (see #MxImage:frame-cache-size). Playback follows
+ * the stage frame clock and pauses while the image is unmapped or fully
+ * clipped.
+ *
  *
  * Since: 1.2
  */
 
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
 #include <unistd.h>
 #include <cogl/cogl.h>
 
@@ -35,7 +45,11 @@
 #include "mx-enum-types.h"
 #include "mx-marshal.h"
 #include "mx-texture-cache.h"
+#include "mx-buffer-pool.h"
+#include "mx-private.h"
 
+#include <string.h>
+#include <glib/gstdio.h>
 #include <gdk-pixbuf/gdk-pixbuf.h>
 
 G_DEFINE_TYPE (MxImage, mx_image, MX_TYPE_WIDGET)
@@ -44,6 +58,17 @@ G_DEFINE_TYPE (MxImage, mx_image, MX_TYPE_WIDGET)
   (G_TYPE_INSTANCE_GET_PRIVATE ((obj), MX_TYPE_IMAGE, MxImagePrivate))
 
 #define DEFAULT_DURATION 250
+#define DEFAULT_FRAME_CACHE_SIZE 4
+
+/* Shortest frame delay honoured when playing back animations, in ms. Many
+ * GIF files specify 0 and rely on the viewer to pick something sensible.
+ */
+#define MIN_FRAME_DELAY 20
+
+/* Every task pushed onto the decoding thread-pool starts with a pointer to
+ * the function that processes it, see mx_image_thread_func().
+ */
+typedef void (*MxImageTaskFunc) (gpointer task_data);
 
 /* This stucture holds all that is necessary for cancellable async
  * image loading using thread pools.
@@ -65,6 +90,8 @@ G_DEFINE_TYPE (MxImage, mx_image, MX_TYPE_WIDGET)
  */
 typedef struct
 {
+  MxImageTaskFunc run;
+
   MxImage   *parent;
 
   GMutex          mutex;
@@ -73,6 +100,10 @@ typedef struct
   guint           upscale   : 1;
   guint           idle_handler;
 
+  /* order in the thread-pool queue, see mx_image_task_compare() */
+  gboolean        prefetch;
+  guint           serial;
+
   gchar          *filename;
   guchar         *buffer;
   gsize           count;
@@ -87,12 +118,72 @@ typedef struct
   GError         *error;
 } MxImageAsyncData;
 
+/* A decoded animation frame. The pixels are held in a buffer from the
+ * shared pixel buffer pool, which is returned once the frame is uploaded.
+ */
+typedef struct
+{
+  guchar   *pixels;
+  gint      width;
+  gint      height;
+  gint      rowstride;
+  gboolean  has_alpha;
+  gint      delay;
+} MxImageFrame;
+
+/* State for animated image playback. This is shared between the main thread
+ * and the decoding thread-pool, and is reference counted: the MxImage holds
+ * a reference while the animation is playing and every queued decode task or
+ * idle callback holds another one.
+ *
+ * Frames are decoded ahead of time into a bounded ring buffer. A decode task
+ * fills the ring and then finishes; the main thread consumes frames as the
+ * stage frame clock advances and pushes a new decode task when there is room
+ * again. At most one decode task is in flight at any time ('decoding' is set),
+ * so the GdkPixbufAnimationIter is only ever touched by a single thread.
+ *
+ * The ring and the flags are protected by the mutex. 'parent' is only
+ * accessed from the main thread, and is reset when the animation is
+ * cancelled.
+ */
+typedef struct
+{
+  MxImageTaskFunc         run;
+
+  volatile gint           ref_count;
+
+  MxImage                *parent;
+
+  GMutex                  mutex;
+  guint                   cancelled : 1;
+  guint                   decoding  : 1;
+  guint                   finished  : 1;
+
+  gchar                  *filename;
+  GdkPixbufAnimation     *animation;
+  GdkPixbufAnimationIter *iter;
+  GTimeVal                iter_time;
+
+  MxImageFrame           *frames;
+  guint                   n_frames;
+  guint                   head;
+  guint                   length;
+
+  GError                 *error;
+} MxImageAnimation;
+
 struct _MxImagePrivate
 {
   MxImageScaleMode mode;
   MxImageScaleMode previous_mode;
   guint            load_async : 1;
   guint            upscale    : 1;
+
+  guint            frame_shown          : 1;
+  guint            frame_hold           : 1;
+  guint            frame_redraw_pending : 1;
+  guint            animation_clipped    : 1;
+
   guint            width_threshold;
   guint            height_threshold;
 
@@ -113,6 +204,11 @@ struct _MxImagePrivate
   guint transition_duration;
 
   MxImageAsyncData *async_load_data;
+
+  MxImageAnimation *animation;
+  ClutterTimeline  *animation_timeline;
+  guint             frame_cache_size;
+  gint              frame_delay;
 };
 
 enum
@@ -127,6 +223,7 @@ enum
   PROP_IMAGE_ROTATION,
   PROP_TRANSITION_DURATION,
   PROP_FILENAME,
+  PROP_FRAME_CACHE_SIZE,
 
   LAST_PROP
 };
@@ -144,6 +241,10 @@ static guint signals[LAST_SIGNAL] = { 0, };
 static GThreadPool *mx_image_threads = NULL;
 static GQuark mx_image_cache_quark = 0;
 
+/* see _mx_image_set_prefetching() */
+static gboolean mx_image_prefetching = FALSE;
+static guint mx_image_serial = 0;
+
 static gboolean
 mx_image_set_from_data_internal (MxImage          *image,
                                  const guchar     *data,
@@ -155,6 +256,9 @@ mx_image_set_from_data_internal (MxImage          *image,
                                  gint              rowstride,
                                  GError          **error);
 
+static void mx_image_async_cb (gpointer task_data);
+static void mx_image_animation_cancel (MxImage *image);
+
 GQuark
 mx_image_error_quark (void)
 {
@@ -186,6 +290,7 @@ mx_image_async_data_new (MxImage *parent)
 {
   MxImageAsyncData *data = g_new0 (MxImageAsyncData, 1);
 
+  data->run = mx_image_async_cb;
   data->parent = parent;
   g_mutex_init (&data->mutex);
   data->width = -1;
@@ -193,6 +298,8 @@ mx_image_async_data_new (MxImage *parent)
   data->upscale = parent->priv->upscale;
   data->width_threshold = parent->priv->width_threshold;
   data->height_threshold = parent->priv->height_threshold;
+  data->prefetch = mx_image_prefetching;
+  data->serial = ++mx_image_serial;
 
   return data;
 }
@@ -277,6 +384,16 @@ mx_image_paint (ClutterActor *actor)
   /* chain up to draw the background */
   CLUTTER_ACTOR_CLASS (mx_image_parent_class)->paint (actor);
 
+  /* The last animation frame made it to the screen; if playback was paused
+   * because the image was clipped away, it is visible again now.
+   */
+  priv->frame_redraw_pending = FALSE;
+  if (priv->animation_clipped)
+    {
+      priv->animation_clipped = FALSE;
+      clutter_timeline_start (priv->animation_timeline);
+    }
+
   if (!priv->material)
     return;
 
@@ -458,6 +575,10 @@ mx_image_set_property (GObject      *object,
       mx_image_set_from_file (image, g_value_get_string (value), NULL);
       break;
 
+    case PROP_FRAME_CACHE_SIZE:
+      mx_image_set_frame_cache_size (image, g_value_get_uint (value));
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -502,6 +623,10 @@ mx_image_get_property (GObject    *object,
       g_value_set_uint (value, priv->transition_duration);
       break;
 
+    case PROP_FRAME_CACHE_SIZE:
+      g_value_set_uint (value, priv->frame_cache_size);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -513,6 +638,15 @@ mx_image_dispose (GObject *object)
 {
   MxImagePrivate *priv = MX_IMAGE (object)->priv;
 
+  mx_image_animation_cancel (MX_IMAGE (object));
+
+  if (priv->animation_timeline)
+    {
+      g_object_unref (priv->animation_timeline);
+
+      priv->animation_timeline = NULL;
+    }
+
   if (priv->timeline)
     {
       clutter_timeline_stop (priv->timeline);
@@ -575,6 +709,31 @@ mx_image_dispose (GObject *object)
   G_OBJECT_CLASS (mx_image_parent_class)->dispose (object);
 }
 
+static void
+mx_image_map (ClutterActor *actor)
+{
+  MxImagePrivate *priv = MX_IMAGE (actor)->priv;
+
+  CLUTTER_ACTOR_CLASS (mx_image_parent_class)->map (actor);
+
+  priv->frame_redraw_pending = FALSE;
+  if (priv->animation && !priv->frame_hold)
+    clutter_timeline_start (priv->animation_timeline);
+}
+
+static void
+mx_image_unmap (ClutterActor *actor)
+{
+  MxImagePrivate *priv = MX_IMAGE (actor)->priv;
+
+  if (priv->animation_timeline)
+    clutter_timeline_pause (priv->animation_timeline);
+
+  priv->animation_clipped = FALSE;
+
+  CLUTTER_ACTOR_CLASS (mx_image_parent_class)->unmap (actor);
+}
+
 static void
 mx_image_class_init (MxImageClass *klass)
 {
@@ -590,6 +749,8 @@ mx_image_class_init (MxImageClass *klass)
   object_class->get_property = mx_image_get_property;
 
   actor_class->paint = mx_image_paint;
+  actor_class->map = mx_image_map;
+  actor_class->unmap = mx_image_unmap;
   actor_class->get_preferred_width = mx_image_get_preferred_width;
   actor_class->get_preferred_height = mx_image_get_preferred_height;
 
@@ -663,6 +824,23 @@ mx_image_class_init (MxImageClass *klass)
 
   g_object_class_install_property (object_class, PROP_FILENAME, pspec);
 
+  /**
+   * MxImage:frame-cache-size:
+   *
+   * The number of animation frames that are decoded ahead of the frame
+   * currently being displayed. Changes take effect the next time an
+   * animation is set.
+   *
+   * Since: 2.0
+   */
+  pspec = g_param_spec_uint ("frame-cache-size",
+                             "Frame cache size",
+                             "Number of animation frames to decode ahead",
+                             1, G_MAXUINT, DEFAULT_FRAME_CACHE_SIZE,
+                             G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  g_object_class_install_property (object_class, PROP_FRAME_CACHE_SIZE, pspec);
+
   /**
    * MxImage::image-loaded:
    * @image: the #MxImage that emitted the signal
@@ -783,6 +961,7 @@ mx_image_init (MxImage *self)
   priv = self->priv = MX_IMAGE_GET_PRIVATE (self);
 
   priv->transition_duration = DEFAULT_DURATION;
+  priv->frame_cache_size = DEFAULT_FRAME_CACHE_SIZE;
   priv->timeline = clutter_timeline_new (priv->transition_duration);
   priv->redraw_timeline = clutter_timeline_new (200);
   clutter_timeline_set_progress_mode (priv->redraw_timeline,
@@ -972,6 +1151,9 @@ mx_image_cancel_in_progress (MxImage *image)
       priv->async_load_data->cancelled = TRUE;
       priv->async_load_data = NULL;
     }
+
+  /* Stop any animation playback */
+  mx_image_animation_cancel (image);
 }
 
 /**
@@ -1103,7 +1285,9 @@ mx_image_set_from_data_internal (MxImage          *image,
                                pixel_format, rowstride, data);
 
       /* Blit a transparent buffer around the texture */
-      blank_area = g_new0 (gint, MAX (width, height) + 2);
+      blank_area = _mx_buffer_pool_alloc ((MAX (width, height) + 2) *
+                                          sizeof (gint));
+      memset (blank_area, 0, (MAX (width, height) + 2) * sizeof (gint));
       cogl_texture_set_region (priv->texture, 0, 0, 0, 0,
                                width, 1, width, 1,
                                COGL_PIXEL_FORMAT_RGBA_8888, (width + 2) * 4,
@@ -1120,7 +1304,7 @@ mx_image_set_from_data_internal (MxImage          *image,
                                1, height + 2, 1, height + 2,
                                COGL_PIXEL_FORMAT_RGBA_8888, 4,
                                (const guint8 *)blank_area);
-      g_free (blank_area);
+      _mx_buffer_pool_free (blank_area);
 
       /* Insert the processed image into the cache, if we have a URI */
       if (uri)
@@ -1307,6 +1491,10 @@ mx_image_load_complete_cb (gpointer task_data)
             mx_image_set_from_pixbuf (data->parent, data->pixbuf,
                                       resized ? data->filename : NULL, &error);
 
+          /* the pixels are in the texture now, give the buffer back */
+          g_object_unref (data->pixbuf);
+          data->pixbuf = NULL;
+
           if (success)
             g_signal_emit (data->parent, signals[IMAGE_LOADED], 0);
           else
@@ -1390,6 +1578,94 @@ mx_image_size_prepared_cb (GdkPixbufLoader *loader,
     }
 }
 
+/*
+ * mx_image_read_file:
+ * @filename: A local file path
+ * @count: Return location for the size of the file
+ * @error: A pointer to a #GError
+ *
+ * Reads the encoded contents of @filename. Images in a scrolling list are
+ * loaded one after another, so the buffer comes from the buffer pool rather
+ * than the system allocator.
+ *
+ * Returns: A buffer to be released with _mx_buffer_pool_free(), or %NULL on
+ *   failure (@error will be set)
+ */
+static guchar *
+mx_image_read_file (const gchar  *filename,
+                    gsize        *count,
+                    GError      **error)
+{
+  struct stat stat_buf;
+  guchar *buffer;
+  gchar *contents;
+  gsize bytes_read;
+  gint fd;
+
+  fd = g_open (filename, O_RDONLY, 0);
+  if (fd < 0)
+    {
+      gint saved_errno = errno;
+
+      g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (saved_errno),
+                   "Failed to open file '%s': %s", filename,
+                   g_strerror (saved_errno));
+      return NULL;
+    }
+
+  if (fstat (fd, &stat_buf) < 0 || !S_ISREG (stat_buf.st_mode))
+    {
+      close (fd);
+
+      /* let GLib deal with anything that isn't a regular file, and copy
+       * the result so that it can be freed like the other buffers */
+      if (!g_file_get_contents (filename, &contents, count, error))
+        return NULL;
+
+      buffer = _mx_buffer_pool_alloc (MAX (*count, 1));
+      memcpy (buffer, contents, *count);
+      g_free (contents);
+
+      return buffer;
+    }
+
+  buffer = _mx_buffer_pool_alloc (MAX (stat_buf.st_size, 1));
+
+  bytes_read = 0;
+  while (bytes_read < (gsize) stat_buf.st_size)
+    {
+      gssize n = read (fd, buffer + bytes_read, stat_buf.st_size - bytes_read);
+
+      if (n < 0)
+        {
+          gint saved_errno = errno;
+
+          if (saved_errno == EINTR)
+            continue;
+
+          g_set_error (error, G_FILE_ERROR,
+                       g_file_error_from_errno (saved_errno),
+                       "Failed to read from file '%s': %s", filename,
+                       g_strerror (saved_errno));
+          _mx_buffer_pool_free (buffer);
+          close (fd);
+          return NULL;
+        }
+
+      /* the file was truncated while reading it */
+      if (n == 0)
+        break;
+
+      bytes_read += n;
+    }
+
+  close (fd);
+
+  *count = bytes_read;
+
+  return buffer;
+}
+
 /*
  * mx_image_pixbuf_new:
  * @filename: A local file path, or %NULL
@@ -1439,7 +1715,8 @@ mx_image_pixbuf_new (const gchar  *filename,
 
   if (filename)
     {
-      if (!g_file_get_contents (filename, (gchar **)&buffer, &count, &err))
+      buffer = mx_image_read_file (filename, &count, &err);
+      if (!buffer)
         {
           if (error)
             g_propagate_error (error, err);
@@ -1448,7 +1725,8 @@ mx_image_pixbuf_new (const gchar  *filename,
           return NULL;
         }
 
-      g_object_weak_ref (G_OBJECT (loader), (GWeakNotify)g_free, buffer);
+      g_object_weak_ref (G_OBJECT (loader), (GWeakNotify)_mx_buffer_pool_free,
+                         buffer);
     }
 
   if (!buffer)
@@ -1488,9 +1766,49 @@ mx_image_pixbuf_new (const gchar  *filename,
   return pixbuf;
 }
 
+/*
+ * mx_image_pixbuf_new_pooled:
+ * @pixbuf: A decoded #GdkPixbuf
+ *
+ * Moves the pixels of @pixbuf into a buffer from the pool. The decoders
+ * allocate the pixels themselves, so this lets them be released on the
+ * decoding thread straight away, while the pixels that wait for the upload
+ * on the main thread come from the pool and go back to it once uploaded.
+ *
+ * Returns: A new #GdkPixbuf using a pooled buffer, or a new reference to
+ *   @pixbuf if the pool can't be used
+ */
+static GdkPixbuf *
+mx_image_pixbuf_new_pooled (GdkPixbuf *pixbuf)
+{
+  gint width, height, channels, rowstride;
+  GdkPixbuf *pooled;
+  guchar *pixels;
+
+  width = gdk_pixbuf_get_width (pixbuf);
+  height = gdk_pixbuf_get_height (pixbuf);
+  channels = gdk_pixbuf_get_n_channels (pixbuf);
+
+  if (gdk_pixbuf_get_bits_per_sample (pixbuf) != 8 ||
+      width > (G_MAXINT - 3) / channels)
+    return g_object_ref (pixbuf);
+
+  rowstride = (width * channels + 3) & ~3;
+  pixels = _mx_buffer_pool_alloc ((gsize) rowstride * height);
+
+  pooled = gdk_pixbuf_new_from_data (pixels, GDK_COLORSPACE_RGB,
+                                     gdk_pixbuf_get_has_alpha (pixbuf), 8,
+                                     width, height, rowstride,
+                                     (GdkPixbufDestroyNotify)
+                                       _mx_buffer_pool_free,
+                                     NULL);
+  gdk_pixbuf_copy_area (pixbuf, 0, 0, width, height, pooled, 0, 0);
+
+  return pooled;
+}
+
 static void
-mx_image_async_cb (gpointer task_data,
-                   gpointer user_data)
+mx_image_async_cb (gpointer task_data)
 {
   gboolean scaled;
   MxImageAsyncData *data = task_data;
@@ -1518,6 +1836,15 @@ mx_image_async_cb (gpointer task_data,
                                       &scaled,
                                       &data->error);
 
+  /* Keep the pixels in the pool until they are uploaded */
+  if (data->pixbuf)
+    {
+      GdkPixbuf *pooled = mx_image_pixbuf_new_pooled (data->pixbuf);
+
+      g_object_unref (data->pixbuf);
+      data->pixbuf = pooled;
+    }
+
   /* If scaling was unnecessary, we can cache the result */
   if (!scaled)
     {
@@ -1533,6 +1860,73 @@ mx_image_async_cb (gpointer task_data,
   g_mutex_unlock (&data->mutex);
 }
 
+static void
+mx_image_thread_func (gpointer task_data,
+                      gpointer user_data)
+{
+  MxImageTaskFunc run = *((MxImageTaskFunc *) task_data);
+
+  run (task_data);
+}
+
+/* Queued tasks run in the order they were pushed, except that image loads
+ * requested while prefetching wait for all the others. Animation decoding
+ * only happens for images being shown, so it always goes first.
+ */
+static gint
+mx_image_task_compare (gconstpointer a,
+                       gconstpointer b,
+                       gpointer      user_data)
+{
+  const MxImageAsyncData *data_a = a;
+  const MxImageAsyncData *data_b = b;
+  gboolean prefetch_a, prefetch_b;
+  guint serial_a, serial_b;
+
+  if (data_a->run == mx_image_async_cb)
+    {
+      prefetch_a = data_a->prefetch;
+      serial_a = data_a->serial;
+    }
+  else
+    prefetch_a = serial_a = 0;
+
+  if (data_b->run == mx_image_async_cb)
+    {
+      prefetch_b = data_b->prefetch;
+      serial_b = data_b->serial;
+    }
+  else
+    prefetch_b = serial_b = 0;
+
+  if (prefetch_a != prefetch_b)
+    return prefetch_a ? 1 : -1;
+
+  return (serial_a > serial_b) - (serial_a < serial_b);
+}
+
+static GThreadPool *
+mx_image_get_thread_pool (GError **error)
+{
+  if (!mx_image_threads)
+    {
+      mx_image_threads = g_thread_pool_new (mx_image_thread_func, NULL,
+#ifdef _SC_NPROCESSORS_ONLN
+                                            sysconf (_SC_NPROCESSORS_ONLN),
+#else
+                                            /* FIXME: add more OSs */
+                                            1,
+#endif
+                                            FALSE, error);
+
+      if (mx_image_threads)
+        g_thread_pool_set_sort_function (mx_image_threads,
+                                         mx_image_task_compare, NULL);
+    }
+
+  return mx_image_threads;
+}
+
 static gboolean
 mx_image_set_async (MxImage         *image,
                     const gchar     *filename,
@@ -1569,21 +1963,10 @@ mx_image_set_async (MxImage         *image,
   data = NULL;
 
   /* Load the pixbuf in a thread, then later on upload it to the GPU */
-  if (!mx_image_threads)
+  if (!mx_image_get_thread_pool (&err))
     {
-      mx_image_threads = g_thread_pool_new (mx_image_async_cb, NULL,
-#ifdef _SC_NPROCESSORS_ONLN
-                                            sysconf (_SC_NPROCESSORS_ONLN),
-#else
-                                            /* FIXME: add more OSs */
-                                            1,
-#endif
-                                            FALSE, &err);
-      if (!mx_image_threads)
-        {
-          g_propagate_error (error, err);
-          return FALSE;
-        }
+      g_propagate_error (error, err);
+      return FALSE;
     }
 
   /* Cancel/free any in-progress load */
@@ -1638,6 +2021,457 @@ mx_image_set_async (MxImage         *image,
   return TRUE;
 }
 
+static MxImageAnimation *
+mx_image_animation_ref (MxImageAnimation *anim)
+{
+  g_atomic_int_inc (&anim->ref_count);
+  return anim;
+}
+
+static void
+mx_image_animation_unref (MxImageAnimation *anim)
+{
+  guint i;
+
+  if (!g_atomic_int_dec_and_test (&anim->ref_count))
+    return;
+
+  for (i = 0; i < anim->n_frames; i++)
+    _mx_buffer_pool_free (anim->frames[i].pixels);
+  g_free (anim->frames);
+
+  if (anim->iter)
+    g_object_unref (anim->iter);
+
+  if (anim->animation)
+    g_object_unref (anim->animation);
+
+  if (anim->error)
+    g_error_free (anim->error);
+
+  g_free (anim->filename);
+  g_mutex_clear (&anim->mutex);
+
+  g_free (anim);
+}
+
+static gboolean
+mx_image_animation_error_cb (gpointer task_data)
+{
+  MxImageAnimation *anim = task_data;
+  MxImage *image = anim->parent;
+
+  /* The parent is reset on the main thread when the animation is cancelled,
+   * so if it's still set, this is still the animation being played.
+   */
+  if (image)
+    {
+      GError *error = anim->error;
+
+      anim->error = NULL;
+      mx_image_animation_cancel (image);
+
+      g_signal_emit (image, signals[IMAGE_LOAD_ERROR], 0, error);
+      g_error_free (error);
+    }
+
+  return FALSE;
+}
+
+static gboolean
+mx_image_animation_ring_full (MxImageAnimation *anim)
+{
+  gboolean full;
+
+  g_mutex_lock (&anim->mutex);
+  full = anim->cancelled || (anim->length == anim->n_frames);
+  g_mutex_unlock (&anim->mutex);
+
+  return full;
+}
+
+static void
+mx_image_animation_decode (gpointer task_data)
+{
+  MxImageAnimation *anim = task_data;
+  gboolean finished = FALSE;
+
+  /* The animation is opened lazily, on the first decode task */
+  if (!anim->animation && !mx_image_animation_ring_full (anim))
+    {
+      GError *error = NULL;
+
+      anim->animation = gdk_pixbuf_animation_new_from_file (anim->filename,
+                                                            &error);
+      if (!anim->animation)
+        {
+          g_mutex_lock (&anim->mutex);
+          anim->error = error;
+          anim->decoding = FALSE;
+          if (!anim->cancelled)
+            clutter_threads_add_idle_full (G_PRIORITY_HIGH_IDLE,
+                                           mx_image_animation_error_cb,
+                                           mx_image_animation_ref (anim),
+                                           (GDestroyNotify)
+                                             mx_image_animation_unref);
+          g_mutex_unlock (&anim->mutex);
+
+          mx_image_animation_unref (anim);
+          return;
+        }
+
+      anim->iter = gdk_pixbuf_animation_get_iter (anim->animation,
+                                                  &anim->iter_time);
+    }
+
+  /* Decode frames until the ring is full. The iterator is advanced using a
+   * synthetic clock, so that it steps exactly one frame at a time no matter
+   * how long decoding takes.
+   */
+  while (!finished && !mx_image_animation_ring_full (anim))
+    {
+      MxImageFrame frame;
+      GdkPixbuf *pixbuf;
+      const guchar *src;
+      gint row, row_length;
+
+      /* The iterator re-uses its pixbuf, so copy the pixels out into a
+       * pooled buffer, tightly packed.
+       */
+      pixbuf = gdk_pixbuf_animation_iter_get_pixbuf (anim->iter);
+      frame.width = gdk_pixbuf_get_width (pixbuf);
+      frame.height = gdk_pixbuf_get_height (pixbuf);
+      frame.has_alpha = gdk_pixbuf_get_has_alpha (pixbuf);
+      row_length = frame.width * gdk_pixbuf_get_n_channels (pixbuf);
+      frame.rowstride = row_length;
+      frame.pixels = _mx_buffer_pool_alloc (row_length * frame.height);
+
+      src = gdk_pixbuf_get_pixels (pixbuf);
+      for (row = 0; row < frame.height; row++)
+        memcpy (frame.pixels + row * row_length,
+                src + row * gdk_pixbuf_get_rowstride (pixbuf),
+                row_length);
+
+      frame.delay = gdk_pixbuf_animation_iter_get_delay_time (anim->iter);
+
+      /* A negative delay means the frame is to be displayed forever; that is
+       * either the last frame of a non-looping animation or a still image.
+       */
+      if (frame.delay < 0)
+        finished = TRUE;
+      else
+        {
+          frame.delay = MAX (frame.delay, MIN_FRAME_DELAY);
+          g_time_val_add (&anim->iter_time, frame.delay * 1000);
+          gdk_pixbuf_animation_iter_advance (anim->iter, &anim->iter_time);
+        }
+
+      g_mutex_lock (&anim->mutex);
+      anim->frames[(anim->head + anim->length) % anim->n_frames] = frame;
+      anim->length++;
+      g_mutex_unlock (&anim->mutex);
+    }
+
+  g_mutex_lock (&anim->mutex);
+  anim->decoding = FALSE;
+  if (finished)
+    anim->finished = TRUE;
+  g_mutex_unlock (&anim->mutex);
+
+  mx_image_animation_unref (anim);
+}
+
+static void
+mx_image_animation_upload_frame (MxImage      *image,
+                                 MxImageFrame *frame,
+                                 gboolean      first_frame)
+{
+  MxImagePrivate *priv = image->priv;
+  MxImageAnimation *anim;
+  CoglPixelFormat format;
+  gint width, height;
+  GError *error = NULL;
+
+  width = frame->width;
+  height = frame->height;
+  format = frame->has_alpha ? COGL_PIXEL_FORMAT_RGBA_8888 :
+                              COGL_PIXEL_FORMAT_RGB_888;
+
+  /* Subsequent frames of the same size are written straight into the
+   * current texture, inside its 1-pixel transparent border.
+   */
+  if (!first_frame &&
+      (cogl_texture_get_width (priv->texture) == width + 2) &&
+      (cogl_texture_get_height (priv->texture) == height + 2))
+    {
+      cogl_texture_set_region (priv->texture, 0, 0, 1, 1,
+                               width, height, width, height,
+                               format, frame->rowstride, frame->pixels);
+      clutter_actor_queue_redraw (CLUTTER_ACTOR (image));
+      return;
+    }
+
+  /* Creating a new texture would cancel the animation, so detach it while
+   * the texture is replaced.
+   */
+  anim = priv->animation;
+  priv->animation = NULL;
+
+  if (mx_image_set_from_data_internal (image, frame->pixels, NULL, FALSE,
+                                       format, width, height,
+                                       frame->rowstride, &error))
+    {
+      priv->animation = anim;
+
+      if (first_frame)
+        g_signal_emit (image, signals[IMAGE_LOADED], 0);
+    }
+  else
+    {
+      priv->animation = anim;
+      mx_image_animation_cancel (image);
+
+      g_signal_emit (image, signals[IMAGE_LOAD_ERROR], 0, error);
+      g_error_free (error);
+    }
+}
+
+static void
+mx_image_animation_new_frame_cb (ClutterTimeline *timeline,
+                                 gint             msecs,
+                                 MxImage         *image)
+{
+  MxImagePrivate *priv = image->priv;
+  MxImageAnimation *anim = priv->animation;
+  MxImageFrame frame = { NULL, };
+  gboolean refill, first_frame;
+
+  if (!anim)
+    return;
+
+  /* If the last frame we uploaded was never painted, the image was culled
+   * because it's fully clipped; pause until it gets painted again.
+   */
+  if (priv->frame_redraw_pending)
+    {
+      priv->animation_clipped = TRUE;
+      clutter_timeline_pause (timeline);
+      return;
+    }
+
+  first_frame = !priv->frame_shown;
+  if (!first_frame)
+    priv->frame_delay -= clutter_timeline_get_delta (timeline);
+
+  g_mutex_lock (&anim->mutex);
+
+  /* Pop frames until we've caught up with the clock. If we've fallen behind,
+   * the frames in between are dropped and only the last one is uploaded.
+   */
+  while (anim->length && !priv->frame_hold &&
+         (!priv->frame_shown || priv->frame_delay <= 0))
+    {
+      _mx_buffer_pool_free (frame.pixels);
+
+      frame = anim->frames[anim->head];
+      anim->frames[anim->head].pixels = NULL;
+      anim->head = (anim->head + 1) % anim->n_frames;
+      anim->length--;
+
+      if (frame.delay < 0)
+        priv->frame_hold = TRUE;
+      else
+        priv->frame_delay += frame.delay;
+
+      priv->frame_shown = TRUE;
+    }
+
+  refill = !anim->decoding && !anim->finished &&
+           (anim->length < anim->n_frames);
+  if (refill)
+    anim->decoding = TRUE;
+
+  g_mutex_unlock (&anim->mutex);
+
+  if (refill)
+    g_thread_pool_push (mx_image_threads, mx_image_animation_ref (anim), NULL);
+
+  if (!frame.pixels)
+    return;
+
+  mx_image_animation_upload_frame (image, &frame, first_frame);
+  _mx_buffer_pool_free (frame.pixels);
+
+  /* Uploading a frame may have failed and cancelled the animation */
+  if (!priv->animation)
+    return;
+
+  priv->frame_redraw_pending = TRUE;
+
+  /* Nothing more to do once the final frame is on screen */
+  if (priv->frame_hold)
+    clutter_timeline_stop (timeline);
+}
+
+static void
+mx_image_animation_cancel (MxImage *image)
+{
+  MxImagePrivate *priv = image->priv;
+  MxImageAnimation *anim = priv->animation;
+
+  if (!anim)
+    return;
+
+  clutter_timeline_stop (priv->animation_timeline);
+
+  g_mutex_lock (&anim->mutex);
+  anim->cancelled = TRUE;
+  g_mutex_unlock (&anim->mutex);
+
+  anim->parent = NULL;
+  mx_image_animation_unref (anim);
+
+  priv->animation = NULL;
+  priv->frame_shown = FALSE;
+  priv->frame_hold = FALSE;
+  priv->frame_redraw_pending = FALSE;
+  priv->animation_clipped = FALSE;
+  priv->frame_delay = 0;
+}
+
+/**
+ * mx_image_set_from_animation_file:
+ * @image: An #MxImage
+ * @filename: Filename to read the animation from
+ * @error: Return location for a #GError, or #NULL
+ *
+ * Plays back an animated image, such as a GIF or an animated PNG file. The
+ * animation is decoded incrementally in a worker thread, keeping at most
+ * #MxImage:frame-cache-size frames decoded ahead of the one being displayed.
+ *
+ * Playback is driven by the stage frame clock, and is paused while @image is
+ * unmapped or fully clipped. Still images are also accepted, and will simply
+ * show their only frame.
+ *
+ * This function returns immediately. #MxImage::image-loaded is emitted when
+ * the first frame is displayed, and #MxImage::image-load-error is emitted if
+ * the file cannot be loaded. Setting a different image stops the animation.
+ *
+ * Returns: #TRUE if the animation was successfully queued for loading
+ *
+ * Since: 2.0
+ */
+gboolean
+mx_image_set_from_animation_file (MxImage      *image,
+                                  const gchar  *filename,
+                                  GError      **error)
+{
+  MxImagePrivate *priv;
+  MxImageAnimation *anim;
+  GError *err = NULL;
+
+  if (G_UNLIKELY (!MX_IS_IMAGE (image)))
+    {
+      g_set_error (error, MX_IMAGE_ERROR,
+                   MX_IMAGE_ERROR_INVALID_PARAMETER,
+                   "image parameter is not a MxImage");
+      return FALSE;
+    }
+
+  if (G_UNLIKELY (!filename))
+    {
+      g_set_error (error, MX_IMAGE_ERROR,
+                   MX_IMAGE_ERROR_INVALID_PARAMETER,
+                   "NULL filename");
+      return FALSE;
+    }
+
+  priv = image->priv;
+
+  if (!mx_image_get_thread_pool (&err))
+    {
+      g_propagate_error (error, err);
+      return FALSE;
+    }
+
+  mx_image_cancel_in_progress (image);
+
+  anim = g_new0 (MxImageAnimation, 1);
+  anim->run = mx_image_animation_decode;
+  anim->ref_count = 1;
+  anim->parent = image;
+  g_mutex_init (&anim->mutex);
+  anim->filename = g_strdup (filename);
+  anim->n_frames = priv->frame_cache_size;
+  anim->frames = g_new0 (MxImageFrame, anim->n_frames);
+  anim->decoding = TRUE;
+
+  priv->animation = anim;
+
+  if (!priv->animation_timeline)
+    {
+      priv->animation_timeline = clutter_timeline_new (1000);
+      clutter_timeline_set_repeat_count (priv->animation_timeline, -1);
+      g_signal_connect (priv->animation_timeline, "new-frame",
+                        G_CALLBACK (mx_image_animation_new_frame_cb), image);
+    }
+
+  g_thread_pool_push (mx_image_threads, mx_image_animation_ref (anim), NULL);
+
+  if (CLUTTER_ACTOR_IS_MAPPED (image))
+    clutter_timeline_start (priv->animation_timeline);
+
+  return TRUE;
+}
+
+/**
+ * mx_image_set_frame_cache_size:
+ * @image: A #MxImage
+ * @n_frames: The number of frames to decode ahead
+ *
+ * Sets the number of animation frames that are decoded ahead of the frame
+ * currently being displayed. Larger values use more memory but are more
+ * resilient to slow decoding. The new value is used the next time
+ * mx_image_set_from_animation_file() is called.
+ *
+ * Since: 2.0
+ */
+void
+mx_image_set_frame_cache_size (MxImage *image,
+                               guint    n_frames)
+{
+  MxImagePrivate *priv;
+
+  g_return_if_fail (MX_IS_IMAGE (image));
+  g_return_if_fail (n_frames > 0);
+
+  priv = image->priv;
+  if (priv->frame_cache_size != n_frames)
+    {
+      priv->frame_cache_size = n_frames;
+      g_object_notify (G_OBJECT (image), "frame-cache-size");
+    }
+}
+
+/**
+ * mx_image_get_frame_cache_size:
+ * @image: A #MxImage
+ *
+ * Retrieves the number of animation frames that are decoded ahead of the
+ * frame currently being displayed.
+ *
+ * Returns: The number of frames
+ *
+ * Since: 2.0
+ */
+guint
+mx_image_get_frame_cache_size (MxImage *image)
+{
+  g_return_val_if_fail (MX_IS_IMAGE (image), 0);
+
+  return image->priv->frame_cache_size;
+}
+
 /**
  * mx_image_set_from_file:
  * @image: An #MxImage
@@ -1849,15 +2683,19 @@ mx_image_set_from_cogl_texture (MxImage    *image,
     {
       guint8 *data;
       gint rowstride;
+      gboolean retval;
       CoglPixelFormat format;
 
       rowstride = cogl_texture_get_rowstride (texture);
       format = cogl_texture_get_format (texture);
 
-      data = g_malloc (height * rowstride);
+      data = _mx_buffer_pool_alloc (height * rowstride);
       cogl_texture_get_data (texture, format, rowstride, data);
-      return mx_image_set_from_data (image, data, format,
-                                     width, height, rowstride, NULL);
+      retval = mx_image_set_from_data (image, data, format,
+                                       width, height, rowstride, NULL);
+      _mx_buffer_pool_free (data);
+
+      return retval;
     }
 }
 
@@ -2235,3 +3073,58 @@ mx_image_get_transition_duration (MxImage *image)
 
   return image->priv->transition_duration;
 }
+
+/**
+ * mx_image_get_buffer_pool_stats:
+ * @bytes_in_use: (out) (allow-none): return location for the number of bytes
+ *   currently handed out by the pool, or %NULL
+ * @high_water_mark: (out) (allow-none): return location for the largest
+ *   number of bytes handed out by the pool at any one time, or %NULL
+ * @hits: (out) (allow-none): return location for the number of requests
+ *   served from a cached buffer, or %NULL
+ * @misses: (out) (allow-none): return location for the number of requests
+ *   that needed a new allocation, or %NULL
+ * @bytes_cached: (out) (allow-none): return location for the number of bytes
+ *   held in the pool for re-use, or %NULL
+ * @cached_high_water_mark: (out) (allow-none): return location for the
+ *   largest number of bytes held in the pool at any one time, or %NULL
+ *
+ * Retrieves usage statistics for the pool of pixel buffers shared by the
+ * image decoding threads and the texture upload path.
+ *
+ * Since: 2.0
+ */
+void
+mx_image_get_buffer_pool_stats (gsize *bytes_in_use,
+                                gsize *high_water_mark,
+                                guint *hits,
+                                guint *misses,
+                                gsize *bytes_cached,
+                                gsize *cached_high_water_mark)
+{
+  MxBufferPoolStats stats;
+
+  _mx_buffer_pool_get_stats (&stats);
+
+  if (bytes_in_use)
+    *bytes_in_use = stats.bytes_in_use;
+  if (high_water_mark)
+    *high_water_mark = stats.bytes_in_use_high_water_mark;
+  if (hits)
+    *hits = stats.hits;
+  if (misses)
+    *misses = stats.misses;
+  if (bytes_cached)
+    *bytes_cached = stats.bytes_cached;
+  if (cached_high_water_mark)
+    *cached_high_water_mark = stats.bytes_cached_high_water_mark;
+}
+
+/* Called by views with %TRUE around binding items ahead of the visible
+ * area, so that the asynchronous image loads they start are queued behind
+ * those of the images in view. */
+void
+_mx_image_set_prefetching (gboolean prefetching)
+{
+  mx_image_prefetching = prefetching;
+}
@@ -154,6 +154,22 @@ void     mx_image_animate_scale_mode (MxImage          *image,
                                       gulong            mode,
                                       guint             duration,
                                       MxImageScaleMode  scale_mode);
+
+gboolean mx_image_set_from_animation_file (MxImage      *image,
+                                           const gchar  *filename,
+                                           GError      **error);
+
+void     mx_image_set_frame_cache_size (MxImage *image,
+                                        guint    n_frames);
+guint    mx_image_get_frame_cache_size (MxImage *image);
+
+void     mx_image_get_buffer_pool_stats (gsize *bytes_in_use,
+                                         gsize *high_water_mark,
+                                         guint *hits,
+                                         guint *misses,
+                                         gsize *bytes_cached,
+                                         gsize *cached_high_water_mark);
+
 G_END_DECLS
 
 #endif /* _MX_IMAGE */
@@ -32,8 +32,14 @@
  *
  * Data is set on the children by mapping columns in the model to object
  * properties on the children.
+ *
+ * #MxItemView provides the rows of its model as the items of the grid, so
+ * when #MxGrid:virtualized is set, children are only created and bound for
+ * the rows in view.
  */
 
+#include <string.h>
+
 #include "mx-item-view.h"
 #include "mx-private.h"
 
@@ -42,12 +48,6 @@ G_DEFINE_TYPE (MxItemView, mx_item_view, MX_TYPE_GRID)
 #define ITEM_VIEW_PRIVATE(o) \
   (G_TYPE_INSTANCE_GET_PRIVATE ((o), MX_TYPE_ITEM_VIEW, MxItemViewPrivate))
 
-typedef struct
-{
-  gchar *name;
-  gint   col;
-} AttributeData;
-
 enum
 {
   PROP_0,
@@ -72,8 +72,23 @@ struct _MxItemViewPrivate
   gulong         sort_changed;
 
   guint          is_frozen : 1;
+
+  GPtrArray     *row_actors;    /* the child showing each row */
 };
 
+static void model_changed_cb (ClutterModel *model,
+                              MxItemView   *item_view);
+static void model_reordered_cb (ClutterModel *model,
+                                MxItemView   *item_view);
+
+static guint mx_item_view_get_n_items (MxGrid *grid);
+static ClutterActor *mx_item_view_grid_create_item (MxGrid *grid);
+static void mx_item_view_grid_bind_item (MxGrid       *grid,
+                                         ClutterActor *item,
+                                         guint         index);
+static void mx_item_view_virtualized_notify_cb (MxItemView *item_view,
+                                                GParamSpec *pspec);
+
 /* gobject implementations */
 
 static void
@@ -140,11 +155,14 @@ mx_item_view_finalize (GObject *object)
 
   if (priv->attributes)
     {
-      g_slist_foreach (priv->attributes, (GFunc) g_free, NULL);
+      g_slist_foreach (priv->attributes, (GFunc) _mx_item_attribute_free,
+                       NULL);
       g_slist_free (priv->attributes);
       priv->attributes = NULL;
     }
 
+  g_ptr_array_free (priv->row_actors, TRUE);
+
   G_OBJECT_CLASS (mx_item_view_parent_class)->finalize (object);
 }
 
@@ -152,10 +170,15 @@ static void
 mx_item_view_class_init (MxItemViewClass *klass)
 {
   GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  MxGridClass *grid_class = MX_GRID_CLASS (klass);
   GParamSpec *pspec;
 
   g_type_class_add_private (klass, sizeof (MxItemViewPrivate));
 
+  grid_class->get_n_items = mx_item_view_get_n_items;
+  grid_class->create_item = mx_item_view_grid_create_item;
+  grid_class->bind_item = mx_item_view_grid_bind_item;
+
   object_class->get_property = mx_item_view_get_property;
   object_class->set_property = mx_item_view_set_property;
   object_class->dispose = mx_item_view_dispose;
@@ -192,15 +215,80 @@ static void
 mx_item_view_init (MxItemView *item_view)
 {
   item_view->priv = ITEM_VIEW_PRIVATE (item_view);
+
+  item_view->priv->row_actors = g_ptr_array_new ();
+
+  g_signal_connect (item_view, "notify::virtualized",
+                    G_CALLBACK (mx_item_view_virtualized_notify_cb), NULL);
 }
 
 
 /* model monitors */
+static ClutterActor *
+mx_item_view_create_item (MxItemView *item_view)
+{
+  MxItemViewPrivate *priv = item_view->priv;
+
+  return _mx_item_create (priv->item_type, priv->factory);
+}
+
+static void
+mx_item_view_bind_item (MxItemView       *item_view,
+                        GObject          *child,
+                        ClutterModelIter *iter)
+{
+  _mx_item_bind (child, iter, item_view->priv->attributes);
+}
+
+/* items for the virtualized grid */
+static guint
+mx_item_view_get_n_items (MxGrid *grid)
+{
+  MxItemViewPrivate *priv = MX_ITEM_VIEW (grid)->priv;
+
+  if (!priv->model || !_mx_item_type_is_valid (priv->item_type, priv->factory))
+    return 0;
+
+  return clutter_model_get_n_rows (priv->model);
+}
+
+static ClutterActor *
+mx_item_view_grid_create_item (MxGrid *grid)
+{
+  return mx_item_view_create_item (MX_ITEM_VIEW (grid));
+}
+
+static void
+mx_item_view_grid_bind_item (MxGrid       *grid,
+                             ClutterActor *item,
+                             guint         index)
+{
+  MxItemViewPrivate *priv = MX_ITEM_VIEW (grid)->priv;
+  ClutterModelIter *iter;
+
+  iter = clutter_model_get_iter_at_row (priv->model, index);
+  if (iter)
+    {
+      mx_item_view_bind_item (MX_ITEM_VIEW (grid), G_OBJECT (item), iter);
+      g_object_unref (iter);
+    }
+}
+
+static void
+mx_item_view_virtualized_notify_cb (MxItemView *item_view,
+                                    GParamSpec *pspec)
+{
+  /* MxGrid has removed all the children, so repopulate if they're ours */
+  g_ptr_array_set_size (item_view->priv->row_actors, 0);
+
+  if (!mx_grid_get_virtualized (MX_GRID (item_view)))
+    model_changed_cb (item_view->priv->model, item_view);
+}
+
 static void
 model_changed_cb (ClutterModel *model,
                   MxItemView   *item_view)
 {
-  GSList *p;
   GList *l, *children;
   MxItemViewPrivate *priv = item_view->priv;
   ClutterModelIter *iter = NULL;
@@ -226,6 +314,12 @@ model_changed_cb (ClutterModel *model,
         }
     }
 
+  if (mx_grid_get_virtualized (MX_GRID (item_view)))
+    {
+      _mx_grid_invalidate_items (MX_GRID (item_view));
+      return;
+    }
+
   children = clutter_actor_get_children (CLUTTER_ACTOR (item_view));
   child_n = g_list_length (children);
 
@@ -239,14 +333,7 @@ model_changed_cb (ClutterModel *model,
     {
       ClutterActor *new_child;
 
-      if (priv->item_type)
-        {
-          new_child = g_object_new (priv->item_type, NULL);
-        }
-      else
-        {
-          new_child = mx_item_factory_create (priv->factory);
-        }
+      new_child = mx_item_view_create_item (item_view);
 
       clutter_actor_add_child (CLUTTER_ACTOR (item_view), new_child);
       child_n++;
@@ -264,32 +351,23 @@ model_changed_cb (ClutterModel *model,
   g_list_free (children);
 
   if (!priv->model)
-    return;
+    {
+      g_ptr_array_set_size (priv->row_actors, 0);
+      return;
+    }
 
   children = clutter_actor_get_children (CLUTTER_ACTOR (item_view));
 
-  /* set the properties on the children */
+  /* set the properties on the children, and remember which child is
+   * showing which row */
+  g_ptr_array_set_size (priv->row_actors, 0);
+
   iter = clutter_model_get_first_iter (priv->model);
   l = children;
   while (iter && !clutter_model_iter_is_last (iter))
     {
-      GObject *child;
-
-      child = G_OBJECT (l->data);
-
-      g_object_freeze_notify (child);
-      for (p = priv->attributes; p; p = p->next)
-        {
-          GValue value = { 0, };
-          AttributeData *attr = p->data;
-
-          clutter_model_iter_get_value (iter, attr->col, &value);
-
-          g_object_set_property (child, attr->name, &value);
-
-          g_value_unset (&value);
-        }
-      g_object_thaw_notify (child);
+      mx_item_view_bind_item (item_view, G_OBJECT (l->data), iter);
+      g_ptr_array_add (priv->row_actors, l->data);
 
       l = g_list_next (l);
       clutter_model_iter_next (iter);
@@ -301,12 +379,113 @@ model_changed_cb (ClutterModel *model,
     g_object_unref (iter);
 }
 
+static gint
+mx_item_view_get_changed_row (MxItemView       *item_view,
+                              ClutterModel     *model,
+                              ClutterModelIter *iter)
+{
+  MxItemViewPrivate *priv = item_view->priv;
+
+  return _mx_item_get_changed_row (model, iter, priv->item_type,
+                                   priv->factory);
+}
+
+/* the rows have been sorted or filtered, move the children showing them */
+static void
+model_reordered_cb (ClutterModel *model,
+                    MxItemView   *item_view)
+{
+  MxItemViewPrivate *priv = item_view->priv;
+
+  if (priv->is_frozen)
+    return;
+
+  /* a virtualized grid only has children for the items in view, which are
+   * bound again when they are realized */
+  if (mx_grid_get_virtualized (MX_GRID (item_view)) ||
+      !_mx_item_type_is_valid (priv->item_type, priv->factory))
+    {
+      model_changed_cb (model, item_view);
+      return;
+    }
+
+  _mx_item_reorder (CLUTTER_ACTOR (item_view), model, priv->attributes,
+                    priv->item_type, priv->factory, priv->row_actors);
+}
+
+static void
+row_added_cb (ClutterModel     *model,
+              ClutterModelIter *iter,
+              MxItemView       *item_view)
+{
+  MxItemViewPrivate *priv = item_view->priv;
+  ClutterActor *child;
+  gint row;
+
+  if (priv->is_frozen)
+    return;
+
+  /* the positions of the following items change, so rebind them all */
+  if (mx_grid_get_virtualized (MX_GRID (item_view)))
+    {
+      model_changed_cb (model, item_view);
+      return;
+    }
+
+  row = mx_item_view_get_changed_row (item_view, model, iter);
+  if (row < 0 || row > (gint) priv->row_actors->len)
+    {
+      model_changed_cb (model, item_view);
+      return;
+    }
+
+  child = mx_item_view_create_item (item_view);
+  mx_item_view_bind_item (item_view, G_OBJECT (child), iter);
+
+  if (row < (gint) priv->row_actors->len)
+    clutter_actor_insert_child_below (CLUTTER_ACTOR (item_view), child,
+                                      g_ptr_array_index (priv->row_actors,
+                                                         row));
+  else
+    clutter_actor_add_child (CLUTTER_ACTOR (item_view), child);
+
+  g_ptr_array_add (priv->row_actors, NULL);
+  memmove (priv->row_actors->pdata + row + 1, priv->row_actors->pdata + row,
+           (priv->row_actors->len - row - 1) * sizeof (gpointer));
+  g_ptr_array_index (priv->row_actors, row) = child;
+}
+
 static void
 row_changed_cb (ClutterModel     *model,
                 ClutterModelIter *iter,
                 MxItemView       *item_view)
 {
-  model_changed_cb (model, item_view);
+  MxItemViewPrivate *priv = item_view->priv;
+  gint row;
+
+  if (priv->is_frozen)
+    return;
+
+  row = mx_item_view_get_changed_row (item_view, model, iter);
+
+  /* only items in view have a child to update */
+  if (row >= 0 && mx_grid_get_virtualized (MX_GRID (item_view)))
+    {
+      ClutterActor *child = _mx_grid_get_item (MX_GRID (item_view), row);
+
+      if (child)
+        mx_item_view_bind_item (item_view, G_OBJECT (child), iter);
+      return;
+    }
+
+  if (row < 0 || row >= (gint) priv->row_actors->len)
+    {
+      model_changed_cb (model, item_view);
+      return;
+    }
+
+  mx_item_view_bind_item (item_view, g_ptr_array_index (priv->row_actors, row),
+                          iter);
 }
 
 static void
@@ -314,18 +493,28 @@ row_removed_cb (ClutterModel     *model,
                 ClutterModelIter *iter,
                 MxItemView       *item_view)
 {
-  GList *children;
-  GList *l;
+  MxItemViewPrivate *priv = item_view->priv;
   ClutterActor *child;
+  gint row;
 
-  if (item_view->priv->is_frozen)
+  if (priv->is_frozen)
     return;
 
-  children = clutter_actor_get_children (CLUTTER_ACTOR (item_view));
-  l = g_list_nth (children, clutter_model_iter_get_row (iter));
-  child = (ClutterActor *) l->data;
+  if (mx_grid_get_virtualized (MX_GRID (item_view)))
+    {
+      model_changed_cb (model, item_view);
+      return;
+    }
+
+  row = mx_item_view_get_changed_row (item_view, model, iter);
+  if (row < 0 || row >= (gint) priv->row_actors->len)
+    {
+      model_changed_cb (model, item_view);
+      return;
+    }
+
+  child = g_ptr_array_remove_index (priv->row_actors, row);
   clutter_actor_remove_child (CLUTTER_ACTOR (item_view), child);
-  g_list_free (children);
 }
 
 /* public api */
@@ -420,6 +609,12 @@ mx_item_view_set_model (MxItemView   *item_view,
       g_signal_handlers_disconnect_by_func (priv->model,
                                             (GCallback) model_changed_cb,
                                             item_view);
+      g_signal_handlers_disconnect_by_func (priv->model,
+                                            (GCallback) model_reordered_cb,
+                                            item_view);
+      g_signal_handlers_disconnect_by_func (priv->model,
+                                            (GCallback) row_added_cb,
+                                            item_view);
       g_signal_handlers_disconnect_by_func (priv->model,
                                             (GCallback) row_changed_cb,
                                             item_view);
@@ -439,12 +634,12 @@ mx_item_view_set_model (MxItemView   *item_view,
 
       priv->filter_changed = g_signal_connect (priv->model,
                                                "filter-changed",
-                                               G_CALLBACK (model_changed_cb),
+                                               G_CALLBACK (model_reordered_cb),
                                                item_view);
 
       priv->row_added = g_signal_connect (priv->model,
                                           "row-added",
-                                          G_CALLBACK (row_changed_cb),
+                                          G_CALLBACK (row_added_cb),
                                           item_view);
 
       priv->row_changed = g_signal_connect (priv->model,
@@ -453,8 +648,9 @@ mx_item_view_set_model (MxItemView   *item_view,
                                             item_view);
 
       /*
-       * model_changed_cb (called from row_changed_cb) expect the row to already
-       * have been removed, thus we need to use _after
+       * model_changed_cb (called from row_removed_cb when the change can't be
+       * applied to a single row) expects the row to already have been
+       * removed, thus we need to use _after
        */
       priv->row_removed = g_signal_connect_after (priv->model,
                                                   "row-removed",
@@ -463,7 +659,7 @@ mx_item_view_set_model (MxItemView   *item_view,
 
       priv->sort_changed = g_signal_connect (priv->model,
                                              "sort-changed",
-                                             G_CALLBACK (model_changed_cb),
+                                             G_CALLBACK (model_reordered_cb),
                                              item_view);
 
       /*
@@ -490,7 +686,7 @@ mx_item_view_add_attribute (MxItemView  *item_view,
                             gint         column)
 {
   MxItemViewPrivate *priv;
-  AttributeData *prop;
+  MxItemAttribute *prop;
 
   g_return_if_fail (MX_IS_ITEM_VIEW (item_view));
   g_return_if_fail (_attribute != NULL);
@@ -498,7 +694,7 @@ mx_item_view_add_attribute (MxItemView  *item_view,
 
   priv = item_view->priv;
 
-  prop = g_new (AttributeData, 1);
+  prop = g_new (MxItemAttribute, 1);
   prop->name = g_strdup (_attribute);
   prop->col = column;
 
@@ -44,6 +44,7 @@
 #include "mx-scrollable.h"
 #include "mx-focusable.h"
 #include <math.h>
+#include <string.h>
 
 #define _KINETIC_DEBUG 0
 
@@ -65,9 +66,48 @@ typedef struct {
   /* Units to store the origin of a click when scrolling */
   gfloat   x;
   gfloat   y;
-  GTimeVal time;
+  gint64   time;
 } MxKineticScrollViewMotion;
 
+/* number of motion events kept to estimate the fling velocity */
+#define MOTION_BUFFER_SIZE 16
+
+/* how far back, in microseconds, motion events are used for the velocity */
+#define MOTION_WINDOW (100 * 1000)
+
+/* samples further from the fitted motion than this many times the average
+ * distance are rejected */
+#define MOTION_OUTLIER_FACTOR 3.0
+
+/* Part of a deceleration during which the velocity is divided by the same
+ * rate every step */
+typedef struct {
+  gdouble step;           /* when it starts */
+  gdouble distance;       /* distance moved before it */
+  gdouble velocity;       /* velocity at its start */
+  gdouble rate;           /* what the velocity is divided by every step */
+} MxKineticScrollViewDecelPhase;
+
+/* Deceleration of one axis. Distances and velocities are in units per 60th
+ * of a second, the velocity being divided by the deceleration rate (and
+ * multiplied by the overshoot while beyond either bound) every 60th of a
+ * second. The position is worked out from the elapsed time, so the
+ * movement does not depend on the frame rate. At most, the value starts
+ * beyond the bound behind it, comes back within the bounds and goes beyond
+ * the bound ahead, hence up to three phases. */
+typedef struct {
+  gdouble start;          /* value of the adjustment at the start */
+  gdouble end_step;       /* when the velocity falls below the minimum */
+  guint   n_phases;
+  MxKineticScrollViewDecelPhase phases[3];
+} MxKineticScrollViewDecel;
+
+/* the length of a deceleration step, in milliseconds */
+#define DECEL_STEP (1000.0 / 60.0)
+
+/* the velocity below which the deceleration stops */
+#define DECEL_MIN_VELOCITY 2.0
+
 typedef enum {
   MX_AUTOMATIC_SCROLL_NONE,
   MX_AUTOMATIC_SCROLL_HORIZONTAL,
@@ -98,9 +138,10 @@ struct _MxKineticScrollViewPrivate
 
   MxAutomaticScroll        in_automatic_scroll;
 
-  /* Mouse motion event information */
-  GArray                *motion_buffer;
+  /* Mouse motion event information, in a ring buffer */
+  MxKineticScrollViewMotion motion_buffer[MOTION_BUFFER_SIZE];
   guint                  last_motion;
+  guint                  n_motions;
 
   /* Variables for storing acceleration information */
   ClutterTimeline       *deceleration_timeline;
@@ -108,8 +149,10 @@ struct _MxKineticScrollViewPrivate
   gfloat                 dy;
   gdouble                decel_rate;
   gdouble                overshoot;
-  gdouble                accumulated_delta;
   gdouble                acceleration_factor;
+  MxKineticScrollViewDecel hdecel;
+  MxKineticScrollViewDecel vdecel;
+  gdouble                decel_time;
 
   MxScrollPolicy         scroll_policy;
 
@@ -139,6 +182,16 @@ enum {
   PROP_SNAP_ON_PAGE,
 };
 
+enum
+{
+  FLING_SAMPLE,
+  PREFETCH_HINT,
+
+  LAST_SIGNAL
+};
+
+static guint signals[LAST_SIGNAL] = { 0, };
+
 #if _KINETIC_DEBUG
 # define LOG_DEBUG(args...) _log_debug(args)
 
@@ -244,7 +297,8 @@ emit_cursor_actor_cancel (MxKineticScrollView *scroll,
 
 static gboolean release_event (MxKineticScrollView *scroll,
                                gint                 x,
-                               gint                 y);
+                               gint                 y,
+                               guint32              time_);
 
 static gboolean mx_kinetic_scroll_view_event (ClutterActor *actor,
                                               ClutterEvent *event);
@@ -312,7 +366,7 @@ mx_kinetic_scroll_view_get_property (GObject    *object,
 
 /*
     case PROP_BUFFER_SIZE :
-      g_value_set_uint (value, priv->motion_buffer->len);
+      g_value_set_uint (value, MOTION_BUFFER_SIZE);
       break;
 */
 
@@ -486,10 +540,6 @@ mx_kinetic_scroll_view_dispose (GObject *object)
 static void
 mx_kinetic_scroll_view_finalize (GObject *object)
 {
-  MxKineticScrollViewPrivate *priv = MX_KINETIC_SCROLL_VIEW (object)->priv;
-
-  g_array_free (priv->motion_buffer, TRUE);
-
   G_OBJECT_CLASS (mx_kinetic_scroll_view_parent_class)->finalize (object);
 }
 
@@ -501,6 +551,8 @@ mx_kinetic_scroll_view_get_preferred_width (ClutterActor *actor,
 {
   MxKineticScrollViewPrivate *priv = MX_KINETIC_SCROLL_VIEW (actor)->priv;
 
+  MX_PROFILE_BEGIN (actor, PREFERRED_SIZE);
+
   CLUTTER_ACTOR_CLASS (mx_kinetic_scroll_view_parent_class)->
     get_preferred_width (actor, for_height, NULL, nat_width_p);
 
@@ -511,6 +563,8 @@ mx_kinetic_scroll_view_get_preferred_width (ClutterActor *actor,
       mx_widget_get_padding (MX_WIDGET (actor), &padding);
       *min_width_p = padding.left + padding.right;
     }
+
+  MX_PROFILE_END (actor, PREFERRED_SIZE);
 }
 
 static void
@@ -521,6 +575,8 @@ mx_kinetic_scroll_view_get_preferred_height (ClutterActor *actor,
 {
   MxKineticScrollViewPrivate *priv = MX_KINETIC_SCROLL_VIEW (actor)->priv;
 
+  MX_PROFILE_BEGIN (actor, PREFERRED_SIZE);
+
   CLUTTER_ACTOR_CLASS (mx_kinetic_scroll_view_parent_class)->
     get_preferred_height (actor, for_width, NULL, nat_height_p);
 
@@ -531,6 +587,8 @@ mx_kinetic_scroll_view_get_preferred_height (ClutterActor *actor,
       mx_widget_get_padding (MX_WIDGET (actor), &padding);
       *min_height_p = padding.top + padding.bottom;
     }
+
+  MX_PROFILE_END (actor, PREFERRED_SIZE);
 }
 
 static void
@@ -541,6 +599,8 @@ mx_kinetic_scroll_view_allocate (ClutterActor           *actor,
   MxKineticScrollViewPrivate *priv = MX_KINETIC_SCROLL_VIEW (actor)->priv;
   ClutterActorBox childbox;
 
+  MX_PROFILE_BEGIN (actor, ALLOCATE);
+
   CLUTTER_ACTOR_CLASS (mx_kinetic_scroll_view_parent_class)->
     allocate (actor, box, flags);
 
@@ -550,6 +610,8 @@ mx_kinetic_scroll_view_allocate (ClutterActor           *actor,
       mx_widget_get_available_area (MX_WIDGET (actor), box, &childbox);
       clutter_actor_allocate (priv->child, &childbox, flags);
     }
+
+  MX_PROFILE_END (actor, ALLOCATE);
 }
 
 static void
@@ -558,6 +620,8 @@ mx_kinetic_scroll_view_paint (ClutterActor *actor)
   MxKineticScrollViewPrivate *priv = ((MxKineticScrollView *) actor)->priv;
   ClutterActorBox box;
 
+  MX_PROFILE_BEGIN (actor, PAINT);
+
   CLUTTER_ACTOR_CLASS (mx_kinetic_scroll_view_parent_class)->paint (actor);
 
   if (priv->child)
@@ -569,6 +633,8 @@ mx_kinetic_scroll_view_paint (ClutterActor *actor)
       clutter_actor_paint (priv->child);
       cogl_clip_pop ();
     }
+
+  MX_PROFILE_END (actor, PAINT);
 }
 
 static void
@@ -577,6 +643,8 @@ mx_kinetic_scroll_view_pick (ClutterActor *actor, const ClutterColor *color)
   MxKineticScrollViewPrivate *priv = ((MxKineticScrollView *) actor)->priv;
   ClutterActorBox box;
 
+  MX_PROFILE_BEGIN (actor, PICK);
+
   CLUTTER_ACTOR_CLASS (mx_kinetic_scroll_view_parent_class)->pick (actor,
                                                                    color);
 
@@ -589,6 +657,8 @@ mx_kinetic_scroll_view_pick (ClutterActor *actor, const ClutterColor *color)
       clutter_actor_paint (priv->child);
       cogl_clip_pop ();
     }
+
+  MX_PROFILE_END (actor, PICK);
 }
 
 static gboolean
@@ -739,6 +809,227 @@ mx_kinetic_scroll_view_class_init (MxKineticScrollViewClass *klass)
   g_object_class_override_property (object_class,
                                     PROP_VADJUST,
                                     "vertical-adjustment");
+
+  /**
+   * MxKineticScrollView::fling-sample:
+   * @scroll: the object that received the signal
+   * @time: the time of the sample, in microseconds before the release
+   * @x: the x coordinate of the sample
+   * @y: the y coordinate of the sample
+   * @rejected: whether the sample was rejected as an outlier
+   *
+   * Emitted for each of the recent motion events used to estimate the
+   * velocity at the end of a drag. This is meant for debugging and tuning
+   * the estimation.
+   *
+   * Since: 2.0
+   */
+  signals[FLING_SAMPLE] =
+    g_signal_new ("fling-sample",
+                  G_TYPE_FROM_CLASS (klass),
+                  G_SIGNAL_RUN_LAST,
+                  0,
+                  NULL, NULL,
+                  _mx_marshal_VOID__INT64_DOUBLE_DOUBLE_BOOLEAN,
+                  G_TYPE_NONE, 4,
+                  G_TYPE_INT64, G_TYPE_DOUBLE, G_TYPE_DOUBLE,
+                  G_TYPE_BOOLEAN);
+
+  /**
+   * MxKineticScrollView::prefetch-hint:
+   * @scroll: the object that received the signal
+   * @hvalue: the value the horizontal adjustment is expected to stop at
+   * @vvalue: the value the vertical adjustment is expected to stop at
+   * @hvelocity: the horizontal scrolling speed, in units per second
+   * @vvelocity: the vertical scrolling speed, in units per second
+   *
+   * Emitted when a kinetic scroll starts, when one of its directions comes
+   * to rest and when it ends or is interrupted, in which case both
+   * velocities are 0. The same hint is passed on to the child with
+   * mx_scrollable_prefetch_hint(), so it can prepare the content that will
+   * scroll into view.
+   *
+   * Since: 2.0
+   */
+  signals[PREFETCH_HINT] =
+    g_signal_new ("prefetch-hint",
+                  G_TYPE_FROM_CLASS (klass),
+                  G_SIGNAL_RUN_LAST,
+                  0,
+                  NULL, NULL,
+                  _mx_marshal_VOID__DOUBLE_DOUBLE_DOUBLE_DOUBLE,
+                  G_TYPE_NONE, 4,
+                  G_TYPE_DOUBLE, G_TYPE_DOUBLE, G_TYPE_DOUBLE,
+                  G_TYPE_DOUBLE);
+}
+
+/* @time_ is the time of the event in milliseconds, or 0 if it has none, in
+ * which case the time it is handled at is used instead */
+static void
+add_motion (MxKineticScrollView *scroll,
+            gfloat               x,
+            gfloat               y,
+            guint32              time_)
+{
+  MxKineticScrollViewPrivate *priv = scroll->priv;
+  MxKineticScrollViewMotion *motion;
+
+  if (priv->n_motions)
+    priv->last_motion = (priv->last_motion + 1) % MOTION_BUFFER_SIZE;
+  else
+    priv->last_motion = 0;
+
+  priv->n_motions = MIN (priv->n_motions + 1, MOTION_BUFFER_SIZE);
+
+  motion = &priv->motion_buffer[priv->last_motion];
+  motion->x = x;
+  motion->y = y;
+  motion->time = time_ ? (gint64) time_ * 1000 : g_get_monotonic_time ();
+}
+
+/* Fits a straight line through the recent motion events that are not
+ * rejected, by least squares weighting newer events more. Gives the position
+ * at the time of the last event, the velocity in units per microsecond and
+ * the average distance of the events from the line. */
+static gboolean
+fit_motions (MxKineticScrollView *scroll,
+             const gboolean      *rejected,
+             gdouble             *x,
+             gdouble             *y,
+             gdouble             *vx,
+             gdouble             *vy,
+             gdouble             *error)
+{
+  MxKineticScrollViewPrivate *priv = scroll->priv;
+  gdouble sw, st, sx, sy, stt, stx, sty, mt, mx, my, e;
+  gint64 now;
+  guint i, n;
+
+  now = priv->motion_buffer[priv->last_motion].time;
+
+  sw = st = sx = sy = 0;
+  for (i = 0, n = 0; i < priv->n_motions; i++)
+    {
+      MxKineticScrollViewMotion *motion = &priv->motion_buffer[i];
+      gdouble w;
+
+      if (rejected[i] || now - motion->time > MOTION_WINDOW)
+        continue;
+
+      w = 1.0 - (now - motion->time) / (gdouble) (MOTION_WINDOW * 2);
+      sw += w;
+      st += w * (motion->time - now);
+      sx += w * motion->x;
+      sy += w * motion->y;
+      n++;
+    }
+
+  if (n < 2)
+    return FALSE;
+
+  mt = st / sw;
+  mx = sx / sw;
+  my = sy / sw;
+
+  stt = stx = sty = 0;
+  for (i = 0; i < priv->n_motions; i++)
+    {
+      MxKineticScrollViewMotion *motion = &priv->motion_buffer[i];
+      gdouble w, t;
+
+      if (rejected[i] || now - motion->time > MOTION_WINDOW)
+        continue;
+
+      w = 1.0 - (now - motion->time) / (gdouble) (MOTION_WINDOW * 2);
+      t = (motion->time - now) - mt;
+      stt += w * t * t;
+      stx += w * t * (motion->x - mx);
+      sty += w * t * (motion->y - my);
+    }
+
+  /* coalesced events all have the same time */
+  if (stt <= 0)
+    return FALSE;
+
+  *vx = stx / stt;
+  *vy = sty / stt;
+  *x = mx - *vx * mt;
+  *y = my - *vy * mt;
+
+  e = 0;
+  for (i = 0; i < priv->n_motions; i++)
+    {
+      MxKineticScrollViewMotion *motion = &priv->motion_buffer[i];
+      gdouble t;
+
+      if (rejected[i] || now - motion->time > MOTION_WINDOW)
+        continue;
+
+      t = motion->time - now;
+      e += hypot (motion->x - (*x + *vx * t), motion->y - (*y + *vy * t));
+    }
+  *error = e / n;
+
+  return TRUE;
+}
+
+/* Estimates the velocity of the pointer at the time of the last motion
+ * event, in units per microsecond. Events far from the motion of the others
+ * are rejected and the line fitted again. */
+static void
+estimate_velocity (MxKineticScrollView *scroll,
+                   gdouble             *vx,
+                   gdouble             *vy)
+{
+  MxKineticScrollViewPrivate *priv = scroll->priv;
+  gboolean rejected[MOTION_BUFFER_SIZE] = { FALSE, };
+  gdouble x, y, error;
+  gint64 now;
+  guint i, n_rejected;
+
+  *vx = *vy = 0;
+  n_rejected = 0;
+
+  now = priv->motion_buffer[priv->last_motion].time;
+
+  if (fit_motions (scroll, rejected, &x, &y, vx, vy, &error) && error > 0.5)
+    {
+      for (i = 0; i < priv->n_motions; i++)
+        {
+          MxKineticScrollViewMotion *motion = &priv->motion_buffer[i];
+          gdouble t = motion->time - now;
+
+          /* already left out of the fit as too old */
+          if (now - motion->time > MOTION_WINDOW)
+            continue;
+
+          if (hypot (motion->x - (x + *vx * t), motion->y - (y + *vy * t)) >
+              MOTION_OUTLIER_FACTOR * error)
+            {
+              rejected[i] = TRUE;
+              n_rejected++;
+            }
+        }
+
+      if (n_rejected &&
+          !fit_motions (scroll, rejected, &x, &y, vx, vy, &error))
+        *vx = *vy = 0;
+    }
+
+  MX_NOTE (KINETIC, "fling from %u samples (%u rejected): %f, %f per ms",
+           priv->n_motions, n_rejected, *vx * 1000, *vy * 1000);
+
+  /* oldest first */
+  for (i = 0; i < priv->n_motions; i++)
+    {
+      guint index = (priv->last_motion + 1 + i) % priv->n_motions;
+      MxKineticScrollViewMotion *motion = &priv->motion_buffer[index];
+
+      g_signal_emit (scroll, signals[FLING_SAMPLE], 0,
+                     now - motion->time,
+                     (gdouble) motion->x, (gdouble) motion->y,
+                     rejected[index]);
+    }
 }
 
 static void
@@ -786,23 +1077,28 @@ motion_event_cb (ClutterActor        *actor,
         default:
         case 1:
           if (!(modifier_state & CLUTTER_BUTTON1_MASK))
-            return release_event (scroll, x, y);
+            return release_event (scroll, x, y,
+                                  clutter_event_get_time (event));
           break;
         case 2:
           if (!(modifier_state & CLUTTER_BUTTON2_MASK))
-            return release_event (scroll, x, y);
+            return release_event (scroll, x, y,
+                                  clutter_event_get_time (event));
           break;
         case 3:
           if (!(modifier_state & CLUTTER_BUTTON3_MASK))
-            return release_event (scroll, x, y);
+            return release_event (scroll, x, y,
+                                  clutter_event_get_time (event));
           break;
         case 4:
           if (!(modifier_state & CLUTTER_BUTTON4_MASK))
-            return release_event (scroll, x, y);
+            return release_event (scroll, x, y,
+                                  clutter_event_get_time (event));
           break;
         case 5:
           if (!(modifier_state & CLUTTER_BUTTON5_MASK))
-            return release_event (scroll, x, y);
+            return release_event (scroll, x, y,
+                                  clutter_event_get_time (event));
           break;
         }
     }
@@ -832,8 +1128,9 @@ motion_event_cb (ClutterActor        *actor,
 
           g_object_get (G_OBJECT (settings),
                         "drag-threshold", &threshold, NULL);
-          motion = &g_array_index (priv->motion_buffer,
-                                   MxKineticScrollViewMotion, 0);
+
+          /* until the drag starts, this is the press */
+          motion = &priv->motion_buffer[priv->last_motion];
 
           dx = ABS (motion->x - x);
           dy = ABS (motion->y - y);
@@ -916,8 +1213,8 @@ motion_event_cb (ClutterActor        *actor,
         }
 
       LOG_DEBUG (scroll, "motion dx=%f dy=%f",
-                 ABS (g_array_index (priv->motion_buffer, MxKineticScrollViewMotion, priv->motion_buffer->len - 1).x - x),
-                 ABS (g_array_index (priv->motion_buffer, MxKineticScrollViewMotion, priv->motion_buffer->len - 1).y - y));
+                 ABS (priv->motion_buffer[priv->last_motion].x - x),
+                 ABS (priv->motion_buffer[priv->last_motion].y - y));
 
       if (priv->child)
         {
@@ -927,9 +1224,7 @@ motion_event_cb (ClutterActor        *actor,
           mx_scrollable_get_adjustments (MX_SCROLLABLE (priv->child),
                                          &hadjust, &vadjust);
 
-          motion = &g_array_index (priv->motion_buffer,
-                                   MxKineticScrollViewMotion,
-                                   priv->last_motion);
+          motion = &priv->motion_buffer[priv->last_motion];
 
           if (!priv->align_tested)
             {
@@ -971,20 +1266,7 @@ motion_event_cb (ClutterActor        *actor,
             }
         }
 
-      priv->last_motion ++;
-      if (priv->last_motion == priv->motion_buffer->len)
-        {
-          LOG_DEBUG (scroll, "reset");
-          priv->motion_buffer = g_array_remove_index (priv->motion_buffer, 0);
-          g_array_set_size (priv->motion_buffer, priv->last_motion);
-          priv->last_motion --;
-        }
-
-      motion = &g_array_index (priv->motion_buffer,
-                               MxKineticScrollViewMotion, priv->last_motion);
-      motion->x = x;
-      motion->y = y;
-      g_get_current_time (&motion->time);
+      add_motion (scroll, x, y, clutter_event_get_time (event));
     }
 
   return swallow;
@@ -1086,6 +1368,8 @@ clamp_adjustments (MxKineticScrollView *scroll,
     set_state (scroll, MX_KINETIC_SCROLL_VIEW_STATE_IDLE);
 }
 
+static void emit_prefetch_hint (MxKineticScrollView *scroll);
+
 static void
 deceleration_completed_cb (ClutterTimeline     *timeline,
                            MxKineticScrollView *scroll)
@@ -1098,6 +1382,250 @@ deceleration_completed_cb (ClutterTimeline     *timeline,
 
   g_object_unref (timeline);
   priv->deceleration_timeline = NULL;
+
+  emit_prefetch_hint (scroll);
+}
+
+/* distance moved after @steps steps, starting at @velocity and dividing it by
+ * @rate every step. This is the sum of the geometric series, extended to
+ * fractions of a step. */
+static gdouble
+deceleration_get_distance (gdouble velocity,
+                           gdouble rate,
+                           gdouble steps)
+{
+  return velocity * (1.0 - pow (rate, -steps)) / (1.0 - 1.0 / rate);
+}
+
+/* number of steps until the velocity falls below the minimum */
+static gdouble
+deceleration_get_n_steps (gdouble velocity,
+                          gdouble rate)
+{
+  if (ABS (velocity) <= DECEL_MIN_VELOCITY)
+    return 0;
+
+  return ceil (log (ABS (velocity) / DECEL_MIN_VELOCITY) / log (rate));
+}
+
+/* Starts a new phase where the value reaches @offset from the start, with
+ * the velocity then divided by @rate every step. Returns %FALSE if the
+ * value stops before getting there. */
+static gboolean
+deceleration_add_crossing (MxKineticScrollViewDecel *decel,
+                           gdouble                   offset,
+                           gdouble                   rate)
+{
+  MxKineticScrollViewDecelPhase *last, *next;
+  gdouble f, steps;
+
+  last = &decel->phases[decel->n_phases - 1];
+
+  f = (offset - last->distance) * (1.0 - 1.0 / last->rate) / last->velocity;
+  if (f >= 1.0)
+    return FALSE;
+
+  steps = -log (1.0 - f) / log (last->rate);
+  if (last->step + steps >= decel->end_step)
+    return FALSE;
+
+  next = &decel->phases[decel->n_phases++];
+  next->step = last->step + steps;
+  next->distance = last->distance +
+    deceleration_get_distance (last->velocity, last->rate, steps);
+  next->velocity = last->velocity * pow (last->rate, -steps);
+  next->rate = rate;
+
+  decel->end_step = next->step +
+    deceleration_get_n_steps (next->velocity, rate);
+
+  return TRUE;
+}
+
+static void
+deceleration_init (MxKineticScrollView      *scroll,
+                   MxKineticScrollViewDecel *decel,
+                   MxAdjustment             *adjust,
+                   gdouble                   velocity)
+{
+  MxKineticScrollViewPrivate *priv = scroll->priv;
+  gdouble value, lower, upper, page_size, ahead, behind, damped_rate;
+  MxKineticScrollViewDecelPhase *first;
+
+  memset (decel, 0, sizeof (MxKineticScrollViewDecel));
+
+  if (!adjust)
+    return;
+
+  mx_adjustment_get_values (adjust, &value, &lower, &upper,
+                            NULL, NULL, &page_size);
+
+  decel->start = value;
+  decel->n_phases = 1;
+
+  first = &decel->phases[0];
+  first->velocity = velocity;
+  first->rate = priv->decel_rate;
+
+  decel->end_step = deceleration_get_n_steps (velocity, priv->decel_rate);
+
+  if (priv->overshoot <= 0.0 || decel->end_step == 0)
+    return;
+
+  /* beyond either bound, the velocity also gets multiplied by the
+   * overshoot every step */
+  damped_rate = priv->decel_rate / priv->overshoot;
+
+  ahead = (velocity > 0) ? upper - page_size : lower;
+  behind = (velocity > 0) ? lower : upper - page_size;
+
+  if ((velocity > 0 && value > ahead) || (velocity < 0 && value < ahead))
+    {
+      first->rate = damped_rate;
+      decel->end_step = deceleration_get_n_steps (velocity, damped_rate);
+      return;
+    }
+
+  /* released beyond the bound behind, and heading back within the bounds */
+  if ((velocity > 0 && value < behind) || (velocity < 0 && value > behind))
+    {
+      first->rate = damped_rate;
+      decel->end_step = deceleration_get_n_steps (velocity, damped_rate);
+
+      if (!deceleration_add_crossing (decel, behind - value,
+                                      priv->decel_rate))
+        return;
+    }
+
+  deceleration_add_crossing (decel, ahead - value, damped_rate);
+}
+
+/* the phase of the deceleration @steps steps in */
+static const MxKineticScrollViewDecelPhase *
+deceleration_get_phase (MxKineticScrollViewDecel *decel,
+                        gdouble                   steps)
+{
+  guint i = decel->n_phases - 1;
+
+  while (i > 0 && steps < decel->phases[i].step)
+    i--;
+
+  return &decel->phases[i];
+}
+
+/* the value of the adjustment after @steps steps */
+static gdouble
+deceleration_get_value (MxKineticScrollView      *scroll,
+                        MxKineticScrollViewDecel *decel,
+                        gdouble                   steps)
+{
+  const MxKineticScrollViewDecelPhase *phase;
+
+  if (decel->n_phases == 0)
+    return decel->start;
+
+  steps = MIN (steps, decel->end_step);
+  phase = deceleration_get_phase (decel, steps);
+
+  return decel->start + phase->distance +
+    deceleration_get_distance (phase->velocity, phase->rate,
+                               steps - phase->step);
+}
+
+/* the velocity after @steps steps, in units per step */
+static gdouble
+deceleration_get_velocity (MxKineticScrollView      *scroll,
+                           MxKineticScrollViewDecel *decel,
+                           gdouble                   steps)
+{
+  const MxKineticScrollViewDecelPhase *phase;
+
+  if (decel->n_phases == 0 || steps >= decel->end_step)
+    return 0;
+
+  phase = deceleration_get_phase (decel, steps);
+
+  return phase->velocity * pow (phase->rate, -(steps - phase->step));
+}
+
+/* where the deceleration of @adjust will leave it, once clamped */
+static gdouble
+deceleration_get_end_value (MxKineticScrollView      *scroll,
+                            MxKineticScrollViewDecel *decel,
+                            MxAdjustment             *adjust)
+{
+  gdouble lower, upper, page_size, value;
+
+  mx_adjustment_get_values (adjust, NULL, &lower, &upper, NULL, NULL,
+                            &page_size);
+
+  value = deceleration_get_value (scroll, decel, decel->end_step);
+
+  return CLAMP (value, lower, MAX (lower, upper - page_size));
+}
+
+/* Tells the child, and anyone listening, where the scrolling is heading.
+ * The deceleration is deterministic, so this only changes when it starts,
+ * when one direction stops and when it ends. */
+static void
+emit_prefetch_hint (MxKineticScrollView *scroll)
+{
+  MxKineticScrollViewPrivate *priv = scroll->priv;
+  MxAdjustment *hadjust, *vadjust;
+  gdouble hvalue, vvalue, hvelocity, vvelocity, steps;
+
+  if (!priv->child)
+    return;
+
+  mx_scrollable_get_adjustments (MX_SCROLLABLE (priv->child),
+                                 &hadjust, &vadjust);
+
+  hvalue = hadjust ? mx_adjustment_get_value (hadjust) : 0;
+  vvalue = vadjust ? mx_adjustment_get_value (vadjust) : 0;
+  hvelocity = vvelocity = 0;
+
+  steps = priv->decel_time / DECEL_STEP;
+
+  if (priv->deceleration_timeline && priv->hmoving && hadjust)
+    {
+      hvalue = deceleration_get_end_value (scroll, &priv->hdecel, hadjust);
+      hvelocity = deceleration_get_velocity (scroll, &priv->hdecel, steps) *
+        1000.0 / DECEL_STEP;
+    }
+
+  if (priv->deceleration_timeline && priv->vmoving && vadjust)
+    {
+      vvalue = deceleration_get_end_value (scroll, &priv->vdecel, vadjust);
+      vvelocity = deceleration_get_velocity (scroll, &priv->vdecel, steps) *
+        1000.0 / DECEL_STEP;
+    }
+
+  MX_NOTE (KINETIC, "prefetch hint: h %.2f (%.2f/s), v %.2f (%.2f/s)",
+           hvalue, hvelocity, vvalue, vvelocity);
+
+  g_signal_emit (scroll, signals[PREFETCH_HINT], 0,
+                 hvalue, vvalue, hvelocity, vvelocity);
+
+  mx_scrollable_prefetch_hint (MX_SCROLLABLE (priv->child),
+                               hvalue, vvalue, hvelocity, vvelocity);
+}
+
+/* To reproduce a deceleration by hand, MX_KINETIC_FRAME_TIME can be set to
+ * the number of milliseconds each frame advances it by, rather than the
+ * elapsed time; MX_DEBUG=kinetic then logs the same positions every run. */
+static gdouble
+deceleration_get_synthetic_frame_time (void)
+{
+  static gdouble frame_time = -1;
+
+  if (frame_time < 0)
+    {
+      const gchar *env = g_getenv ("MX_KINETIC_FRAME_TIME");
+
+      frame_time = env ? MAX (0, g_ascii_strtod (env, NULL)) : 0;
+    }
+
+  return frame_time;
 }
 
 static void
@@ -1110,99 +1638,87 @@ deceleration_new_frame_cb (ClutterTimeline     *timeline,
   if (priv->child)
     {
       MxAdjustment *hadjust, *vadjust;
+      gdouble frame_time, steps;
 
       gboolean stop = TRUE;
+      gboolean axis_stopped = FALSE;
 
       mx_scrollable_get_adjustments (MX_SCROLLABLE (priv->child),
                                      &hadjust, &vadjust);
 
-      priv->accumulated_delta += clutter_timeline_get_delta (timeline);
+      frame_time = deceleration_get_synthetic_frame_time ();
+      if (frame_time > 0)
+        priv->decel_time += frame_time;
+      else
+        priv->decel_time = clutter_timeline_get_elapsed_time (timeline);
 
-      if (priv->accumulated_delta <= 1000.0/60.0)
-        stop = FALSE;
+      steps = priv->decel_time / DECEL_STEP;
 
-      while (priv->accumulated_delta > 1000.0/60.0)
+      if (hadjust &&
+          (priv->scroll_policy == MX_SCROLL_POLICY_HORIZONTAL ||
+          priv->scroll_policy == MX_SCROLL_POLICY_BOTH ||
+          priv->scroll_policy == MX_SCROLL_POLICY_AUTOMATIC) &&
+          priv->in_automatic_scroll != MX_AUTOMATIC_SCROLL_VERTICAL &&
+          priv->hmoving)
         {
-          gdouble hvalue, vvalue;
+          mx_adjustment_set_value (hadjust,
+                                   deceleration_get_value (scroll,
+                                                           &priv->hdecel,
+                                                           steps));
 
-          if (hadjust &&
-              (priv->scroll_policy == MX_SCROLL_POLICY_HORIZONTAL ||
-              priv->scroll_policy == MX_SCROLL_POLICY_BOTH ||
-              priv->scroll_policy == MX_SCROLL_POLICY_AUTOMATIC) &&
-              priv->in_automatic_scroll != MX_AUTOMATIC_SCROLL_VERTICAL)
+          if (steps < priv->hdecel.end_step)
+            stop = FALSE;
+          else
             {
-              if (ABS (priv->dx) > 2)
-                {
-                  hvalue = priv->dx + mx_adjustment_get_value (hadjust);
-                  mx_adjustment_set_value (hadjust, hvalue);
-
-                  if (priv->overshoot > 0.0)
-                    {
-                      if ((hvalue > mx_adjustment_get_upper (hadjust) -
-                           mx_adjustment_get_page_size (hadjust)) ||
-                          (hvalue < mx_adjustment_get_lower (hadjust)))
-                        priv->dx *= priv->overshoot;
-                    }
-
-                  priv->dx = priv->dx / priv->decel_rate;
+              guint duration;
 
-                  stop = FALSE;
-                }
-              else if (priv->hmoving)
-                {
-                  guint duration;
+              priv->hmoving = FALSE;
+              axis_stopped = TRUE;
 
-                  priv->hmoving = FALSE;
-
-                  duration = (priv->overshoot > 0.0) ?
-                                priv->clamp_duration : 10;
-                  clamp_adjustments (scroll, duration, TRUE, FALSE);
-                }
+              duration = (priv->overshoot > 0.0) ?
+                            priv->clamp_duration : 10;
+              clamp_adjustments (scroll, duration, TRUE, FALSE);
             }
+        }
 
-          if (vadjust &&
-              (priv->scroll_policy == MX_SCROLL_POLICY_VERTICAL ||
-              priv->scroll_policy == MX_SCROLL_POLICY_BOTH ||
-              priv->scroll_policy == MX_SCROLL_POLICY_AUTOMATIC) &&
-              priv->in_automatic_scroll != MX_AUTOMATIC_SCROLL_HORIZONTAL)
-            {
-              if (ABS (priv->dy) > 2)
-                {
-                  vvalue = priv->dy + mx_adjustment_get_value (vadjust);
-                  mx_adjustment_set_value (vadjust, vvalue);
-
-                  if (priv->overshoot > 0.0)
-                    {
-                      if ((vvalue > mx_adjustment_get_upper (vadjust) -
-                           mx_adjustment_get_page_size (vadjust)) ||
-                          (vvalue < mx_adjustment_get_lower (vadjust)))
-                        priv->dy *= priv->overshoot;
-                    }
-
-                  priv->dy = priv->dy / priv->decel_rate;
+      if (vadjust &&
+          (priv->scroll_policy == MX_SCROLL_POLICY_VERTICAL ||
+          priv->scroll_policy == MX_SCROLL_POLICY_BOTH ||
+          priv->scroll_policy == MX_SCROLL_POLICY_AUTOMATIC) &&
+          priv->in_automatic_scroll != MX_AUTOMATIC_SCROLL_HORIZONTAL &&
+          priv->vmoving)
+        {
+          mx_adjustment_set_value (vadjust,
+                                   deceleration_get_value (scroll,
+                                                           &priv->vdecel,
+                                                           steps));
 
-                  stop = FALSE;
-                }
-              else if (priv->vmoving)
-                {
-                  guint duration;
+          if (steps < priv->vdecel.end_step)
+            stop = FALSE;
+          else
+            {
+              guint duration;
 
-                  priv->vmoving = FALSE;
+              priv->vmoving = FALSE;
+              axis_stopped = TRUE;
 
-                  duration = (priv->overshoot > 0.0) ?
-                                priv->clamp_duration : 10;
-                  clamp_adjustments (scroll, duration, FALSE, TRUE);
-                }
+              duration = (priv->overshoot > 0.0) ?
+                            priv->clamp_duration : 10;
+              clamp_adjustments (scroll, duration, FALSE, TRUE);
             }
-
-          priv->accumulated_delta -= 1000.0/60.0;
         }
 
+      MX_NOTE (KINETIC, "frame at %.2f ms: h %.2f, v %.2f", priv->decel_time,
+               hadjust ? mx_adjustment_get_value (hadjust) : 0.0,
+               vadjust ? mx_adjustment_get_value (vadjust) : 0.0);
+
       if (stop)
         {
           clutter_timeline_stop (timeline);
           deceleration_completed_cb (timeline, scroll);
         }
+      else if (axis_stopped)
+        emit_prefetch_hint (scroll);
     }
 }
 
@@ -1229,7 +1745,8 @@ button_release_event_cb (ClutterActor        *stage,
       if (clutter_event_get_button (event) == priv->button)
         {
           clutter_event_get_coords (event, &x, &y);
-          return release_event (scroll, x, y);
+          return release_event (scroll, x, y,
+                                clutter_event_get_time (event));
         }
       break;
 
@@ -1238,7 +1755,8 @@ button_release_event_cb (ClutterActor        *stage,
       if (clutter_event_get_event_sequence (event) == priv->sequence)
         {
           clutter_event_get_coords (event, &x, &y);
-          return release_event (scroll, x, y);
+          return release_event (scroll, x, y,
+                                clutter_event_get_time (event));
         }
       break;
 
@@ -1252,7 +1770,8 @@ button_release_event_cb (ClutterActor        *stage,
 static gboolean
 release_event (MxKineticScrollView *scroll,
                gint                 x_pos,
-               gint                 y_pos)
+               gint                 y_pos,
+               guint32              time_)
 {
   ClutterActor *actor = CLUTTER_ACTOR (scroll);
   ClutterActor *stage = clutter_actor_get_stage (actor);
@@ -1275,7 +1794,7 @@ release_event (MxKineticScrollView *scroll,
     {
       priv->device = NULL;
       priv->sequence = NULL;
-      priv->last_motion = 0;
+      priv->n_motions = 0;
       return FALSE;
     }
 
@@ -1289,52 +1808,19 @@ release_event (MxKineticScrollView *scroll,
                                                &event_x, &event_y))
         {
           gdouble value, lower, upper, step_increment, page_size,
-                  d, ax, ay, y, nx, ny, n;
-          gfloat frac, x_origin, y_origin;
-          GTimeVal release_time, motion_time;
+                  d, ax, ay, y, nx, ny, n, vx, vy;
           MxAdjustment *hadjust, *vadjust;
-          glong time_diff;
           guint duration;
-          gint i;
 
-          /* Get time delta */
-          g_get_current_time (&release_time);
+          /* Estimate the velocity of the pointer from the recent motion
+           * events and the release */
+          add_motion (scroll, event_x, event_y, time_);
+          estimate_velocity (scroll, &vx, &vy);
 
-          /* Get average position/time of last x mouse events */
-          priv->last_motion ++;
-          x_origin = y_origin = 0;
-          motion_time = (GTimeVal){ 0, 0 };
-          for (i = 0; i < priv->last_motion; i++)
-            {
-              MxKineticScrollViewMotion *motion =
-                &g_array_index (priv->motion_buffer, MxKineticScrollViewMotion, i);
-
-              /* FIXME: This doesn't guard against overflows - Should
-               *        either fix that, or calculate the correct maximum
-               *        value for the buffer size
-               */
-              x_origin += motion->x;
-              y_origin += motion->y;
-              motion_time.tv_sec += motion->time.tv_sec;
-              motion_time.tv_usec += motion->time.tv_usec;
-            }
-          x_origin = x_origin / priv->last_motion;
-          y_origin = y_origin / priv->last_motion;
-          motion_time.tv_sec /= priv->last_motion;
-          motion_time.tv_usec /= priv->last_motion;
-
-          if (motion_time.tv_sec == release_time.tv_sec)
-            time_diff = release_time.tv_usec - motion_time.tv_usec;
-          else
-            time_diff = release_time.tv_usec +
-                        (G_USEC_PER_SEC - motion_time.tv_usec);
-
-          /* Work out the fraction of 1/60th of a second that has elapsed */
-          frac = (time_diff/1000.0) / (1000.0/60.0);
-
-          /* See how many units to move in 1/60th of a second */
-          priv->dx = (x_origin - event_x) / frac * priv->acceleration_factor;
-          priv->dy = (y_origin - event_y) / frac * priv->acceleration_factor;
+          /* See how many units to move in 1/60th of a second, the content
+           * moving the other way to the pointer */
+          priv->dx = -vx * DECEL_STEP * 1000 * priv->acceleration_factor;
+          priv->dy = -vy * DECEL_STEP * 1000 * priv->acceleration_factor;
 
           /* If the delta is too low for the equations to work,
            * bump the values up a bit.
@@ -1460,17 +1946,36 @@ release_event (MxKineticScrollView *scroll,
                   priv->dy = d / ay;
                 }
 
+              deceleration_init (scroll, &priv->hdecel, hadjust, priv->dx);
+              deceleration_init (scroll, &priv->vdecel, vadjust, priv->dy);
+              priv->decel_time = 0;
+
+              /* the deceleration stops itself once both axes are done, the
+               * timeline only needs to last until then */
+              duration = MAX (1, (gint) (ceil (MAX (priv->hdecel.end_step,
+                                                    priv->vdecel.end_step)) *
+                                         DECEL_STEP));
+
               priv->deceleration_timeline = clutter_timeline_new (duration);
 
               g_signal_connect (priv->deceleration_timeline, "new_frame",
                                 G_CALLBACK (deceleration_new_frame_cb), scroll);
-              g_signal_connect (priv->deceleration_timeline, "completed",
-                                G_CALLBACK (deceleration_completed_cb), scroll);
-              priv->accumulated_delta = 0;
+
+              /* with synthetic frame times, the deceleration may take longer
+               * than the timeline */
+              if (deceleration_get_synthetic_frame_time () > 0)
+                clutter_timeline_set_repeat_count (priv->deceleration_timeline,
+                                                   -1);
+              else
+                g_signal_connect (priv->deceleration_timeline, "completed",
+                                  G_CALLBACK (deceleration_completed_cb),
+                                  scroll);
               priv->hmoving = priv->vmoving = TRUE;
               clutter_timeline_start (priv->deceleration_timeline);
               decelerating = TRUE;
               set_state (scroll, MX_KINETIC_SCROLL_VIEW_STATE_SCROLLING);
+
+              emit_prefetch_hint (scroll);
             }
         }
     }
@@ -1487,7 +1992,7 @@ release_event (MxKineticScrollView *scroll,
   priv->device = NULL;
 
   /* Reset motion event buffer */
-  priv->last_motion = 0;
+  priv->n_motions = 0;
 
   if (!decelerating)
     clamp_adjustments (scroll, priv->clamp_duration, TRUE, TRUE);
@@ -1498,32 +2003,30 @@ release_event (MxKineticScrollView *scroll,
 static gboolean
 press_event (MxKineticScrollView *scroll,
              gfloat               x,
-             gfloat               y)
+             gfloat               y,
+             guint32              time_)
 {
   MxKineticScrollViewPrivate *priv = scroll->priv;
   ClutterActor *actor = (ClutterActor *) scroll;
   ClutterActor *stage = clutter_actor_get_stage (actor);
-  MxKineticScrollViewMotion *motion;
+  gfloat motion_x, motion_y;
 
   /* Reset automatic-scroll setting */
   priv->in_automatic_scroll = MX_AUTOMATIC_SCROLL_NONE;
   priv->align_tested = 0;
 
   /* Reset motion buffer */
-  priv->last_motion = 0;
-  motion = &g_array_index (priv->motion_buffer, MxKineticScrollViewMotion, 0);
-  motion->x = x;
-  motion->y = y;
+  priv->n_motions = 0;
 
   LOG_DEBUG (scroll, "initial point(%fx%f)", x, y);
 
   if (clutter_actor_transform_stage_point (actor, x, y,
-                                           &motion->x, &motion->y))
+                                           &motion_x, &motion_y))
     {
       guint threshold;
       MxSettings *settings = mx_settings_get_default ();
 
-      g_get_current_time (&motion->time);
+      add_motion (scroll, motion_x, motion_y, time_);
 
       if (priv->deceleration_timeline)
         {
@@ -1533,6 +2036,7 @@ press_event (MxKineticScrollView *scroll,
 
           clamp_adjustments (scroll, priv->clamp_duration, priv->hmoving,
                              priv->vmoving);
+          emit_prefetch_hint (scroll);
         }
 
       if (priv->use_captured)
@@ -1614,7 +2118,7 @@ button_press_event_cb (ClutterActor        *actor,
           priv->sequence = clutter_event_get_event_sequence (event);
           priv->source_press_actor = clutter_event_get_source (event);
           clutter_event_get_coords (event, &x, &y);
-          if (press_event (scroll, x, y))
+          if (press_event (scroll, x, y, clutter_event_get_time (event)))
             {
               if (priv->use_grab)
                 {
@@ -1633,7 +2137,7 @@ button_press_event_cb (ClutterActor        *actor,
           priv->sequence = clutter_event_get_event_sequence (event);
           priv->source_press_actor = clutter_event_get_source (event);
           clutter_event_get_coords (event, &x, &y);
-          if (press_event (scroll, x, y))
+          if (press_event (scroll, x, y, clutter_event_get_time (event)))
             {
               if (priv->use_grab)
                 {
@@ -1739,9 +2243,6 @@ mx_kinetic_scroll_view_init (MxKineticScrollView *self)
   MxKineticScrollViewPrivate *priv = self->priv =
     KINETIC_SCROLL_VIEW_PRIVATE (self);
 
-  priv->motion_buffer =
-    g_array_sized_new (FALSE, TRUE, sizeof (MxKineticScrollViewMotion), 3);
-  g_array_set_size (priv->motion_buffer, 3);
   priv->decel_rate = 1.1f;
   priv->button = 1;
   priv->scroll_policy = MX_SCROLL_POLICY_BOTH;
@@ -1800,6 +2301,8 @@ mx_kinetic_scroll_view_stop (MxKineticScrollView *scroll)
       clutter_timeline_stop (priv->deceleration_timeline);
       g_object_unref (priv->deceleration_timeline);
       priv->deceleration_timeline = NULL;
+
+      emit_prefetch_hint (scroll);
     }
 }
 
@@ -48,6 +48,7 @@
 #include "mx-stylable.h"
 #include "mx-private.h"
 #include "mx-fade-effect.h"
+#include "mx-text-cache.h"
 
 enum
 {
@@ -197,13 +198,16 @@ mx_label_get_preferred_width (ClutterActor *actor,
   MxLabelPrivate *priv = MX_LABEL (actor)->priv;
   MxPadding padding = { 0, };
 
+  MX_PROFILE_BEGIN (actor, PREFERRED_SIZE);
+
   mx_widget_get_padding (MX_WIDGET (actor), &padding);
 
   for_height -= padding.top + padding.bottom;
 
-  clutter_actor_get_preferred_width (priv->label, for_height,
-                                     min_width_p,
-                                     natural_width_p);
+  /* the width of the text doesn't depend on the height */
+  _mx_text_cache_get_preferred_width (CLUTTER_TEXT (priv->label),
+                                      min_width_p,
+                                      natural_width_p);
 
   /* If we're fading out, make sure our minimum width is zero */
   if (priv->fade_out && min_width_p)
@@ -214,6 +218,8 @@ mx_label_get_preferred_width (ClutterActor *actor,
 
   if (natural_width_p)
     *natural_width_p += padding.left + padding.right;
+
+  MX_PROFILE_END (actor, PREFERRED_SIZE);
 }
 
 static void
@@ -225,19 +231,23 @@ mx_label_get_preferred_height (ClutterActor *actor,
   MxLabelPrivate *priv = MX_LABEL (actor)->priv;
   MxPadding padding = { 0, };
 
+  MX_PROFILE_BEGIN (actor, PREFERRED_SIZE);
+
   mx_widget_get_padding (MX_WIDGET (actor), &padding);
 
   for_width -= padding.left + padding.right;
 
-  clutter_actor_get_preferred_height (priv->label, for_width,
-                                      min_height_p,
-                                      natural_height_p);
+  _mx_text_cache_get_preferred_height (CLUTTER_TEXT (priv->label), for_width,
+                                       min_height_p,
+                                       natural_height_p);
 
   if (min_height_p)
     *min_height_p += padding.top + padding.bottom;
 
   if (natural_height_p)
     *natural_height_p += padding.top + padding.bottom;
+
+  MX_PROFILE_END (actor, PREFERRED_SIZE);
 }
 
 static void
@@ -253,6 +263,8 @@ mx_label_allocate (ClutterActor          *actor,
   gboolean x_fill, y_fill;
   gfloat avail_width;
 
+  MX_PROFILE_BEGIN (actor, ALLOCATE);
+
   parent_class = CLUTTER_ACTOR_CLASS (mx_label_parent_class);
   parent_class->allocate (actor, box, flags);
 
@@ -282,7 +294,8 @@ mx_label_allocate (ClutterActor          *actor,
        */
       gfloat label_width;
 
-      clutter_actor_get_preferred_width (priv->label, -1, NULL, &label_width);
+      _mx_text_cache_get_preferred_width (CLUTTER_TEXT (priv->label),
+                                          NULL, &label_width);
 
       if (label_width > avail_width)
         {
@@ -328,6 +341,8 @@ mx_label_allocate (ClutterActor          *actor,
 
       clutter_timeline_start (priv->fade_timeline);
     }
+
+  MX_PROFILE_END (actor, ALLOCATE);
 }
 
 static void
@@ -336,11 +351,18 @@ mx_label_paint (ClutterActor *actor)
   MxLabelPrivate *priv = MX_LABEL (actor)->priv;
   ClutterActorClass *parent_class;
 
+  MX_PROFILE_BEGIN (actor, PAINT);
+
   parent_class = CLUTTER_ACTOR_CLASS (mx_label_parent_class);
   parent_class->paint (actor);
 
   clutter_actor_paint (priv->label);
-  _mx_fade_effect_set_freeze_update (MX_FADE_EFFECT (priv->fade_effect), TRUE);
+
+  if (priv->fade_effect)
+    _mx_fade_effect_set_freeze_update (MX_FADE_EFFECT (priv->fade_effect),
+                                       TRUE);
+
+  MX_PROFILE_END (actor, PAINT);
 }
 
 static void
@@ -350,10 +372,14 @@ mx_label_pick (ClutterActor *actor,
   MxLabelPrivate *priv = MX_LABEL (actor)->priv;
   ClutterActorClass *parent_class;
 
+  MX_PROFILE_BEGIN (actor, PICK);
+
   parent_class = CLUTTER_ACTOR_CLASS (mx_label_parent_class);
   parent_class->pick (actor, pick_color);
 
   clutter_actor_paint (priv->label);
+
+  MX_PROFILE_END (actor, PICK);
 }
 
 static void
@@ -568,7 +594,6 @@ static void
 mx_label_init (MxLabel *label)
 {
   MxLabelPrivate *priv;
-  const ClutterColor opaque = { 0xff, 0xff, 0xff, 0xff };
 
   label->priv = priv = MX_LABEL_GET_PRIVATE (label);
 
@@ -578,14 +603,27 @@ mx_label_init (MxLabel *label)
 
   clutter_actor_add_child (CLUTTER_ACTOR (label), priv->label);
 
+  g_signal_connect (label, "style-changed",
+                    G_CALLBACK (mx_label_style_changed), NULL);
+}
+
+/* Most labels never fade, so the effect and its timeline are only created
+ * the first time fading out is enabled */
+static void
+mx_label_ensure_fade (MxLabel *label)
+{
+  MxLabelPrivate *priv = label->priv;
+  const ClutterColor opaque = { 0xff, 0xff, 0xff, 0xff };
+
+  if (priv->fade_effect)
+    return;
+
   priv->fade_effect = mx_fade_effect_new ();
   mx_fade_effect_set_color (MX_FADE_EFFECT (priv->fade_effect), &opaque);
   clutter_actor_add_effect (priv->label, priv->fade_effect);
   clutter_actor_meta_set_enabled (CLUTTER_ACTOR_META (priv->fade_effect),
                                   FALSE);
 
-  g_signal_connect (label, "style-changed",
-                    G_CALLBACK (mx_label_style_changed), NULL);
   g_signal_connect (priv->label, "notify::single-line-mode",
                     G_CALLBACK (mx_label_single_line_mode_cb), label);
   g_signal_connect_swapped (priv->label, "queue-redraw",
@@ -905,6 +943,8 @@ mx_label_set_fade_out (MxLabel  *label,
       /* Enable the fade-effect */
       if (fade)
         {
+          mx_label_ensure_fade (label);
+
           priv->label_should_fade = FALSE;
           clutter_text_set_single_line_mode (CLUTTER_TEXT (priv->label), TRUE);
           clutter_text_set_ellipsize (CLUTTER_TEXT (priv->label),
@@ -994,3 +1034,34 @@ mx_label_get_show_tooltip (MxLabel *label)
 
   return label->priv->show_tooltip;
 }
+
+/**
+ * mx_label_get_layout_cache_stats:
+ * @n_entries: (out) (allow-none): return location for the number of
+ *   measurements in the cache, or %NULL
+ * @hits: (out) (allow-none): return location for the number of size
+ *   requests answered from the cache, or %NULL
+ * @misses: (out) (allow-none): return location for the number of size
+ *   requests that needed the text to be measured, or %NULL
+ *
+ * Retrieves usage statistics for the cache of text sizes shared by all the
+ * labels. Labels using markup are measured directly and aren't counted.
+ *
+ * Since: 2.0
+ */
+void
+mx_label_get_layout_cache_stats (guint *n_entries,
+                                 guint *hits,
+                                 guint *misses)
+{
+  MxTextCacheStats stats;
+
+  _mx_text_cache_get_stats (&stats);
+
+  if (n_entries)
+    *n_entries = stats.n_entries;
+  if (hits)
+    *hits = stats.hits;
+  if (misses)
+    *misses = stats.misses;
+}
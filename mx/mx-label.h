@@ -105,6 +105,10 @@ gboolean mx_label_get_fade_out (MxLabel *label);
 void     mx_label_set_show_tooltip (MxLabel *label, gboolean show_tooltip);
 gboolean mx_label_get_show_tooltip (MxLabel *label);
 
+void     mx_label_get_layout_cache_stats (guint *n_entries,
+                                          guint *hits,
+                                          guint *misses);
+
 G_END_DECLS
 
 #endif /* __MX_LABEL_H__ */
@@ -32,33 +32,48 @@
  *
  * Data is set on the children by mapping columns in the model to object
  * properties on the children.
+ *
+ * When #MxListView:virtualized is set, children are only created for the
+ * rows that intersect the visible area, plus #MxListView:overscan rows on
+ * either side. As rows scroll out of view, their children are recycled for
+ * the rows scrolling into view. Row heights are measured as rows are
+ * realized; rows that have not been realized yet are assumed to have the
+ * average height of the rows measured so far. In this mode, rows are always
+ * laid out vertically. While a kinetic scroll is under way,
+ * mx_scrollable_prefetch_hint() lets the view also realize up to a page of
+ * the rows it is heading towards.
  */
 
+#include <string.h>
+
 #include "mx-list-view.h"
 #include "mx-box-layout.h"
 #include "mx-private.h"
 #include "mx-item-factory.h"
+#include "mx-scrollable.h"
 
-G_DEFINE_TYPE (MxListView, mx_list_view, MX_TYPE_BOX_LAYOUT)
+static void mx_list_view_scrollable_iface_init (MxScrollableIface *iface);
+
+G_DEFINE_TYPE_WITH_CODE (MxListView, mx_list_view, MX_TYPE_BOX_LAYOUT,
+                         G_IMPLEMENT_INTERFACE (MX_TYPE_SCROLLABLE,
+                                                mx_list_view_scrollable_iface_init))
 
 #define LIST_VIEW_PRIVATE(o) \
   (G_TYPE_INSTANCE_GET_PRIVATE ((o), MX_TYPE_LIST_VIEW, MxListViewPrivate))
 
-typedef struct
-{
-  gchar *name;
-  gint   col;
-} AttributeData;
-
 enum
 {
   PROP_0,
 
   PROP_MODEL,
   PROP_ITEM_TYPE,
-  PROP_FACTORY
+  PROP_FACTORY,
+  PROP_VIRTUALIZED,
+  PROP_OVERSCAN
 };
 
+#define DEFAULT_OVERSCAN 4
+
 struct _MxListViewPrivate
 {
   ClutterModel  *model;
@@ -74,8 +89,40 @@ struct _MxListViewPrivate
   gulong         sort_changed;
 
   guint          is_frozen : 1;
+
+  /* virtualized mode */
+  guint          virtualized : 1;
+  guint          offsets_dirty : 1;
+  guint          in_allocation : 1;
+  guint          overscan;
+
+  MxAdjustment  *vadjustment;
+
+  GArray        *row_heights;    /* measured height of each row, or -1 */
+  GArray        *row_offsets;    /* start of each row, plus the total */
+  gdouble        measured_total;
+  guint          n_measured;
+
+  gint           first_row;      /* row of the first realized child */
+  GPtrArray     *row_actors;     /* realized children, in row order */
+  GSList        *free_actors;    /* hidden children available for re-use */
+
+  gfloat         last_width;     /* available size of the last allocation */
+  gfloat         last_height;
+  gfloat         realized_width; /* width the realized rows were measured
+                                  * for, or -1 to realize them again */
+  guint          pre_paint_func;
+
+  /* where a kinetic scroll is heading, see mx_scrollable_prefetch_hint() */
+  guint          prefetching : 1;
+  gdouble        prefetch_value;
 };
 
+static void model_changed_cb (ClutterModel *model,
+                              MxListView   *list_view);
+static void model_reordered_cb (ClutterModel *model,
+                                MxListView   *list_view);
+
 /* gobject implementations */
 
 static void
@@ -96,6 +143,12 @@ mx_list_view_get_property (GObject    *object,
     case PROP_FACTORY:
       g_value_set_object (value, priv->factory);
       break;
+    case PROP_VIRTUALIZED:
+      g_value_set_boolean (value, priv->virtualized);
+      break;
+    case PROP_OVERSCAN:
+      g_value_set_uint (value, priv->overscan);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
     }
@@ -121,11 +174,23 @@ mx_list_view_set_property (GObject      *object,
       mx_list_view_set_factory ((MxListView*) object,
                                 (MxItemFactory*) g_value_get_object (value));
       break;
+    case PROP_VIRTUALIZED:
+      mx_list_view_set_virtualized ((MxListView*) object,
+                                    g_value_get_boolean (value));
+      break;
+    case PROP_OVERSCAN:
+      mx_list_view_set_overscan ((MxListView*) object,
+                                 g_value_get_uint (value));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
     }
 }
 
+static void mx_list_view_vadjustment_value_cb (MxAdjustment *adjustment,
+                                               GParamSpec   *pspec,
+                                               MxListView   *list_view);
+
 static void
 mx_list_view_dispose (GObject *object)
 {
@@ -134,20 +199,28 @@ mx_list_view_dispose (GObject *object)
   /* This will cause the unref of the model and also disconnect the signals */
   mx_list_view_set_model (MX_LIST_VIEW (object), NULL);
 
+  if (priv->vadjustment)
+    {
+      g_signal_handlers_disconnect_by_func (priv->vadjustment,
+                                            mx_list_view_vadjustment_value_cb,
+                                            object);
+      g_object_unref (priv->vadjustment);
+      priv->vadjustment = NULL;
+    }
+
   if (priv->factory)
     {
       g_object_unref (priv->factory);
       priv->factory = NULL;
     }
 
-  G_OBJECT_CLASS (mx_list_view_parent_class)->dispose (object);
-}
+  if (priv->pre_paint_func)
+    {
+      clutter_threads_remove_repaint_func (priv->pre_paint_func);
+      priv->pre_paint_func = 0;
+    }
 
-static void
-free_attribute (AttributeData *data)
-{
-  g_free (data->name);
-  g_free (data);
+  G_OBJECT_CLASS (mx_list_view_parent_class)->dispose (object);
 }
 
 static void
@@ -157,18 +230,706 @@ mx_list_view_finalize (GObject *object)
 
   if (priv->attributes)
     {
-      g_slist_foreach (priv->attributes, (GFunc) free_attribute, NULL);
+      g_slist_foreach (priv->attributes, (GFunc) _mx_item_attribute_free,
+                       NULL);
       g_slist_free (priv->attributes);
       priv->attributes = NULL;
     }
 
+  g_array_free (priv->row_heights, TRUE);
+  g_array_free (priv->row_offsets, TRUE);
+  g_ptr_array_free (priv->row_actors, TRUE);
+  g_slist_free (priv->free_actors);
+
   G_OBJECT_CLASS (mx_list_view_parent_class)->finalize (object);
 }
 
+/* item creation and binding */
+
+static ClutterActor *
+mx_list_view_create_item (MxListView *list_view)
+{
+  MxListViewPrivate *priv = list_view->priv;
+
+  return _mx_item_create (priv->item_type, priv->factory);
+}
+
+static void
+mx_list_view_bind_item (MxListView       *list_view,
+                        GObject          *child,
+                        ClutterModelIter *iter)
+{
+  _mx_item_bind (child, iter, list_view->priv->attributes);
+}
+
+/* virtualized mode */
+
+static gfloat
+mx_list_view_get_row_height (MxListViewPrivate *priv,
+                             guint              row)
+{
+  gfloat height = g_array_index (priv->row_heights, gfloat, row);
+
+  if (height >= 0)
+    return height;
+
+  return priv->n_measured ? priv->measured_total / priv->n_measured : 0;
+}
+
+static void
+mx_list_view_update_offsets (MxListView *list_view)
+{
+  MxListViewPrivate *priv = list_view->priv;
+  gfloat offset, spacing;
+  guint row, n_rows;
+
+  if (!priv->offsets_dirty)
+    return;
+
+  spacing = mx_box_layout_get_spacing (MX_BOX_LAYOUT (list_view));
+  n_rows = priv->row_heights->len;
+
+  g_array_set_size (priv->row_offsets, n_rows + 1);
+
+  offset = 0;
+  for (row = 0; row < n_rows; row++)
+    {
+      g_array_index (priv->row_offsets, gfloat, row) = offset;
+      offset += mx_list_view_get_row_height (priv, row) + spacing;
+    }
+  g_array_index (priv->row_offsets, gfloat, n_rows) = offset;
+
+  priv->offsets_dirty = FALSE;
+}
+
+static gfloat
+mx_list_view_get_total_height (MxListView *list_view)
+{
+  MxListViewPrivate *priv = list_view->priv;
+  guint n_rows = priv->row_heights->len;
+
+  if (n_rows == 0)
+    return 0;
+
+  mx_list_view_update_offsets (list_view);
+
+  return g_array_index (priv->row_offsets, gfloat, n_rows) -
+    mx_box_layout_get_spacing (MX_BOX_LAYOUT (list_view));
+}
+
+/* Returns the last row starting at or before @offset */
+static guint
+mx_list_view_get_row_at_offset (MxListView *list_view,
+                                gfloat      offset)
+{
+  MxListViewPrivate *priv = list_view->priv;
+  guint low, high;
+
+  mx_list_view_update_offsets (list_view);
+
+  low = 0;
+  high = priv->row_heights->len;
+  while (low < high)
+    {
+      guint mid = (low + high) / 2;
+
+      if (g_array_index (priv->row_offsets, gfloat, mid) <= offset)
+        low = mid + 1;
+      else
+        high = mid;
+    }
+
+  return low ? low - 1 : 0;
+}
+
+static void
+mx_list_view_release_actor (MxListView   *list_view,
+                            ClutterActor *actor)
+{
+  MxListViewPrivate *priv = list_view->priv;
+
+  clutter_actor_hide (actor);
+  priv->free_actors = g_slist_prepend (priv->free_actors, actor);
+}
+
+static void
+mx_list_view_release_all (MxListView *list_view)
+{
+  MxListViewPrivate *priv = list_view->priv;
+  guint i;
+
+  for (i = 0; i < priv->row_actors->len; i++)
+    mx_list_view_release_actor (list_view,
+                                g_ptr_array_index (priv->row_actors, i));
+
+  g_ptr_array_set_size (priv->row_actors, 0);
+  priv->first_row = 0;
+}
+
+static ClutterActor *
+mx_list_view_acquire_actor (MxListView *list_view)
+{
+  MxListViewPrivate *priv = list_view->priv;
+  ClutterActor *actor;
+
+  if (priv->free_actors)
+    {
+      actor = priv->free_actors->data;
+      priv->free_actors = g_slist_delete_link (priv->free_actors,
+                                               priv->free_actors);
+      clutter_actor_show (actor);
+    }
+  else
+    {
+      actor = mx_list_view_create_item (list_view);
+      clutter_actor_add_child (CLUTTER_ACTOR (list_view), actor);
+    }
+
+  return actor;
+}
+
+static void
+mx_list_view_measure_row (MxListView   *list_view,
+                          ClutterActor *actor,
+                          guint         row,
+                          gfloat        for_width)
+{
+  MxListViewPrivate *priv = list_view->priv;
+  gfloat *height, new_height;
+
+  clutter_actor_get_preferred_height (actor, for_width, NULL, &new_height);
+
+  height = &g_array_index (priv->row_heights, gfloat, row);
+  if (*height == new_height)
+    return;
+
+  if (*height >= 0)
+    priv->measured_total -= *height;
+  else
+    priv->n_measured++;
+
+  priv->measured_total += new_height;
+  *height = new_height;
+
+  priv->offsets_dirty = TRUE;
+}
+
+/* Gets the visible area. With @extend, this also covers up to a page
+ * towards the position a kinetic scroll is heading to. */
+static void
+mx_list_view_get_view_range (MxListView *list_view,
+                             gfloat      height,
+                             gboolean    extend,
+                             gfloat     *start,
+                             gfloat     *end)
+{
+  MxListViewPrivate *priv = list_view->priv;
+  gdouble value = 0;
+
+  if (priv->vadjustment)
+    value = mx_adjustment_get_value (priv->vadjustment);
+
+  *start = value;
+  *end = value + height;
+
+  if (extend && priv->prefetching)
+    {
+      if (priv->prefetch_value > value)
+        *end = MIN (priv->prefetch_value, value + height) + height;
+      else
+        *start = MAX (priv->prefetch_value, value - height);
+    }
+}
+
+/* Checks whether the realized rows cover the visible area, and the area a
+ * kinetic scroll is heading to */
+static gboolean
+mx_list_view_needs_realize (MxListView *list_view,
+                            gfloat      height)
+{
+  MxListViewPrivate *priv = list_view->priv;
+  gfloat start, end;
+  guint first, last, n_rows;
+
+  n_rows = priv->row_heights->len;
+  if (n_rows == 0)
+    return priv->row_actors->len > 0;
+
+  mx_list_view_get_view_range (list_view, height, TRUE, &start, &end);
+
+  first = mx_list_view_get_row_at_offset (list_view, start);
+  last = mx_list_view_get_row_at_offset (list_view, end);
+
+  return (priv->row_actors->len == 0 ||
+          first < priv->first_row ||
+          last >= priv->first_row + priv->row_actors->len);
+}
+
+/*
+ * mx_list_view_realize_rows:
+ * @list_view: An #MxListView
+ * @width: The width available to the rows
+ * @height: The height of the visible area
+ *
+ * Makes sure there is a child for each of the visible rows, plus the
+ * overscan, re-using the children of rows that are no longer needed.
+ */
+static void
+mx_list_view_realize_rows (MxListView *list_view,
+                           gfloat      width,
+                           gfloat      height)
+{
+  MxListViewPrivate *priv = list_view->priv;
+  GPtrArray *old_actors, *new_actors;
+  gint old_first, start, estimated_end, row, n_rows;
+  gfloat view_start, view_end, visible_start, visible_end, offset, spacing;
+  ClutterActor *prev;
+  gint n_after;
+  guint i;
+
+  n_rows = priv->row_heights->len;
+  priv->realized_width = width;
+
+  if (!priv->model || n_rows == 0)
+    {
+      mx_list_view_release_all (list_view);
+      return;
+    }
+
+  spacing = mx_box_layout_get_spacing (MX_BOX_LAYOUT (list_view));
+  mx_list_view_get_view_range (list_view, height, TRUE, &view_start,
+                               &view_end);
+  mx_list_view_get_view_range (list_view, height, FALSE, &visible_start,
+                               &visible_end);
+
+  start = mx_list_view_get_row_at_offset (list_view, view_start);
+  start = MAX (0, start - (gint) priv->overscan);
+
+  /* Release the children that are certainly outside the new range, so they
+   * can be re-used straight away.
+   */
+  estimated_end = mx_list_view_get_row_at_offset (list_view, view_end) +
+    priv->overscan;
+
+  old_actors = priv->row_actors;
+  old_first = priv->first_row;
+
+  for (i = 0; i < old_actors->len; i++)
+    {
+      row = old_first + i;
+
+      if (row < start || row > estimated_end)
+        {
+          mx_list_view_release_actor (list_view,
+                                      g_ptr_array_index (old_actors, i));
+          g_ptr_array_index (old_actors, i) = NULL;
+        }
+    }
+
+  /* Walk down from the first row, realizing and measuring rows until we're
+   * past the end of the visible area and the overscan.
+   */
+  new_actors = g_ptr_array_sized_new (old_actors->len);
+
+  mx_list_view_update_offsets (list_view);
+  offset = g_array_index (priv->row_offsets, gfloat, start);
+  n_after = priv->overscan;
+
+  for (row = start; row < n_rows; row++)
+    {
+      ClutterActor *actor = NULL;
+
+      if (offset >= view_end && n_after-- <= 0)
+        break;
+
+      if (row >= old_first && row < old_first + (gint) old_actors->len)
+        {
+          actor = g_ptr_array_index (old_actors, row - old_first);
+          g_ptr_array_index (old_actors, row - old_first) = NULL;
+        }
+
+      if (!actor)
+        {
+          ClutterModelIter *iter;
+
+          actor = mx_list_view_acquire_actor (list_view);
+
+          iter = clutter_model_get_iter_at_row (priv->model, row);
+          if (iter)
+            {
+              /* let images loaded for rows that aren't in view yet wait
+               * for the ones that are */
+              _mx_image_set_prefetching
+                (offset >= visible_end ||
+                 offset + mx_list_view_get_row_height (priv, row) <=
+                 visible_start);
+              mx_list_view_bind_item (list_view, G_OBJECT (actor), iter);
+              _mx_image_set_prefetching (FALSE);
+
+              g_object_unref (iter);
+            }
+        }
+
+      mx_list_view_measure_row (list_view, actor, row, width);
+      offset += mx_list_view_get_row_height (priv, row) + spacing;
+
+      g_ptr_array_add (new_actors, actor);
+    }
+
+  /* Release anything else that was realized before */
+  for (i = 0; i < old_actors->len; i++)
+    {
+      ClutterActor *actor = g_ptr_array_index (old_actors, i);
+
+      if (actor)
+        mx_list_view_release_actor (list_view, actor);
+    }
+
+  g_ptr_array_free (old_actors, TRUE);
+  priv->row_actors = new_actors;
+  priv->first_row = start;
+
+  /* Keep the children in row order, so that focus navigation works. Children
+   * that were kept are already in order relative to each other, so usually
+   * only the newly bound ones need moving.
+   */
+  prev = NULL;
+  for (i = 0; i < new_actors->len; i++)
+    {
+      ClutterActor *actor = g_ptr_array_index (new_actors, i);
+
+      if (prev && clutter_actor_get_previous_sibling (actor) != prev)
+        clutter_actor_set_child_above_sibling (CLUTTER_ACTOR (list_view),
+                                               actor, prev);
+
+      prev = actor;
+    }
+}
+
+/* The height the rows are realized for: that of the view in the last
+ * allocation, or of the stage before the first one */
+static gfloat
+mx_list_view_get_view_height (MxListView *list_view)
+{
+  MxListViewPrivate *priv = list_view->priv;
+  ClutterActor *stage;
+
+  if (priv->last_height >= 0)
+    return priv->last_height;
+
+  stage = clutter_actor_get_stage (CLUTTER_ACTOR (list_view));
+
+  return stage ? clutter_actor_get_height (stage) : 0;
+}
+
+static gboolean
+mx_list_view_needs_update (MxListView *list_view)
+{
+  MxListViewPrivate *priv = list_view->priv;
+
+  return (priv->realized_width != priv->last_width ||
+          mx_list_view_needs_realize (list_view,
+                                      mx_list_view_get_view_height (list_view)));
+}
+
+/* Realizes the rows for the current view, and lays them out again. This is
+ * never called from within a layout, as adding and binding children would
+ * queue another one. */
+static void
+mx_list_view_update_rows (MxListView *list_view)
+{
+  MxListViewPrivate *priv = list_view->priv;
+
+  mx_list_view_realize_rows (list_view, priv->last_width,
+                             mx_list_view_get_view_height (list_view));
+  clutter_actor_queue_relayout (CLUTTER_ACTOR (list_view));
+}
+
+/* Runs before the stage is laid out, to realize the rows the changes to the
+ * model, the size of the view or the scrolling since the last frame need */
+static gboolean
+mx_list_view_pre_paint_cb (gpointer data)
+{
+  MxListView *list_view = data;
+
+  if (list_view->priv->virtualized && mx_list_view_needs_update (list_view))
+    mx_list_view_update_rows (list_view);
+
+  return TRUE;
+}
+
+static void
+mx_list_view_virtual_reset (MxListView *list_view)
+{
+  MxListViewPrivate *priv = list_view->priv;
+  guint row, n_rows;
+
+  mx_list_view_release_all (list_view);
+
+  n_rows = priv->model ? clutter_model_get_n_rows (priv->model) : 0;
+
+  g_array_set_size (priv->row_heights, n_rows);
+  for (row = 0; row < n_rows; row++)
+    g_array_index (priv->row_heights, gfloat, row) = -1;
+
+  priv->measured_total = 0;
+  priv->n_measured = 0;
+  priv->offsets_dirty = TRUE;
+
+  clutter_actor_queue_relayout (CLUTTER_ACTOR (list_view));
+}
+
+/* Removes all the children, for when the kind of child changes */
+static void
+mx_list_view_virtual_clear (MxListView *list_view)
+{
+  MxListViewPrivate *priv = list_view->priv;
+
+  g_ptr_array_set_size (priv->row_actors, 0);
+  g_slist_free (priv->free_actors);
+  priv->free_actors = NULL;
+  priv->first_row = 0;
+
+  clutter_actor_remove_all_children (CLUTTER_ACTOR (list_view));
+}
+
+static void
+mx_list_view_vadjustment_value_cb (MxAdjustment *adjustment,
+                                   GParamSpec   *pspec,
+                                   MxListView   *list_view)
+{
+  MxListViewPrivate *priv = list_view->priv;
+
+  if (!priv->virtualized)
+    return;
+
+  /* The box layout may clamp the value while allocating, the rows are then
+   * realized before the next layout, see mx_list_view_pre_paint_cb() */
+  if (priv->in_allocation)
+    return;
+
+  /* Only re-layout when rows without a child scroll into view */
+  if (mx_list_view_needs_update (list_view))
+    mx_list_view_update_rows (list_view);
+}
+
+static void
+mx_list_view_prefetch_hint (MxScrollable *scrollable,
+                            gdouble       hvalue,
+                            gdouble       vvalue,
+                            gdouble       hvelocity,
+                            gdouble       vvelocity)
+{
+  MxListView *list_view = MX_LIST_VIEW (scrollable);
+  MxListViewPrivate *priv = list_view->priv;
+
+  /* rows are only laid out vertically when virtualized */
+  priv->prefetching = (vvelocity != 0);
+  priv->prefetch_value = vvalue;
+
+  if (priv->virtualized && priv->prefetching &&
+      mx_list_view_needs_update (list_view))
+    mx_list_view_update_rows (list_view);
+}
+
+static void
+mx_list_view_scrollable_iface_init (MxScrollableIface *iface)
+{
+  /* the adjustments are still handled by MxBoxLayout, whose implementation
+   * is inherited */
+  iface->prefetch_hint = mx_list_view_prefetch_hint;
+}
+
+static void
+mx_list_view_vadjustment_notify_cb (MxListView *list_view,
+                                    GParamSpec *pspec)
+{
+  MxListViewPrivate *priv = list_view->priv;
+  MxAdjustment *vadjustment;
+
+  /* mx_scrollable_get_adjustments() and the property would create a new
+   * adjustment when it has just been unset */
+  vadjustment = _mx_box_layout_get_vadjustment (MX_BOX_LAYOUT (list_view));
+
+  if (vadjustment == priv->vadjustment)
+    return;
+
+  if (priv->vadjustment)
+    {
+      g_signal_handlers_disconnect_by_func (priv->vadjustment,
+                                            mx_list_view_vadjustment_value_cb,
+                                            list_view);
+      g_object_unref (priv->vadjustment);
+    }
+
+  /* the box layout has already dropped its reference to the old
+   * adjustment when this is called, so keep one of our own */
+  priv->vadjustment = vadjustment ? g_object_ref (vadjustment) : NULL;
+
+  if (priv->vadjustment)
+    g_signal_connect (priv->vadjustment, "notify::value",
+                      G_CALLBACK (mx_list_view_vadjustment_value_cb),
+                      list_view);
+}
+
+static void
+mx_list_view_get_preferred_width (ClutterActor *actor,
+                                  gfloat        for_height,
+                                  gfloat       *min_width_p,
+                                  gfloat       *nat_width_p)
+{
+  MxListViewPrivate *priv = MX_LIST_VIEW (actor)->priv;
+  MxPadding padding;
+  gfloat min_width, nat_width;
+  guint i;
+
+  MX_PROFILE_BEGIN (actor, PREFERRED_SIZE);
+
+  if (!priv->virtualized)
+    {
+      CLUTTER_ACTOR_CLASS (mx_list_view_parent_class)->
+        get_preferred_width (actor, for_height, min_width_p, nat_width_p);
+      MX_PROFILE_END (actor, PREFERRED_SIZE);
+      return;
+    }
+
+  /* Base the width on the rows currently realized */
+  min_width = nat_width = 0;
+  for (i = 0; i < priv->row_actors->len; i++)
+    {
+      gfloat child_min, child_nat;
+
+      clutter_actor_get_preferred_width (g_ptr_array_index (priv->row_actors,
+                                                            i),
+                                         -1, &child_min, &child_nat);
+      min_width = MAX (min_width, child_min);
+      nat_width = MAX (nat_width, child_nat);
+    }
+
+  mx_widget_get_padding (MX_WIDGET (actor), &padding);
+
+  if (min_width_p)
+    *min_width_p = min_width + padding.left + padding.right;
+  if (nat_width_p)
+    *nat_width_p = nat_width + padding.left + padding.right;
+
+  MX_PROFILE_END (actor, PREFERRED_SIZE);
+}
+
+static void
+mx_list_view_get_preferred_height (ClutterActor *actor,
+                                   gfloat        for_width,
+                                   gfloat       *min_height_p,
+                                   gfloat       *nat_height_p)
+{
+  MxListViewPrivate *priv = MX_LIST_VIEW (actor)->priv;
+  MxPadding padding;
+  gfloat height;
+
+  MX_PROFILE_BEGIN (actor, PREFERRED_SIZE);
+
+  if (!priv->virtualized)
+    {
+      CLUTTER_ACTOR_CLASS (mx_list_view_parent_class)->
+        get_preferred_height (actor, for_width, min_height_p, nat_height_p);
+      MX_PROFILE_END (actor, PREFERRED_SIZE);
+      return;
+    }
+
+  mx_widget_get_padding (MX_WIDGET (actor), &padding);
+
+  height = mx_list_view_get_total_height (MX_LIST_VIEW (actor)) +
+    padding.top + padding.bottom;
+
+  if (min_height_p)
+    *min_height_p = 0;
+  if (nat_height_p)
+    *nat_height_p = height;
+
+  MX_PROFILE_END (actor, PREFERRED_SIZE);
+}
+
+static void
+mx_list_view_allocate (ClutterActor           *actor,
+                       const ClutterActorBox  *box,
+                       ClutterAllocationFlags  flags)
+{
+  MxListView *list_view = MX_LIST_VIEW (actor);
+  MxListViewPrivate *priv = list_view->priv;
+  MxPadding padding;
+  guint first_row;
+
+  MX_PROFILE_BEGIN (actor, ALLOCATE);
+
+  if (!priv->virtualized)
+    {
+      _mx_box_layout_set_content_range (MX_BOX_LAYOUT (actor), 0, -1);
+      CLUTTER_ACTOR_CLASS (mx_list_view_parent_class)->allocate (actor, box,
+                                                                 flags);
+      MX_PROFILE_END (actor, ALLOCATE);
+      return;
+    }
+
+  mx_widget_get_padding (MX_WIDGET (actor), &padding);
+
+  priv->last_width = box->x2 - box->x1 - padding.left - padding.right;
+  priv->last_height = box->y2 - box->y1 - padding.top - padding.bottom;
+
+  /* The box layout places the realized rows one after the other from the
+   * first one, and scrolls over all the rows */
+  mx_list_view_update_offsets (list_view);
+  first_row = MIN ((guint) priv->first_row, priv->row_heights->len);
+  _mx_box_layout_set_content_range (MX_BOX_LAYOUT (actor),
+                                    g_array_index (priv->row_offsets, gfloat,
+                                                   first_row),
+                                    mx_list_view_get_total_height (list_view));
+
+  priv->in_allocation = TRUE;
+  CLUTTER_ACTOR_CLASS (mx_list_view_parent_class)->allocate (actor, box,
+                                                             flags);
+  priv->in_allocation = FALSE;
+
+  /* Realizing rows from here would add children during the layout, so
+   * make sure there is another frame to realize them before */
+  if (mx_list_view_needs_update (list_view))
+    clutter_actor_queue_redraw (actor);
+
+  MX_PROFILE_END (actor, ALLOCATE);
+}
+
+static void
+mx_list_view_map (ClutterActor *actor)
+{
+  MxListViewPrivate *priv = MX_LIST_VIEW (actor)->priv;
+
+  CLUTTER_ACTOR_CLASS (mx_list_view_parent_class)->map (actor);
+
+  if (!priv->pre_paint_func)
+    priv->pre_paint_func =
+      clutter_threads_add_repaint_func_full (CLUTTER_REPAINT_FLAGS_PRE_PAINT,
+                                             mx_list_view_pre_paint_cb,
+                                             actor, NULL);
+}
+
+static void
+mx_list_view_unmap (ClutterActor *actor)
+{
+  MxListViewPrivate *priv = MX_LIST_VIEW (actor)->priv;
+
+  if (priv->pre_paint_func)
+    {
+      clutter_threads_remove_repaint_func (priv->pre_paint_func);
+      priv->pre_paint_func = 0;
+    }
+
+  CLUTTER_ACTOR_CLASS (mx_list_view_parent_class)->unmap (actor);
+}
+
 static void
 mx_list_view_class_init (MxListViewClass *klass)
 {
   GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  ClutterActorClass *actor_class = CLUTTER_ACTOR_CLASS (klass);
   GParamSpec *pspec;
 
   g_type_class_add_private (klass, sizeof (MxListViewPrivate));
@@ -178,6 +939,12 @@ mx_list_view_class_init (MxListViewClass *klass)
   object_class->dispose = mx_list_view_dispose;
   object_class->finalize = mx_list_view_finalize;
 
+  actor_class->get_preferred_width = mx_list_view_get_preferred_width;
+  actor_class->get_preferred_height = mx_list_view_get_preferred_height;
+  actor_class->allocate = mx_list_view_allocate;
+  actor_class->map = mx_list_view_map;
+  actor_class->unmap = mx_list_view_unmap;
+
   pspec = g_param_spec_object ("model",
                                "model",
                                "The model for the item view",
@@ -203,14 +970,56 @@ mx_list_view_class_init (MxListViewClass *klass)
                                G_TYPE_OBJECT /*MX_TYPE_ITEM_FACTORY*/,
                                MX_PARAM_READWRITE);
   g_object_class_install_property (object_class, PROP_FACTORY, pspec);
+
+  /**
+   * MxListView:virtualized:
+   *
+   * Whether to only create children for the visible rows of the model,
+   * re-using them as the view scrolls.
+   *
+   * Since: 2.0
+   */
+  pspec = g_param_spec_boolean ("virtualized",
+                                "Virtualized",
+                                "Only create children for the visible rows",
+                                FALSE,
+                                MX_PARAM_READWRITE);
+  g_object_class_install_property (object_class, PROP_VIRTUALIZED, pspec);
+
+  /**
+   * MxListView:overscan:
+   *
+   * The number of rows to keep realized on either side of the visible
+   * area when #MxListView:virtualized is set.
+   *
+   * Since: 2.0
+   */
+  pspec = g_param_spec_uint ("overscan",
+                             "Overscan",
+                             "Number of rows to realize beyond the visible "
+                             "area on either side",
+                             0, G_MAXUINT, DEFAULT_OVERSCAN,
+                             MX_PARAM_READWRITE);
+  g_object_class_install_property (object_class, PROP_OVERSCAN, pspec);
 }
 
 static void
 mx_list_view_init (MxListView *list_view)
 {
-  list_view->priv = LIST_VIEW_PRIVATE (list_view);
+  MxListViewPrivate *priv = list_view->priv = LIST_VIEW_PRIVATE (list_view);
 
   mx_box_layout_set_orientation (MX_BOX_LAYOUT (list_view), MX_ORIENTATION_VERTICAL);
+
+  priv->overscan = DEFAULT_OVERSCAN;
+  priv->last_width = -1;
+  priv->last_height = -1;
+  priv->realized_width = -1;
+  priv->row_heights = g_array_new (FALSE, FALSE, sizeof (gfloat));
+  priv->row_offsets = g_array_new (FALSE, FALSE, sizeof (gfloat));
+  priv->row_actors = g_ptr_array_new ();
+
+  g_signal_connect (list_view, "notify::vertical-adjustment",
+                    G_CALLBACK (mx_list_view_vadjustment_notify_cb), NULL);
 }
 
 
@@ -219,7 +1028,6 @@ static void
 model_changed_cb (ClutterModel *model,
                   MxListView   *list_view)
 {
-  GSList *p;
   GList *l, *children;
   MxListViewPrivate *priv = list_view->priv;
   ClutterModelIter *iter = NULL;
@@ -245,6 +1053,12 @@ model_changed_cb (ClutterModel *model,
         }
     }
 
+  if (priv->virtualized)
+    {
+      mx_list_view_virtual_reset (list_view);
+      return;
+    }
+
   children = clutter_actor_get_children (CLUTTER_ACTOR (list_view));
   child_n = g_list_length (children);
 
@@ -258,14 +1072,7 @@ model_changed_cb (ClutterModel *model,
     {
       ClutterActor *new_child;
 
-      if (priv->item_type)
-        {
-          new_child = g_object_new (priv->item_type, NULL);
-        }
-      else
-        {
-          new_child = mx_item_factory_create (priv->factory);
-        }
+      new_child = mx_list_view_create_item (list_view);
 
       clutter_actor_add_child (CLUTTER_ACTOR (list_view), new_child);
       child_n++;
@@ -283,41 +1090,135 @@ model_changed_cb (ClutterModel *model,
   g_list_free (children);
 
   if (!priv->model)
-    return;
+    {
+      g_ptr_array_set_size (priv->row_actors, 0);
+      return;
+    }
 
   children = clutter_actor_get_children (CLUTTER_ACTOR (list_view));
 
-  /* set the properties on the children */
+  /* set the properties on the children, and remember which child is
+   * showing which row */
+  g_ptr_array_set_size (priv->row_actors, 0);
+  priv->first_row = 0;
+
   iter = clutter_model_get_first_iter (priv->model);
   l = children;
   while (iter && !clutter_model_iter_is_last (iter))
     {
-      GObject *child;
+      mx_list_view_bind_item (list_view, G_OBJECT (l->data), iter);
+      g_ptr_array_add (priv->row_actors, l->data);
 
-      child = G_OBJECT (l->data);
+      l = g_list_next (l);
+      clutter_model_iter_next (iter);
+    }
 
-      g_object_freeze_notify (child);
-      for (p = priv->attributes; p; p = p->next)
-        {
-          GValue value = { 0, };
-          AttributeData *attr = p->data;
+  g_list_free (children);
 
-          clutter_model_iter_get_value (iter, attr->col, &value);
+  if (iter)
+    g_object_unref (iter);
+}
+
+static gint
+mx_list_view_get_changed_row (MxListView       *list_view,
+                              ClutterModel     *model,
+                              ClutterModelIter *iter)
+{
+  MxListViewPrivate *priv = list_view->priv;
+
+  return _mx_item_get_changed_row (model, iter, priv->item_type,
+                                   priv->factory);
+}
+
+/* the rows have been sorted or filtered, move the children showing them */
+static void
+model_reordered_cb (ClutterModel *model,
+                    MxListView   *list_view)
+{
+  MxListViewPrivate *priv = list_view->priv;
+
+  if (priv->is_frozen)
+    return;
+
+  /* when virtualized the row heights have to be measured again anyway, and
+   * the rows in view are bound again as they're realized */
+  if (priv->virtualized ||
+      !_mx_item_type_is_valid (priv->item_type, priv->factory))
+    {
+      model_changed_cb (model, list_view);
+      return;
+    }
+
+  _mx_item_reorder (CLUTTER_ACTOR (list_view), model, priv->attributes,
+                    priv->item_type, priv->factory, priv->row_actors);
+}
 
-          g_object_set_property (child, attr->name, &value);
+static void
+row_added_cb (ClutterModel     *model,
+              ClutterModelIter *iter,
+              MxListView       *list_view)
+{
+  MxListViewPrivate *priv = list_view->priv;
+  ClutterActor *child;
+  gfloat height;
+  guint i;
+  gint row;
 
-          g_value_unset (&value);
+  if (priv->is_frozen)
+    return;
+
+  row = mx_list_view_get_changed_row (list_view, model, iter);
+
+  if (priv->virtualized)
+    {
+      if (row < 0 || row > (gint) priv->row_heights->len)
+        {
+          model_changed_cb (model, list_view);
+          return;
         }
-      g_object_thaw_notify (child);
 
-      l = g_list_next (l);
-      clutter_model_iter_next (iter);
+      height = -1;
+      g_array_insert_val (priv->row_heights, row, height);
+      priv->offsets_dirty = TRUE;
+
+      /* Children of the rows after the new one are showing the wrong rows
+       * now; let them be re-used.
+       */
+      if (row < priv->first_row)
+        priv->first_row++;
+      else if (row < priv->first_row + (gint) priv->row_actors->len)
+        {
+          for (i = row - priv->first_row; i < priv->row_actors->len; i++)
+            mx_list_view_release_actor (list_view,
+                                        g_ptr_array_index (priv->row_actors,
+                                                           i));
+          g_ptr_array_set_size (priv->row_actors, row - priv->first_row);
+        }
+
+      clutter_actor_queue_relayout (CLUTTER_ACTOR (list_view));
+      return;
     }
 
-  g_list_free (children);
+  if (row < 0 || row > (gint) priv->row_actors->len)
+    {
+      model_changed_cb (model, list_view);
+      return;
+    }
 
-  if (iter)
-    g_object_unref (iter);
+  child = mx_list_view_create_item (list_view);
+  mx_list_view_bind_item (list_view, G_OBJECT (child), iter);
+
+  if (row < (gint) priv->row_actors->len)
+    clutter_actor_insert_child_below (CLUTTER_ACTOR (list_view), child,
+                                      g_ptr_array_index (priv->row_actors,
+                                                         row));
+  else
+    clutter_actor_add_child (CLUTTER_ACTOR (list_view), child);
+
+  g_ptr_array_add (priv->row_actors, NULL);
+  memmove (priv->row_actors->pdata + row + 1, priv->row_actors->pdata + row,
+           (priv->row_actors->len - row - 1) * sizeof (gpointer));
+  g_ptr_array_index (priv->row_actors, row) = child;
 }
 
 static void
@@ -325,7 +1226,48 @@ row_changed_cb (ClutterModel     *model,
                 ClutterModelIter *iter,
                 MxListView       *list_view)
 {
-  model_changed_cb (model, list_view);
+  MxListViewPrivate *priv = list_view->priv;
+  gint row;
+
+  if (priv->is_frozen)
+    return;
+
+  row = mx_list_view_get_changed_row (list_view, model, iter);
+
+  if (priv->virtualized)
+    {
+      if (row < 0 || row >= (gint) priv->row_heights->len)
+        {
+          model_changed_cb (model, list_view);
+          return;
+        }
+
+      /* Off-screen rows will be bound when they're realized */
+      if (row < priv->first_row ||
+          row >= priv->first_row + (gint) priv->row_actors->len)
+        return;
+
+      row -= priv->first_row;
+      mx_list_view_bind_item (list_view,
+                              g_ptr_array_index (priv->row_actors, row),
+                              iter);
+
+      /* The height of the row may have changed, so measure the realized
+       * rows again before the next allocation.
+       */
+      priv->realized_width = -1;
+      clutter_actor_queue_relayout (CLUTTER_ACTOR (list_view));
+      return;
+    }
+
+  if (row < 0 || row >= (gint) priv->row_actors->len)
+    {
+      model_changed_cb (model, list_view);
+      return;
+    }
+
+  mx_list_view_bind_item (list_view, g_ptr_array_index (priv->row_actors, row),
+                          iter);
 }
 
 static void
@@ -333,18 +1275,56 @@ row_removed_cb (ClutterModel     *model,
                 ClutterModelIter *iter,
                 MxListView       *list_view)
 {
-  GList *children;
-  GList *l;
+  MxListViewPrivate *priv = list_view->priv;
   ClutterActor *child;
+  gfloat height;
+  gint row;
 
-  if (list_view->priv->is_frozen)
+  if (priv->is_frozen)
     return;
 
-  children = clutter_actor_get_children (CLUTTER_ACTOR (list_view));
-  l = g_list_nth (children, clutter_model_iter_get_row (iter));
-  child = (ClutterActor *) l->data;
+  row = mx_list_view_get_changed_row (list_view, model, iter);
+
+  if (priv->virtualized)
+    {
+      if (row < 0 || row >= (gint) priv->row_heights->len)
+        {
+          model_changed_cb (model, list_view);
+          return;
+        }
+
+      height = g_array_index (priv->row_heights, gfloat, row);
+      if (height >= 0)
+        {
+          priv->measured_total -= height;
+          priv->n_measured--;
+        }
+
+      g_array_remove_index (priv->row_heights, row);
+      priv->offsets_dirty = TRUE;
+
+      /* The children of the following rows move up with their rows */
+      if (row < priv->first_row)
+        priv->first_row--;
+      else if (row < priv->first_row + (gint) priv->row_actors->len)
+        {
+          child = g_ptr_array_remove_index (priv->row_actors,
+                                            row - priv->first_row);
+          mx_list_view_release_actor (list_view, child);
+        }
+
+      clutter_actor_queue_relayout (CLUTTER_ACTOR (list_view));
+      return;
+    }
+
+  if (row < 0 || row >= (gint) priv->row_actors->len)
+    {
+      model_changed_cb (model, list_view);
+      return;
+    }
+
+  child = g_ptr_array_remove_index (priv->row_actors, row);
   clutter_actor_remove_child (CLUTTER_ACTOR (list_view), child);
-  g_list_free (children);
 }
 
 /* public api */
@@ -396,6 +1376,9 @@ mx_list_view_set_item_type (MxListView *list_view,
 
   list_view->priv->item_type = item_type;
 
+  if (list_view->priv->virtualized)
+    mx_list_view_virtual_clear (list_view);
+
   /* update the view */
   model_changed_cb (list_view->priv->model, list_view);
 }
@@ -439,6 +1422,12 @@ mx_list_view_set_model (MxListView   *list_view,
       g_signal_handlers_disconnect_by_func (priv->model,
                                             (GCallback) model_changed_cb,
                                             list_view);
+      g_signal_handlers_disconnect_by_func (priv->model,
+                                            (GCallback) model_reordered_cb,
+                                            list_view);
+      g_signal_handlers_disconnect_by_func (priv->model,
+                                            (GCallback) row_added_cb,
+                                            list_view);
       g_signal_handlers_disconnect_by_func (priv->model,
                                             (GCallback) row_changed_cb,
                                             list_view);
@@ -458,12 +1447,12 @@ mx_list_view_set_model (MxListView   *list_view,
 
       priv->filter_changed = g_signal_connect (priv->model,
                                                "filter-changed",
-                                               G_CALLBACK (model_changed_cb),
+                                               G_CALLBACK (model_reordered_cb),
                                                list_view);
 
       priv->row_added = g_signal_connect (priv->model,
                                           "row-added",
-                                          G_CALLBACK (row_changed_cb),
+                                          G_CALLBACK (row_added_cb),
                                           list_view);
 
       priv->row_changed = g_signal_connect (priv->model,
@@ -472,8 +1461,9 @@ mx_list_view_set_model (MxListView   *list_view,
                                             list_view);
 
       /*
-       * model_changed_cb (called from row_changed_cb) expect the row to already
-       * have been removed, thus we need to use _after
+       * model_changed_cb (called from row_removed_cb when the change can't be
+       * applied to a single row) expects the row to already have been
+       * removed, thus we need to use _after
        */
       priv->row_removed = g_signal_connect_after (priv->model,
                                                   "row-removed",
@@ -482,7 +1472,7 @@ mx_list_view_set_model (MxListView   *list_view,
 
       priv->sort_changed = g_signal_connect (priv->model,
                                              "sort-changed",
-                                             G_CALLBACK (model_changed_cb),
+                                             G_CALLBACK (model_reordered_cb),
                                              list_view);
 
       /*
@@ -509,7 +1499,7 @@ mx_list_view_add_attribute (MxListView  *list_view,
                             gint         column)
 {
   MxListViewPrivate *priv;
-  AttributeData *prop;
+  MxItemAttribute *prop;
 
   g_return_if_fail (MX_IS_LIST_VIEW (list_view));
   g_return_if_fail (_attribute != NULL);
@@ -517,7 +1507,7 @@ mx_list_view_add_attribute (MxListView  *list_view,
 
   priv = list_view->priv;
 
-  prop = g_new (AttributeData, 1);
+  prop = g_new (MxItemAttribute, 1);
   prop->name = g_strdup (_attribute);
   prop->col = column;
 
@@ -596,6 +1586,9 @@ mx_list_view_set_factory (MxListView    *list_view,
   if (factory)
     priv->factory = g_object_ref (factory);
 
+  if (priv->virtualized)
+    mx_list_view_virtual_clear (list_view);
+
   g_object_notify (G_OBJECT (list_view), "factory");
 }
 
@@ -613,3 +1606,116 @@ mx_list_view_get_factory (MxListView *list_view)
   g_return_val_if_fail (MX_IS_LIST_VIEW (list_view), NULL);
   return list_view->priv->factory;
 }
+
+/**
+ * mx_list_view_set_virtualized:
+ * @list_view: A #MxListView
+ * @virtualized: %TRUE to only create children for the visible rows
+ *
+ * Sets whether @list_view only creates children for the rows that are
+ * visible, plus #MxListView:overscan rows on either side, re-using them
+ * as the view scrolls. This requires @list_view to be scrolled by its
+ * #MxScrollable adjustments, for example by placing it in a
+ * #MxScrollView.
+ *
+ * Since: 2.0
+ */
+void
+mx_list_view_set_virtualized (MxListView *list_view,
+                              gboolean    virtualized)
+{
+  MxListViewPrivate *priv;
+
+  g_return_if_fail (MX_IS_LIST_VIEW (list_view));
+
+  priv = list_view->priv;
+
+  if (priv->virtualized == virtualized)
+    return;
+
+  priv->virtualized = virtualized;
+
+  /* Start again from scratch, whichever way round we're going */
+  mx_list_view_virtual_clear (list_view);
+  g_array_set_size (priv->row_heights, 0);
+  priv->offsets_dirty = TRUE;
+
+  if (virtualized)
+    mx_box_layout_set_orientation (MX_BOX_LAYOUT (list_view),
+                                   MX_ORIENTATION_VERTICAL);
+
+  model_changed_cb (priv->model, list_view);
+
+  g_object_notify (G_OBJECT (list_view), "virtualized");
+}
+
+/**
+ * mx_list_view_get_virtualized:
+ * @list_view: A #MxListView
+ *
+ * Gets whether @list_view only creates children for the visible rows.
+ *
+ * Returns: %TRUE if @list_view is virtualized
+ *
+ * Since: 2.0
+ */
+gboolean
+mx_list_view_get_virtualized (MxListView *list_view)
+{
+  g_return_val_if_fail (MX_IS_LIST_VIEW (list_view), FALSE);
+  return list_view->priv->virtualized;
+}
+
+/**
+ * mx_list_view_set_overscan:
+ * @list_view: A #MxListView
+ * @overscan: the number of rows
+ *
+ * Sets the number of rows to keep realized on either side of the visible
+ * area when @list_view is virtualized. A larger value means fewer rows
+ * need binding when scrolling quickly, at the cost of more children.
+ *
+ * Since: 2.0
+ */
+void
+mx_list_view_set_overscan (MxListView *list_view,
+                           guint       overscan)
+{
+  MxListViewPrivate *priv;
+
+  g_return_if_fail (MX_IS_LIST_VIEW (list_view));
+
+  priv = list_view->priv;
+
+  if (priv->overscan == overscan)
+    return;
+
+  priv->overscan = overscan;
+
+  if (priv->virtualized)
+    {
+      /* Force the rows to be realized again before the next allocation */
+      priv->realized_width = -1;
+      clutter_actor_queue_relayout (CLUTTER_ACTOR (list_view));
+    }
+
+  g_object_notify (G_OBJECT (list_view), "overscan");
+}
+
+/**
+ * mx_list_view_get_overscan:
+ * @list_view: A #MxListView
+ *
+ * Gets the number of rows kept realized on either side of the visible
+ * area when @list_view is virtualized.
+ *
+ * Returns: the number of rows
+ *
+ * Since: 2.0
+ */
+guint
+mx_list_view_get_overscan (MxListView *list_view)
+{
+  g_return_val_if_fail (MX_IS_LIST_VIEW (list_view), 0);
+  return list_view->priv->overscan;
+}
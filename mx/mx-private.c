@@ -28,7 +28,10 @@ static GDebugKey debug_keys[] =
     {"layout", MX_DEBUG_LAYOUT},
     {"inspector", MX_DEBUG_INSPECTOR},
     {"focus", MX_DEBUG_FOCUS},
-    {"css", MX_DEBUG_CSS}
+    {"css", MX_DEBUG_CSS},
+    {"kinetic", MX_DEBUG_KINETIC},
+    {"profile", MX_DEBUG_PROFILE},
+    {"redraws", MX_DEBUG_REDRAWS}
 };
 
 
@@ -122,3 +125,392 @@ _mx_paint_texture_with_opacity (CoglHandle texture,
 
   cogl_handle_unref (material);
 }
+
+/* model items, shared by MxItemView and MxListView */
+
+void
+_mx_item_attribute_free (MxItemAttribute *attribute)
+{
+  g_free (attribute->name);
+  g_free (attribute);
+}
+
+gboolean
+_mx_item_type_is_valid (GType          item_type,
+                        MxItemFactory *factory)
+{
+  if (!item_type && !factory)
+    return FALSE;
+
+  if (item_type && !g_type_is_a (item_type, CLUTTER_TYPE_ACTOR))
+    return FALSE;
+
+  return TRUE;
+}
+
+ClutterActor *
+_mx_item_create (GType          item_type,
+                 MxItemFactory *factory)
+{
+  if (item_type)
+    return g_object_new (item_type, NULL);
+  else
+    return mx_item_factory_create (factory);
+}
+
+void
+_mx_item_bind (GObject          *item,
+               ClutterModelIter *iter,
+               GSList           *attributes)
+{
+  GSList *p;
+
+  g_object_freeze_notify (item);
+  for (p = attributes; p; p = p->next)
+    {
+      GValue value = { 0, };
+      MxItemAttribute *attr = p->data;
+
+      clutter_model_iter_get_value (iter, attr->col, &value);
+
+      g_object_set_property (item, attr->name, &value);
+
+      g_value_unset (&value);
+    }
+  g_object_thaw_notify (item);
+}
+
+/*
+ * Returns the row @iter points to if the change can be applied to just that
+ * row, or -1 if the whole view should be updated. Row numbers are only
+ * reliable when the model isn't filtered.
+ */
+gint
+_mx_item_get_changed_row (ClutterModel     *model,
+                          ClutterModelIter *iter,
+                          GType             item_type,
+                          MxItemFactory    *factory)
+{
+  if (clutter_model_get_filter_set (model))
+    return -1;
+
+  if (!_mx_item_type_is_valid (item_type, factory))
+    return -1;
+
+  return clutter_model_iter_get_row (iter);
+}
+
+/* an existing item and the values its attributes are showing */
+typedef struct
+{
+  ClutterActor *actor;
+  GValue       *values;
+} MxBoundItem;
+
+static void
+mx_bound_item_free (MxBoundItem *bound,
+                    guint        n_values)
+{
+  guint i;
+
+  for (i = 0; i < n_values; i++)
+    if (G_IS_VALUE (&bound->values[i]))
+      g_value_unset (&bound->values[i]);
+
+  g_free (bound->values);
+  g_slice_free (MxBoundItem, bound);
+}
+
+/*
+ * Reads the attributes back from @bound's actor. The returned key is the
+ * contents of the values converted to the model's column types, so that it
+ * can be compared to the key of a row. Returns NULL if a property can't be
+ * read, in which case the item is only ever re-used by binding it again.
+ */
+static gchar *
+mx_bound_item_read (MxBoundItem  *bound,
+                    ClutterModel *model,
+                    GSList       *attributes)
+{
+  GObjectClass *klass = G_OBJECT_GET_CLASS (bound->actor);
+  GString *key = g_string_new (NULL);
+  GSList *p;
+  guint i;
+
+  for (p = attributes, i = 0; p; p = p->next, i++)
+    {
+      MxItemAttribute *attr = p->data;
+      GValue column_value = { 0, };
+      GParamSpec *pspec;
+      gchar *contents;
+
+      pspec = g_object_class_find_property (klass, attr->name);
+      if (!pspec || !(pspec->flags & G_PARAM_READABLE))
+        goto unreadable;
+
+      g_value_init (&bound->values[i], pspec->value_type);
+      g_object_get_property (G_OBJECT (bound->actor), attr->name,
+                             &bound->values[i]);
+
+      g_value_init (&column_value,
+                    clutter_model_get_column_type (model, attr->col));
+      if (!g_value_transform (&bound->values[i], &column_value))
+        {
+          g_value_unset (&column_value);
+          goto unreadable;
+        }
+
+      contents = g_strdup_value_contents (&column_value);
+      g_string_append (key, contents);
+      g_string_append_c (key, '\n');
+
+      g_free (contents);
+      g_value_unset (&column_value);
+    }
+
+  return g_string_free (key, FALSE);
+
+unreadable:
+  g_string_free (key, TRUE);
+  return NULL;
+}
+
+static gchar *
+mx_item_get_row_key (ClutterModelIter *iter,
+                     GSList           *attributes)
+{
+  GString *key = g_string_new (NULL);
+  GSList *p;
+
+  for (p = attributes; p; p = p->next)
+    {
+      MxItemAttribute *attr = p->data;
+      GValue value = { 0, };
+      gchar *contents;
+
+      clutter_model_iter_get_value (iter, attr->col, &value);
+      contents = g_strdup_value_contents (&value);
+      g_string_append (key, contents);
+      g_string_append_c (key, '\n');
+
+      g_free (contents);
+      g_value_unset (&value);
+    }
+
+  return g_string_free (key, FALSE);
+}
+
+/* whether binding @iter to @bound's actor would leave it unchanged */
+static gboolean
+mx_bound_item_matches (MxBoundItem      *bound,
+                       ClutterModelIter *iter,
+                       GSList           *attributes)
+{
+  GObjectClass *klass = G_OBJECT_GET_CLASS (bound->actor);
+  gboolean matches = TRUE;
+  GSList *p;
+  guint i;
+
+  for (p = attributes, i = 0; p && matches; p = p->next, i++)
+    {
+      MxItemAttribute *attr = p->data;
+      GValue value = { 0, };
+      GValue property_value = { 0, };
+      GParamSpec *pspec;
+
+      pspec = g_object_class_find_property (klass, attr->name);
+
+      clutter_model_iter_get_value (iter, attr->col, &value);
+      g_value_init (&property_value, pspec->value_type);
+
+      matches = (g_value_transform (&value, &property_value) &&
+                 g_param_values_cmp (pspec, &property_value,
+                                     &bound->values[i]) == 0);
+
+      g_value_unset (&property_value);
+      g_value_unset (&value);
+    }
+
+  return matches;
+}
+
+/*
+ * Brings the items of @container, one per row in @row_actors, in line with
+ * @model after it has been sorted or filtered. ClutterModel doesn't say
+ * where each row has moved to, so rows are matched to the items already
+ * showing the same values, which are moved to their new position rather
+ * than bound again. Only the rows that don't match an existing item are
+ * bound, re-using the items left over before creating new ones.
+ */
+void
+_mx_item_reorder (ClutterActor  *container,
+                  ClutterModel  *model,
+                  GSList        *attributes,
+                  GType          item_type,
+                  MxItemFactory *factory,
+                  GPtrArray     *row_actors)
+{
+  GHashTable *bound_items, *unbound;
+  ClutterModelIter *iter;
+  ClutterActor *prev;
+  GPtrArray *new_actors;
+  guint i, row, n_attributes;
+
+  n_attributes = g_slist_length (attributes);
+
+  /* index the items by the values they show */
+  bound_items = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                       (GDestroyNotify) g_queue_free);
+  unbound = g_hash_table_new (NULL, NULL);
+
+  for (i = 0; i < row_actors->len; i++)
+    {
+      MxBoundItem *bound = g_slice_new (MxBoundItem);
+      GQueue *queue;
+      gchar *key;
+
+      bound->actor = g_ptr_array_index (row_actors, i);
+      bound->values = g_new0 (GValue, n_attributes);
+      g_hash_table_insert (unbound, bound->actor, bound);
+
+      key = mx_bound_item_read (bound, model, attributes);
+      if (!key)
+        continue;
+
+      queue = g_hash_table_lookup (bound_items, key);
+      if (!queue)
+        {
+          queue = g_queue_new ();
+          g_hash_table_insert (bound_items, key, queue);
+        }
+      else
+        g_free (key);
+
+      g_queue_push_tail (queue, bound);
+    }
+
+  /* match the rows to the items that already show them */
+  new_actors = g_ptr_array_sized_new (clutter_model_get_n_rows (model));
+
+  iter = clutter_model_get_first_iter (model);
+  while (iter && !clutter_model_iter_is_last (iter))
+    {
+      ClutterActor *actor = NULL;
+      gchar *key;
+      GQueue *queue;
+
+      key = mx_item_get_row_key (iter, attributes);
+      queue = g_hash_table_lookup (bound_items, key);
+      g_free (key);
+
+      if (queue)
+        {
+          GList *l;
+
+          for (l = queue->head; l; l = l->next)
+            {
+              MxBoundItem *bound = l->data;
+
+              if (mx_bound_item_matches (bound, iter, attributes))
+                {
+                  actor = bound->actor;
+                  g_queue_delete_link (queue, l);
+                  g_hash_table_remove (unbound, actor);
+                  mx_bound_item_free (bound, n_attributes);
+                  break;
+                }
+            }
+        }
+
+      g_ptr_array_add (new_actors, actor);
+      clutter_model_iter_next (iter);
+    }
+
+  if (iter)
+    g_object_unref (iter);
+
+  g_hash_table_destroy (bound_items);
+
+  /* bind the remaining rows to the left over items, in their old order */
+  i = 0;
+  row = 0;
+  iter = clutter_model_get_first_iter (model);
+  while (iter && !clutter_model_iter_is_last (iter))
+    {
+      ClutterActor *actor = NULL;
+
+      if (g_ptr_array_index (new_actors, row))
+        {
+          clutter_model_iter_next (iter);
+          row++;
+          continue;
+        }
+
+      for (; i < row_actors->len && !actor; i++)
+        {
+          MxBoundItem *bound;
+
+          bound = g_hash_table_lookup (unbound,
+                                       g_ptr_array_index (row_actors, i));
+          if (bound)
+            {
+              actor = bound->actor;
+              g_hash_table_remove (unbound, actor);
+              mx_bound_item_free (bound, n_attributes);
+            }
+        }
+
+      if (!actor)
+        {
+          actor = _mx_item_create (item_type, factory);
+          clutter_actor_add_child (container, actor);
+        }
+
+      _mx_item_bind (G_OBJECT (actor), iter, attributes);
+      g_ptr_array_index (new_actors, row) = actor;
+
+      clutter_model_iter_next (iter);
+      row++;
+    }
+
+  if (iter)
+    g_object_unref (iter);
+
+  /* remove the items that no longer show a row */
+  for (; i < row_actors->len; i++)
+    {
+      MxBoundItem *bound;
+
+      bound = g_hash_table_lookup (unbound, g_ptr_array_index (row_actors, i));
+      if (bound)
+        {
+          clutter_actor_remove_child (container, bound->actor);
+          mx_bound_item_free (bound, n_attributes);
+        }
+    }
+
+  g_hash_table_destroy (unbound);
+
+  /* and put the items in row order */
+  prev = NULL;
+  for (i = 0; i < new_actors->len; i++)
+    {
+      ClutterActor *actor = g_ptr_array_index (new_actors, i);
+
+      if (clutter_actor_get_previous_sibling (actor) != prev)
+        {
+          if (prev)
+            clutter_actor_set_child_above_sibling (container, actor, prev);
+          else
+            clutter_actor_set_child_below_sibling (container, actor, NULL);
+        }
+
+      prev = actor;
+    }
+
+  g_ptr_array_set_size (row_actors, 0);
+  for (i = 0; i < new_actors->len; i++)
+    g_ptr_array_add (row_actors, g_ptr_array_index (new_actors, i));
+
+  g_ptr_array_free (new_actors, TRUE);
+}
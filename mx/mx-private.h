@@ -73,11 +73,52 @@ typedef enum
 
 ClutterActor *_mx_widget_get_dnd_clone (MxWidget *widget);
 
-void _mx_box_layout_start_animation (MxBoxLayout *box);
+void          _mx_box_layout_start_animation  (MxBoxLayout *box);
+MxAdjustment *_mx_box_layout_get_vadjustment (MxBoxLayout *box);
+void          _mx_box_layout_set_content_range (MxBoxLayout *box,
+                                                gfloat       start,
+                                                gfloat       size);
+void          _mx_box_layout_child_changed (MxBoxLayout  *box,
+                                            ClutterActor *child);
+
+/* used by MxGrid subclasses providing items when virtualized */
+void          _mx_grid_invalidate_items (MxGrid *grid);
+ClutterActor *_mx_grid_get_item         (MxGrid *grid,
+                                         guint   index);
+
+/* model items, shared by MxItemView and MxListView */
+typedef struct
+{
+  gchar *name;
+  gint   col;
+} MxItemAttribute;
+
+void          _mx_item_attribute_free  (MxItemAttribute *attribute);
+gboolean      _mx_item_type_is_valid   (GType             item_type,
+                                        MxItemFactory    *factory);
+ClutterActor *_mx_item_create          (GType             item_type,
+                                        MxItemFactory    *factory);
+void          _mx_item_bind            (GObject          *item,
+                                        ClutterModelIter *iter,
+                                        GSList           *attributes);
+gint          _mx_item_get_changed_row (ClutterModel     *model,
+                                        ClutterModelIter *iter,
+                                        GType             item_type,
+                                        MxItemFactory    *factory);
+void          _mx_item_reorder         (ClutterActor     *container,
+                                        ClutterModel     *model,
+                                        GSList           *attributes,
+                                        GType             item_type,
+                                        MxItemFactory    *factory,
+                                        GPtrArray        *row_actors);
+
+/* used by views binding items ahead of the visible area */
+void _mx_image_set_prefetching (gboolean prefetching);
 
 /* used by MxTableChild to update row/column count */
 void _mx_table_update_row_col (MxTable      *table,
                                MxTableChild *meta);
+void _mx_table_invalidate_cells (MxTable *table);
 
 CoglHandle _mx_window_get_icon_cogl_texture (MxWindow *window);
 
@@ -108,6 +149,40 @@ void _mx_paint_texture_with_opacity (CoglHandle texture,
 
 gboolean _mx_settings_get_touch_mode (MxSettings *settings);
 
+/* border images painted repeatedly by the same widget */
+typedef struct _MxTextureFrameCache MxTextureFrameCache;
+
+MxTextureFrameCache *_mx_texture_frame_cache_new    (void);
+void                 _mx_texture_frame_cache_free   (MxTextureFrameCache *cache);
+void                 _mx_texture_frame_paint_cached (MxTextureFrameCache *cache,
+                                                     CoglHandle           texture,
+                                                     guint8               opacity,
+                                                     gfloat               top,
+                                                     gfloat               right,
+                                                     gfloat               bottom,
+                                                     gfloat               left,
+                                                     gfloat               width,
+                                                     gfloat               height);
+
+/* frame timing instrumentation, see MxProfiler */
+extern gboolean _mx_profiler_enabled;
+
+void _mx_profiler_init  (void);
+void _mx_profiler_begin (gpointer        instance,
+                         MxProfilerPhase phase);
+void _mx_profiler_end   (gpointer        instance,
+                         MxProfilerPhase phase);
+
+#define MX_PROFILE_BEGIN(instance,phase)           G_STMT_START { \
+    if (G_UNLIKELY (_mx_profiler_enabled))                        \
+      _mx_profiler_begin ((instance), MX_PROFILER_PHASE_##phase); \
+                                                   } G_STMT_END
+
+#define MX_PROFILE_END(instance,phase)             G_STMT_START { \
+    if (G_UNLIKELY (_mx_profiler_enabled))                        \
+      _mx_profiler_end ((instance), MX_PROFILER_PHASE_##phase);   \
+                                                   } G_STMT_END
+
 
 typedef enum
 {
@@ -115,7 +190,10 @@ typedef enum
   MX_DEBUG_INSPECTOR   = 1 << 1,
   MX_DEBUG_FOCUS       = 1 << 2,
   MX_DEBUG_CSS         = 1 << 3,
-  MX_DEBUG_STYLE_CACHE = 1 << 4
+  MX_DEBUG_STYLE_CACHE = 1 << 4,
+  MX_DEBUG_KINETIC     = 1 << 5,
+  MX_DEBUG_PROFILE     = 1 << 6,
+  MX_DEBUG_REDRAWS     = 1 << 7
 } MxDebugTopic;
 
 gboolean _mx_debug (gint debug);
@@ -0,0 +1,821 @@
+/*
+ * mx-profiler.c: Per-frame timing instrumentation
+ *
+ * Copyright 2012 Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/**
+ * SECTION:mx-profiler
+ * @short_description: Per-frame timing instrumentation
+ *
+ * #MxProfiler records where the time of each stage frame goes. While it is
+ * enabled, the time spent applying style changes, answering preferred size
+ * queries, allocating, painting and picking is measured for the widgets and
+ * containers of the toolkit, and accumulated by phase and by the #GType of
+ * the widget.
+ *
+ * Times are exclusive: the time a container spends allocating its children
+ * is counted for the children, not the container, so the times of all the
+ * types add up to the total of each phase. Widgets that don't have their own
+ * instrumentation are counted as part of the nearest instrumented widget.
+ *
+ * At the end of each frame the timings become available through
+ * mx_profiler_get_frame_time(), mx_profiler_get_timing() and
+ * mx_profiler_to_json(), and #MxProfiler::frame is emitted. Work done
+ * between frames, such as picking for events, is counted with the frame
+ * that follows it.
+ *
+ * mx_profiler_set_trace_file() additionally writes every timed call to a
+ * file in the Chrome trace event format, which can be loaded into
+ * about:tracing. Setting the MX_PROFILE_TRACE environment variable to a
+ * file name enables the profiler and the trace from start-up, and setting
+ * MX_DEBUG to "profile" enables the profiler and prints the time of each
+ * phase after every frame.
+ *
+ * When the profiler is disabled, the instrumentation costs a single check
+ * of a global flag.
+ *
+ * Setting MX_DEBUG to "redraws" tints the area redrawn in each frame with a
+ * different color, to check that small changes only cause clipped redraws
+ * rather than redrawing the whole stage.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <clutter/clutter.h>
+
+#include "mx-profiler.h"
+#include "mx-private.h"
+#include "mx-marshal.h"
+
+G_DEFINE_TYPE (MxProfiler, mx_profiler, G_TYPE_OBJECT)
+
+#define PROFILER_PRIVATE(o) \
+  (G_TYPE_INSTANCE_GET_PRIVATE ((o), MX_TYPE_PROFILER, MxProfilerPrivate))
+
+#define N_PHASES (MX_PROFILER_PHASE_PICK + 1)
+
+typedef struct
+{
+  gdouble time[N_PHASES];
+  guint   n_calls[N_PHASES];
+} MxProfilerTiming;
+
+typedef struct
+{
+  gpointer        instance;
+  GType           type;
+  MxProfilerPhase phase;
+  guint           depth;
+  gint64          start;
+  gint64          child_time;
+} MxProfilerCall;
+
+struct _MxProfilerPrivate
+{
+  guint       pre_paint_func;
+  guint       post_paint_func;
+  gint64      frame_start;
+
+  GArray     *calls;          /* calls in progress, innermost last */
+
+  GHashTable *timings;        /* GType -> MxProfilerTiming, this frame */
+  gdouble     phase_time[N_PHASES];
+
+  GHashTable *frame_timings;  /* the same for the last completed frame */
+  gdouble     frame_phase_time[N_PHASES];
+
+  FILE       *trace;
+  gint        pid;
+};
+
+enum
+{
+  PROP_0,
+
+  PROP_ENABLED
+};
+
+enum
+{
+  FRAME,
+
+  LAST_SIGNAL
+};
+
+static guint signals[LAST_SIGNAL] = { 0, };
+
+static const gchar *phase_names[N_PHASES] =
+{
+  "style",
+  "preferred-size",
+  "allocate",
+  "paint",
+  "pick"
+};
+
+static MxProfiler *default_profiler = NULL;
+
+gboolean _mx_profiler_enabled = FALSE;
+
+static void
+mx_profiler_get_property (GObject    *object,
+                          guint       property_id,
+                          GValue     *value,
+                          GParamSpec *pspec)
+{
+  switch (property_id)
+    {
+    case PROP_ENABLED:
+      g_value_set_boolean (value,
+                           mx_profiler_get_enabled (MX_PROFILER (object)));
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+    }
+}
+
+static void
+mx_profiler_set_property (GObject      *object,
+                          guint         property_id,
+                          const GValue *value,
+                          GParamSpec   *pspec)
+{
+  switch (property_id)
+    {
+    case PROP_ENABLED:
+      mx_profiler_set_enabled (MX_PROFILER (object),
+                               g_value_get_boolean (value));
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+    }
+}
+
+static void
+mx_profiler_timing_free (MxProfilerTiming *timing)
+{
+  g_slice_free (MxProfilerTiming, timing);
+}
+
+static void
+mx_profiler_close_trace (MxProfiler *profiler)
+{
+  MxProfilerPrivate *priv = profiler->priv;
+
+  if (priv->trace)
+    {
+      fputs ("\n]\n", priv->trace);
+      fclose (priv->trace);
+      priv->trace = NULL;
+    }
+}
+
+static void
+mx_profiler_finalize (GObject *object)
+{
+  MxProfiler *profiler = MX_PROFILER (object);
+  MxProfilerPrivate *priv = profiler->priv;
+
+  mx_profiler_set_enabled (profiler, FALSE);
+  mx_profiler_close_trace (profiler);
+
+  g_array_free (priv->calls, TRUE);
+  g_hash_table_destroy (priv->timings);
+  g_hash_table_destroy (priv->frame_timings);
+
+  G_OBJECT_CLASS (mx_profiler_parent_class)->finalize (object);
+}
+
+static void
+mx_profiler_class_init (MxProfilerClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  GParamSpec *pspec;
+
+  g_type_class_add_private (klass, sizeof (MxProfilerPrivate));
+
+  object_class->get_property = mx_profiler_get_property;
+  object_class->set_property = mx_profiler_set_property;
+  object_class->finalize = mx_profiler_finalize;
+
+  /**
+   * MxProfiler:enabled:
+   *
+   * Whether frames are being timed.
+   *
+   * Since: 2.0
+   */
+  pspec = g_param_spec_boolean ("enabled",
+                                "Enabled",
+                                "Whether frames are being timed",
+                                FALSE,
+                                MX_PARAM_READWRITE);
+  g_object_class_install_property (object_class, PROP_ENABLED, pspec);
+
+  /**
+   * MxProfiler::frame:
+   * @profiler: the object that received the signal
+   *
+   * Emitted after each frame while the profiler is enabled, once the
+   * timings of the frame are available.
+   *
+   * Since: 2.0
+   */
+  signals[FRAME] =
+    g_signal_new ("frame",
+                  G_TYPE_FROM_CLASS (klass),
+                  G_SIGNAL_RUN_LAST,
+                  G_STRUCT_OFFSET (MxProfilerClass, frame),
+                  NULL, NULL,
+                  _mx_marshal_VOID__VOID,
+                  G_TYPE_NONE, 0);
+}
+
+static void
+mx_profiler_init (MxProfiler *self)
+{
+  MxProfilerPrivate *priv = self->priv = PROFILER_PRIVATE (self);
+
+  priv->calls = g_array_new (FALSE, FALSE, sizeof (MxProfilerCall));
+  priv->timings =
+    g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL,
+                           (GDestroyNotify) mx_profiler_timing_free);
+  priv->frame_timings =
+    g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL,
+                           (GDestroyNotify) mx_profiler_timing_free);
+  priv->pid = getpid ();
+}
+
+static void
+mx_profiler_trace_event (MxProfiler  *profiler,
+                         const gchar *name,
+                         const gchar *category,
+                         gint64       start,
+                         gint64       duration)
+{
+  MxProfilerPrivate *priv = profiler->priv;
+
+  fprintf (priv->trace,
+           ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\","
+           "\"ts\":%" G_GINT64_FORMAT ",\"dur\":%" G_GINT64_FORMAT ","
+           "\"pid\":%d,\"tid\":0}",
+           name, category, start, duration, priv->pid);
+}
+
+static gboolean
+mx_profiler_pre_paint_cb (gpointer data)
+{
+  MxProfiler *profiler = data;
+
+  profiler->priv->frame_start = g_get_monotonic_time ();
+
+  return TRUE;
+}
+
+static gboolean
+mx_profiler_post_paint_cb (gpointer data)
+{
+  MxProfiler *profiler = data;
+  MxProfilerPrivate *priv = profiler->priv;
+  GHashTable *timings;
+
+  if (priv->trace)
+    mx_profiler_trace_event (profiler, "frame", "frame", priv->frame_start,
+                             g_get_monotonic_time () - priv->frame_start);
+
+  /* the timings of this frame become the last frame's */
+  timings = priv->frame_timings;
+  priv->frame_timings = priv->timings;
+  priv->timings = timings;
+  g_hash_table_remove_all (priv->timings);
+
+  memcpy (priv->frame_phase_time, priv->phase_time,
+          sizeof (priv->phase_time));
+  memset (priv->phase_time, 0, sizeof (priv->phase_time));
+
+  MX_NOTE (PROFILE, "frame: style %.3f ms, preferred size %.3f ms, "
+           "allocate %.3f ms, paint %.3f ms, pick %.3f ms",
+           priv->frame_phase_time[MX_PROFILER_PHASE_STYLE],
+           priv->frame_phase_time[MX_PROFILER_PHASE_PREFERRED_SIZE],
+           priv->frame_phase_time[MX_PROFILER_PHASE_ALLOCATE],
+           priv->frame_phase_time[MX_PROFILER_PHASE_PAINT],
+           priv->frame_phase_time[MX_PROFILER_PHASE_PICK]);
+
+  g_signal_emit (profiler, signals[FRAME], 0);
+
+  return TRUE;
+}
+
+/*
+ * _mx_profiler_begin:
+ * @instance: the widget being timed
+ * @phase: the phase of the frame
+ *
+ * Starts timing a call. Use through MX_PROFILE_BEGIN(), which only calls
+ * this while the profiler is enabled. A call nested directly in a call for
+ * the same widget and phase, like a chain-up, counts as part of it.
+ */
+void
+_mx_profiler_begin (gpointer        instance,
+                    MxProfilerPhase phase)
+{
+  MxProfilerPrivate *priv = default_profiler->priv;
+  MxProfilerCall *call;
+
+  if (priv->calls->len)
+    {
+      call = &g_array_index (priv->calls, MxProfilerCall,
+                             priv->calls->len - 1);
+      if (call->instance == instance && call->phase == phase)
+        {
+          call->depth++;
+          return;
+        }
+    }
+
+  g_array_set_size (priv->calls, priv->calls->len + 1);
+  call = &g_array_index (priv->calls, MxProfilerCall, priv->calls->len - 1);
+
+  call->instance = instance;
+  call->type = G_OBJECT_TYPE (instance);
+  call->phase = phase;
+  call->depth = 0;
+  call->child_time = 0;
+  call->start = g_get_monotonic_time ();
+}
+
+/*
+ * _mx_profiler_end:
+ * @instance: the widget being timed
+ * @phase: the phase of the frame
+ *
+ * Stops timing a call started with _mx_profiler_begin().
+ */
+void
+_mx_profiler_end (gpointer        instance,
+                  MxProfilerPhase phase)
+{
+  MxProfilerPrivate *priv = default_profiler->priv;
+  MxProfilerTiming *timing;
+  MxProfilerCall *call;
+  gint64 elapsed;
+  gdouble self_time;
+
+  /* the call may have started before the profiler was enabled */
+  if (!priv->calls->len)
+    return;
+
+  call = &g_array_index (priv->calls, MxProfilerCall, priv->calls->len - 1);
+  if (call->instance != instance || call->phase != phase)
+    return;
+
+  if (call->depth)
+    {
+      call->depth--;
+      return;
+    }
+
+  elapsed = g_get_monotonic_time () - call->start;
+  self_time = (elapsed - call->child_time) / 1000.0;
+
+  timing = g_hash_table_lookup (priv->timings, GSIZE_TO_POINTER (call->type));
+  if (!timing)
+    {
+      timing = g_slice_new0 (MxProfilerTiming);
+      g_hash_table_insert (priv->timings, GSIZE_TO_POINTER (call->type),
+                           timing);
+    }
+
+  timing->time[phase] += self_time;
+  timing->n_calls[phase]++;
+  priv->phase_time[phase] += self_time;
+
+  if (priv->trace)
+    mx_profiler_trace_event (default_profiler, g_type_name (call->type),
+                             phase_names[phase], call->start, elapsed);
+
+  g_array_set_size (priv->calls, priv->calls->len - 1);
+
+  if (priv->calls->len)
+    g_array_index (priv->calls, MxProfilerCall,
+                   priv->calls->len - 1).child_time += elapsed;
+}
+
+static void
+mx_profiler_paint_redraw_clip_cb (ClutterActor *stage,
+                                  gpointer      data)
+{
+  /* cycle through the tints, so consecutive redraws can be told apart */
+  static const guint8 tints[][3] =
+  {
+    { 0xff, 0x00, 0x00 },
+    { 0x00, 0xff, 0x00 },
+    { 0x00, 0x00, 0xff },
+    { 0xff, 0xff, 0x00 },
+    { 0x00, 0xff, 0xff },
+    { 0xff, 0x00, 0xff }
+  };
+  static guint frame = 0;
+
+  cairo_rectangle_int_t clip;
+  const guint8 *tint;
+  CoglColor color;
+
+  clutter_stage_get_redraw_clip_bounds (CLUTTER_STAGE (stage), &clip);
+
+  tint = tints[frame++ % G_N_ELEMENTS (tints)];
+  cogl_color_init_from_4ub (&color, tint[0], tint[1], tint[2], 0x40);
+  cogl_color_premultiply (&color);
+
+  cogl_set_source_color (&color);
+  cogl_rectangle (clip.x, clip.y, clip.x + clip.width, clip.y + clip.height);
+}
+
+static void
+mx_profiler_stage_added_cb (ClutterStageManager *manager,
+                            ClutterStage        *stage,
+                            gpointer             data)
+{
+  /* paint after the stage and the floating widgets */
+  g_signal_connect_after (stage, "paint",
+                          G_CALLBACK (mx_profiler_paint_redraw_clip_cb), NULL);
+}
+
+static void
+mx_profiler_show_redraws (void)
+{
+  ClutterStageManager *manager = clutter_stage_manager_get_default ();
+  GSList *stages, *s;
+
+  stages = clutter_stage_manager_list_stages (manager);
+  for (s = stages; s; s = s->next)
+    mx_profiler_stage_added_cb (manager, s->data, NULL);
+  g_slist_free (stages);
+
+  g_signal_connect (manager, "stage-added",
+                    G_CALLBACK (mx_profiler_stage_added_cb), NULL);
+}
+
+/*
+ * _mx_profiler_init:
+ *
+ * Enables the profiler from start-up when MX_PROFILE_TRACE is set, or when
+ * MX_DEBUG includes "profile", and the redraw overlay when MX_DEBUG includes
+ * "redraws".
+ */
+void
+_mx_profiler_init (void)
+{
+  static gboolean initialized = FALSE;
+  const gchar *filename;
+  GError *error = NULL;
+
+  if (initialized)
+    return;
+
+  initialized = TRUE;
+
+  if (_mx_debug (MX_DEBUG_REDRAWS))
+    mx_profiler_show_redraws ();
+
+  filename = g_getenv ("MX_PROFILE_TRACE");
+  if (filename && *filename &&
+      !mx_profiler_set_trace_file (mx_profiler_get_default (), filename,
+                                   &error))
+    {
+      g_warning ("Unable to write a trace to %s: %s", filename,
+                 error->message);
+      g_error_free (error);
+      return;
+    }
+
+  if ((filename && *filename) || _mx_debug (MX_DEBUG_PROFILE))
+    mx_profiler_set_enabled (mx_profiler_get_default (), TRUE);
+}
+
+/**
+ * mx_profiler_get_default:
+ *
+ * Gets the global #MxProfiler.
+ *
+ * Returns: (transfer none): the #MxProfiler
+ *
+ * Since: 2.0
+ */
+MxProfiler *
+mx_profiler_get_default (void)
+{
+  if (G_UNLIKELY (default_profiler == NULL))
+    default_profiler = g_object_new (MX_TYPE_PROFILER, NULL);
+
+  return default_profiler;
+}
+
+/**
+ * mx_profiler_set_enabled:
+ * @profiler: An #MxProfiler
+ * @enabled: %TRUE to time frames
+ *
+ * Sets whether frames are timed. Timings gathered before the profiler was
+ * disabled are kept until the next frame that is timed.
+ *
+ * Since: 2.0
+ */
+void
+mx_profiler_set_enabled (MxProfiler *profiler,
+                         gboolean    enabled)
+{
+  MxProfilerPrivate *priv;
+
+  g_return_if_fail (MX_IS_PROFILER (profiler));
+
+  priv = profiler->priv;
+
+  if (mx_profiler_get_enabled (profiler) == enabled)
+    return;
+
+  if (enabled)
+    {
+      priv->frame_start = g_get_monotonic_time ();
+      priv->pre_paint_func =
+        clutter_threads_add_repaint_func_full (CLUTTER_REPAINT_FLAGS_PRE_PAINT,
+                                               mx_profiler_pre_paint_cb,
+                                               profiler, NULL);
+      priv->post_paint_func =
+        clutter_threads_add_repaint_func_full (CLUTTER_REPAINT_FLAGS_POST_PAINT,
+                                               mx_profiler_post_paint_cb,
+                                               profiler, NULL);
+    }
+  else
+    {
+      clutter_threads_remove_repaint_func (priv->pre_paint_func);
+      clutter_threads_remove_repaint_func (priv->post_paint_func);
+      priv->pre_paint_func = priv->post_paint_func = 0;
+
+      g_array_set_size (priv->calls, 0);
+      g_hash_table_remove_all (priv->timings);
+      memset (priv->phase_time, 0, sizeof (priv->phase_time));
+    }
+
+  /* only the default profiler is fed by the instrumentation */
+  if (profiler == default_profiler)
+    _mx_profiler_enabled = enabled;
+
+  g_object_notify (G_OBJECT (profiler), "enabled");
+}
+
+/**
+ * mx_profiler_get_enabled:
+ * @profiler: An #MxProfiler
+ *
+ * Gets whether frames are timed.
+ *
+ * Returns: %TRUE if the profiler is enabled
+ *
+ * Since: 2.0
+ */
+gboolean
+mx_profiler_get_enabled (MxProfiler *profiler)
+{
+  g_return_val_if_fail (MX_IS_PROFILER (profiler), FALSE);
+
+  return (profiler->priv->pre_paint_func != 0);
+}
+
+/**
+ * mx_profiler_set_trace_file:
+ * @profiler: An #MxProfiler
+ * @filename: (allow-none): the file to write to, or %NULL
+ * @error: return location for a #GError, or %NULL
+ *
+ * Writes every call timed while the profiler is enabled, and every frame,
+ * to @filename in the Chrome trace event format. Any file previously set is
+ * completed and closed. Pass %NULL to stop writing a trace.
+ *
+ * Returns: %TRUE if the file could be opened
+ *
+ * Since: 2.0
+ */
+gboolean
+mx_profiler_set_trace_file (MxProfiler   *profiler,
+                            const gchar  *filename,
+                            GError      **error)
+{
+  MxProfilerPrivate *priv;
+
+  g_return_val_if_fail (MX_IS_PROFILER (profiler), FALSE);
+
+  priv = profiler->priv;
+
+  mx_profiler_close_trace (profiler);
+
+  if (!filename)
+    return TRUE;
+
+  priv->trace = fopen (filename, "w");
+  if (!priv->trace)
+    {
+      gint errsv = errno;
+
+      g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errsv),
+                   "%s", g_strerror (errsv));
+      return FALSE;
+    }
+
+  /* events are written with a leading separator, so start with metadata */
+  fprintf (priv->trace,
+           "[\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,"
+           "\"args\":{\"name\":\"%s\"}}",
+           priv->pid, g_get_prgname () ? g_get_prgname () : "mx");
+
+  return TRUE;
+}
+
+/**
+ * mx_profiler_get_frame_time:
+ * @profiler: An #MxProfiler
+ * @phase: An #MxProfilerPhase
+ *
+ * Gets the time spent in @phase during the last frame, for all the timed
+ * types together.
+ *
+ * Returns: the time, in milliseconds
+ *
+ * Since: 2.0
+ */
+gdouble
+mx_profiler_get_frame_time (MxProfiler      *profiler,
+                            MxProfilerPhase  phase)
+{
+  g_return_val_if_fail (MX_IS_PROFILER (profiler), 0);
+  g_return_val_if_fail (phase < N_PHASES, 0);
+
+  return profiler->priv->frame_phase_time[phase];
+}
+
+/**
+ * mx_profiler_get_types:
+ * @profiler: An #MxProfiler
+ * @n_types: (out): return location for the number of types
+ *
+ * Gets the types of the widgets timed during the last frame.
+ *
+ * Returns: (array length=n_types) (transfer container): a newly allocated
+ *   array of #GType, free with g_free()
+ *
+ * Since: 2.0
+ */
+GType *
+mx_profiler_get_types (MxProfiler *profiler,
+                       guint      *n_types)
+{
+  GHashTableIter iter;
+  gpointer key;
+  GType *types;
+  guint i;
+
+  g_return_val_if_fail (MX_IS_PROFILER (profiler), NULL);
+
+  types = g_new (GType, g_hash_table_size (profiler->priv->frame_timings) + 1);
+
+  i = 0;
+  g_hash_table_iter_init (&iter, profiler->priv->frame_timings);
+  while (g_hash_table_iter_next (&iter, &key, NULL))
+    types[i++] = GPOINTER_TO_SIZE (key);
+  types[i] = G_TYPE_INVALID;
+
+  if (n_types)
+    *n_types = i;
+
+  return types;
+}
+
+/**
+ * mx_profiler_get_timing:
+ * @profiler: An #MxProfiler
+ * @type: the #GType of a widget
+ * @phase: An #MxProfilerPhase
+ * @time: (out) (allow-none): return location for the time, in milliseconds
+ * @n_calls: (out) (allow-none): return location for the number of calls
+ *
+ * Gets the time widgets of @type spent in @phase during the last frame,
+ * and how many times they were called.
+ *
+ * Since: 2.0
+ */
+void
+mx_profiler_get_timing (MxProfiler      *profiler,
+                        GType            type,
+                        MxProfilerPhase  phase,
+                        gdouble         *time,
+                        guint           *n_calls)
+{
+  MxProfilerTiming *timing;
+
+  g_return_if_fail (MX_IS_PROFILER (profiler));
+  g_return_if_fail (phase < N_PHASES);
+
+  timing = g_hash_table_lookup (profiler->priv->frame_timings,
+                                GSIZE_TO_POINTER (type));
+
+  if (time)
+    *time = timing ? timing->time[phase] : 0;
+  if (n_calls)
+    *n_calls = timing ? timing->n_calls[phase] : 0;
+}
+
+/* printf would use the decimal separator of the locale */
+static void
+mx_profiler_append_time (GString *json,
+                         gdouble  time)
+{
+  gchar buf[G_ASCII_DTOSTR_BUF_SIZE];
+
+  g_string_append (json, g_ascii_formatd (buf, sizeof (buf), "%.3f", time));
+}
+
+/**
+ * mx_profiler_to_json:
+ * @profiler: An #MxProfiler
+ *
+ * Gets the timings of the last frame as a JSON object. It has a "phases"
+ * member with the total time of each phase, and a "types" member with the
+ * time and number of calls of each phase for every timed type. Times are
+ * in milliseconds.
+ *
+ * Returns: a newly allocated string, free with g_free()
+ *
+ * Since: 2.0
+ */
+gchar *
+mx_profiler_to_json (MxProfiler *profiler)
+{
+  MxProfilerPrivate *priv;
+  MxProfilerTiming *timing;
+  GHashTableIter iter;
+  gpointer key;
+  GString *json;
+  gboolean first;
+  gint phase;
+
+  g_return_val_if_fail (MX_IS_PROFILER (profiler), NULL);
+
+  priv = profiler->priv;
+  json = g_string_new ("{\n  \"phases\": {");
+
+  for (phase = 0; phase < N_PHASES; phase++)
+    {
+      g_string_append_printf (json, "%s \"%s\": ", phase ? "," : "",
+                              phase_names[phase]);
+      mx_profiler_append_time (json, priv->frame_phase_time[phase]);
+    }
+
+  g_string_append (json, " },\n  \"types\": {");
+
+  first = TRUE;
+  g_hash_table_iter_init (&iter, priv->frame_timings);
+  while (g_hash_table_iter_next (&iter, &key, (gpointer *) &timing))
+    {
+      g_string_append_printf (json, "%s\n    \"%s\": {", first ? "" : ",",
+                              g_type_name (GPOINTER_TO_SIZE (key)));
+      first = FALSE;
+
+      for (phase = 0; phase < N_PHASES; phase++)
+        {
+          g_string_append_printf (json, "%s \"%s\": { \"time\": ",
+                                  phase ? "," : "", phase_names[phase]);
+          mx_profiler_append_time (json, timing->time[phase]);
+          g_string_append_printf (json, ", \"calls\": %u }",
+                                  timing->n_calls[phase]);
+        }
+
+      g_string_append (json, " }");
+    }
+
+  g_string_append (json, "\n  }\n}\n");
+
+  return g_string_free (json, FALSE);
+}
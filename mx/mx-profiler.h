@@ -0,0 +1,134 @@
+/*
+ * mx-profiler.h: Per-frame timing instrumentation
+ *
+ * Copyright 2012 Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#if !defined(MX_H_INSIDE) && !defined(MX_COMPILATION)
+#error "Only <mx/mx.h> can be included directly.h"
+#endif
+
+#ifndef _MX_PROFILER_H
+#define _MX_PROFILER_H
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+#define MX_TYPE_PROFILER mx_profiler_get_type()
+
+#define MX_PROFILER(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST ((obj), \
+  MX_TYPE_PROFILER, MxProfiler))
+
+#define MX_PROFILER_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_CAST ((klass), \
+  MX_TYPE_PROFILER, MxProfilerClass))
+
+#define MX_IS_PROFILER(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE ((obj), \
+  MX_TYPE_PROFILER))
+
+#define MX_IS_PROFILER_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_TYPE ((klass), \
+  MX_TYPE_PROFILER))
+
+#define MX_PROFILER_GET_CLASS(obj) \
+  (G_TYPE_INSTANCE_GET_CLASS ((obj), \
+  MX_TYPE_PROFILER, MxProfilerClass))
+
+typedef struct _MxProfiler MxProfiler;
+typedef struct _MxProfilerClass MxProfilerClass;
+typedef struct _MxProfilerPrivate MxProfilerPrivate;
+
+/**
+ * MxProfilerPhase:
+ * @MX_PROFILER_PHASE_STYLE: applying a style change
+ * @MX_PROFILER_PHASE_PREFERRED_SIZE: a preferred width or height query
+ * @MX_PROFILER_PHASE_ALLOCATE: allocating an actor
+ * @MX_PROFILER_PHASE_PAINT: painting an actor
+ * @MX_PROFILER_PHASE_PICK: picking an actor
+ *
+ * The phases of a frame timed by #MxProfiler.
+ *
+ * Since: 2.0
+ */
+typedef enum
+{
+  MX_PROFILER_PHASE_STYLE,
+  MX_PROFILER_PHASE_PREFERRED_SIZE,
+  MX_PROFILER_PHASE_ALLOCATE,
+  MX_PROFILER_PHASE_PAINT,
+  MX_PROFILER_PHASE_PICK
+} MxProfilerPhase;
+
+/**
+ * MxProfiler:
+ *
+ * The contents of this structure are private and should only be accessed
+ * through the public API.
+ */
+struct _MxProfiler
+{
+  /*< private >*/
+  GObject parent;
+
+  MxProfilerPrivate *priv;
+};
+
+struct _MxProfilerClass
+{
+  GObjectClass parent_class;
+
+  /* signals */
+  void (*frame) (MxProfiler *profiler);
+
+  /*< private >*/
+  /* padding for future expansion */
+  void (*_padding_0) (void);
+  void (*_padding_1) (void);
+  void (*_padding_2) (void);
+  void (*_padding_3) (void);
+  void (*_padding_4) (void);
+};
+
+GType mx_profiler_get_type (void) G_GNUC_CONST;
+
+MxProfiler *mx_profiler_get_default (void);
+
+void     mx_profiler_set_enabled    (MxProfiler      *profiler,
+                                     gboolean         enabled);
+gboolean mx_profiler_get_enabled    (MxProfiler      *profiler);
+
+gboolean mx_profiler_set_trace_file (MxProfiler      *profiler,
+                                     const gchar     *filename,
+                                     GError         **error);
+
+gdouble  mx_profiler_get_frame_time (MxProfiler      *profiler,
+                                     MxProfilerPhase  phase);
+GType   *mx_profiler_get_types      (MxProfiler      *profiler,
+                                     guint           *n_types);
+void     mx_profiler_get_timing     (MxProfiler      *profiler,
+                                     GType            type,
+                                     MxProfilerPhase  phase,
+                                     gdouble         *time,
+                                     guint           *n_calls);
+gchar   *mx_profiler_to_json        (MxProfiler      *profiler);
+
+G_END_DECLS
+
+#endif /* _MX_PROFILER_H */
@@ -191,6 +191,8 @@ mx_scroll_view_paint (ClutterActor *actor)
   guint8 r, g, b;
   const gint shadow = 15;
 
+  MX_PROFILE_BEGIN (actor, PAINT);
+
   CLUTTER_ACTOR_CLASS (mx_scroll_view_parent_class)->paint (actor);
 
   mx_stylable_get (MX_STYLABLE (actor), "background-color", &color, NULL);
@@ -336,7 +338,7 @@ mx_scroll_view_paint (ClutterActor *actor)
         }
     }
 
-
+  MX_PROFILE_END (actor, PAINT);
 }
 
 static void
@@ -345,6 +347,8 @@ mx_scroll_view_pick (ClutterActor       *actor,
 {
   MxScrollViewPrivate *priv = MX_SCROLL_VIEW (actor)->priv;
 
+  MX_PROFILE_BEGIN (actor, PICK);
+
   CLUTTER_ACTOR_CLASS (mx_scroll_view_parent_class)->pick (actor, color);
 
   /* Chain up so we get a bounding box pained (if we are reactive) */
@@ -368,6 +372,8 @@ mx_scroll_view_pick (ClutterActor       *actor,
     clutter_actor_paint (priv->hscroll);
   if (CLUTTER_ACTOR_IS_VISIBLE (priv->vscroll))
     clutter_actor_paint (priv->vscroll);
+
+  MX_PROFILE_END (actor, PICK);
 }
 
 static void
@@ -382,8 +388,13 @@ mx_scroll_view_get_preferred_width (ClutterActor *actor,
 
   MxScrollViewPrivate *priv = MX_SCROLL_VIEW (actor)->priv;
 
+  MX_PROFILE_BEGIN (actor, PREFERRED_SIZE);
+
   if (!priv->child)
-    return;
+    {
+      MX_PROFILE_END (actor, PREFERRED_SIZE);
+      return;
+    }
 
   mx_widget_get_padding (MX_WIDGET (actor), &padding);
 
@@ -423,6 +434,8 @@ mx_scroll_view_get_preferred_width (ClutterActor *actor,
   /* Add space for padding */
   if (natural_width_p)
     *natural_width_p = padding.left + padding.right + child_nat_w + vscroll_w;
+
+  MX_PROFILE_END (actor, PREFERRED_SIZE);
 }
 
 static void
@@ -437,8 +450,13 @@ mx_scroll_view_get_preferred_height (ClutterActor *actor,
 
   MxScrollViewPrivate *priv = MX_SCROLL_VIEW (actor)->priv;
 
+  MX_PROFILE_BEGIN (actor, PREFERRED_SIZE);
+
   if (!priv->child)
-    return;
+    {
+      MX_PROFILE_END (actor, PREFERRED_SIZE);
+      return;
+    }
 
   mx_widget_get_padding (MX_WIDGET (actor), &padding);
 
@@ -475,6 +493,8 @@ mx_scroll_view_get_preferred_height (ClutterActor *actor,
 
   if (natural_height_p)
     *natural_height_p = padding.top + nat_child_h + padding.bottom + scroll_h;
+
+  MX_PROFILE_END (actor, PREFERRED_SIZE);
 }
 
 static void
@@ -488,6 +508,8 @@ mx_scroll_view_allocate (ClutterActor          *actor,
 
   MxScrollViewPrivate *priv = MX_SCROLL_VIEW (actor)->priv;
 
+  MX_PROFILE_BEGIN (actor, ALLOCATE);
+
   CLUTTER_ACTOR_CLASS (mx_scroll_view_parent_class)->
     allocate (actor, box, flags);
 
@@ -536,6 +558,8 @@ mx_scroll_view_allocate (ClutterActor          *actor,
 
   if (priv->child)
     clutter_actor_allocate (priv->child, &child_box, flags);
+
+  MX_PROFILE_END (actor, ALLOCATE);
 }
 
 static void
@@ -97,3 +97,38 @@ mx_scrollable_get_adjustments (MxScrollable  *scrollable,
                                                          hadjustment,
                                                          vadjustment);
 }
+
+/**
+ * mx_scrollable_prefetch_hint:
+ * @scrollable: An #MxScrollable
+ * @hvalue: the value the horizontal adjustment is expected to reach
+ * @vvalue: the value the vertical adjustment is expected to reach
+ * @hvelocity: the current horizontal scrolling speed, in units per second
+ * @vvelocity: the current vertical scrolling speed, in units per second
+ *
+ * Tells @scrollable that its adjustments are expected to move towards
+ * @hvalue and @vvalue, for example at the start of a kinetic scroll. The
+ * scrollable can use this to prepare the content that will come into view
+ * ahead of time. A hint with both velocities set to 0 means the scrolling
+ * has stopped.
+ *
+ * Implementing this is optional, the hint is ignored by scrollables that
+ * don't.
+ *
+ * Since: 2.0
+ */
+void
+mx_scrollable_prefetch_hint (MxScrollable *scrollable,
+                             gdouble       hvalue,
+                             gdouble       vvalue,
+                             gdouble       hvelocity,
+                             gdouble       vvelocity)
+{
+  MxScrollableIface *iface;
+
+  g_return_if_fail (MX_IS_SCROLLABLE (scrollable));
+
+  iface = MX_SCROLLABLE_GET_IFACE (scrollable);
+  if (iface->prefetch_hint)
+    iface->prefetch_hint (scrollable, hvalue, vvalue, hvelocity, vvelocity);
+}
@@ -61,6 +61,12 @@ struct _MxScrollableIface
   void (* get_adjustments) (MxScrollable  *scrollable,
                             MxAdjustment **hadjustment,
                             MxAdjustment **vadjustment);
+
+  void (* prefetch_hint)   (MxScrollable  *scrollable,
+                            gdouble        hvalue,
+                            gdouble        vvalue,
+                            gdouble        hvelocity,
+                            gdouble        vvelocity);
 };
 
 GType mx_scrollable_get_type (void) G_GNUC_CONST;
@@ -72,6 +78,12 @@ void mx_scrollable_get_adjustments (MxScrollable  *scrollable,
                                     MxAdjustment **hadjustment,
                                     MxAdjustment **vadjustment);
 
+void mx_scrollable_prefetch_hint   (MxScrollable  *scrollable,
+                                    gdouble        hvalue,
+                                    gdouble        vvalue,
+                                    gdouble        hvelocity,
+                                    gdouble        vvelocity);
+
 G_END_DECLS
 
 #endif /* __MX_SCROLLABLE_H__ */
@@ -37,6 +37,7 @@
 #include "mx-stack-child.h"
 #include "mx-focusable.h"
 #include "mx-utils.h"
+#include "mx-private.h"
 
 #include <string.h>
 
@@ -195,6 +196,8 @@ mx_stack_get_preferred_width (ClutterActor *actor,
   ClutterActorIter iter;
   ClutterActor *child;
 
+  MX_PROFILE_BEGIN (actor, PREFERRED_SIZE);
+
   mx_widget_get_padding (MX_WIDGET (actor), &padding);
   if (for_height >= 0)
     for_height = MAX (0, for_height - padding.top - padding.bottom);
@@ -220,6 +223,8 @@ mx_stack_get_preferred_width (ClutterActor *actor,
     *min_width_p = min_width;
   if (nat_width_p)
     *nat_width_p = nat_width;
+
+  MX_PROFILE_END (actor, PREFERRED_SIZE);
 }
 
 static void
@@ -233,6 +238,8 @@ mx_stack_get_preferred_height (ClutterActor *actor,
   ClutterActorIter iter;
   ClutterActor *child;
 
+  MX_PROFILE_BEGIN (actor, PREFERRED_SIZE);
+
   mx_widget_get_padding (MX_WIDGET (actor), &padding);
   if (for_width >= 0)
     for_width = MAX (0, for_width - padding.left - padding.right);
@@ -258,6 +265,8 @@ mx_stack_get_preferred_height (ClutterActor *actor,
     *min_height_p = min_height;
   if (nat_height_p)
     *nat_height_p = nat_height;
+
+  MX_PROFILE_END (actor, PREFERRED_SIZE);
 }
 
 static void
@@ -271,6 +280,8 @@ mx_stack_allocate (ClutterActor           *actor,
 
   MxStackPrivate *priv = MX_STACK (actor)->priv;
 
+  MX_PROFILE_BEGIN (actor, ALLOCATE);
+
   CLUTTER_ACTOR_CLASS (mx_stack_parent_class)->allocate (actor, box, flags);
 
   mx_widget_get_available_area (MX_WIDGET (actor), box, &avail_space);
@@ -475,14 +486,21 @@ mx_stack_allocate (ClutterActor           *actor,
 
       clutter_actor_allocate (child, &child_box, flags);
     }
+
+  MX_PROFILE_END (actor, ALLOCATE);
 }
 
 static void
 mx_stack_paint_children (ClutterActor *actor)
 {
   MxStackPrivate *priv = MX_STACK (actor)->priv;
+  ClutterActorBox view_b;
   ClutterActorIter iter;
   ClutterActor *child;
+  gboolean cull;
+
+  /* skip children out of the view of a scrolling ancestor */
+  cull = mx_widget_get_view_area (MX_WIDGET (actor), &view_b);
 
   clutter_actor_iter_init (&iter, actor);
   while (clutter_actor_iter_next (&iter, &child))
@@ -492,6 +510,10 @@ mx_stack_paint_children (ClutterActor *actor)
       if (!CLUTTER_ACTOR_IS_VISIBLE (child))
         continue;
 
+      if (cull && !mx_widget_is_child_in_area (MX_WIDGET (actor), child,
+                                               &view_b))
+        continue;
+
       clutter_container_child_get (CLUTTER_CONTAINER (actor),
                                    child,
                                    "crop", &crop,
@@ -515,20 +537,28 @@ mx_stack_paint_children (ClutterActor *actor)
 static void
 mx_stack_paint (ClutterActor *actor)
 {
+  MX_PROFILE_BEGIN (actor, PAINT);
+
   /* allow MxWidget to paint the background */
   CLUTTER_ACTOR_CLASS (mx_stack_parent_class)->paint (actor);
 
 
   mx_stack_paint_children (actor);
+
+  MX_PROFILE_END (actor, PAINT);
 }
 
 static void
 mx_stack_pick (ClutterActor       *actor,
                const ClutterColor *color)
 {
+  MX_PROFILE_BEGIN (actor, PICK);
+
   CLUTTER_ACTOR_CLASS (mx_stack_parent_class)->pick (actor, color);
 
   mx_stack_paint_children (actor);
+
+  MX_PROFILE_END (actor, PICK);
 }
 
 static void
@@ -1081,7 +1081,9 @@ mx_stylable_style_changed_internal (MxStylable          *stylable,
        */
       flags |= MX_STYLE_CHANGED_INVALIDATE_CACHE;
 
+      MX_PROFILE_BEGIN (stylable, STYLE);
       g_signal_emit (stylable, stylable_signals[STYLE_CHANGED], 0, flags);
+      MX_PROFILE_END (stylable, STYLE);
     }
 
   /* propagate the style-changed signal to children, since their style may
@@ -495,6 +495,16 @@ mx_style_transform_css_value (MxStyleSheetValue *css_value,
       else
         g_value_set_float (value, ((GParamSpecFloat *) pspec)->default_value);
     }
+  else if (pspec->value_type == G_TYPE_BOOLEAN)
+    {
+      g_value_init (value, pspec->value_type);
+
+      if (css_value->string)
+        g_value_set_boolean (value, !g_strcmp0 (css_value->string, "true"));
+      else
+        g_value_set_boolean (value,
+                             ((GParamSpecBoolean *) pspec)->default_value);
+    }
   else if (pspec->value_type == MX_TYPE_BORDER_IMAGE)
     {
       g_value_init (value, pspec->value_type);
@@ -70,19 +70,23 @@ table_child_set_property (GObject      *gobject,
     case CHILD_PROP_COLUMN:
       child->col = g_value_get_int (value);
       _mx_table_update_row_col (table, child);
+      _mx_table_invalidate_cells (table);
       clutter_actor_queue_relayout (CLUTTER_ACTOR (table));
       break;
     case CHILD_PROP_ROW:
       child->row = g_value_get_int (value);
       _mx_table_update_row_col (table, child);
+      _mx_table_invalidate_cells (table);
       clutter_actor_queue_relayout (CLUTTER_ACTOR (table));
       break;
     case CHILD_PROP_COLUMN_SPAN:
       child->col_span = g_value_get_int (value);
+      _mx_table_invalidate_cells (table);
       clutter_actor_queue_relayout (CLUTTER_ACTOR (table));
       break;
     case CHILD_PROP_ROW_SPAN:
       child->row_span = g_value_get_int (value);
+      _mx_table_invalidate_cells (table);
       clutter_actor_queue_relayout (CLUTTER_ACTOR (table));
       break;
     case CHILD_PROP_X_EXPAND:
@@ -378,6 +382,7 @@ mx_table_child_set_column_span (MxTable      *table,
   meta = get_child_meta (table, child);
 
   meta->col_span = span;
+  _mx_table_invalidate_cells (table);
 
   clutter_actor_queue_relayout (child);
 }
@@ -428,6 +433,7 @@ mx_table_child_set_row_span (MxTable      *table,
   meta = get_child_meta (table, child);
 
   meta->row_span = span;
+  _mx_table_invalidate_cells (table);
 
   clutter_actor_queue_relayout (child);
 }
@@ -818,6 +824,7 @@ mx_table_child_set_column (MxTable      *table,
   meta->col = col;
 
   _mx_table_update_row_col (table, meta);
+  _mx_table_invalidate_cells (table);
   clutter_actor_queue_relayout (CLUTTER_ACTOR (table));
 }
 
@@ -870,5 +877,6 @@ mx_table_child_set_row (MxTable      *table,
   meta->row = row;
 
   _mx_table_update_row_col (table, meta);
+  _mx_table_invalidate_cells (table);
   clutter_actor_queue_relayout (CLUTTER_ACTOR (table));
 }
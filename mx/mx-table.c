@@ -90,6 +90,27 @@ typedef struct
 
 } DimensionData;
 
+/* the number of solved constraints to remember; measuring and allocating
+ * usually asks for three different ones */
+#define N_CACHED_SOLVES 3
+
+/* the largest number of cells to keep a map of the actor occupying each;
+ * sparser tables look the actor up from the children */
+#define MAX_CACHED_CELLS (1 << 16)
+
+typedef struct
+{
+  guint   valid : 1;
+
+  gfloat  for_width;
+  gfloat  for_height;
+
+  GArray *columns;
+  GArray *rows;
+  gint    visible_cols;
+  gint    visible_rows;
+} SolveData;
+
 struct _MxTablePrivate
 {
   guint   ignore_css_col_spacing : 1;
@@ -110,6 +131,18 @@ struct _MxTablePrivate
   GArray *rows;
 
   MxFocusable *last_focus;
+
+  /* the actor occupying each cell, row by row, built when needed; NULL
+   * when the table has too many cells */
+  ClutterActor **cells;
+  gint           cells_rows;
+  gint           cells_cols;
+  guint          cells_valid : 1;
+
+  /* column and row sizes solved for recent constraints */
+  SolveData solves[N_CACHED_SOLVES];
+  guint     next_solve;
+  guint     n_solves;
 };
 
 static void mx_container_iface_init (ClutterContainerIface *iface);
@@ -125,14 +158,86 @@ G_DEFINE_TYPE_WITH_CODE (MxTable, mx_table, MX_TYPE_WIDGET,
                                                 mx_focusable_iface_init));
 
 
+/* fills in the actor occupying each cell; where children overlap, the first
+ * child in the list of children occupies the cell */
+static void
+mx_table_update_cells (MxTable *table)
+{
+  MxTablePrivate *priv = table->priv;
+  ClutterActorIter iter;
+  ClutterActor *actor_child;
+  gint rows, cols;
+
+  if (priv->cells_valid)
+    return;
+
+  rows = cols = 0;
+  clutter_actor_iter_init (&iter, CLUTTER_ACTOR (table));
+  while (clutter_actor_iter_next (&iter, &actor_child))
+    {
+      MxTableChild *child;
+
+      child = (MxTableChild *) clutter_container_get_child_meta (CLUTTER_CONTAINER (table),
+                                                                 actor_child);
+      rows = MAX (rows, child->row + child->row_span);
+      cols = MAX (cols, child->col + child->col_span);
+    }
+
+  g_free (priv->cells);
+  priv->cells = NULL;
+  priv->cells_rows = rows;
+  priv->cells_cols = cols;
+  priv->cells_valid = TRUE;
+
+  if ((guint64) rows * cols > MAX_CACHED_CELLS)
+    return;
+
+  priv->cells = g_new0 (ClutterActor *, rows * cols);
+
+  clutter_actor_iter_init (&iter, CLUTTER_ACTOR (table));
+  while (clutter_actor_iter_next (&iter, &actor_child))
+    {
+      MxTableChild *child;
+      gint row, column;
+
+      child = (MxTableChild *) clutter_container_get_child_meta (CLUTTER_CONTAINER (table),
+                                                                 actor_child);
+
+      for (row = MAX (0, child->row);
+           row < child->row + child->row_span;
+           row++)
+        {
+          ClutterActor **cell = priv->cells + (row * cols);
+
+          for (column = MAX (0, child->col);
+               column < child->col + child->col_span;
+               column++)
+            {
+              if (!cell[column])
+                cell[column] = actor_child;
+            }
+        }
+    }
+}
+
 static ClutterActor*
 mx_table_find_actor_at (MxTable *table,
                         int      row,
                         int      column)
 {
+  MxTablePrivate *priv = table->priv;
   ClutterActorIter iter;
   ClutterActor *actor_child;
 
+  mx_table_update_cells (table);
+
+  if (row < 0 || row >= priv->cells_rows ||
+      column < 0 || column >= priv->cells_cols)
+    return NULL;
+
+  if (priv->cells)
+    return priv->cells[(row * priv->cells_cols) + column];
+
   clutter_actor_iter_init (&iter, CLUTTER_ACTOR (table));
   while (clutter_actor_iter_next (&iter, &actor_child))
     {
@@ -141,8 +246,8 @@ mx_table_find_actor_at (MxTable *table,
       child = (MxTableChild *) clutter_container_get_child_meta (CLUTTER_CONTAINER (table),
                                                                  actor_child);
 
-      if ((row >= child->row && row <= child->row + (child->row_span - 1)) &&
-          (column >= child->col && column <= child->col + (child->col_span - 1)))
+      if (row >= child->row && row < child->row + child->row_span &&
+          column >= child->col && column < child->col + child->col_span)
         return actor_child;
     }
 
@@ -156,7 +261,6 @@ mx_table_move_focus (MxFocusable      *focusable,
 {
   MxTablePrivate *priv = MX_TABLE (focusable)->priv;
   MxTable *table = MX_TABLE (focusable);
-  GList *l, *childlink, *children;
   MxTableChild *child_meta;
   ClutterActor *child_actor;
   MxFocusable *focused;
@@ -179,49 +283,39 @@ mx_table_move_focus (MxFocusable      *focusable,
   switch (direction)
     {
     case MX_FOCUS_DIRECTION_NEXT:
-      children = clutter_actor_get_children (CLUTTER_ACTOR (focusable));
-      childlink = g_list_find (children, from);
-
-      for (l = childlink->next; l; l = g_list_next (l))
+      for (found = clutter_actor_get_next_sibling (child_actor);
+           found;
+           found = clutter_actor_get_next_sibling (found))
         {
-          if (MX_IS_FOCUSABLE (l->data))
+          if (MX_IS_FOCUSABLE (found))
             {
-              focused = mx_focusable_accept_focus (MX_FOCUSABLE (l->data),
+              focused = mx_focusable_accept_focus (MX_FOCUSABLE (found),
                                                    MX_FOCUS_HINT_FIRST);
 
               if (focused)
-                {
-                  g_list_free (children);
-                  return focused;
-                }
+                return focused;
             }
         }
 
       /* no next widgets to focus */
-      g_list_free (children);
       return NULL;
 
     case MX_FOCUS_DIRECTION_PREVIOUS:
-
-      children = clutter_actor_get_children (CLUTTER_ACTOR (focusable));
-      childlink = g_list_find (children, from);
-      for (l = g_list_previous (childlink); l; l = g_list_previous (l))
+      for (found = clutter_actor_get_previous_sibling (child_actor);
+           found;
+           found = clutter_actor_get_previous_sibling (found))
         {
-          if (MX_IS_FOCUSABLE (l->data))
+          if (MX_IS_FOCUSABLE (found))
             {
-              focused = mx_focusable_accept_focus (MX_FOCUSABLE (l->data),
+              focused = mx_focusable_accept_focus (MX_FOCUSABLE (found),
                                                    MX_FOCUS_HINT_LAST);
 
               if (focused)
-                {
-                  g_list_free (children);
-                  return focused;
-                }
+                return focused;
             }
         }
 
       /* no widget found in the previous position */
-      g_list_free (children);
       return NULL;
 
     case MX_FOCUS_DIRECTION_UP:
@@ -438,6 +532,7 @@ mx_table_actor_added (ClutterContainer *container,
 
   /* default position of the actor is 0, 0 */
   _mx_table_update_row_col (MX_TABLE (container), meta);
+  _mx_table_invalidate_cells (MX_TABLE (container));
 
   clutter_actor_queue_relayout (CLUTTER_ACTOR (container));
 }
@@ -455,6 +550,8 @@ mx_table_actor_removed (ClutterContainer *container,
   if ((ClutterActor *)priv->last_focus == actor)
     priv->last_focus = NULL;
 
+  _mx_table_invalidate_cells (MX_TABLE (container));
+
   /* update row/column count */
   rows = 0;
   cols = 0;
@@ -572,8 +669,17 @@ mx_table_finalize (GObject *gobject)
 {
   MxTablePrivate *priv = MX_TABLE (gobject)->priv;
 
+  gint i;
+
   g_array_free (priv->columns, TRUE);
   g_array_free (priv->rows, TRUE);
+  g_free (priv->cells);
+
+  for (i = 0; i < N_CACHED_SOLVES; i++)
+    {
+      g_array_free (priv->solves[i].columns, TRUE);
+      g_array_free (priv->solves[i].rows, TRUE);
+    }
 
   G_OBJECT_CLASS (mx_table_parent_class)->finalize (gobject);
 }
@@ -1157,13 +1263,68 @@ mx_table_calculate_row_heights (MxTable *table,
 
 }
 
+static void
+mx_table_copy_dimensions (GArray *dest,
+                          GArray *src)
+{
+  g_array_set_size (dest, src->len);
+  memcpy (dest->data, src->data, src->len * sizeof (DimensionData));
+}
+
+static void
+mx_table_invalidate_solves (MxTable *table)
+{
+  MxTablePrivate *priv = table->priv;
+  gint i;
+
+  for (i = 0; i < N_CACHED_SOLVES; i++)
+    priv->solves[i].valid = FALSE;
+}
+
 static void
 mx_table_calculate_dimensions (MxTable *table,
                                gfloat for_width,
                                gfloat for_height)
 {
+  MxTablePrivate *priv = table->priv;
+  SolveData *solve;
+  gint i;
+
+  /* re-use the column and row sizes if they were already solved for these
+   * constraints since the last relayout was queued */
+  for (i = 0; i < N_CACHED_SOLVES; i++)
+    {
+      solve = &priv->solves[i];
+
+      if (solve->valid &&
+          solve->for_width == for_width &&
+          solve->for_height == for_height)
+        {
+          mx_table_copy_dimensions (priv->columns, solve->columns);
+          mx_table_copy_dimensions (priv->rows, solve->rows);
+          priv->visible_cols = solve->visible_cols;
+          priv->visible_rows = solve->visible_rows;
+          return;
+        }
+    }
+
+  priv->n_solves++;
+  MX_NOTE (LAYOUT, "(%p) solve #%u for %.1f x %.1f",
+           table, priv->n_solves, for_width, for_height);
+
   mx_table_calculate_col_widths (table, for_width);
   mx_table_calculate_row_heights (table, for_height);
+
+  solve = &priv->solves[priv->next_solve];
+  priv->next_solve = (priv->next_solve + 1) % N_CACHED_SOLVES;
+
+  solve->valid = TRUE;
+  solve->for_width = for_width;
+  solve->for_height = for_height;
+  mx_table_copy_dimensions (solve->columns, priv->columns);
+  mx_table_copy_dimensions (solve->rows, priv->rows);
+  solve->visible_cols = priv->visible_cols;
+  solve->visible_rows = priv->visible_rows;
 }
 
 static void
@@ -1314,14 +1475,19 @@ mx_table_allocate (ClutterActor          *self,
 {
   MxTablePrivate *priv = MX_TABLE (self)->priv;
 
+  MX_PROFILE_BEGIN (self, ALLOCATE);
+
   CLUTTER_ACTOR_CLASS (mx_table_parent_class)->allocate (self, box, flags);
 
   if (priv->n_cols < 1 || priv->n_rows < 1)
     {
+      MX_PROFILE_END (self, ALLOCATE);
       return;
     };
 
   mx_table_preferred_allocate (self, box, flags);
+
+  MX_PROFILE_END (self, ALLOCATE);
 }
 
 static void
@@ -1336,10 +1502,13 @@ mx_table_get_preferred_width (ClutterActor *self,
   MxPadding padding;
   DimensionData *columns;
 
+  MX_PROFILE_BEGIN (self, PREFERRED_SIZE);
+
   if (priv->n_cols < 1)
     {
       *min_width_p = 0;
       *natural_width_p = 0;
+      MX_PROFILE_END (self, PREFERRED_SIZE);
       return;
     }
 
@@ -1365,6 +1534,8 @@ mx_table_get_preferred_width (ClutterActor *self,
     *min_width_p = total_min_width;
   if (natural_width_p)
     *natural_width_p = total_pref_width;
+
+  MX_PROFILE_END (self, PREFERRED_SIZE);
 }
 
 static void
@@ -1379,10 +1550,13 @@ mx_table_get_preferred_height (ClutterActor *self,
   MxPadding padding;
   DimensionData *rows;
 
+  MX_PROFILE_BEGIN (self, PREFERRED_SIZE);
+
   if (priv->n_rows < 1)
     {
       *min_height_p = 0;
       *natural_height_p = 0;
+      MX_PROFILE_END (self, PREFERRED_SIZE);
       return;
     }
 
@@ -1409,25 +1583,56 @@ mx_table_get_preferred_height (ClutterActor *self,
     *min_height_p = total_min_height;
   if (natural_height_p)
     *natural_height_p = total_pref_height;
+
+  MX_PROFILE_END (self, PREFERRED_SIZE);
 }
 
 static void
-mx_table_paint (ClutterActor *self)
+mx_table_queue_relayout (ClutterActor *self)
 {
-  MxTablePrivate *priv = MX_TABLE (self)->priv;
+  /* children, child properties, spacing and padding all queue a relayout
+   * when they change, as does reordering the children, which changes the
+   * child occupying overlapping cells */
+  mx_table_invalidate_solves (MX_TABLE (self));
+  _mx_table_invalidate_cells (MX_TABLE (self));
+
+  CLUTTER_ACTOR_CLASS (mx_table_parent_class)->queue_relayout (self);
+}
+
+/* paints (or picks) the children within the view of a scrolling ancestor */
+static void
+mx_table_paint_children (ClutterActor *self)
+{
+  ClutterActorBox view_b;
   ClutterActorIter iter;
   ClutterActor *child;
+  gboolean cull;
 
-
-  /* make sure the background gets painted first */
-  CLUTTER_ACTOR_CLASS (mx_table_parent_class)->paint (self);
+  cull = mx_widget_get_view_area (MX_WIDGET (self), &view_b);
 
   clutter_actor_iter_init (&iter, self);
   while (clutter_actor_iter_next (&iter, &child))
     {
-      if (CLUTTER_ACTOR_IS_VISIBLE (child))
+      if (!CLUTTER_ACTOR_IS_VISIBLE (child))
+        continue;
+
+      if (!cull || mx_widget_is_child_in_area (MX_WIDGET (self), child,
+                                               &view_b))
         clutter_actor_paint (child);
     }
+}
+
+static void
+mx_table_paint (ClutterActor *self)
+{
+  MxTablePrivate *priv = MX_TABLE (self)->priv;
+
+  MX_PROFILE_BEGIN (self, PAINT);
+
+  /* make sure the background gets painted first */
+  CLUTTER_ACTOR_CLASS (mx_table_parent_class)->paint (self);
+
+  mx_table_paint_children (self);
 
   if (_mx_debug (MX_DEBUG_LAYOUT))
     {
@@ -1463,24 +1668,22 @@ mx_table_paint (ClutterActor *self)
 
 
     }
+
+  MX_PROFILE_END (self, PAINT);
 }
 
 static void
 mx_table_pick (ClutterActor       *self,
                const ClutterColor *color)
 {
-  ClutterActorIter iter;
-  ClutterActor *child;
+  MX_PROFILE_BEGIN (self, PICK);
 
   /* Chain up so we get a bounding box painted (if we are reactive) */
   CLUTTER_ACTOR_CLASS (mx_table_parent_class)->pick (self, color);
 
-  clutter_actor_iter_init (&iter, self);
-  while (clutter_actor_iter_next (&iter, &child))
-    {
-      if (CLUTTER_ACTOR_IS_VISIBLE (child))
-        clutter_actor_paint (child);
-    }
+  mx_table_paint_children (self);
+
+  MX_PROFILE_END (self, PICK);
 }
 
 static void
@@ -1501,6 +1704,7 @@ mx_table_class_init (MxTableClass *klass)
   actor_class->allocate = mx_table_allocate;
   actor_class->get_preferred_width = mx_table_get_preferred_width;
   actor_class->get_preferred_height = mx_table_get_preferred_height;
+  actor_class->queue_relayout = mx_table_queue_relayout;
 
 
   pspec = g_param_spec_int ("column-spacing",
@@ -1558,11 +1762,15 @@ mx_table_style_changed (MxWidget *widget,
 
   if (!priv->ignore_css_row_spacing)
     priv->row_spacing = row_spacing;
+
+  mx_table_invalidate_solves (table);
 }
 
 static void
 mx_table_init (MxTable *table)
 {
+  gint i;
+
   table->priv = MX_TABLE_GET_PRIVATE (table);
 
   table->priv->n_cols = 0;
@@ -1571,6 +1779,14 @@ mx_table_init (MxTable *table)
   table->priv->columns = g_array_new (FALSE, TRUE, sizeof (DimensionData));
   table->priv->rows = g_array_new (FALSE, TRUE, sizeof (DimensionData));
 
+  for (i = 0; i < N_CACHED_SOLVES; i++)
+    {
+      table->priv->solves[i].columns =
+        g_array_new (FALSE, TRUE, sizeof (DimensionData));
+      table->priv->solves[i].rows =
+        g_array_new (FALSE, TRUE, sizeof (DimensionData));
+    }
+
   g_signal_connect (table, "style-changed",
                     G_CALLBACK (mx_table_style_changed), NULL);
 }
@@ -1587,6 +1803,13 @@ void _mx_table_update_row_col (MxTable      *table,
 
 }
 
+/* used by MxTableChild when a child moves or changes its span */
+void
+_mx_table_invalidate_cells (MxTable *table)
+{
+  table->priv->cells_valid = FALSE;
+}
+
 /*** Public Functions ***/
 
 /**
@@ -1847,3 +2070,23 @@ mx_table_get_column_count (MxTable *table)
 
   return MX_TABLE (table)->priv->n_cols;
 }
+
+/**
+ * mx_table_get_n_solves:
+ * @table: A #MxTable
+ *
+ * Gets the number of times the column widths and row heights of @table
+ * were solved, rather than reused from a previous measurement or
+ * allocation with the same constraints. This is intended for profiling.
+ *
+ * Returns: the number of solves since @table was created
+ *
+ * Since: 2.0
+ */
+guint
+mx_table_get_n_solves (MxTable *table)
+{
+  g_return_val_if_fail (MX_IS_TABLE (table), 0);
+
+  return table->priv->n_solves;
+}
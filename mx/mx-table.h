@@ -103,6 +103,8 @@ void mx_table_insert_actor_with_properties (MxTable      *table,
 gint mx_table_get_row_count    (MxTable *table);
 gint mx_table_get_column_count (MxTable *table);
 
+guint mx_table_get_n_solves (MxTable *table);
+
 G_END_DECLS
 
 #endif /* __MX_TABLE_H__ */
@@ -0,0 +1,347 @@
+/* -*- mode: C; c-file-style: "gnu"; indent-tabs-mode: nil; -*- */
+/*
+ * mx-text-cache.c: Shared cache of text measurements
+ *
+ * Copyright 2012 Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/*
+ * A process-wide cache of the preferred sizes of text actors.
+ *
+ * Lists of labels often repeat the same strings in the same font, and every
+ * ClutterText lays its text out again to measure it, even when another actor
+ * has just measured the same string. The sizes are keyed on the text, the
+ * font description, the wrapping and ellipsizing modes and the width the
+ * height is requested for, and the least recently used entries are dropped
+ * once the cache is full.
+ *
+ * Only plain text is cached: text using markup or attributes, editable text,
+ * password entries and actors with a size request or margins set go
+ * straight to the actor. The cache is cleared when
+ * the resolution or the font options of the backend change, as both affect
+ * the layout. It is only used from the main thread.
+ */
+
+#include "mx-text-cache.h"
+
+#include <string.h>
+
+/* Maximum number of measurements kept */
+#define MAX_ENTRIES 1024
+
+/* the height entries have this flag, with the width they were requested
+ * for */
+#define FLAG_HEIGHT       (1 << 0)
+#define FLAG_SINGLE_LINE  (1 << 1)
+#define FLAG_WRAP         (1 << 2)
+#define WRAP_MODE_SHIFT   3
+#define ELLIPSIZE_SHIFT   5
+
+typedef struct
+{
+  gchar                *text;
+  PangoFontDescription *font;
+  guint                 flags;
+  gfloat                for_width;
+  guint                 hash;
+
+  gfloat                min_size;
+  gfloat                natural_size;
+
+  GList                 link;
+} MxTextCacheEntry;
+
+static GHashTable       *cache_entries = NULL;
+static GQueue            cache_lru = G_QUEUE_INIT;
+static MxTextCacheStats  cache_stats = { 0, };
+
+static guint
+mx_text_cache_entry_hash (gconstpointer key)
+{
+  return ((const MxTextCacheEntry *) key)->hash;
+}
+
+static gboolean
+mx_text_cache_entry_equal (gconstpointer a,
+                           gconstpointer b)
+{
+  const MxTextCacheEntry *entry_a = a;
+  const MxTextCacheEntry *entry_b = b;
+
+  return (entry_a->hash == entry_b->hash &&
+          entry_a->flags == entry_b->flags &&
+          entry_a->for_width == entry_b->for_width &&
+          strcmp (entry_a->text, entry_b->text) == 0 &&
+          pango_font_description_equal (entry_a->font, entry_b->font));
+}
+
+static void
+mx_text_cache_entry_free (MxTextCacheEntry *entry)
+{
+  g_free (entry->text);
+  pango_font_description_free (entry->font);
+  g_slice_free (MxTextCacheEntry, entry);
+}
+
+static void
+mx_text_cache_clear (void)
+{
+  g_queue_init (&cache_lru);
+  g_hash_table_remove_all (cache_entries);
+}
+
+static void
+mx_text_cache_backend_changed_cb (ClutterBackend *backend,
+                                  gpointer        data)
+{
+  mx_text_cache_clear ();
+}
+
+static void
+mx_text_cache_ensure (void)
+{
+  ClutterBackend *backend;
+
+  if (G_LIKELY (cache_entries))
+    return;
+
+  cache_entries =
+    g_hash_table_new_full (mx_text_cache_entry_hash,
+                           mx_text_cache_entry_equal,
+                           NULL,
+                           (GDestroyNotify) mx_text_cache_entry_free);
+
+  backend = clutter_get_default_backend ();
+  g_signal_connect (backend, "resolution-changed",
+                    G_CALLBACK (mx_text_cache_backend_changed_cb), NULL);
+  g_signal_connect (backend, "font-changed",
+                    G_CALLBACK (mx_text_cache_backend_changed_cb), NULL);
+}
+
+/* fills in the key of @entry from @text, borrowing its strings; returns
+ * %FALSE if the size of @text can't be shared */
+static gboolean
+mx_text_cache_entry_init (MxTextCacheEntry *entry,
+                          ClutterText      *text,
+                          gboolean          height,
+                          gfloat            for_width)
+{
+  gboolean min_width_set, natural_width_set;
+  gboolean min_height_set, natural_height_set;
+  ClutterMargin margin;
+
+  if (clutter_text_get_editable (text) ||
+      clutter_text_get_use_markup (text) ||
+      clutter_text_get_attributes (text) ||
+      clutter_text_get_password_char (text))
+    return FALSE;
+
+  /* the size requests and margins set on the actor change its preferred
+   * size without being part of the key */
+  g_object_get (G_OBJECT (text),
+                "min-width-set", &min_width_set,
+                "natural-width-set", &natural_width_set,
+                "min-height-set", &min_height_set,
+                "natural-height-set", &natural_height_set,
+                NULL);
+  if (min_width_set || natural_width_set ||
+      min_height_set || natural_height_set)
+    return FALSE;
+
+  clutter_actor_get_margin (CLUTTER_ACTOR (text), &margin);
+  if (margin.left != 0 || margin.right != 0 ||
+      margin.top != 0 || margin.bottom != 0)
+    return FALSE;
+
+  entry->text = (gchar *) clutter_text_get_text (text);
+  entry->font = clutter_text_get_font_description (text);
+  if (!entry->text || !entry->font)
+    return FALSE;
+
+  entry->flags = 0;
+  if (height)
+    entry->flags |= FLAG_HEIGHT;
+  if (clutter_text_get_single_line_mode (text))
+    entry->flags |= FLAG_SINGLE_LINE;
+  if (clutter_text_get_line_wrap (text))
+    entry->flags |= FLAG_WRAP;
+  entry->flags |= clutter_text_get_line_wrap_mode (text) << WRAP_MODE_SHIFT;
+  entry->flags |= clutter_text_get_ellipsize (text) << ELLIPSIZE_SHIFT;
+
+  /* any negative width means the height isn't constrained */
+  entry->for_width = (height && for_width >= 0) ? for_width : -1;
+
+  entry->hash = g_str_hash (entry->text) ^
+                pango_font_description_hash (entry->font) ^
+                (entry->flags << 24) ^
+                (guint) (gint) MIN (entry->for_width, G_MAXINT16);
+
+  return TRUE;
+}
+
+static gboolean
+mx_text_cache_lookup (MxTextCacheEntry *key,
+                      gfloat           *min_size_p,
+                      gfloat           *natural_size_p)
+{
+  MxTextCacheEntry *entry;
+
+  mx_text_cache_ensure ();
+
+  entry = g_hash_table_lookup (cache_entries, key);
+  if (!entry)
+    {
+      cache_stats.misses++;
+      return FALSE;
+    }
+
+  cache_stats.hits++;
+
+  /* move the entry to the front of the queue */
+  g_queue_unlink (&cache_lru, &entry->link);
+  g_queue_push_head_link (&cache_lru, &entry->link);
+
+  if (min_size_p)
+    *min_size_p = entry->min_size;
+  if (natural_size_p)
+    *natural_size_p = entry->natural_size;
+
+  return TRUE;
+}
+
+static void
+mx_text_cache_insert (const MxTextCacheEntry *key,
+                      gfloat                  min_size,
+                      gfloat                  natural_size)
+{
+  MxTextCacheEntry *entry;
+
+  /* drop the least recently used entry if the cache is full */
+  if (cache_lru.length >= MAX_ENTRIES)
+    {
+      GList *last = g_queue_pop_tail_link (&cache_lru);
+
+      g_hash_table_remove (cache_entries, last->data);
+    }
+
+  entry = g_slice_new (MxTextCacheEntry);
+  entry->text = g_strdup (key->text);
+  entry->font = pango_font_description_copy (key->font);
+  entry->flags = key->flags;
+  entry->for_width = key->for_width;
+  entry->hash = key->hash;
+  entry->min_size = min_size;
+  entry->natural_size = natural_size;
+
+  entry->link.data = entry;
+  entry->link.prev = entry->link.next = NULL;
+  g_queue_push_head_link (&cache_lru, &entry->link);
+
+  g_hash_table_add (cache_entries, entry);
+}
+
+/*
+ * _mx_text_cache_get_preferred_width:
+ * @text: a #ClutterText
+ * @min_width_p: (allow-none): return location for the minimum width
+ * @natural_width_p: (allow-none): return location for the natural width
+ *
+ * Gets the preferred width of @text, as clutter_actor_get_preferred_width()
+ * would, measuring the text only if no text with the same contents, font
+ * and layout modes has been measured before.
+ */
+void
+_mx_text_cache_get_preferred_width (ClutterText *text,
+                                    gfloat      *min_width_p,
+                                    gfloat      *natural_width_p)
+{
+  MxTextCacheEntry key;
+  gfloat min_width, natural_width;
+
+  if (!mx_text_cache_entry_init (&key, text, FALSE, -1))
+    {
+      clutter_actor_get_preferred_width (CLUTTER_ACTOR (text), -1,
+                                         min_width_p, natural_width_p);
+      return;
+    }
+
+  if (mx_text_cache_lookup (&key, min_width_p, natural_width_p))
+    return;
+
+  clutter_actor_get_preferred_width (CLUTTER_ACTOR (text), -1,
+                                     &min_width, &natural_width);
+  mx_text_cache_insert (&key, min_width, natural_width);
+
+  if (min_width_p)
+    *min_width_p = min_width;
+  if (natural_width_p)
+    *natural_width_p = natural_width;
+}
+
+/*
+ * _mx_text_cache_get_preferred_height:
+ * @text: a #ClutterText
+ * @for_width: the available width, or a negative value
+ * @min_height_p: (allow-none): return location for the minimum height
+ * @natural_height_p: (allow-none): return location for the natural height
+ *
+ * Gets the preferred height of @text for @for_width, as
+ * clutter_actor_get_preferred_height() would, measuring the text only if
+ * no text with the same contents, font and layout modes has been measured
+ * for that width before.
+ */
+void
+_mx_text_cache_get_preferred_height (ClutterText *text,
+                                     gfloat       for_width,
+                                     gfloat      *min_height_p,
+                                     gfloat      *natural_height_p)
+{
+  MxTextCacheEntry key;
+  gfloat min_height, natural_height;
+
+  if (!mx_text_cache_entry_init (&key, text, TRUE, for_width))
+    {
+      clutter_actor_get_preferred_height (CLUTTER_ACTOR (text), for_width,
+                                          min_height_p, natural_height_p);
+      return;
+    }
+
+  if (mx_text_cache_lookup (&key, min_height_p, natural_height_p))
+    return;
+
+  clutter_actor_get_preferred_height (CLUTTER_ACTOR (text), for_width,
+                                      &min_height, &natural_height);
+  mx_text_cache_insert (&key, min_height, natural_height);
+
+  if (min_height_p)
+    *min_height_p = min_height;
+  if (natural_height_p)
+    *natural_height_p = natural_height;
+}
+
+/*
+ * _mx_text_cache_get_stats:
+ * @stats: return location for the statistics
+ *
+ * Retrieves a snapshot of the cache usage statistics.
+ */
+void
+_mx_text_cache_get_stats (MxTextCacheStats *stats)
+{
+  memcpy (stats, &cache_stats, sizeof (MxTextCacheStats));
+  stats->n_entries = cache_lru.length;
+}
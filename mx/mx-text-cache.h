@@ -0,0 +1,51 @@
+/* -*- mode: C; c-file-style: "gnu"; indent-tabs-mode: nil; -*- */
+/*
+ * mx-text-cache.h: Shared cache of text measurements
+ *
+ * Copyright 2012 Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/*
+ * This is private to MX
+ */
+
+#ifndef __MX_TEXT_CACHE_H__
+#define __MX_TEXT_CACHE_H__
+
+#include <clutter/clutter.h>
+
+G_BEGIN_DECLS
+
+typedef struct
+{
+  guint n_entries;
+  guint hits;
+  guint misses;
+} MxTextCacheStats;
+
+void _mx_text_cache_get_preferred_width  (ClutterText      *text,
+                                          gfloat           *min_width_p,
+                                          gfloat           *natural_width_p);
+void _mx_text_cache_get_preferred_height (ClutterText      *text,
+                                          gfloat            for_width,
+                                          gfloat           *min_height_p,
+                                          gfloat           *natural_height_p);
+void _mx_text_cache_get_stats            (MxTextCacheStats *stats);
+
+G_END_DECLS
+
+#endif /* __MX_TEXT_CACHE_H__ */
@@ -25,6 +25,18 @@
  *
  * #MxTextureCache allows an application to re-use an previously loaded
  * textures.
+ *
+ * Images are loaded from local files, or from resources compiled into the
+ * binary using "resource://" URIs. In both cases the encoded data is decoded
+ * in place (from a read-only mapping of the file, or directly from the
+ * resource data), without intermediate copies. For resources, this requires
+ * that the images are not compressed in the resource bundle.
+ *
+ * Images can also be stored pre-decoded, in which case they are uploaded
+ * without decoding at all. Such images start with the 8 bytes "MXRGBA01",
+ * followed by the width, height and rowstride as little-endian 32-bit
+ * unsigned integers, followed by the pixel data in non-premultiplied RGBA
+ * format, 8 bits per channel.
  */
 
 #ifdef HAVE_CONFIG_H
@@ -79,6 +91,17 @@ enum
 
 static MxTextureCache* __cache_singleton = NULL;
 
+/* Header of pre-decoded RGBA images, see the section documentation */
+#define MX_RAW_IMAGE_MAGIC "MXRGBA01"
+
+typedef struct
+{
+  gchar   magic[8];
+  guint32 width;
+  guint32 height;
+  guint32 rowstride;
+} MxRawImageHeader;
+
 /*
  * Convention: posX with a value of -1 indicates whole texture
  */
@@ -319,13 +342,145 @@ mx_texture_cache_uri_to_filename (const gchar *uri)
   return file;
 }
 
-#if defined(__ANDROID__) || defined(ANDROID)
 static GQuark
 mx_texture_cache_error_quark (void)
 {
   return g_quark_from_static_string ("mx-texture-cache-error-quark");
 }
-#endif
+
+/*
+ * mx_texture_cache_source_open:
+ * @path: A resource path or a local file name
+ * @is_resource: Whether @path is a resource path
+ * @error: Return location for a #GError, or %NULL
+ *
+ * Retrieves the data of an image source without copying it. Resource data
+ * is returned as stored in the binary, and files are mapped read-only.
+ *
+ * Returns: A #GBytes holding the image data, or %NULL on failure
+ */
+static GBytes *
+mx_texture_cache_source_open (const gchar  *path,
+                              gboolean      is_resource,
+                              GError      **error)
+{
+  GMappedFile *mapped_file;
+  GBytes *bytes;
+
+  if (is_resource)
+    return g_resources_lookup_data (path, G_RESOURCE_LOOKUP_FLAGS_NONE, error);
+
+  mapped_file = g_mapped_file_new (path, FALSE, error);
+  if (!mapped_file)
+    return NULL;
+
+  /* The bytes keep a reference on the mapping */
+  bytes = g_mapped_file_get_bytes (mapped_file);
+  g_mapped_file_unref (mapped_file);
+
+  return bytes;
+}
+
+static CoglHandle
+mx_texture_cache_source_load_raw (GBytes  *bytes,
+                                  GError **error)
+{
+  const MxRawImageHeader *header;
+  guint32 width, height, rowstride;
+  const guint8 *data;
+  gsize size;
+
+  data = g_bytes_get_data (bytes, &size);
+  header = (const MxRawImageHeader *) data;
+
+  width = GUINT32_FROM_LE (header->width);
+  height = GUINT32_FROM_LE (header->height);
+  rowstride = GUINT32_FROM_LE (header->rowstride);
+
+  /* compare in 64 bits, so that a huge width can't wrap around */
+  if (width == 0 || height == 0 || width > G_MAXINT || height > G_MAXINT ||
+      rowstride < (guint64) width * 4 ||
+      (size - sizeof (MxRawImageHeader)) / rowstride < height)
+    {
+      g_set_error (error, mx_texture_cache_error_quark (), 0,
+                   "Invalid pre-decoded image data");
+      return COGL_INVALID_HANDLE;
+    }
+
+  return cogl_texture_new_from_data (width, height,
+                                     COGL_TEXTURE_NONE,
+                                     COGL_PIXEL_FORMAT_RGBA_8888,
+                                     COGL_PIXEL_FORMAT_ANY,
+                                     rowstride,
+                                     data + sizeof (MxRawImageHeader));
+}
+
+/*
+ * mx_texture_cache_source_load:
+ * @bytes: Image data returned by mx_texture_cache_source_open()
+ * @error: Return location for a #GError, or %NULL
+ *
+ * Creates a texture from image data. Pre-decoded data is uploaded as is,
+ * anything else is decoded with gdk-pixbuf straight from @bytes.
+ *
+ * Returns: A new texture, or %COGL_INVALID_HANDLE on failure
+ */
+static CoglHandle
+mx_texture_cache_source_load (GBytes  *bytes,
+                              GError **error)
+{
+  GdkPixbufLoader *loader;
+  GdkPixbuf *pixbuf;
+  CoglHandle texture;
+  const guint8 *data;
+  gsize size;
+
+  data = g_bytes_get_data (bytes, &size);
+
+  if (size >= sizeof (MxRawImageHeader) &&
+      memcmp (data, MX_RAW_IMAGE_MAGIC, 8) == 0)
+    return mx_texture_cache_source_load_raw (bytes, error);
+
+  loader = gdk_pixbuf_loader_new ();
+
+  if (!gdk_pixbuf_loader_write (loader, data, size, error))
+    {
+      gdk_pixbuf_loader_close (loader, NULL);
+      g_object_unref (loader);
+      return COGL_INVALID_HANDLE;
+    }
+
+  if (!gdk_pixbuf_loader_close (loader, error))
+    {
+      g_object_unref (loader);
+      return COGL_INVALID_HANDLE;
+    }
+
+  pixbuf = gdk_pixbuf_loader_get_pixbuf (loader);
+  if (!pixbuf)
+    {
+      g_set_error (error, mx_texture_cache_error_quark (), 0,
+                   "Could not decode image");
+      g_object_unref (loader);
+      return COGL_INVALID_HANDLE;
+    }
+
+  texture =
+    cogl_texture_new_from_data (gdk_pixbuf_get_width (pixbuf),
+                                gdk_pixbuf_get_height (pixbuf),
+                                COGL_TEXTURE_NONE,
+                                gdk_pixbuf_get_has_alpha (pixbuf) ?
+                                  COGL_PIXEL_FORMAT_RGBA_8888 :
+                                  COGL_PIXEL_FORMAT_RGB_888,
+                                COGL_PIXEL_FORMAT_ANY,
+                                gdk_pixbuf_get_rowstride (pixbuf),
+                                gdk_pixbuf_get_pixels (pixbuf));
+
+  /* The pixbuf is owned by the loader */
+  g_object_unref (loader);
+
+  return texture;
+}
 
 static MxTextureCacheItem *
 mx_texture_cache_get_item (MxTextureCache *self,
@@ -382,33 +537,12 @@ mx_texture_cache_get_item (MxTextureCache *self,
 
       if (is_resource)
         {
-          GdkPixbuf *pixbuf;
-          GInputStream *stream = NULL;
-          gint width, height, has_alpha, rowstride;
+          GBytes *bytes = mx_texture_cache_source_open (&uri[11], TRUE, &err);
 
-          stream = g_resources_open_stream (&uri[11],
-                                            G_RESOURCE_LOOKUP_FLAGS_NONE,
-                                            &err);
-
-          if (stream)
+          if (bytes)
             {
-
-              pixbuf = gdk_pixbuf_new_from_stream (stream, NULL, &err);
-
-
-              width = gdk_pixbuf_get_width (pixbuf);
-              height = gdk_pixbuf_get_height (pixbuf);
-              has_alpha = gdk_pixbuf_get_has_alpha (pixbuf);
-              rowstride = gdk_pixbuf_get_rowstride (pixbuf);
-
-              item->ptr = cogl_texture_new_from_data (width, height,
-                                                      COGL_TEXTURE_NONE,
-                                                      has_alpha ? COGL_PIXEL_FORMAT_RGBA_8888 : COGL_PIXEL_FORMAT_RGB_888,
-                                                      COGL_PIXEL_FORMAT_ANY,
-                                                      rowstride,
-                                                      gdk_pixbuf_get_pixels (pixbuf));
-
-              g_object_unref (stream);
+              item->ptr = mx_texture_cache_source_load (bytes, &err);
+              g_bytes_unref (bytes);
             }
         }
       else
@@ -460,9 +594,13 @@ mx_texture_cache_get_item (MxTextureCache *self,
             err = g_error_new (mx_texture_cache_error_quark (), 0,
                                "Could not open %s", file);
 #else
-          item->ptr = cogl_texture_new_from_file (file, COGL_TEXTURE_NONE,
-                                                  COGL_PIXEL_FORMAT_ANY,
-                                                  &err);
+          GBytes *bytes = mx_texture_cache_source_open (file, FALSE, &err);
+
+          if (bytes)
+            {
+              item->ptr = mx_texture_cache_source_load (bytes, &err);
+              g_bytes_unref (bytes);
+            }
 #endif
         }
 
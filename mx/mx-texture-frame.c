@@ -33,6 +33,7 @@
 #include "config.h"
 #endif
 
+#include <string.h>
 #include <cogl/cogl.h>
 
 #include "mx-texture-frame.h"
@@ -40,41 +41,77 @@
 
 static CoglMaterial *template_material = NULL;
 
-static void
-mx_texture_frame_paint_texture_internal (CoglHandle  material,
-                                         CoglHandle  texture,
-                                         guint8      opacity,
-                                         gfloat      top,
-                                         gfloat      right,
-                                         gfloat      bottom,
-                                         gfloat      left,
-                                         gfloat      width,
-                                         gfloat      height)
+/* the largest number of floats needed to describe the 9 slices */
+#define N_SLICE_FLOATS (9 * 8)
+
+struct _MxTextureFrameCache
 {
-  gfloat tex_width, tex_height;
-  gfloat ex, ey;
-  gfloat tx1, ty1, tx2, ty2;
+  CoglHandle  texture;
+  CoglHandle  material;
+  guint8      opacity;
+
+  /* the geometry the rectangles were computed for */
+  gfloat      top;
+  gfloat      right;
+  gfloat      bottom;
+  gfloat      left;
+  gfloat      width;
+  gfloat      height;
+
+  gint        n_rectangles;
+  gfloat      rectangles[N_SLICE_FLOATS];
+};
+
+static CoglHandle
+mx_texture_frame_new_material (CoglHandle texture,
+                               guint8     opacity)
+{
+  CoglHandle material;
 
-  /* apply opacity */
+  /* setup the template material */
+  if (!template_material)
+    template_material = cogl_material_new ();
+
+  /* create the material and apply opacity */
+  material = cogl_material_copy (template_material);
   cogl_material_set_color4ub (material, opacity, opacity, opacity, opacity);
 
   /* add the texture */
   cogl_material_set_layer (material, 0, texture);
 
-  /* set the source */
-  cogl_set_source (material);
+  return material;
+}
 
-  tex_width  = cogl_texture_get_width (texture);
-  tex_height = cogl_texture_get_height (texture);
+/* Fills @rectangles with the vertex and texture coordinates of the slices
+ * and returns how many there are */
+static gint
+mx_texture_frame_compute_rectangles (CoglHandle  texture,
+                                     gfloat      top,
+                                     gfloat      right,
+                                     gfloat      bottom,
+                                     gfloat      left,
+                                     gfloat      width,
+                                     gfloat      height,
+                                     gfloat     *rectangles)
+{
+  gfloat tex_width, tex_height;
+  gfloat ex, ey;
+  gfloat tx1, ty1, tx2, ty2;
 
   /* simple stretch */
   if (left == 0 && right == 0 && top == 0
       && bottom == 0)
     {
-      cogl_rectangle (0, 0, width, height);
-      return;
+      const gfloat stretch[] = { 0, 0, width, height, 0.0, 0.0, 1.0, 1.0 };
+
+      memcpy (rectangles, stretch, sizeof (stretch));
+
+      return 1;
     }
 
+  tex_width  = cogl_texture_get_width (texture);
+  tex_height = cogl_texture_get_height (texture);
+
   tx1 = left / tex_width;
   tx2 = (tex_width - right) / tex_width;
   ty1 = top / tex_height;
@@ -90,7 +127,7 @@ mx_texture_frame_paint_texture_internal (CoglHandle  material,
 
 
   {
-    float rectangles[] =
+    const gfloat slices[] =
     {
       /* top left corner */
       0, 0,
@@ -147,8 +184,10 @@ mx_texture_frame_paint_texture_internal (CoglHandle  material,
       1.0, 1.0
     };
 
-    cogl_rectangles_with_texture_coords (rectangles, 9);
+    memcpy (rectangles, slices, sizeof (slices));
   }
+
+  return 9;
 }
 
 void
@@ -161,20 +200,122 @@ mx_texture_frame_paint_texture (CoglHandle  texture,
                                 gfloat      width,
                                 gfloat      height)
 {
+  gfloat rectangles[N_SLICE_FLOATS];
   CoglHandle material;
+  gint n_rectangles;
 
-  /* setup the template material */
-  if (!template_material)
-    template_material = cogl_material_new ();
+  material = mx_texture_frame_new_material (texture, opacity);
 
-  /* create the material and apply opacity */
-  material = cogl_material_copy (template_material);
+  /* set the source */
+  cogl_set_source (material);
 
-  mx_texture_frame_paint_texture_internal (material, texture,
-                                           opacity,
-                                           top, right,
-                                           bottom, left,
-                                           width, height);
+  n_rectangles = mx_texture_frame_compute_rectangles (texture,
+                                                      top, right,
+                                                      bottom, left,
+                                                      width, height,
+                                                      rectangles);
+  cogl_rectangles_with_texture_coords (rectangles, n_rectangles);
 
   cogl_handle_unref (material);
 }
+
+/*
+ * _mx_texture_frame_cache_new:
+ *
+ * Creates a cache for painting a border image repeatedly with
+ * _mx_texture_frame_paint_cached(). Each widget painting a border image
+ * should have its own.
+ *
+ * Returns: a new #MxTextureFrameCache
+ */
+MxTextureFrameCache *
+_mx_texture_frame_cache_new (void)
+{
+  return g_slice_new0 (MxTextureFrameCache);
+}
+
+/*
+ * _mx_texture_frame_cache_free:
+ * @cache: (allow-none): An #MxTextureFrameCache
+ *
+ * Frees @cache and releases the texture and material it holds.
+ */
+void
+_mx_texture_frame_cache_free (MxTextureFrameCache *cache)
+{
+  if (!cache)
+    return;
+
+  if (cache->material)
+    cogl_handle_unref (cache->material);
+
+  if (cache->texture)
+    cogl_handle_unref (cache->texture);
+
+  g_slice_free (MxTextureFrameCache, cache);
+}
+
+/*
+ * _mx_texture_frame_paint_cached:
+ * @cache: An #MxTextureFrameCache
+ *
+ * Paints like mx_texture_frame_paint_texture(), but keeps the material and
+ * the slices in @cache. The slices are only computed again when the
+ * texture, insets or size change, and the material is only recreated for a
+ * different texture; a change of opacity updates its color in place. The
+ * slices still go through the journal, so frames sharing a texture and
+ * opacity are batched together.
+ */
+void
+_mx_texture_frame_paint_cached (MxTextureFrameCache *cache,
+                                CoglHandle           texture,
+                                guint8               opacity,
+                                gfloat               top,
+                                gfloat               right,
+                                gfloat               bottom,
+                                gfloat               left,
+                                gfloat               width,
+                                gfloat               height)
+{
+  if (cache->texture != texture)
+    {
+      if (cache->material)
+        cogl_handle_unref (cache->material);
+      if (cache->texture)
+        cogl_handle_unref (cache->texture);
+
+      cache->texture = cogl_handle_ref (texture);
+      cache->material = mx_texture_frame_new_material (texture, opacity);
+      cache->opacity = opacity;
+      cache->n_rectangles = 0;
+    }
+  else if (cache->opacity != opacity)
+    {
+      cogl_material_set_color4ub (cache->material,
+                                  opacity, opacity, opacity, opacity);
+      cache->opacity = opacity;
+    }
+
+  if (cache->n_rectangles == 0 ||
+      cache->top != top || cache->right != right ||
+      cache->bottom != bottom || cache->left != left ||
+      cache->width != width || cache->height != height)
+    {
+      cache->top = top;
+      cache->right = right;
+      cache->bottom = bottom;
+      cache->left = left;
+      cache->width = width;
+      cache->height = height;
+      cache->n_rectangles =
+        mx_texture_frame_compute_rectangles (texture,
+                                             top, right,
+                                             bottom, left,
+                                             width, height,
+                                             cache->rectangles);
+    }
+
+  cogl_set_source (cache->material);
+  cogl_rectangles_with_texture_coords (cache->rectangles,
+                                       cache->n_rectangles);
+}
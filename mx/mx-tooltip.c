@@ -77,6 +77,7 @@ struct _MxTooltipPrivate
   MxBorderImage   *border_image;
   ClutterActorBox  text_allocation;
   CoglHandle       border_image_texture;
+  MxTextureFrameCache *border_image_cache;
 };
 
 /* Time in milliseconds after a tooltip is hidden before disabling
@@ -195,6 +196,12 @@ mx_tooltip_style_changed (MxWidget *self)
       priv->border_image_texture = NULL;
     }
 
+  if (priv->border_image_cache)
+    {
+      _mx_texture_frame_cache_free (priv->border_image_cache);
+      priv->border_image_cache = NULL;
+    }
+
   if (border_image)
     {
       priv->border_image_texture =
@@ -402,14 +409,20 @@ mx_tooltip_paint (ClutterActor *self)
                   0);
 
   if (priv->border_image_texture)
-    mx_texture_frame_paint_texture (priv->border_image_texture,
-                                    alpha,
-                                    priv->border_image->top,
-                                    priv->border_image->right,
-                                    priv->border_image->bottom,
-                                    priv->border_image->left,
-                                    priv->text_allocation.x2 - priv->text_allocation.x1,
-                                    priv->text_allocation.y2 - priv->text_allocation.y1);
+    {
+      if (!priv->border_image_cache)
+        priv->border_image_cache = _mx_texture_frame_cache_new ();
+
+      _mx_texture_frame_paint_cached (priv->border_image_cache,
+                                      priv->border_image_texture,
+                                      alpha,
+                                      priv->border_image->top,
+                                      priv->border_image->right,
+                                      priv->border_image->bottom,
+                                      priv->border_image->left,
+                                      priv->text_allocation.x2 - priv->text_allocation.x1,
+                                      priv->text_allocation.y2 - priv->text_allocation.y1);
+    }
   cogl_pop_matrix ();
 
   arrow_image = mx_widget_get_background_texture (MX_WIDGET (self));
@@ -441,6 +454,12 @@ mx_tooltip_dispose (GObject *object)
       priv->border_image_texture = NULL;
     }
 
+  if (priv->border_image_cache)
+    {
+      _mx_texture_frame_cache_free (priv->border_image_cache);
+      priv->border_image_cache = NULL;
+    }
+
   G_OBJECT_CLASS (mx_tooltip_parent_class)->dispose (object);
 }
 
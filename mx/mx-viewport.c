@@ -47,11 +47,18 @@
  * be selective about the area of its child that is painted/picked. Therefore
  * if the child is very large or contains a lot of children, you will experience
  * poor performance.
+ *
+ * If the child is mostly static, such as a long page of text, setting
+ * #MxViewport:cache-content makes the viewport paint the child once into
+ * tiles covering the view and a margin around it. Scrolling then only
+ * composites the tiles. Tiles are repainted when the part of the child
+ * they cover changes.
  */
 #ifdef HAVE_CONFIG_H
 #include "config.h"
 #endif
 
+#include <math.h>
 #include <string.h>
 #include <clutter/clutter.h>
 
@@ -59,6 +66,7 @@
 #include "mx-adjustment.h"
 #include "mx-scrollable.h"
 #include "mx-private.h"
+#include "mx-widget-private.h"
 
 static void scrollable_interface_init (MxScrollableIface *iface);
 
@@ -90,8 +98,36 @@ struct _MxViewportPrivate
   gboolean      sync_adjustments;
 
   ClutterActor *child;
+
+  /* cached tiles of the child, by position */
+  gboolean        cache_content;
+  GHashTable     *tiles;
+  guint8          tiles_opacity;
+  gfloat          tiles_x;
+  gfloat          tiles_y;
+  ClutterActorBox child_box;
+  guint           margin_source;
 };
 
+/* size of the cached tiles, in pixels */
+#define TILE_SIZE 256
+
+/* number of tiles kept around the view */
+#define TILE_MARGIN 1
+
+#define TILE_KEY(col,row) GUINT_TO_POINTER (((row) << 16) | (col))
+
+typedef struct
+{
+  gint        col;
+  gint        row;
+  CoglHandle  texture;
+  CoglHandle  fbo;
+  gboolean    valid;
+} MxViewportTile;
+
+static GQuark redraw_box_quark = 0;
+
 enum
 {
   PROP_0,
@@ -101,7 +137,8 @@ enum
   PROP_Z_ORIGIN,
   PROP_HADJUST,
   PROP_VADJUST,
-  PROP_SYNC_ADJUST
+  PROP_SYNC_ADJUST,
+  PROP_CACHE_CONTENT
 };
 
 static void
@@ -142,6 +179,10 @@ mx_viewport_get_property (GObject    *object,
       g_value_set_boolean (value, priv->sync_adjustments);
       break;
 
+    case PROP_CACHE_CONTENT:
+      g_value_set_boolean (value, priv->cache_content);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -196,6 +237,10 @@ mx_viewport_set_property (GObject      *object,
       mx_viewport_set_sync_adjustments (viewport, g_value_get_boolean (value));
       break;
 
+    case PROP_CACHE_CONTENT:
+      mx_viewport_set_cache_content (viewport, g_value_get_boolean (value));
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -219,9 +264,119 @@ mx_viewport_dispose (GObject *gobject)
       priv->vadjustment = NULL;
     }
 
+  if (priv->tiles)
+    {
+      g_hash_table_destroy (priv->tiles);
+      priv->tiles = NULL;
+    }
+
+  if (priv->margin_source)
+    {
+      g_source_remove (priv->margin_source);
+      priv->margin_source = 0;
+    }
+
   G_OBJECT_CLASS (mx_viewport_parent_class)->dispose (gobject);
 }
 
+static void
+mx_viewport_tile_free (MxViewportTile *tile)
+{
+  if (tile->fbo)
+    cogl_handle_unref (tile->fbo);
+  if (tile->texture)
+    cogl_handle_unref (tile->texture);
+
+  g_slice_free (MxViewportTile, tile);
+}
+
+/* marks the tiles covering @box (or all the tiles) as needing a repaint */
+static void
+mx_viewport_invalidate_tiles (MxViewport            *viewport,
+                              const ClutterActorBox *box)
+{
+  MxViewportPrivate *priv = viewport->priv;
+  GHashTableIter iter;
+  MxViewportTile *tile;
+
+  if (!priv->tiles)
+    return;
+
+  g_hash_table_iter_init (&iter, priv->tiles);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &tile))
+    {
+      if (box &&
+          (box->x2 <= tile->col * TILE_SIZE ||
+           box->x1 >= (tile->col + 1) * TILE_SIZE ||
+           box->y2 <= tile->row * TILE_SIZE ||
+           box->y1 >= (tile->row + 1) * TILE_SIZE))
+        continue;
+
+      tile->valid = FALSE;
+    }
+}
+
+static void
+mx_viewport_queue_redraw (ClutterActor *self,
+                          ClutterActor *origin)
+{
+  MxViewportPrivate *priv = MX_VIEWPORT (self)->priv;
+
+  /* invalidate the tiles covering the old and new areas of the actor that
+   * changed. The old area is only known after it has been seen once, so
+   * invalidate everything the first time. */
+  if (priv->tiles && origin != self)
+    {
+      const ClutterPaintVolume *volume;
+      ClutterPaintVolume *copy = NULL;
+      ClutterActorBox *old_box;
+
+      old_box = g_object_get_qdata (G_OBJECT (origin), redraw_box_quark);
+
+      /* the transformed volume belongs to @origin and can't be passed to
+       * clutter_paint_volume_get_bounding_box() as it is */
+      volume = clutter_actor_get_transformed_paint_volume (origin, self);
+      if (volume)
+        copy = clutter_paint_volume_copy (volume);
+
+      if (copy && old_box)
+        {
+          cairo_rectangle_int_t clip;
+
+          /* the child may have last been painted into a tile before the
+           * view scrolled, so Clutter doesn't know where its old area is on
+           * the stage any more */
+          clip.x = floorf (old_box->x1);
+          clip.y = floorf (old_box->y1);
+          clip.width = ceilf (old_box->x2) - clip.x;
+          clip.height = ceilf (old_box->y2) - clip.y;
+          clutter_actor_queue_redraw_with_clip (self, &clip);
+
+          mx_viewport_invalidate_tiles (MX_VIEWPORT (self), old_box);
+          clutter_paint_volume_get_bounding_box (copy, old_box);
+          mx_viewport_invalidate_tiles (MX_VIEWPORT (self), old_box);
+        }
+      else
+        {
+          mx_viewport_invalidate_tiles (MX_VIEWPORT (self), NULL);
+
+          if (copy)
+            {
+              old_box = g_slice_new (ClutterActorBox);
+              clutter_paint_volume_get_bounding_box (copy, old_box);
+              g_object_set_qdata_full (G_OBJECT (origin), redraw_box_quark,
+                                       old_box,
+                                       (GDestroyNotify) clutter_actor_box_free);
+            }
+        }
+
+      if (copy)
+        clutter_paint_volume_free (copy);
+    }
+
+  CLUTTER_ACTOR_CLASS (mx_viewport_parent_class)->queue_redraw (self, origin);
+}
+
 static void
 mx_viewport_allocate (ClutterActor          *self,
                       const ClutterActorBox *box,
@@ -231,6 +386,8 @@ mx_viewport_allocate (ClutterActor          *self,
   gfloat width, height;
   ClutterActorBox childbox;
 
+  MX_PROFILE_BEGIN (self, ALLOCATE);
+
   /* Chain up. */
   CLUTTER_ACTOR_CLASS (mx_viewport_parent_class)-> allocate (self, box, flags);
 
@@ -241,6 +398,12 @@ mx_viewport_allocate (ClutterActor          *self,
       clutter_actor_get_preferred_size (priv->child, NULL, &width, NULL,
                                         &height);
       clutter_actor_allocate (priv->child, &childbox, flags);
+
+      if (!clutter_actor_box_equal (&childbox, &priv->child_box))
+        {
+          priv->child_box = childbox;
+          mx_viewport_invalidate_tiles (MX_VIEWPORT (self), NULL);
+        }
     }
   else
     {
@@ -277,29 +440,8 @@ mx_viewport_allocate (ClutterActor          *self,
                         NULL);
         }
     }
-}
-
-static gboolean
-mx_viewport_get_paint_volume (ClutterActor       *actor,
-                              ClutterPaintVolume *volume)
-{
-  MxViewportPrivate *priv = MX_VIEWPORT (actor)->priv;
-  ClutterVertex vertex;
-
-  if (!clutter_paint_volume_set_from_allocation (volume, actor))
-    return FALSE;
-
-  clutter_paint_volume_get_origin (volume, &vertex);
-
-  if (priv->hadjustment)
-    vertex.x += mx_adjustment_get_value (priv->hadjustment);
-
-  if (priv->vadjustment)
-    vertex.y += mx_adjustment_get_value (priv->vadjustment);
-
-  clutter_paint_volume_set_origin (volume, &vertex);
 
-  return TRUE;
+  MX_PROFILE_END (self, ALLOCATE);
 }
 
 static void
@@ -324,27 +466,270 @@ mx_viewport_apply_transform (ClutterActor *actor,
   cogl_matrix_translate (matrix, (int) -x, (int) -y, 0);
 }
 
+/* paints (or picks) the child, unless it is scrolled out of view */
 static void
-mx_viewport_paint (ClutterActor *self)
+mx_viewport_paint_child (ClutterActor *self)
 {
   MxViewportPrivate *priv = ((MxViewport *) self)->priv;
+  ClutterActorBox view_b;
+
+  if (!priv->child)
+    return;
+
+  if (mx_widget_get_view_area (MX_WIDGET (self), &view_b) &&
+      !mx_widget_is_child_in_area (MX_WIDGET (self), priv->child, &view_b))
+    return;
+
+  clutter_actor_paint (priv->child);
+}
+
+/* paints the child into @tile, which is at @x_offset, @y_offset on the
+ * stage */
+static gboolean
+mx_viewport_paint_tile (MxViewport     *viewport,
+                        MxViewportTile *tile,
+                        gfloat          x_offset,
+                        gfloat          y_offset)
+{
+  MxViewportPrivate *priv = viewport->priv;
+  CoglMatrix modelview, projection;
+  float stage_viewport[4];
+  ClutterActorBox box;
+  CoglColor transparent;
+
+  if (!tile->fbo)
+    {
+      tile->texture = cogl_texture_new_with_size (TILE_SIZE, TILE_SIZE,
+                                                  COGL_TEXTURE_NO_SLICING |
+                                                  COGL_TEXTURE_NO_ATLAS,
+                                                  COGL_PIXEL_FORMAT_RGBA_8888_PRE);
+      if (tile->texture == COGL_INVALID_HANDLE)
+        return FALSE;
+
+      tile->fbo = cogl_offscreen_new_to_texture (tile->texture);
+      if (tile->fbo == COGL_INVALID_HANDLE)
+        {
+          cogl_handle_unref (tile->texture);
+          tile->texture = COGL_INVALID_HANDLE;
+          return FALSE;
+        }
+    }
+
+  box.x1 = tile->col * TILE_SIZE;
+  box.y1 = tile->row * TILE_SIZE;
+  box.x2 = box.x1 + TILE_SIZE;
+  box.y2 = box.y1 + TILE_SIZE;
+
+  cogl_color_set_from_4ub (&transparent, 0, 0, 0, 0);
+
+  /* paint with the transformation of the stage and move the viewport of
+   * the tile over it, as an offscreen effect does. Clutter then records
+   * the paint volumes of the descendants where they are on the stage, and
+   * clipped redraws of the child cover the right area. */
+  cogl_get_modelview_matrix (&modelview);
+  cogl_get_projection_matrix (&projection);
+  cogl_get_viewport (stage_viewport);
+
+  cogl_push_framebuffer (tile->fbo);
+  cogl_set_viewport (stage_viewport[0] - x_offset,
+                     stage_viewport[1] - y_offset,
+                     stage_viewport[2],
+                     stage_viewport[3]);
+  cogl_set_projection_matrix (&projection);
+  cogl_set_modelview_matrix (&modelview);
+  cogl_clear (&transparent, COGL_BUFFER_BIT_COLOR);
+
+  /* make the descendants cull against the tile rather than the view */
+  _mx_widget_set_view_area (MX_WIDGET (viewport), &box);
+  clutter_actor_paint (priv->child);
+  _mx_widget_set_view_area (MX_WIDGET (viewport), NULL);
+
+  cogl_pop_framebuffer ();
+
+  tile->valid = TRUE;
+
+  return TRUE;
+}
+
+static gboolean
+mx_viewport_paint_margin_cb (MxViewport *viewport)
+{
+  viewport->priv->margin_source = 0;
+
+  clutter_actor_queue_redraw (CLUTTER_ACTOR (viewport));
+
+  return FALSE;
+}
+
+/* paints the child through the tiles covering the view, painting the tiles
+ * that changed. The tiles in the view are painted straight away, those in
+ * the margin around it one per frame. Returns %FALSE, before compositing
+ * anything, if the child has to be painted directly. */
+static gboolean
+mx_viewport_paint_tiles (MxViewport *viewport)
+{
+  MxViewportPrivate *priv = viewport->priv;
+  gint first_col, first_row, last_col, last_row, col, row;
+  gboolean painted_margin = FALSE, pending_margin = FALSE;
+  GHashTableIter iter;
+  MxViewportTile *tile;
+  ClutterVertex origin = { 0, }, corner = { TILE_SIZE, TILE_SIZE, 0 };
+  gfloat x, y, width, height;
+  guint8 opacity, child_opacity;
+
+  if (!clutter_feature_available (CLUTTER_FEATURE_OFFSCREEN))
+    return FALSE;
+
+  if (!CLUTTER_ACTOR_IS_VISIBLE (priv->child))
+    return TRUE;
+
+  /* the tiles hold the child as painted in an opaque viewport, and are
+   * composited with the opacity of the viewport */
+  opacity = clutter_actor_get_paint_opacity (CLUTTER_ACTOR (viewport));
+  child_opacity = clutter_actor_get_opacity (priv->child);
+  if (child_opacity != priv->tiles_opacity)
+    {
+      priv->tiles_opacity = child_opacity;
+      mx_viewport_invalidate_tiles (viewport, NULL);
+    }
+
+  /* the view, in the coordinates of the child */
+  x = priv->hadjustment ? (gint) mx_adjustment_get_value (priv->hadjustment) : 0;
+  y = priv->vadjustment ? (gint) mx_adjustment_get_value (priv->vadjustment) : 0;
+  clutter_actor_get_size (CLUTTER_ACTOR (viewport), &width, &height);
+
+  /* the tiles are painted where they are on the stage, so they can only be
+   * used while the view isn't scaled or rotated */
+  clutter_actor_apply_transform_to_point (CLUTTER_ACTOR (viewport),
+                                          &origin, &origin);
+  clutter_actor_apply_transform_to_point (CLUTTER_ACTOR (viewport),
+                                          &corner, &corner);
+  if (fabsf (corner.x - origin.x - TILE_SIZE) > 0.5f ||
+      fabsf (corner.y - origin.y - TILE_SIZE) > 0.5f)
+    return FALSE;
+
+  /* repaint the tiles when the viewport moves on the stage, so that the
+   * paint volumes of the child follow it */
+  if (fabsf (origin.x + x - priv->tiles_x) > 0.5f ||
+      fabsf (origin.y + y - priv->tiles_y) > 0.5f)
+    {
+      priv->tiles_x = origin.x + x;
+      priv->tiles_y = origin.y + y;
+      mx_viewport_invalidate_tiles (viewport, NULL);
+    }
+
+  first_col = MAX (0, floorf (x / TILE_SIZE));
+  first_row = MAX (0, floorf (y / TILE_SIZE));
+  last_col = MAX (0, floorf ((x + width - 1) / TILE_SIZE));
+  last_row = MAX (0, floorf ((y + height - 1) / TILE_SIZE));
+
+  /* forget the tiles that scrolled away */
+  g_hash_table_iter_init (&iter, priv->tiles);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &tile))
+    {
+      if (tile->col < first_col - TILE_MARGIN ||
+          tile->col > last_col + TILE_MARGIN ||
+          tile->row < first_row - TILE_MARGIN ||
+          tile->row > last_row + TILE_MARGIN)
+        g_hash_table_iter_remove (&iter);
+    }
+
+  /* bring the tiles up to date before compositing any of them, so that the
+   * child can still be painted directly if one of them can't be painted */
+  for (row = MAX (0, first_row - TILE_MARGIN);
+       row <= last_row + TILE_MARGIN; row++)
+    for (col = MAX (0, first_col - TILE_MARGIN);
+         col <= last_col + TILE_MARGIN; col++)
+      {
+        gboolean visible = (row >= first_row && row <= last_row &&
+                            col >= first_col && col <= last_col);
+
+        tile = g_hash_table_lookup (priv->tiles, TILE_KEY (col, row));
+        if (!tile)
+          {
+            tile = g_slice_new0 (MxViewportTile);
+            tile->col = col;
+            tile->row = row;
+            g_hash_table_insert (priv->tiles, TILE_KEY (col, row), tile);
+          }
+
+        if (tile->valid)
+          continue;
+
+        /* the opacity of a translucent viewport would be painted into the
+         * tiles along with the child */
+        if (opacity != 0xff)
+          {
+            if (visible)
+              return FALSE;
+
+            continue;
+          }
+
+        if (!visible && painted_margin)
+          {
+            pending_margin = TRUE;
+            continue;
+          }
+
+        if (!mx_viewport_paint_tile (viewport, tile,
+                                     origin.x + col * TILE_SIZE,
+                                     origin.y + row * TILE_SIZE))
+          return FALSE;
+
+        if (!visible)
+          painted_margin = TRUE;
+      }
+
+  for (row = first_row; row <= last_row; row++)
+    for (col = first_col; col <= last_col; col++)
+      {
+        tile = g_hash_table_lookup (priv->tiles, TILE_KEY (col, row));
+        _mx_paint_texture_with_opacity (tile->texture, opacity,
+                                        col * TILE_SIZE, row * TILE_SIZE,
+                                        TILE_SIZE, TILE_SIZE);
+      }
+
+  /* keep painting the margin while the view is static */
+  if (pending_margin && !priv->margin_source)
+    priv->margin_source =
+      g_idle_add ((GSourceFunc) mx_viewport_paint_margin_cb, viewport);
+
+  return TRUE;
+}
+
+static void
+mx_viewport_paint (ClutterActor *self)
+{
+  MxViewportPrivate *priv = MX_VIEWPORT (self)->priv;
+
+  MX_PROFILE_BEGIN (self, PAINT);
 
   CLUTTER_ACTOR_CLASS (mx_viewport_parent_class)->paint (self);
 
-  if (priv->child)
-    clutter_actor_paint (priv->child);
+  if (priv->tiles && priv->child &&
+      mx_viewport_paint_tiles (MX_VIEWPORT (self)))
+    {
+      MX_PROFILE_END (self, PAINT);
+      return;
+    }
+
+  mx_viewport_paint_child (self);
+
+  MX_PROFILE_END (self, PAINT);
 }
 
 static void
 mx_viewport_pick (ClutterActor       *self,
                   const ClutterColor *color)
 {
-  MxViewportPrivate *priv = ((MxViewport *) self)->priv;
+  MX_PROFILE_BEGIN (self, PICK);
 
   CLUTTER_ACTOR_CLASS (mx_viewport_parent_class)->pick (self, color);
 
-  if (priv->child)
-    clutter_actor_paint (priv->child);
+  mx_viewport_paint_child (self);
+
+  MX_PROFILE_END (self, PICK);
 }
 
 static void
@@ -356,6 +741,8 @@ mx_viewport_get_preferred_width (ClutterActor *actor,
   MxViewportPrivate *priv = ((MxViewport *) actor)->priv;
   MxPadding padding;
 
+  MX_PROFILE_BEGIN (actor, PREFERRED_SIZE);
+
   mx_widget_get_padding (MX_WIDGET (actor), &padding);
 
   if (min_width)
@@ -377,6 +764,7 @@ mx_viewport_get_preferred_width (ClutterActor *actor,
   if (pref_width)
     *pref_width += padding.left + padding.right;
 
+  MX_PROFILE_END (actor, PREFERRED_SIZE);
 }
 
 static void
@@ -388,6 +776,8 @@ mx_viewport_get_preferred_height (ClutterActor *actor,
   MxViewportPrivate *priv = ((MxViewport *) actor)->priv;
   MxPadding padding;
 
+  MX_PROFILE_BEGIN (actor, PREFERRED_SIZE);
+
   mx_widget_get_padding (MX_WIDGET (actor), &padding);
 
   if (min_height)
@@ -408,6 +798,8 @@ mx_viewport_get_preferred_height (ClutterActor *actor,
 
   if (pref_height)
     *pref_height += padding.top + padding.bottom;
+
+  MX_PROFILE_END (actor, PREFERRED_SIZE);
 }
 
 static void
@@ -424,10 +816,10 @@ mx_viewport_class_init (MxViewportClass *klass)
   gobject_class->dispose = mx_viewport_dispose;
 
   actor_class->allocate = mx_viewport_allocate;
-  actor_class->get_paint_volume = mx_viewport_get_paint_volume;
   actor_class->apply_transform = mx_viewport_apply_transform;
   actor_class->paint = mx_viewport_paint;
   actor_class->pick = mx_viewport_pick;
+  actor_class->queue_redraw = mx_viewport_queue_redraw;
   actor_class->get_preferred_width = mx_viewport_get_preferred_width;
   actor_class->get_preferred_height = mx_viewport_get_preferred_height;
 
@@ -461,6 +853,24 @@ mx_viewport_class_init (MxViewportClass *klass)
                                 MX_PARAM_READWRITE);
   g_object_class_install_property (gobject_class, PROP_SYNC_ADJUST, pspec);
 
+  /**
+   * MxViewport:cache-content:
+   *
+   * Whether the child is painted into cached tiles, so that scrolling does
+   * not need to repaint it. This is best for large children that rarely
+   * change.
+   *
+   * Since: 2.0
+   */
+  pspec = g_param_spec_boolean ("cache-content",
+                                "Cache content",
+                                "Whether to cache the child in tiles",
+                                FALSE,
+                                MX_PARAM_READWRITE);
+  g_object_class_install_property (gobject_class, PROP_CACHE_CONTENT, pspec);
+
+  redraw_box_quark = g_quark_from_static_string ("mx-viewport-redraw-box");
+
   g_object_class_override_property (gobject_class,
                                     PROP_HADJUST,
                                     "horizontal-adjustment");
@@ -552,6 +962,9 @@ scrollable_set_adjustments (MxScrollable *scrollable,
       priv->vadjustment = vadjustment;
       g_object_notify (G_OBJECT (scrollable), "vertical-adjustment");
     }
+
+  _mx_widget_set_scroll_adjustments (MX_WIDGET (scrollable),
+                                     priv->hadjustment, priv->vadjustment);
 }
 
 static void
@@ -632,6 +1045,8 @@ mx_viewport_actor_added (ClutterActor *container,
     clutter_actor_remove_child (container, priv->child);
 
   priv->child = actor;
+
+  mx_viewport_invalidate_tiles (MX_VIEWPORT (container), NULL);
 }
 
 static void
@@ -641,7 +1056,12 @@ mx_viewport_actor_removed (ClutterActor *container,
   MxViewportPrivate *priv = MX_VIEWPORT (container)->priv;
 
   if (priv->child == actor)
-    priv->child = NULL;
+    {
+      priv->child = NULL;
+
+      if (priv->tiles)
+        g_hash_table_remove_all (priv->tiles);
+    }
 }
 
 
@@ -652,6 +1072,9 @@ mx_viewport_init (MxViewport *self)
 
   self->priv->sync_adjustments = TRUE;
 
+  /* cull the descendants against the scrolled view */
+  _mx_widget_set_scroll_adjustments (MX_WIDGET (self), NULL, NULL);
+
   g_object_set (G_OBJECT (self),
                 "reactive", FALSE,
                 "x-align", MX_ALIGN_START,
@@ -759,3 +1182,57 @@ mx_viewport_get_sync_adjustments (MxViewport *viewport)
   g_return_val_if_fail (MX_IS_VIEWPORT (viewport), FALSE);
   return viewport->priv->sync_adjustments;
 }
+
+/**
+ * mx_viewport_set_cache_content:
+ * @viewport: An #MxViewport
+ * @cache: %TRUE to cache the child in tiles
+ *
+ * Set the value of the #MxViewport:cache-content property.
+ *
+ * Since: 2.0
+ */
+void
+mx_viewport_set_cache_content (MxViewport *viewport,
+                               gboolean    cache)
+{
+  MxViewportPrivate *priv;
+
+  g_return_if_fail (MX_IS_VIEWPORT (viewport));
+
+  priv = viewport->priv;
+  if (priv->cache_content != cache)
+    {
+      priv->cache_content = cache;
+
+      if (cache)
+        priv->tiles =
+          g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL,
+                                 (GDestroyNotify) mx_viewport_tile_free);
+      else
+        {
+          g_hash_table_destroy (priv->tiles);
+          priv->tiles = NULL;
+        }
+
+      clutter_actor_queue_redraw (CLUTTER_ACTOR (viewport));
+      g_object_notify (G_OBJECT (viewport), "cache-content");
+    }
+}
+
+/**
+ * mx_viewport_get_cache_content:
+ * @viewport: An #MxViewport
+ *
+ * Get the value of the #MxViewport:cache-content property.
+ *
+ * Returns: %TRUE if the child is cached in tiles
+ *
+ * Since: 2.0
+ */
+gboolean
+mx_viewport_get_cache_content (MxViewport *viewport)
+{
+  g_return_val_if_fail (MX_IS_VIEWPORT (viewport), FALSE);
+  return viewport->priv->cache_content;
+}
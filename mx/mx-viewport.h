@@ -89,6 +89,10 @@ void mx_viewport_set_sync_adjustments (MxViewport *viewport,
                                        gboolean    sync);
 gboolean mx_viewport_get_sync_adjustments (MxViewport *viewport);
 
+void     mx_viewport_set_cache_content (MxViewport *viewport,
+                                        gboolean    cache);
+gboolean mx_viewport_get_cache_content (MxViewport *viewport);
+
 G_END_DECLS
 
 #endif /* __MX_VIEWPORT_H__ */
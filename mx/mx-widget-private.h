@@ -25,6 +25,7 @@
 #define __MX_WIDGET_PRIVATE_H__
 
 #include <mx-widget.h>
+#include <mx-adjustment.h>
 
 G_BEGIN_DECLS
 
@@ -36,6 +37,12 @@ gboolean _mx_widget_has_touch_sequence    (MxWidget             *widget,
                                            ClutterEventSequence *sequence);
 gboolean _mx_widget_has_touch_sequences   (MxWidget *widget);
 
+void     _mx_widget_set_scroll_adjustments (MxWidget     *widget,
+                                            MxAdjustment *hadjustment,
+                                            MxAdjustment *vadjustment);
+void     _mx_widget_set_view_area          (MxWidget              *widget,
+                                            const ClutterActorBox *area);
+
 G_END_DECLS
 
 #endif /* __MX_WIDGET_PRIVATE_H__ */
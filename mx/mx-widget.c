@@ -28,6 +28,7 @@
 #include "config.h"
 #endif
 
+#include <math.h>
 #include <stdlib.h>
 #include <string.h>
 #include <libintl.h>
@@ -47,30 +48,10 @@
 
 #include "mx-private.h"
 
-/*
- * Forward declaration for sake of MxWidgetChild
- */
-struct _MxWidgetPrivate
+/* state for tooltips, menus and input handling, which most widgets never
+ * use; allocated on first use */
+typedef struct
 {
-  MxPadding     border;
-  MxPadding     padding;
-
-  MxStyle       *style;
-  gchar         *pseudo_class;
-  gchar         *style_class;
-  MxBorderImage *mx_border_image;
-  MxBorderImage *mx_background_image;
-
-  CoglHandle      border_image;
-  CoglHandle      old_border_image;
-  CoglHandle      background_image;
-  ClutterActorBox background_image_box;
-  ClutterColor   *bg_color;
-  gfloat          opacity;
-
-  guint         is_disabled : 1;
-  guint         parent_disabled : 1;
-
   MxTooltip    *tooltip;
   MxMenu       *menu;
 
@@ -79,10 +60,13 @@ struct _MxWidgetPrivate
   guint         tooltip_timeout;
   guint         tooltip_delay;
 
-  guint         in_dispose;
-
   GHashTable   *sequences;
+} MxWidgetExtra;
 
+/* state saved while the style overrides the size, opacity or visibility;
+ * allocated on first use */
+typedef struct
+{
   /* width/height set by css */
   gfloat css_width;
   gfloat css_height;
@@ -103,6 +87,44 @@ struct _MxWidgetPrivate
 
   /* previous visible state if the "display" style property was set to "none" */
   gint old_visible;
+} MxWidgetCssState;
+
+/*
+ * Forward declaration for sake of MxWidgetChild
+ */
+struct _MxWidgetPrivate
+{
+  MxPadding     border;
+  MxPadding     padding;
+
+  MxStyle       *style;
+  gchar         *pseudo_class;
+  gchar         *style_class;
+  MxBorderImage *mx_border_image;
+  MxBorderImage *mx_background_image;
+
+  CoglHandle      border_image;
+  MxTextureFrameCache *border_image_cache;
+  CoglHandle      background_image;
+  ClutterActorBox background_image_box;
+  ClutterColor   *bg_color;
+  gfloat          opacity;
+
+  guint         is_disabled : 1;
+  guint         parent_disabled : 1;
+
+  MxWidgetExtra    *extra;
+  MxWidgetCssState *css;
+
+  /* adjustments that scroll the children, set by scrollable subclasses */
+  MxAdjustment *scroll_hadjustment;
+  MxAdjustment *scroll_vadjustment;
+  guint         scrolls : 1;
+
+  /* area painted instead of the scrolled view, while caching */
+  const ClutterActorBox *view_area;
+
+  guint         cull_children : 1;
 };
 
 /**
@@ -149,6 +171,8 @@ enum
 
   PROP_TOOLTIP_DELAY,
 
+  PROP_CULL_CHILDREN,
+
   LAST_PROP
 };
 
@@ -218,6 +242,10 @@ mx_widget_set_property (GObject      *gobject,
       mx_widget_set_tooltip_delay (actor, g_value_get_int (value));
       break;
 
+    case PROP_CULL_CHILDREN:
+      mx_widget_set_cull_children (actor, g_value_get_boolean (value));
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (gobject, prop_id, pspec);
       break;
@@ -263,12 +291,47 @@ mx_widget_get_property (GObject    *gobject,
       g_value_set_int (value, mx_widget_get_tooltip_delay (actor));
       break;
 
+    case PROP_CULL_CHILDREN:
+      g_value_set_boolean (value, priv->cull_children);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (gobject, prop_id, pspec);
       break;
     }
 }
 
+static MxWidgetExtra *
+mx_widget_get_extra (MxWidget *widget)
+{
+  MxWidgetPrivate *priv = widget->priv;
+
+  if (G_UNLIKELY (!priv->extra))
+    {
+      priv->extra = g_slice_new0 (MxWidgetExtra);
+      priv->extra->tooltip_delay = MX_WIDGET_TOOLTIP_TIMEOUT;
+    }
+
+  return priv->extra;
+}
+
+static MxWidgetCssState *
+mx_widget_get_css_state (MxWidget *widget)
+{
+  MxWidgetPrivate *priv = widget->priv;
+
+  if (G_UNLIKELY (!priv->css))
+    {
+      priv->css = g_slice_new0 (MxWidgetCssState);
+      priv->css->css_width = -1;
+      priv->css->css_height = -1;
+      priv->css->old_opacity = -1;
+      priv->css->old_visible = -1;
+    }
+
+  return priv->css;
+}
+
 static gboolean
 mx_widget_tooltip_timeout_cb (gpointer data)
 {
@@ -277,7 +340,7 @@ mx_widget_tooltip_timeout_cb (gpointer data)
 
   mx_widget_show_tooltip (self);
 
-  priv->tooltip_timeout = 0;
+  priv->extra->tooltip_timeout = 0;
 
   return FALSE;
 }
@@ -287,22 +350,22 @@ mx_widget_remove_tooltip_timeout (MxWidget *widget)
 {
   MxWidgetPrivate *priv = widget->priv;
 
-  if (priv->tooltip_timeout)
+  if (priv->extra && priv->extra->tooltip_timeout)
     {
-      g_source_remove (priv->tooltip_timeout);
-      priv->tooltip_timeout = 0;
+      g_source_remove (priv->extra->tooltip_timeout);
+      priv->extra->tooltip_timeout = 0;
     }
 }
 
 static void
 mx_widget_set_tooltip_timeout (MxWidget *widget)
 {
-  MxWidgetPrivate *priv = widget->priv;
+  MxWidgetExtra *extra = mx_widget_get_extra (widget);
 
   /* Remove any existing tooltip timeout so that we can start again */
   mx_widget_remove_tooltip_timeout (widget);
 
-  priv->tooltip_timeout =
+  extra->tooltip_timeout =
     clutter_threads_add_timeout (mx_widget_get_tooltip_delay (widget),
                                  mx_widget_tooltip_timeout_cb,
                                  widget);
@@ -328,10 +391,10 @@ mx_widget_dispose (GObject *gobject)
       priv->border_image = NULL;
     }
 
-  if (priv->old_border_image)
+  if (priv->border_image_cache)
     {
-      cogl_handle_unref (priv->old_border_image);
-      priv->old_border_image = NULL;
+      _mx_texture_frame_cache_free (priv->border_image_cache);
+      priv->border_image_cache = NULL;
     }
 
   if (priv->background_image)
@@ -340,18 +403,30 @@ mx_widget_dispose (GObject *gobject)
       priv->background_image = NULL;
     }
 
-  if (priv->tooltip)
+  if (priv->extra && priv->extra->tooltip)
     {
       clutter_actor_remove_child (CLUTTER_ACTOR (actor),
-                                  CLUTTER_ACTOR (priv->tooltip));
-      priv->tooltip = NULL;
+                                  CLUTTER_ACTOR (priv->extra->tooltip));
+      priv->extra->tooltip = NULL;
     }
 
-  if (priv->menu)
+  if (priv->extra && priv->extra->menu)
     {
       clutter_actor_remove_child (CLUTTER_ACTOR (actor),
-                                  CLUTTER_ACTOR (priv->menu));
-      priv->menu = NULL;
+                                  CLUTTER_ACTOR (priv->extra->menu));
+      priv->extra->menu = NULL;
+    }
+
+  if (priv->scroll_hadjustment)
+    {
+      g_object_unref (priv->scroll_hadjustment);
+      priv->scroll_hadjustment = NULL;
+    }
+
+  if (priv->scroll_vadjustment)
+    {
+      g_object_unref (priv->scroll_vadjustment);
+      priv->scroll_vadjustment = NULL;
     }
 
   G_OBJECT_CLASS (mx_widget_parent_class)->dispose (gobject);
@@ -379,10 +454,19 @@ mx_widget_finalize (GObject *gobject)
       priv->mx_background_image = NULL;
     }
 
-  if (priv->sequences)
+  if (priv->extra)
+    {
+      if (priv->extra->sequences)
+        g_hash_table_unref (priv->extra->sequences);
+
+      g_slice_free (MxWidgetExtra, priv->extra);
+      priv->extra = NULL;
+    }
+
+  if (priv->css)
     {
-      g_hash_table_unref (priv->sequences);
-      priv->sequences = NULL;
+      g_slice_free (MxWidgetCssState, priv->css);
+      priv->css = NULL;
     }
 
   clutter_color_free (priv->bg_color);
@@ -399,11 +483,13 @@ mx_widget_allocate (ClutterActor          *actor,
   ClutterActorClass *klass;
   ClutterActorBox frame_box = { 0, 0, box->x2 - box->x1, box->y2 - box->y1 };
 
+  MX_PROFILE_BEGIN (actor, ALLOCATE);
+
   klass = CLUTTER_ACTOR_CLASS (mx_widget_parent_class);
   klass->allocate (actor, box, flags);
 
   /* update tooltip position */
-  if (priv->tooltip)
+  if (priv->extra && priv->extra->tooltip)
     {
       ClutterVertex verts[4];
       ClutterGeometry area;
@@ -431,7 +517,7 @@ mx_widget_allocate (ClutterActor          *actor,
       area.width = x2 - x;
       area.height = y2 - y;
 
-      mx_tooltip_set_tip_area (priv->tooltip, &area);
+      mx_tooltip_set_tip_area (priv->extra->tooltip, &area);
     }
 
   if (priv->background_image)
@@ -486,12 +572,14 @@ mx_widget_allocate (ClutterActor          *actor,
       priv->background_image_box = frame_box;
     }
 
-  if (priv->tooltip)
-    clutter_actor_allocate_preferred_size (CLUTTER_ACTOR (priv->tooltip),
+  if (priv->extra && priv->extra->tooltip)
+    clutter_actor_allocate_preferred_size (CLUTTER_ACTOR (priv->extra->tooltip),
                                            flags);
-  if (priv->menu)
-    clutter_actor_allocate_preferred_size (CLUTTER_ACTOR (priv->menu),
+  if (priv->extra && priv->extra->menu)
+    clutter_actor_allocate_preferred_size (CLUTTER_ACTOR (priv->extra->menu),
                                            flags);
+
+  MX_PROFILE_END (actor, ALLOCATE);
 }
 
 static void
@@ -503,6 +591,8 @@ mx_widget_paint (ClutterActor *actor)
   gfloat width, height;
   guint alpha = clutter_actor_get_paint_opacity (actor);
 
+  MX_PROFILE_BEGIN (actor, PAINT);
+
   clutter_actor_get_allocation_box (actor, &allocation);
 
   width = allocation.x2 - allocation.x1;
@@ -521,13 +611,19 @@ mx_widget_paint (ClutterActor *actor)
     }
 
   if (priv->border_image)
-    mx_texture_frame_paint_texture (priv->border_image,
-                                    alpha,
-                                    priv->mx_border_image->top,
-                                    priv->mx_border_image->right,
-                                    priv->mx_border_image->bottom,
-                                    priv->mx_border_image->left,
-                                    width, height);
+    {
+      if (!priv->border_image_cache)
+        priv->border_image_cache = _mx_texture_frame_cache_new ();
+
+      _mx_texture_frame_paint_cached (priv->border_image_cache,
+                                      priv->border_image,
+                                      alpha,
+                                      priv->mx_border_image->top,
+                                      priv->mx_border_image->right,
+                                      priv->mx_border_image->bottom,
+                                      priv->mx_border_image->left,
+                                      width, height);
+    }
 
   if (priv->background_image)
     _mx_paint_texture_with_opacity (priv->background_image,
@@ -537,11 +633,16 @@ mx_widget_paint (ClutterActor *actor)
                                     priv->background_image_box.x2 - priv->background_image_box.x1,
                                     priv->background_image_box.y2 - priv->background_image_box.y1);
 
-  if (priv->tooltip)
-    clutter_actor_paint (CLUTTER_ACTOR (priv->tooltip));
+  if (priv->extra)
+    {
+      if (priv->extra->tooltip)
+        clutter_actor_paint (CLUTTER_ACTOR (priv->extra->tooltip));
+
+      if (priv->extra->menu)
+        clutter_actor_paint (CLUTTER_ACTOR (priv->extra->menu));
+    }
 
-  if (priv->menu)
-    clutter_actor_paint (CLUTTER_ACTOR (priv->menu));
+  MX_PROFILE_END (actor, PAINT);
 }
 
 static void
@@ -549,11 +650,14 @@ mx_widget_pick (ClutterActor *self, const ClutterColor *color)
 {
   MxWidgetPrivate *priv = MX_WIDGET (self)->priv;
 
+  MX_PROFILE_BEGIN (self, PICK);
+
   CLUTTER_ACTOR_CLASS (mx_widget_parent_class)->pick (self, color);
 
-  if (priv->menu)
-    clutter_actor_paint (CLUTTER_ACTOR (priv->menu));
+  if (priv->extra && priv->extra->menu)
+    clutter_actor_paint (CLUTTER_ACTOR (priv->extra->menu));
 
+  MX_PROFILE_END (self, PICK);
 }
 
 static void
@@ -561,6 +665,7 @@ mx_widget_style_changed (MxStylable *self, MxStyleChangedFlags flags)
 {
   MxWidgetPrivate *priv = MX_WIDGET (self)->priv;
   ClutterActor *actor = (ClutterActor *) self;
+  MxWidgetCssState *css;
   MxBorderImage *border_image = NULL, *background_image = NULL;
   MxTextureCache *texture_cache = mx_texture_cache_get_default ();
   MxPadding *padding = NULL;
@@ -573,6 +678,8 @@ mx_widget_style_changed (MxStylable *self, MxStyleChangedFlags flags)
   gfloat width = -1, height = -1;
   MxDisplayStyle display;
   MxVisibilityStyle visibility;
+  gboolean cache = FALSE;
+  ClutterEffect *cache_effect;
 
   /* cache these values for use in the paint function */
   mx_stylable_get (self,
@@ -586,6 +693,7 @@ mx_widget_style_changed (MxStylable *self, MxStyleChangedFlags flags)
                    "height", &height,
                    "display", &display,
                    "visibility", &visibility,
+                   "x-mx-cache", &cache,
                    NULL);
 
   if (color)
@@ -617,70 +725,80 @@ mx_widget_style_changed (MxStylable *self, MxStyleChangedFlags flags)
       has_changed = TRUE;
     }
 
+  /* the previous state only needs saving once the style overrides it */
+  if (width > -1 || height > -1 ||
+      visibility == MX_VISIBILITY_STYLE_HIDDEN ||
+      display == MX_DISPLAY_STYLE_NONE)
+    css = mx_widget_get_css_state (MX_WIDGET (self));
+  else
+    css = priv->css;
+
   /* check if css height has been requested */
   if (height > -1)
     {
       /* check if the height was previously set from css */
-      if (priv->css_height == -1)
+      if (css->css_height == -1)
         {
           /* store the old state before setting the css height */
 
           g_object_get (self,
-                        "min-height", &priv->old_min_height,
-                        "min-height-set", &priv->old_min_height_set,
-                        "natural-height", &priv->old_nat_height,
-                        "natural-height-set", &priv->old_nat_height_set,
+                        "min-height", &css->old_min_height,
+                        "min-height-set", &css->old_min_height_set,
+                        "natural-height", &css->old_nat_height,
+                        "natural-height-set", &css->old_nat_height_set,
                         NULL);
         }
       clutter_actor_set_height (CLUTTER_ACTOR (self), height);
     }
-  else if (priv->css_height != -1)
+  else if (css && css->css_height != -1)
     {
       /* no css height to set and css height was previously set, so restore the
        * saved state */
 
       g_object_set (self,
-                    "min-height", priv->old_min_height,
-                    "min-height-set", priv->old_min_height_set,
-                    "natural-height", priv->old_nat_height,
-                    "natural-height-set", priv->old_nat_height_set,
+                    "min-height", css->old_min_height,
+                    "min-height-set", css->old_min_height_set,
+                    "natural-height", css->old_nat_height,
+                    "natural-height-set", css->old_nat_height_set,
                     NULL);
     }
   /* store the css height set (-1 means not set) */
-  priv->css_height = height;
+  if (css)
+    css->css_height = height;
 
 
   /* check if css width has been requested */
   if (width > -1)
     {
       /* check if the width was previously set from css */
-      if (priv->css_width == -1)
+      if (css->css_width == -1)
         {
           /* store the old state before setting the css width */
 
           g_object_get (self,
-                        "min-width", &priv->old_min_width,
-                        "min-width-set", &priv->old_min_width_set,
-                        "natural-width", &priv->old_nat_width,
-                        "natural-width-set", &priv->old_nat_width_set,
+                        "min-width", &css->old_min_width,
+                        "min-width-set", &css->old_min_width_set,
+                        "natural-width", &css->old_nat_width,
+                        "natural-width-set", &css->old_nat_width_set,
                         NULL);
         }
       clutter_actor_set_width (CLUTTER_ACTOR (self), width);
     }
-  else if (priv->css_width != -1)
+  else if (css && css->css_width != -1)
     {
       /* no css width to set and css width was previously set, so restore the
        * saved state */
 
       g_object_set (self,
-                    "min-width", priv->old_min_width,
-                    "min-width-set", priv->old_min_width_set,
-                    "natural-width", priv->old_nat_width,
-                    "natural-width-set", priv->old_nat_width_set,
+                    "min-width", css->old_min_width,
+                    "min-width-set", css->old_min_width_set,
+                    "natural-width", css->old_nat_width,
+                    "natural-width-set", css->old_nat_width_set,
                     NULL);
     }
   /* store the css width set (-1 means not set) */
-  priv->css_width = width;
+  if (css)
+    css->css_width = width;
 
 
   /* padding */
@@ -729,6 +847,9 @@ mx_widget_style_changed (MxStylable *self, MxStyleChangedFlags flags)
       cogl_handle_unref (priv->border_image);
 
       priv->border_image = NULL;
+
+      _mx_texture_frame_cache_free (priv->border_image_cache);
+      priv->border_image_cache = NULL;
     }
 
   /* apply the new border-image, as long as there is a valid URI */
@@ -800,8 +921,8 @@ mx_widget_style_changed (MxStylable *self, MxStyleChangedFlags flags)
   /* visibility */
   if (visibility == MX_VISIBILITY_STYLE_HIDDEN)
     {
-      if (priv->old_opacity == -1)
-        priv->old_opacity = clutter_actor_get_opacity (actor);
+      if (css->old_opacity == -1)
+        css->old_opacity = clutter_actor_get_opacity (actor);
 
       clutter_actor_set_opacity (actor, 0);
     }
@@ -809,35 +930,43 @@ mx_widget_style_changed (MxStylable *self, MxStyleChangedFlags flags)
     {
       /* if visibility has been set previously, restore the old opacity or set
        * it to the current css opacity value */
-      if (priv->old_opacity > -1)
+      if (css && css->old_opacity > -1)
         {
           if (opacity < 0)
-            clutter_actor_set_opacity (actor, priv->old_opacity);
+            clutter_actor_set_opacity (actor, css->old_opacity);
           else
             clutter_actor_set_opacity (actor, opacity * 255);
 
-          priv->old_opacity = -1;
+          css->old_opacity = -1;
         }
     }
 
   /* display */
   if (display == MX_DISPLAY_STYLE_NONE)
     {
-      if (priv->old_visible == -1)
-        priv->old_visible = (CLUTTER_ACTOR_IS_VISIBLE (actor)) ? 1 : 0;
+      if (css->old_visible == -1)
+        css->old_visible = (CLUTTER_ACTOR_IS_VISIBLE (actor)) ? 1 : 0;
 
       clutter_actor_hide (actor);
     }
-  else
+  else if (css)
     {
       /* if display has been set to none previously and the actor was visible
        * when it was set, show the actor again */
-      if (priv->old_visible == 1)
+      if (css->old_visible == 1)
         clutter_actor_show (actor);
 
-      priv->old_visible = -1;
+      css->old_visible = -1;
     }
 
+  /* cache */
+  cache_effect = clutter_actor_get_effect (actor, "mx-cache");
+  if (cache && !cache_effect)
+    clutter_actor_add_effect_with_name (actor, "mx-cache",
+                                        mx_cache_effect_new ());
+  else if (!cache && MX_IS_CACHE_EFFECT (cache_effect))
+    clutter_actor_remove_effect (actor, cache_effect);
+
   /* If there are any properties above that need to cause a relayout thay
    * should set this flag.
    */
@@ -893,7 +1022,8 @@ mx_widget_motion (ClutterActor       *actor,
   MxWidget *widget = MX_WIDGET (actor);
   MxWidgetPrivate *priv = widget->priv;
 
-  if (priv->tooltip && !CLUTTER_ACTOR_IS_VISIBLE (priv->tooltip))
+  if (priv->extra && priv->extra->tooltip &&
+      !CLUTTER_ACTOR_IS_VISIBLE (priv->extra->tooltip))
     {
       /* If tooltips are in browse mode then display the tooltip immediately */
       if (mx_tooltip_is_in_browse_mode ())
@@ -912,7 +1042,7 @@ mx_widget_emit_long_press (MxWidget *widget)
 
   g_signal_emit (widget, widget_signals[LONG_PRESS], 0,
                  0.0, 0.0, MX_LONG_PRESS_ACTION, &result);
-  widget->priv->long_press_source = 0;
+  widget->priv->extra->long_press_source = 0;
 
   return FALSE;
 }
@@ -928,7 +1058,6 @@ void
 mx_widget_long_press_query (MxWidget           *widget,
                             ClutterEvent       *event)
 {
-  MxWidgetPrivate *priv = widget->priv;
   gboolean query_result = FALSE;
   MxSettings *settings = mx_settings_get_default ();
   guint timeout;
@@ -955,9 +1084,8 @@ mx_widget_long_press_query (MxWidget           *widget,
     }
 
   if (query_result)
-    priv->long_press_source = g_timeout_add (timeout,
-                                             (GSourceFunc) mx_widget_emit_long_press,
-                                             widget);
+    mx_widget_get_extra (widget)->long_press_source =
+      g_timeout_add (timeout, (GSourceFunc) mx_widget_emit_long_press, widget);
 }
 
 /**
@@ -972,12 +1100,12 @@ mx_widget_long_press_cancel (MxWidget *widget)
 {
   MxWidgetPrivate *priv = widget->priv;
 
-  if (priv->long_press_source)
+  if (priv->extra && priv->extra->long_press_source)
     {
       gboolean result;
 
-      g_source_remove (priv->long_press_source);
-      priv->long_press_source = 0;
+      g_source_remove (priv->extra->long_press_source);
+      priv->extra->long_press_source = 0;
       g_signal_emit (widget, widget_signals[LONG_PRESS], 0,
                      0.0, 0.0, MX_LONG_PRESS_CANCEL, &result);
     }
@@ -1157,13 +1285,60 @@ static gboolean
 mx_widget_get_paint_volume (ClutterActor       *actor,
                             ClutterPaintVolume *volume)
 {
-  /* the allocation of scrollable widgets cannot be used as the paint volume
-   * because it does not account for any transformations applied during
-   * scrolling */
-  if (MX_IS_SCROLLABLE (actor))
+  MxWidgetPrivate *priv = MX_WIDGET (actor)->priv;
+  ClutterActorIter iter;
+  ClutterActor *child;
+  gboolean scrolled;
+
+  if (!clutter_paint_volume_set_from_allocation (volume, actor))
     return FALSE;
 
-  return clutter_paint_volume_set_from_allocation (volume, actor);
+  /* scrollable widgets are translated by the scroll offset when painted, so
+   * move the allocation by it to cover the area in view */
+  scrolled = priv->scrolls &&
+    (priv->scroll_hadjustment || priv->scroll_vadjustment);
+
+  if (scrolled)
+    {
+      ClutterVertex origin;
+
+      clutter_paint_volume_get_origin (volume, &origin);
+
+      if (priv->scroll_hadjustment)
+        origin.x += mx_adjustment_get_value (priv->scroll_hadjustment);
+      if (priv->scroll_vadjustment)
+        origin.y += mx_adjustment_get_value (priv->scroll_vadjustment);
+
+      clutter_paint_volume_set_origin (volume, &origin);
+    }
+
+  /* add the children that paint outside the allocation. The tooltip and
+   * menu are painted above the stage, but only once this widget has
+   * painted them to find their position, so they must be included too. */
+  clutter_actor_iter_init (&iter, actor);
+  while (clutter_actor_iter_next (&iter, &child))
+    {
+      const ClutterPaintVolume *child_volume;
+
+      if (!CLUTTER_ACTOR_IS_VISIBLE (child))
+        continue;
+
+      /* the content of a scrolled widget is clipped to the view by the
+       * scroll view */
+      if (scrolled &&
+          !(priv->extra &&
+            (child == (ClutterActor *) priv->extra->tooltip ||
+             child == (ClutterActor *) priv->extra->menu)))
+        continue;
+
+      child_volume = clutter_actor_get_transformed_paint_volume (child, actor);
+      if (!child_volume)
+        return FALSE;
+
+      clutter_paint_volume_union (volume, child_volume);
+    }
+
+  return TRUE;
 }
 
 static void
@@ -1174,6 +1349,8 @@ mx_widget_class_init (MxWidgetClass *klass)
 
   g_type_class_add_private (klass, sizeof (MxWidgetPrivate));
 
+  _mx_profiler_init ();
+
   gobject_class->set_property = mx_widget_set_property;
   gobject_class->get_property = mx_widget_get_property;
   gobject_class->dispose = mx_widget_dispose;
@@ -1258,6 +1435,26 @@ mx_widget_class_init (MxWidgetClass *klass)
   g_object_class_install_property (gobject_class, PROP_TOOLTIP_DELAY,
                                    widget_properties[PROP_TOOLTIP_DELAY]);
 
+  /**
+   * MxWidget:cull-children:
+   *
+   * Whether children that are scrolled out of view are skipped when
+   * painting and picking. Culling uses the allocation of the children, so
+   * this should be disabled if the children have transforms or effects
+   * that paint outside their allocation.
+   *
+   * Since: 2.0
+   */
+  widget_properties[PROP_CULL_CHILDREN] =
+    g_param_spec_boolean ("cull-children",
+                          "Cull children",
+                          "Whether children scrolled out of view are "
+                          "skipped when painting",
+                          TRUE,
+                          MX_PARAM_READWRITE);
+  g_object_class_install_property (gobject_class, PROP_CULL_CHILDREN,
+                                   widget_properties[PROP_CULL_CHILDREN]);
+
   /**
    * MxWidget::long-press:
    * @widget: the object that received the signal
@@ -1482,6 +1679,14 @@ mx_stylable_iface_init (MxStylableIface *iface)
                                  G_PARAM_READWRITE);
       mx_stylable_iface_install_property (iface, MX_TYPE_WIDGET, pspec);
 
+      pspec = g_param_spec_boolean ("x-mx-cache",
+                                    "Cache",
+                                    "Whether to paint the widget from a "
+                                    "cached texture while it is unchanged",
+                                    FALSE,
+                                    G_PARAM_READWRITE);
+      mx_stylable_iface_install_property (iface, MX_TYPE_WIDGET, pspec);
+
       /*
       pspec = g_param_spec_uint ("x-mx-transition-duration",
                                  "transition duration",
@@ -1515,11 +1720,7 @@ mx_widget_init (MxWidget *actor)
 {
   actor->priv = MX_WIDGET_GET_PRIVATE (actor);
 
-  actor->priv->css_width = -1;
-  actor->priv->css_height = -1;
-
-  actor->priv->old_opacity = -1;
-  actor->priv->old_visible = -1;
+  actor->priv->cull_children = TRUE;
 
   /* set the default style */
   mx_stylable_set_style (MX_STYLABLE (actor), mx_style_get_default ());
@@ -1596,22 +1797,25 @@ mx_widget_set_has_tooltip (MxWidget *widget,
 
   if (has_tooltip)
     {
+      MxWidgetExtra *extra = mx_widget_get_extra (widget);
+
       clutter_actor_set_reactive (actor, TRUE);
 
-      if (!priv->tooltip)
+      if (!extra->tooltip)
         {
-          priv->tooltip = g_object_new (MX_TYPE_TOOLTIP, NULL);
-          clutter_actor_add_child (actor, CLUTTER_ACTOR (priv->tooltip));
+          extra->tooltip = g_object_new (MX_TYPE_TOOLTIP, NULL);
+          clutter_actor_add_child (actor, CLUTTER_ACTOR (extra->tooltip));
           if (mx_stylable_style_pseudo_class_contains (MX_STYLABLE (widget), "hover"))
             mx_widget_show_tooltip (widget);
         }
     }
   else
     {
-      if (priv->tooltip)
+      if (priv->extra && priv->extra->tooltip)
         {
-          clutter_actor_remove_child (actor, CLUTTER_ACTOR (priv->tooltip));
-          priv->tooltip = NULL;
+          clutter_actor_remove_child (actor,
+                                      CLUTTER_ACTOR (priv->extra->tooltip));
+          priv->extra->tooltip = NULL;
         }
 
       mx_widget_remove_tooltip_timeout (widget);
@@ -1640,8 +1844,8 @@ mx_widget_set_tooltip_text (MxWidget    *widget,
 
   priv = widget->priv;
 
-  if (priv->tooltip)
-    old_text = mx_tooltip_get_text (priv->tooltip);
+  if (priv->extra && priv->extra->tooltip)
+    old_text = mx_tooltip_get_text (priv->extra->tooltip);
   else
     old_text = NULL;
 
@@ -1655,8 +1859,8 @@ mx_widget_set_tooltip_text (MxWidget    *widget,
   else
     mx_widget_set_has_tooltip (widget, TRUE);
 
-  if (priv->tooltip)
-    mx_tooltip_set_text (priv->tooltip, text);
+  if (priv->extra && priv->extra->tooltip)
+    mx_tooltip_set_text (priv->extra->tooltip, text);
 
   g_object_notify_by_pspec (G_OBJECT (widget),
                             widget_properties[PROP_TOOLTIP_TEXT]);
@@ -1678,10 +1882,10 @@ mx_widget_get_tooltip_text (MxWidget *widget)
   g_return_val_if_fail (MX_IS_WIDGET (widget), NULL);
   priv = widget->priv;
 
-  if (!priv->tooltip)
+  if (!priv->extra || !priv->extra->tooltip)
     return NULL;
 
-  return mx_tooltip_get_text (widget->priv->tooltip);
+  return mx_tooltip_get_text (priv->extra->tooltip);
 }
 
 /**
@@ -1730,10 +1934,10 @@ mx_widget_show_tooltip (MxWidget *widget)
   area.height = y2 - y;
 
 
-  if (widget->priv->tooltip)
+  if (widget->priv->extra && widget->priv->extra->tooltip)
     {
-      mx_tooltip_set_tip_area (widget->priv->tooltip, &area);
-      mx_tooltip_show (widget->priv->tooltip);
+      mx_tooltip_set_tip_area (widget->priv->extra->tooltip, &area);
+      mx_tooltip_show (widget->priv->extra->tooltip);
     }
 }
 
@@ -1751,8 +1955,8 @@ mx_widget_hide_tooltip (MxWidget *widget)
 
   mx_widget_remove_tooltip_timeout (widget);
 
-  if (widget->priv->tooltip)
-    mx_tooltip_hide (widget->priv->tooltip);
+  if (widget->priv->extra && widget->priv->extra->tooltip)
+    mx_tooltip_hide (widget->priv->extra->tooltip);
 }
 
 /**
@@ -1794,15 +1998,15 @@ mx_widget_set_menu (MxWidget *widget,
 {
   MxWidgetPrivate *priv = widget->priv;
 
-  if (priv->menu)
+  if (priv->extra && priv->extra->menu)
     {
-      clutter_actor_destroy (CLUTTER_ACTOR (priv->menu));
-      priv->menu = NULL;
+      clutter_actor_destroy (CLUTTER_ACTOR (priv->extra->menu));
+      priv->extra->menu = NULL;
     }
 
   if (menu)
     {
-      priv->menu = menu;
+      mx_widget_get_extra (widget)->menu = menu;
       clutter_actor_add_child (CLUTTER_ACTOR (widget), CLUTTER_ACTOR (menu));
     }
 
@@ -1820,7 +2024,7 @@ mx_widget_set_menu (MxWidget *widget,
 MxMenu *
 mx_widget_get_menu (MxWidget *widget)
 {
-  return widget->priv->menu;
+  return widget->priv->extra ? widget->priv->extra->menu : NULL;
 }
 
 /**
@@ -1892,9 +2096,11 @@ mx_widget_set_tooltip_delay (MxWidget *widget,
 {
   g_return_if_fail (MX_IS_WIDGET (widget));
 
-  if (widget->priv->tooltip_delay != delay)
+  /* "tooltip-delay" is set at construction, so only store delays other than
+   * the default */
+  if (mx_widget_get_tooltip_delay (widget) != delay)
     {
-      widget->priv->tooltip_delay = delay;
+      mx_widget_get_extra (widget)->tooltip_delay = delay;
       g_object_notify_by_pspec (G_OBJECT (widget),
                                 widget_properties[PROP_TOOLTIP_DELAY]);
     }
@@ -1913,7 +2119,214 @@ mx_widget_get_tooltip_delay (MxWidget *widget)
 {
   g_return_val_if_fail (MX_IS_WIDGET (widget), 0);
 
-  return widget->priv->tooltip_delay;
+  if (!widget->priv->extra)
+    return MX_WIDGET_TOOLTIP_TIMEOUT;
+
+  return widget->priv->extra->tooltip_delay;
+}
+
+/**
+ * mx_widget_set_cull_children:
+ * @widget: an #MxWidget
+ * @cull: %TRUE to skip children that are out of view
+ *
+ * Set the value of the #MxWidget:cull-children property.
+ *
+ * Since: 2.0
+ */
+void
+mx_widget_set_cull_children (MxWidget *widget,
+                             gboolean  cull)
+{
+  g_return_if_fail (MX_IS_WIDGET (widget));
+
+  if (widget->priv->cull_children != cull)
+    {
+      widget->priv->cull_children = cull;
+      g_object_notify_by_pspec (G_OBJECT (widget),
+                                widget_properties[PROP_CULL_CHILDREN]);
+      clutter_actor_queue_redraw (CLUTTER_ACTOR (widget));
+    }
+}
+
+/**
+ * mx_widget_get_cull_children:
+ * @widget: an #MxWidget
+ *
+ * Get the value of the #MxWidget:cull-children property.
+ *
+ * Returns: %TRUE if children out of view are skipped when painting
+ *
+ * Since: 2.0
+ */
+gboolean
+mx_widget_get_cull_children (MxWidget *widget)
+{
+  g_return_val_if_fail (MX_IS_WIDGET (widget), TRUE);
+
+  return widget->priv->cull_children;
+}
+
+/**
+ * mx_widget_get_view_area:
+ * @widget: an #MxWidget
+ * @area: (out): return location for the visible area
+ *
+ * Gets the area of @widget, in the coordinates its children are allocated
+ * in, that is visible through the nearest scrolling widget. This is either
+ * @widget itself, if it implements #MxScrollable, or an ancestor such as an
+ * #MxViewport.
+ *
+ * If there is no scrolling widget, if an actor between @widget and the
+ * scrolling widget is rotated or scaled, or if #MxWidget:cull-children is
+ * %FALSE, the visible area is not known and %FALSE is returned. In that
+ * case, all the children should be painted. This function should normally
+ * only be used by subclasses.
+ *
+ * Returns: %TRUE if @area was set
+ *
+ * Since: 2.0
+ */
+gboolean
+mx_widget_get_view_area (MxWidget        *widget,
+                         ClutterActorBox *area)
+{
+  ClutterActor *actor;
+  gfloat x, y;
+
+  g_return_val_if_fail (MX_IS_WIDGET (widget), FALSE);
+  g_return_val_if_fail (area != NULL, FALSE);
+
+  if (!widget->priv->cull_children)
+    return FALSE;
+
+  /* the position of the children of widget in the children of actor */
+  x = y = 0;
+
+  actor = CLUTTER_ACTOR (widget);
+  while (actor)
+    {
+      ClutterActorBox box;
+
+      clutter_actor_get_allocation_box (actor, &box);
+
+      if (MX_IS_WIDGET (actor) && MX_WIDGET (actor)->priv->scrolls)
+        {
+          MxWidgetPrivate *priv = MX_WIDGET (actor)->priv;
+          gfloat scroll_x, scroll_y;
+
+          if (priv->view_area)
+            {
+              area->x1 = priv->view_area->x1 - x;
+              area->y1 = priv->view_area->y1 - y;
+              area->x2 = priv->view_area->x2 - x;
+              area->y2 = priv->view_area->y2 - y;
+
+              return TRUE;
+            }
+
+          scroll_x = priv->scroll_hadjustment ?
+            mx_adjustment_get_value (priv->scroll_hadjustment) : 0;
+          scroll_y = priv->scroll_vadjustment ?
+            mx_adjustment_get_value (priv->scroll_vadjustment) : 0;
+
+          area->x1 = scroll_x - x;
+          area->y1 = scroll_y - y;
+          area->x2 = area->x1 + (box.x2 - box.x1);
+          area->y2 = area->y1 + (box.y2 - box.y1);
+
+          return TRUE;
+        }
+
+      if (clutter_actor_is_rotated (actor) || clutter_actor_is_scaled (actor))
+        return FALSE;
+
+      x += box.x1;
+      y += box.y1;
+
+      actor = clutter_actor_get_parent (actor);
+    }
+
+  return FALSE;
+}
+
+/* whether the transformation of @child is only the offset of its
+ * allocation, @child_b */
+static gboolean
+mx_widget_child_is_untransformed (ClutterActor          *child,
+                                  const ClutterActorBox *child_b)
+{
+  CoglMatrix m;
+
+  cogl_matrix_init_identity (&m);
+  clutter_actor_get_transform (child, &m);
+
+  return (m.xx == 1.f && m.yx == 0.f && m.zx == 0.f && m.wx == 0.f &&
+          m.xy == 0.f && m.yy == 1.f && m.zy == 0.f && m.wy == 0.f &&
+          m.xz == 0.f && m.yz == 0.f && m.zz == 1.f && m.wz == 0.f &&
+          m.zw == 0.f && m.ww == 1.f &&
+          fabsf (m.xw - child_b->x1) < 0.001f &&
+          fabsf (m.yw - child_b->y1) < 0.001f);
+}
+
+/**
+ * mx_widget_is_child_in_area:
+ * @widget: an #MxWidget
+ * @child: a visible child of @widget
+ * @area: an area returned by mx_widget_get_view_area()
+ *
+ * Checks whether @child paints within @area. The allocation of @child is
+ * used, unless @child has any transformation besides the offset of its
+ * allocation (a rotation, scale, translation, anchor point or custom
+ * transform) or effects, which may paint outside of it. In that case its
+ * transformed paint volume is used instead, and @child is always painted if
+ * it doesn't have one. This function should normally only be used by
+ * subclasses.
+ *
+ * Returns: %TRUE if @child should be painted
+ *
+ * Since: 2.0
+ */
+gboolean
+mx_widget_is_child_in_area (MxWidget              *widget,
+                            ClutterActor          *child,
+                            const ClutterActorBox *area)
+{
+  const ClutterPaintVolume *volume;
+  ClutterPaintVolume *copy;
+  ClutterActorBox child_b;
+
+  g_return_val_if_fail (MX_IS_WIDGET (widget) && CLUTTER_IS_ACTOR (child),
+                        TRUE);
+  g_return_val_if_fail (area != NULL, TRUE);
+
+  clutter_actor_get_allocation_box (child, &child_b);
+
+  if ((child_b.x1 < area->x2) &&
+      (child_b.x2 > area->x1) &&
+      (child_b.y1 < area->y2) &&
+      (child_b.y2 > area->y1))
+    return TRUE;
+
+  if (!clutter_actor_has_effects (child) &&
+      mx_widget_child_is_untransformed (child, &child_b))
+    return FALSE;
+
+  volume = clutter_actor_get_transformed_paint_volume (child,
+                                                       CLUTTER_ACTOR (widget));
+  if (!volume)
+    return TRUE;
+
+  /* the volume belongs to Clutter, and getting its bounding box may
+   * complete it */
+  copy = clutter_paint_volume_copy (volume);
+  clutter_paint_volume_get_bounding_box (copy, &child_b);
+  clutter_paint_volume_free (copy);
+
+  return ((child_b.x1 < area->x2) &&
+          (child_b.x2 > area->x1) &&
+          (child_b.y1 < area->y2) &&
+          (child_b.y2 > area->y1));
 }
 
 /* Support translateable strings from JSON */
@@ -1959,17 +2372,19 @@ void
 _mx_widget_add_touch_sequence (MxWidget             *widget,
                                ClutterEventSequence *sequence)
 {
-  MxWidgetPrivate *priv = widget->priv;
+  MxWidgetExtra *extra;
 
   if (sequence == NULL)
     return;
 
-  if (!priv->sequences)
-    priv->sequences = g_hash_table_new_full (g_direct_hash,
-                                             g_direct_equal,
-                                             NULL, NULL);
+  extra = mx_widget_get_extra (widget);
+
+  if (!extra->sequences)
+    extra->sequences = g_hash_table_new_full (g_direct_hash,
+                                              g_direct_equal,
+                                              NULL, NULL);
 
-  g_hash_table_add (priv->sequences, sequence);
+  g_hash_table_add (extra->sequences, sequence);
 }
 
 void
@@ -1981,8 +2396,8 @@ _mx_widget_remove_touch_sequence (MxWidget             *widget,
   if (sequence == NULL)
     return;
 
-  if (priv->sequences)
-    g_hash_table_remove (priv->sequences, sequence);
+  if (priv->extra && priv->extra->sequences)
+    g_hash_table_remove (priv->extra->sequences, sequence);
 }
 
 gboolean
@@ -1994,8 +2409,8 @@ _mx_widget_has_touch_sequence (MxWidget             *widget,
   if (sequence == NULL)
     return TRUE;
 
-  if (priv->sequences)
-    return g_hash_table_contains (priv->sequences, sequence);
+  if (priv->extra && priv->extra->sequences)
+    return g_hash_table_contains (priv->extra->sequences, sequence);
 
   return FALSE;
 }
@@ -2006,9 +2421,42 @@ _mx_widget_has_touch_sequences (MxWidget *widget)
 
   MxWidgetPrivate *priv = widget->priv;
 
-  if (priv->sequences)
-    return g_hash_table_size (priv->sequences) != 0;
+  if (priv->extra && priv->extra->sequences)
+    return g_hash_table_size (priv->extra->sequences) != 0;
 
   return FALSE;
 
 }
+
+/* Called by scrollable subclasses whenever their adjustments change, so that
+ * the children of their descendants can be culled */
+void
+_mx_widget_set_scroll_adjustments (MxWidget     *widget,
+                                   MxAdjustment *hadjustment,
+                                   MxAdjustment *vadjustment)
+{
+  MxWidgetPrivate *priv = widget->priv;
+
+  priv->scrolls = TRUE;
+
+  if (hadjustment)
+    g_object_ref (hadjustment);
+  if (priv->scroll_hadjustment)
+    g_object_unref (priv->scroll_hadjustment);
+  priv->scroll_hadjustment = hadjustment;
+
+  if (vadjustment)
+    g_object_ref (vadjustment);
+  if (priv->scroll_vadjustment)
+    g_object_unref (priv->scroll_vadjustment);
+  priv->scroll_vadjustment = vadjustment;
+}
+
+/* Overrides the visible area of a scrolling widget, in the coordinates of its
+ * children, while it paints them somewhere other than the scrolled view. */
+void
+_mx_widget_set_view_area (MxWidget              *widget,
+                          const ClutterActorBox *area)
+{
+  widget->priv->view_area = area;
+}
@@ -122,6 +122,10 @@ void mx_widget_long_press_cancel (MxWidget           *widget);
 void   mx_widget_set_tooltip_delay (MxWidget *widget, guint delay);
 guint  mx_widget_get_tooltip_delay (MxWidget *widget);
 
+void     mx_widget_set_cull_children (MxWidget *widget,
+                                      gboolean  cull);
+gboolean mx_widget_get_cull_children (MxWidget *widget);
+
 /* Only to be used by sub-classes of MxWidget */
 ClutterColor *mx_widget_get_background_color (MxWidget  *actor);
 CoglHandle    mx_widget_get_background_texture (MxWidget *actor);
@@ -132,6 +136,11 @@ void          mx_widget_apply_style          (MxWidget  *widget,
 void          mx_widget_get_available_area   (MxWidget              *widget,
                                               const ClutterActorBox *allocation,
                                               ClutterActorBox       *area);
+gboolean      mx_widget_get_view_area        (MxWidget              *widget,
+                                              ClutterActorBox       *area);
+gboolean      mx_widget_is_child_in_area     (MxWidget              *widget,
+                                              ClutterActor          *child,
+                                              const ClutterActorBox *area);
 
 
 G_END_DECLS
@@ -33,6 +33,7 @@
 #include <mx/mx-box-layout-child.h>
 #include <mx/mx-button.h>
 #include <mx/mx-button-group.h>
+#include <mx/mx-cache-effect.h>
 #include <mx/mx-combo-box.h>
 #include <mx/mx-dialog.h>
 #include <mx/mx-draggable.h>
@@ -58,6 +59,7 @@
 #include <mx/mx-notebook.h>
 #include <mx/mx-path-bar.h>
 #include <mx/mx-menu.h>
+#include <mx/mx-profiler.h>
 #include <mx/mx-progress-bar.h>
 #include <mx/mx-scroll-bar.h>
 #include <mx/mx-scroll-view.h>
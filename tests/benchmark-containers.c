@@ -0,0 +1,711 @@
+/*
+ * Copyright 2012 Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/*
+ * Times layout, paint, pick and scrolling of the Mx containers, without
+ * any user input, and prints the results as JSON.
+ *
+ * Each container is filled with children and put in a scroll view. The
+ * scroll view is allocated and painted directly, rather than from the
+ * main loop, and painted into an offscreen buffer. Picking still goes
+ * through the stage, so a display is needed; on machines without one, run
+ * it under Xvfb.
+ *
+ * Before the timing runs, the memory used by each type of child is
+ * reported, from the growth of the heap in use while the children are
+ * created and allocated. One child of each type is created first, so that
+ * class, theme and font initialisation isn't counted. This needs
+ * mallinfo(), and reads zero elsewhere; run it with G_SLICE=always-malloc
+ * to count slice allocations exactly.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <mx/mx.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined (HAVE_MALLINFO2) || defined (HAVE_MALLINFO)
+#include <malloc.h>
+#endif
+
+#define VIEW_WIDTH    800
+#define VIEW_HEIGHT   600
+#define TABLE_COLUMNS 10
+#define IMAGE_SIZE    32
+
+typedef enum
+{
+  CHILD_LABEL,
+  CHILD_BUTTON,
+  CHILD_IMAGE
+} ChildType;
+
+typedef struct
+{
+  const gchar  *name;
+  gboolean      scrollable;
+  ClutterActor *(*create) (void);
+  void          (*add)    (ClutterActor *container,
+                           ClutterActor *child,
+                           gint          index);
+} ContainerType;
+
+typedef struct
+{
+  const gchar *name;
+  GArray      *samples;
+  guint        allocation_changes;
+  gint         solves;
+} Cycle;
+
+static gint         n_children = 1000;
+static gint         n_iterations = 100;
+static gchar       *child_type_name = "label";
+static gchar       *container_names = NULL;
+static gchar       *output_name = NULL;
+
+static GOptionEntry entries[] =
+{
+  { "children", 'n', 0, G_OPTION_ARG_INT, &n_children,
+    "Number of children in each container", "N" },
+  { "iterations", 'i', 0, G_OPTION_ARG_INT, &n_iterations,
+    "Number of timed iterations of each cycle", "N" },
+  { "child-type", 't', 0, G_OPTION_ARG_STRING, &child_type_name,
+    "Type of the children: label, button, image or mixed", "TYPE" },
+  { "containers", 'c', 0, G_OPTION_ARG_STRING, &container_names,
+    "Comma separated containers to run, all of them by default", "LIST" },
+  { "output", 'o', 0, G_OPTION_ARG_FILENAME, &output_name,
+    "File to write the results to, instead of stdout", "FILE" },
+  { NULL }
+};
+
+static gboolean
+is_selected (gchar       **names,
+             const gchar  *name)
+{
+  if (!names)
+    return TRUE;
+
+  for (; *names; names++)
+    if (!strcmp (*names, name))
+      return TRUE;
+
+  return FALSE;
+}
+
+static ClutterActor *
+create_box_layout (void)
+{
+  return mx_box_layout_new_with_orientation (MX_ORIENTATION_VERTICAL);
+}
+
+static ClutterActor *
+create_grid (void)
+{
+  return mx_grid_new ();
+}
+
+static ClutterActor *
+create_table (void)
+{
+  return mx_table_new ();
+}
+
+static ClutterActor *
+create_stack (void)
+{
+  return mx_stack_new ();
+}
+
+static void
+add_child (ClutterActor *container,
+           ClutterActor *child,
+           gint          index)
+{
+  clutter_actor_add_child (container, child);
+}
+
+static void
+add_table_child (ClutterActor *container,
+                 ClutterActor *child,
+                 gint          index)
+{
+  mx_table_insert_actor (MX_TABLE (container), child,
+                         index / TABLE_COLUMNS, index % TABLE_COLUMNS);
+}
+
+static const gchar *child_type_names[] = { "label", "button", "image" };
+
+static const ContainerType containers[] =
+{
+  { "box-layout", TRUE, create_box_layout, add_child },
+  { "grid", TRUE, create_grid, add_child },
+  { "table", FALSE, create_table, add_table_child },
+  { "stack", FALSE, create_stack, add_child },
+};
+
+static ClutterActor *
+create_child (ChildType type,
+              gint      index)
+{
+  static guchar *pixels = NULL;
+  ClutterActor *child;
+  gchar *text;
+
+  switch (type)
+    {
+    case CHILD_BUTTON:
+      text = g_strdup_printf ("Button %d", index);
+      child = mx_button_new_with_label (text);
+      g_free (text);
+      return child;
+
+    case CHILD_IMAGE:
+      if (!pixels)
+        {
+          gint i;
+
+          pixels = g_malloc (IMAGE_SIZE * IMAGE_SIZE * 4);
+          for (i = 0; i < IMAGE_SIZE * IMAGE_SIZE * 4; i++)
+            pixels[i] = i & 0xff;
+        }
+
+      child = mx_image_new ();
+      mx_image_set_from_data (MX_IMAGE (child), pixels,
+                              COGL_PIXEL_FORMAT_RGBA_8888,
+                              IMAGE_SIZE, IMAGE_SIZE, IMAGE_SIZE * 4, NULL);
+      clutter_actor_set_size (child, IMAGE_SIZE, IMAGE_SIZE);
+      return child;
+
+    default:
+    case CHILD_LABEL:
+      text = g_strdup_printf ("Item %d", index);
+      child = mx_label_new_with_text (text);
+      g_free (text);
+      return child;
+    }
+}
+
+static GType
+child_gtype (ChildType type)
+{
+  switch (type)
+    {
+    case CHILD_BUTTON:
+      return MX_TYPE_BUTTON;
+
+    case CHILD_IMAGE:
+      return MX_TYPE_IMAGE;
+
+    default:
+    case CHILD_LABEL:
+      return MX_TYPE_LABEL;
+    }
+}
+
+/* the heap in use by the process in bytes, or 0 if unknown */
+static gsize
+heap_size (void)
+{
+#if defined (HAVE_MALLINFO2)
+  return mallinfo2 ().uordblks;
+#elif defined (HAVE_MALLINFO)
+  return (guint) mallinfo ().uordblks;
+#else
+  return 0;
+#endif
+}
+
+static gint64
+now (void)
+{
+  return g_get_monotonic_time ();
+}
+
+static void
+add_sample (Cycle  *cycle,
+            gint64  start)
+{
+  gdouble msecs = (now () - start) / 1000.0;
+
+  g_array_append_val (cycle->samples, msecs);
+}
+
+static void
+allocate_view (ClutterActor *view)
+{
+  ClutterActorBox box = { 0, 0, VIEW_WIDTH, VIEW_HEIGHT };
+
+  clutter_actor_allocate (view, &box, CLUTTER_ALLOCATION_NONE);
+}
+
+static void
+paint_view (ClutterActor *view,
+            CoglHandle    offscreen)
+{
+  cogl_push_framebuffer (offscreen);
+  cogl_ortho (0, VIEW_WIDTH, VIEW_HEIGHT, 0, -1, 1);
+
+  clutter_actor_paint (view);
+
+  cogl_flush ();
+  cogl_pop_framebuffer ();
+}
+
+static void
+allocation_changed_cb (ClutterActor *actor,
+                       gpointer      box,
+                       gint          flags,
+                       Cycle        *cycle)
+{
+  cycle->allocation_changes++;
+}
+
+/* counts the children whose allocation changes, and for tables the times
+ * the column and row sizes are solved, while running @func once */
+static void
+count_allocation_changes (ClutterActor *container,
+                          Cycle        *cycle,
+                          void        (*func) (gpointer data, gint iteration),
+                          gpointer      data)
+{
+  ClutterActorIter iter;
+  ClutterActor *child;
+
+  cycle->allocation_changes = 0;
+  cycle->solves = -1;
+
+  clutter_actor_iter_init (&iter, container);
+  while (clutter_actor_iter_next (&iter, &child))
+    g_signal_connect (child, "allocation-changed",
+                      G_CALLBACK (allocation_changed_cb), cycle);
+
+  if (MX_IS_TABLE (container))
+    cycle->solves = mx_table_get_n_solves (MX_TABLE (container));
+
+  func (data, n_iterations);
+
+  if (MX_IS_TABLE (container))
+    cycle->solves = mx_table_get_n_solves (MX_TABLE (container)) -
+                    cycle->solves;
+
+  clutter_actor_iter_init (&iter, container);
+  while (clutter_actor_iter_next (&iter, &child))
+    g_signal_handlers_disconnect_by_func (child, allocation_changed_cb, cycle);
+}
+
+typedef struct
+{
+  ClutterActor *view;
+  ClutterActor *container;
+  ClutterActor *stage;
+  MxAdjustment *adjustment;
+  CoglHandle    offscreen;
+  GRand        *rand;
+} Bench;
+
+static void
+run_allocate (gpointer data,
+              gint     iteration)
+{
+  Bench *bench = data;
+
+  clutter_actor_queue_relayout (bench->container);
+  allocate_view (bench->view);
+}
+
+static void
+run_relayout_child (gpointer data,
+                    gint     iteration)
+{
+  Bench *bench = data;
+  ClutterActor *child;
+
+  /* resize a child in the middle, so the children after it move */
+  child = clutter_actor_get_child_at_index (bench->container,
+                                            n_children / 2);
+  clutter_actor_set_height (child, (iteration % 2) ? 48 : -1);
+
+  allocate_view (bench->view);
+}
+
+static void
+run_paint (gpointer data,
+           gint     iteration)
+{
+  Bench *bench = data;
+
+  paint_view (bench->view, bench->offscreen);
+}
+
+static void
+run_pick (gpointer data,
+          gint     iteration)
+{
+  Bench *bench = data;
+
+  clutter_stage_get_actor_at_pos (CLUTTER_STAGE (bench->stage),
+                                  CLUTTER_PICK_REACTIVE,
+                                  g_rand_int_range (bench->rand,
+                                                    0, VIEW_WIDTH),
+                                  g_rand_int_range (bench->rand,
+                                                    0, VIEW_HEIGHT));
+}
+
+static void
+run_scroll (gpointer data,
+            gint     iteration)
+{
+  Bench *bench = data;
+  gdouble lower, upper, page_size, value;
+
+  mx_adjustment_get_values (bench->adjustment, NULL, &lower, &upper,
+                            NULL, NULL, &page_size);
+
+  /* scroll by a quarter of a page, going back to the top at the end */
+  value = lower;
+  if (upper - page_size > lower)
+    value += fmod (iteration * page_size / 4, upper - page_size - lower);
+
+  mx_adjustment_set_value (bench->adjustment, value);
+
+  allocate_view (bench->view);
+  paint_view (bench->view, bench->offscreen);
+}
+
+static void
+run_cycle (Bench  *bench,
+           Cycle  *cycle,
+           void  (*func) (gpointer data, gint iteration))
+{
+  gint i;
+
+  /* warm up caches before timing */
+  func (bench, 0);
+
+  for (i = 0; i < n_iterations; i++)
+    {
+      gint64 start = now ();
+
+      func (bench, i);
+      add_sample (cycle, start);
+    }
+
+  count_allocation_changes (bench->container, cycle, func, bench);
+}
+
+static gint
+compare_samples (gconstpointer a,
+                 gconstpointer b)
+{
+  gdouble da = *(const gdouble *) a;
+  gdouble db = *(const gdouble *) b;
+
+  return (da > db) - (da < db);
+}
+
+static gdouble
+percentile (GArray  *samples,
+            gdouble  fraction)
+{
+  guint index = (guint) (fraction * (samples->len - 1) + 0.5);
+
+  return g_array_index (samples, gdouble, index);
+}
+
+static void
+print_cycle (GString *json,
+             Cycle   *cycle,
+             gboolean last)
+{
+  GArray *samples = cycle->samples;
+  gdouble total = 0;
+  guint i;
+
+  g_array_sort (samples, compare_samples);
+
+  for (i = 0; i < samples->len; i++)
+    total += g_array_index (samples, gdouble, i);
+
+  g_string_append_printf (json,
+                          "      \"%s\": {\n"
+                          "        \"min\": %.4f,\n"
+                          "        \"p50\": %.4f,\n"
+                          "        \"p90\": %.4f,\n"
+                          "        \"p99\": %.4f,\n"
+                          "        \"max\": %.4f,\n"
+                          "        \"mean\": %.4f,\n"
+                          "        \"allocation-changes\": %u",
+                          cycle->name,
+                          g_array_index (samples, gdouble, 0),
+                          percentile (samples, 0.5),
+                          percentile (samples, 0.9),
+                          percentile (samples, 0.99),
+                          g_array_index (samples, gdouble, samples->len - 1),
+                          total / samples->len,
+                          cycle->allocation_changes);
+
+  if (cycle->solves >= 0)
+    g_string_append_printf (json, ",\n        \"solves\": %d", cycle->solves);
+
+  g_string_append_printf (json, "\n      }%s\n", last ? "" : ",");
+}
+
+static void
+print_memory (ClutterActor *stage,
+              GString      *json)
+{
+  ClutterActor *container;
+  guint i;
+
+  /* initialise the classes, the theme and the fonts before measuring */
+  container = create_box_layout ();
+  for (i = 0; i < G_N_ELEMENTS (child_type_names); i++)
+    clutter_actor_add_child (container, create_child ((ChildType) i, i));
+  clutter_actor_add_child (stage, container);
+  allocate_view (container);
+  clutter_actor_destroy (container);
+
+  g_string_append (json, "  \"memory\": {\n");
+
+  for (i = 0; i < G_N_ELEMENTS (child_type_names); i++)
+    {
+      GTypeQuery query;
+      gsize before, after;
+      gint j;
+
+      g_type_query (child_gtype ((ChildType) i), &query);
+
+      before = heap_size ();
+
+      container = create_box_layout ();
+      for (j = 0; j < n_children; j++)
+        clutter_actor_add_child (container, create_child ((ChildType) i, j));
+      clutter_actor_add_child (stage, container);
+      allocate_view (container);
+
+      after = heap_size ();
+
+      g_string_append_printf (json,
+                              "    \"%s\": {\n"
+                              "      \"instance-size\": %u,\n"
+                              "      \"bytes-per-child\": %" G_GSIZE_FORMAT
+                              "\n"
+                              "    }%s\n",
+                              child_type_names[i],
+                              query.instance_size,
+                              after > before ?
+                                (after - before) / n_children : 0,
+                              i == G_N_ELEMENTS (child_type_names) - 1 ?
+                                "" : ",");
+
+      clutter_actor_destroy (container);
+    }
+
+  g_string_append (json, "  },\n");
+}
+
+static void
+run_container (const ContainerType *type,
+               ChildType            child_type,
+               gboolean             mixed,
+               ClutterActor        *stage,
+               CoglHandle           offscreen,
+               GString             *json,
+               gboolean             last)
+{
+  Cycle cycles[] = {
+    { "allocate", NULL, 0 },
+    { "relayout-child", NULL, 0 },
+    { "paint", NULL, 0 },
+    { "pick", NULL, 0 },
+    { "scroll", NULL, 0 },
+  };
+  void (*funcs[]) (gpointer, gint) = {
+    run_allocate,
+    run_relayout_child,
+    run_paint,
+    run_pick,
+    run_scroll,
+  };
+  ClutterActor *scrollable;
+  Bench bench = { 0, };
+  guint i;
+
+  bench.stage = stage;
+  bench.offscreen = offscreen;
+  bench.rand = g_rand_new_with_seed (0);
+
+  bench.view = mx_scroll_view_new ();
+  clutter_actor_set_size (bench.view, VIEW_WIDTH, VIEW_HEIGHT);
+
+  bench.container = type->create ();
+  for (i = 0; i < (guint) n_children; i++)
+    type->add (bench.container,
+               create_child (mixed ? (ChildType) (i % 3) : child_type, i),
+               i);
+
+  if (type->scrollable)
+    clutter_actor_add_child (bench.view, bench.container);
+  else
+    {
+      ClutterActor *viewport = mx_viewport_new ();
+
+      clutter_actor_add_child (viewport, bench.container);
+      clutter_actor_add_child (bench.view, viewport);
+    }
+
+  clutter_actor_add_child (stage, bench.view);
+
+  scrollable = clutter_actor_get_first_child (bench.view);
+  mx_scrollable_get_adjustments (MX_SCROLLABLE (scrollable),
+                                 NULL, &bench.adjustment);
+
+  allocate_view (bench.view);
+
+  g_string_append_printf (json, "    \"%s\": {\n", type->name);
+
+  for (i = 0; i < G_N_ELEMENTS (cycles); i++)
+    {
+      cycles[i].samples = g_array_sized_new (FALSE, FALSE, sizeof (gdouble),
+                                             n_iterations);
+      run_cycle (&bench, &cycles[i], funcs[i]);
+      print_cycle (json, &cycles[i], i == G_N_ELEMENTS (cycles) - 1);
+      g_array_free (cycles[i].samples, TRUE);
+    }
+
+  g_string_append_printf (json, "    }%s\n", last ? "" : ",");
+
+  clutter_actor_destroy (bench.view);
+  g_rand_free (bench.rand);
+}
+
+int
+main (int argc, char **argv)
+{
+  GOptionContext *context;
+  ClutterActor *stage;
+  CoglHandle texture, offscreen;
+  ChildType child_type;
+  gboolean mixed = FALSE;
+  GError *error = NULL;
+  gchar **names = NULL;
+  GString *json;
+  guint i, n_run, n_selected;
+
+  context = g_option_context_new ("- benchmark Mx containers");
+  g_option_context_add_main_entries (context, entries, NULL);
+  g_option_context_add_group (context, clutter_get_option_group ());
+
+  if (!g_option_context_parse (context, &argc, &argv, &error))
+    {
+      g_printerr ("%s\n", error->message);
+      return EXIT_FAILURE;
+    }
+
+  if (n_children < 1 || n_iterations < 1)
+    {
+      g_printerr ("The numbers of children and iterations must be "
+                  "positive\n");
+      return EXIT_FAILURE;
+    }
+
+  if (!strcmp (child_type_name, "label"))
+    child_type = CHILD_LABEL;
+  else if (!strcmp (child_type_name, "button"))
+    child_type = CHILD_BUTTON;
+  else if (!strcmp (child_type_name, "image"))
+    child_type = CHILD_IMAGE;
+  else if (!strcmp (child_type_name, "mixed"))
+    {
+      child_type = CHILD_LABEL;
+      mixed = TRUE;
+    }
+  else
+    {
+      g_printerr ("Unknown child type '%s', expected one of: label, button, "
+                  "image, mixed\n", child_type_name);
+      return EXIT_FAILURE;
+    }
+
+  if (container_names)
+    names = g_strsplit (container_names, ",", -1);
+
+  stage = clutter_stage_new ();
+  clutter_actor_set_size (stage, VIEW_WIDTH, VIEW_HEIGHT);
+  clutter_actor_show (stage);
+
+  texture = cogl_texture_new_with_size (VIEW_WIDTH, VIEW_HEIGHT,
+                                        COGL_TEXTURE_NO_SLICING,
+                                        COGL_PIXEL_FORMAT_RGBA_8888_PRE);
+  offscreen = cogl_offscreen_new_to_texture (texture);
+
+  n_selected = 0;
+  for (i = 0; i < G_N_ELEMENTS (containers); i++)
+    if (is_selected (names, containers[i].name))
+      n_selected++;
+
+  json = g_string_new (NULL);
+  g_string_append_printf (json,
+                          "{\n"
+                          "  \"children\": %d,\n"
+                          "  \"iterations\": %d,\n"
+                          "  \"child-type\": \"%s\",\n",
+                          n_children, n_iterations,
+                          mixed ? "mixed" : child_type_name);
+
+  print_memory (stage, json);
+
+  g_string_append (json, "  \"containers\": {\n");
+
+  n_run = 0;
+  for (i = 0; i < G_N_ELEMENTS (containers); i++)
+    {
+      if (!is_selected (names, containers[i].name))
+        continue;
+
+      n_run++;
+      run_container (&containers[i], child_type, mixed, stage, offscreen,
+                     json, n_run == n_selected);
+    }
+
+  g_string_append (json, "  }\n}\n");
+
+  if (output_name)
+    {
+      if (!g_file_set_contents (output_name, json->str, json->len, &error))
+        {
+          g_printerr ("%s\n", error->message);
+          return EXIT_FAILURE;
+        }
+    }
+  else
+    fputs (json->str, stdout);
+
+  g_string_free (json, TRUE);
+  g_strfreev (names);
+  cogl_handle_unref (offscreen);
+  cogl_handle_unref (texture);
+  clutter_actor_destroy (stage);
+  g_option_context_free (context);
+
+  return EXIT_SUCCESS;
+}